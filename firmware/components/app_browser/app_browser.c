@@ -28,6 +28,13 @@ static const char *TAG = "browser";
 #define MAX_PAGE_LEN 4096
 #define MAX_LINKS 20
 #define MAX_BOOKMARKS 10
+#define MAX_PAGE_LINES 512
+
+/* Page view text layout */
+#define PAGE_CONTENT_Y 13              /* Below the URL bar */
+#define PAGE_FONT DISPLAY_FONT_PROP
+#define PAGE_LINE_HEIGHT 9
+#define PAGE_TEXT_WIDTH (DISPLAY_WIDTH - 4)
 
 /* ============================================================================
  * Types
@@ -54,25 +61,46 @@ typedef enum {
  * State
  * ============================================================================ */
 
-static view_mode_t s_mode = VIEW_HOME;
-static char s_url[MAX_URL_LEN] = "";
-static char s_page_title[64] = "";
-static char s_page_text[MAX_PAGE_LEN] = "";
-static int s_page_len = 0;
-
-static link_t s_links[MAX_LINKS];
-static int s_link_count = 0;
-static int s_selected_link = 0;
-
-static bookmark_t s_bookmarks[MAX_BOOKMARKS];
-static int s_bookmark_count = 0;
+/* Working state, allocated by the UI while the app is open or warm */
+typedef struct {
+    view_mode_t mode;
+    char url[MAX_URL_LEN];
+    char page_title[64];
+    char page_text[MAX_PAGE_LEN];
+    int page_len;
+    
+    /* Page text wrapped to the screen width */
+    uint16_t line_start[MAX_PAGE_LINES];
+    uint8_t line_len[MAX_PAGE_LINES];
+    int line_count;
+    
+    link_t links[MAX_LINKS];
+    int link_count;
+    int selected_link;
+    
+    bookmark_t bookmarks[MAX_BOOKMARKS];
+    int bookmark_count;
+    
+    int scroll;
+    bool loading;
+    
+    /* History for back button */
+    char history[10][MAX_URL_LEN];
+    int history_count;
+} browser_state_t;
 
-static int s_scroll = 0;
-static bool s_loading = false;
+static browser_state_t *s_state = NULL;
 
-/* History for back button */
-static char s_history[10][MAX_URL_LEN];
-static int s_history_count = 0;
+/**
+ * @brief Lock panel RAM rows to page text lines
+ *
+ * With the hardware scroll following the page scroll, a one-line step
+ * only sends the newly exposed line and the fixed URL/link rows.
+ */
+static void sync_hw_scroll(void)
+{
+    display_set_scroll(s_state->mode == VIEW_PAGE ? s_state->scroll * PAGE_LINE_HEIGHT : 0);
+}
 
 /* ============================================================================
  * HTML Parser (Very Basic)
@@ -86,9 +114,9 @@ static void strip_html_to_text(const char *html, size_t html_len)
      * - Extract link hrefs
      */
     
-    s_page_len = 0;
-    s_link_count = 0;
-    s_page_title[0] = '\0';
+    s_state->page_len = 0;
+    s_state->link_count = 0;
+    s_state->page_title[0] = '\0';
     
     bool in_tag = false;
     bool in_script = false;
@@ -112,16 +140,16 @@ static void strip_html_to_text(const char *html, size_t html_len)
             }
             
             /* Check for <a href="..."> */
-            if (i + 9 < html_len && strncasecmp(&html[i], "<a href=\"", 9) == 0 && s_link_count < MAX_LINKS) {
+            if (i + 9 < html_len && strncasecmp(&html[i], "<a href=\"", 9) == 0 && s_state->link_count < MAX_LINKS) {
                 size_t href_start = i + 9;
                 size_t href_end = href_start;
                 while (href_end < html_len && html[href_end] != '"') href_end++;
                 
                 if (href_end - href_start < MAX_URL_LEN) {
-                    strncpy(s_links[s_link_count].url, &html[href_start], href_end - href_start);
-                    s_links[s_link_count].url[href_end - href_start] = '\0';
-                    s_links[s_link_count].text[0] = '\0';
-                    s_link_count++;
+                    strncpy(s_state->links[s_state->link_count].url, &html[href_start], href_end - href_start);
+                    s_state->links[s_state->link_count].url[href_end - href_start] = '\0';
+                    s_state->links[s_state->link_count].text[0] = '\0';
+                    s_state->link_count++;
                 }
             }
             
@@ -148,19 +176,39 @@ static void strip_html_to_text(const char *html, size_t html_len)
         if (c == '\r' || c == '\n' || c == '\t') c = ' ';
         
         /* Skip multiple spaces */
-        if (c == ' ' && text_pos > 0 && s_page_text[text_pos - 1] == ' ') continue;
+        if (c == ' ' && text_pos > 0 && s_state->page_text[text_pos - 1] == ' ') continue;
         
-        s_page_text[text_pos++] = c;
+        s_state->page_text[text_pos++] = c;
     }
     
-    s_page_text[text_pos] = '\0';
-    s_page_len = text_pos;
+    s_state->page_text[text_pos] = '\0';
+    s_state->page_len = text_pos;
     
     /* Extract title if present in first 200 chars */
-    const char *title_start = strstr(s_page_text, "<title>");
+    const char *title_start = strstr(s_state->page_text, "<title>");
     if (!title_start) {
         /* Use URL as title */
-        strncpy(s_page_title, s_url, 63);
+        strncpy(s_state->page_title, s_state->url, 63);
+    }
+}
+
+/**
+ * @brief Break the page text into screen lines, once per page load
+ */
+static void wrap_page_text(void)
+{
+    int pos = 0;
+    s_state->line_count = 0;
+    
+    while (pos < s_state->page_len && s_state->line_count < MAX_PAGE_LINES) {
+        while (s_state->page_text[pos] == ' ') pos++;
+        if (pos >= s_state->page_len) break;
+        
+        int len = display_wrap_chars(&s_state->page_text[pos], PAGE_TEXT_WIDTH, PAGE_FONT);
+        s_state->line_start[s_state->line_count] = pos;
+        s_state->line_len[s_state->line_count] = len;
+        s_state->line_count++;
+        pos += len;
     }
 }
 
@@ -173,14 +221,14 @@ static void fetch_url(const char *url)
     ESP_LOGI(TAG, "Fetching: %s", url);
     
     /* Add to history */
-    if (s_url[0] != '\0' && s_history_count < 10) {
-        strcpy(s_history[s_history_count++], s_url);
+    if (s_state->url[0] != '\0' && s_state->history_count < 10) {
+        strcpy(s_state->history[s_state->history_count++], s_state->url);
     }
     
-    strncpy(s_url, url, MAX_URL_LEN - 1);
-    s_loading = true;
-    s_scroll = 0;
-    s_selected_link = 0;
+    strncpy(s_state->url, url, MAX_URL_LEN - 1);
+    s_state->loading = true;
+    s_state->scroll = 0;
+    s_state->selected_link = 0;
     
     /* TODO: Implement actual HTTP GET request
      * 
@@ -207,29 +255,31 @@ static void fetch_url(const char *url)
         "</body></html>";
     
     strip_html_to_text(demo_html, strlen(demo_html));
-    strcpy(s_page_title, "Demo Page");
+    strcpy(s_state->page_title, "Demo Page");
+    wrap_page_text();
     
-    s_loading = false;
-    s_mode = VIEW_PAGE;
+    s_state->loading = false;
+    s_state->mode = VIEW_PAGE;
+    sync_hw_scroll();
 }
 
 static void go_back(void)
 {
-    if (s_history_count > 0) {
-        s_history_count--;
-        fetch_url(s_history[s_history_count]);
-        s_history_count--;  /* Don't add to history again */
+    if (s_state->history_count > 0) {
+        s_state->history_count--;
+        fetch_url(s_state->history[s_state->history_count]);
+        s_state->history_count--;  /* Don't add to history again */
     }
 }
 
 static void add_bookmark(void)
 {
-    if (s_bookmark_count >= MAX_BOOKMARKS) return;
-    if (s_url[0] == '\0') return;
+    if (s_state->bookmark_count >= MAX_BOOKMARKS) return;
+    if (s_state->url[0] == '\0') return;
     
-    bookmark_t *b = &s_bookmarks[s_bookmark_count++];
-    strncpy(b->url, s_url, MAX_URL_LEN - 1);
-    strncpy(b->title, s_page_title, 31);
+    bookmark_t *b = &s_state->bookmarks[s_state->bookmark_count++];
+    strncpy(b->url, s_state->url, MAX_URL_LEN - 1);
+    strncpy(b->title, s_state->page_title, 31);
     
     ui_notify_simple("Bookmarked!");
 }
@@ -259,19 +309,21 @@ static void on_url_entered(const char *text, bool confirmed)
 static void on_enter(void)
 {
     ESP_LOGI(TAG, "Browser app entered");
+    s_state = ui_app_state(&app_browser);
     
-    if (s_url[0] != '\0') {
-        s_mode = VIEW_PAGE;
+    if (s_state->url[0] != '\0') {
+        s_state->mode = VIEW_PAGE;
     } else {
-        s_mode = VIEW_HOME;
+        s_state->mode = VIEW_HOME;
     }
+    sync_hw_scroll();
     
     /* Load bookmarks from SD */
     /* TODO: Load from /sdcard/bookmarks.txt */
-    if (s_bookmark_count == 0) {
-        strcpy(s_bookmarks[0].title, "Example");
-        strcpy(s_bookmarks[0].url, "http://example.com");
-        s_bookmark_count = 1;
+    if (s_state->bookmark_count == 0) {
+        strcpy(s_state->bookmarks[0].title, "Example");
+        strcpy(s_state->bookmarks[0].url, "http://example.com");
+        s_state->bookmark_count = 1;
     }
 }
 
@@ -280,25 +332,32 @@ static void on_exit(void)
     ESP_LOGI(TAG, "Browser app exited");
 }
 
+static void on_evict(void *state)
+{
+    (void)state;
+    s_state = NULL;     /* Page, history and bookmarks go; on_enter starts from home */
+}
+
 static void on_input(int8_t x, int8_t y, uint8_t buttons)
 {
     static uint32_t last_nav = 0;
     uint32_t now = esp_timer_get_time() / 1000;
     
-    if (s_loading) return;
+    if (s_state->loading) return;
     
     if (buttons & UI_BTN_BACK) {
-        if (s_mode == VIEW_PAGE && s_history_count > 0) {
+        if (s_state->mode == VIEW_PAGE && s_state->history_count > 0) {
             go_back();
-        } else if (s_mode == VIEW_BOOKMARKS) {
-            s_mode = VIEW_HOME;
+        } else if (s_state->mode == VIEW_BOOKMARKS) {
+            s_state->mode = VIEW_HOME;
         } else {
             ui_go_back();
         }
+        sync_hw_scroll();
         return;
     }
     
-    switch (s_mode) {
+    switch (s_state->mode) {
     case VIEW_HOME:
         if (buttons & UI_BTN_PRESS) {
             ui_osk_config_t osk = {
@@ -312,36 +371,37 @@ static void on_input(int8_t x, int8_t y, uint8_t buttons)
         }
         
         if (buttons & UI_BTN_LONG) {
-            s_mode = VIEW_BOOKMARKS;
-            s_scroll = 0;
+            s_state->mode = VIEW_BOOKMARKS;
+            s_state->scroll = 0;
         }
         break;
         
     case VIEW_PAGE:
         if (now - last_nav > 100) {
-            /* Scroll page */
-            if (y < -30) {
-                s_scroll++;
+            /* Scroll page (stop once the last line is in view) */
+            int lines_visible = (UI_CONTENT_HEIGHT - PAGE_CONTENT_Y) / PAGE_LINE_HEIGHT;
+            if (y < -30 && s_state->scroll + lines_visible < s_state->line_count) {
+                s_state->scroll++;
                 last_nav = now;
-            } else if (y > 30 && s_scroll > 0) {
-                s_scroll--;
+            } else if (y > 30 && s_state->scroll > 0) {
+                s_state->scroll--;
                 last_nav = now;
             }
             
             /* Navigate links */
-            if (x > 30 && s_selected_link < s_link_count - 1) {
-                s_selected_link++;
+            if (x > 30 && s_state->selected_link < s_state->link_count - 1) {
+                s_state->selected_link++;
                 last_nav = now;
-            } else if (x < -30 && s_selected_link > 0) {
-                s_selected_link--;
+            } else if (x < -30 && s_state->selected_link > 0) {
+                s_state->selected_link--;
                 last_nav = now;
             }
         }
         
         if (buttons & UI_BTN_PRESS) {
             /* Follow selected link */
-            if (s_link_count > 0) {
-                fetch_url(s_links[s_selected_link].url);
+            if (s_state->link_count > 0) {
+                fetch_url(s_state->links[s_state->selected_link].url);
             }
         }
         
@@ -353,7 +413,7 @@ static void on_input(int8_t x, int8_t y, uint8_t buttons)
             /* New URL */
             ui_osk_config_t osk = {
                 .title = "Enter URL:",
-                .initial_text = s_url,
+                .initial_text = s_state->url,
                 .max_length = MAX_URL_LEN - 1,
                 .password_mode = false,
                 .callback = on_url_entered,
@@ -364,18 +424,18 @@ static void on_input(int8_t x, int8_t y, uint8_t buttons)
         
     case VIEW_BOOKMARKS:
         if (now - last_nav > 150) {
-            if (y < -30 && s_scroll < s_bookmark_count - 1) {
-                s_scroll++;
+            if (y < -30 && s_state->scroll < s_state->bookmark_count - 1) {
+                s_state->scroll++;
                 last_nav = now;
-            } else if (y > 30 && s_scroll > 0) {
-                s_scroll--;
+            } else if (y > 30 && s_state->scroll > 0) {
+                s_state->scroll--;
                 last_nav = now;
             }
         }
         
         if (buttons & UI_BTN_PRESS) {
-            if (s_bookmark_count > 0) {
-                fetch_url(s_bookmarks[s_scroll].url);
+            if (s_state->bookmark_count > 0) {
+                fetch_url(s_state->bookmarks[s_state->scroll].url);
             }
         }
         break;
@@ -383,18 +443,20 @@ static void on_input(int8_t x, int8_t y, uint8_t buttons)
     default:
         break;
     }
+    
+    sync_hw_scroll();
 }
 
 static void on_render(void)
 {
-    int y = UI_STATUS_BAR_HEIGHT + 2;
+    int y = 2;
     
-    if (s_loading) {
-        display_draw_string(35, 30, "Loading...", COLOR_WHITE, 1);
+    if (s_state->loading) {
+        display_draw_string(35, 20, "Loading...", COLOR_WHITE, 1);
         return;
     }
     
-    switch (s_mode) {
+    switch (s_state->mode) {
     case VIEW_HOME:
         display_draw_string(2, y, "Browser", COLOR_WHITE, 1);
         display_draw_hline(0, y + 9, DISPLAY_WIDTH, COLOR_WHITE);
@@ -412,32 +474,29 @@ static void on_render(void)
         
     case VIEW_PAGE:
         /* URL bar */
-        display_printf(2, y, COLOR_WHITE, 1, "%.20s", s_url);
+        display_draw_text_fit(2, y, PAGE_TEXT_WIDTH, s_state->url, PAGE_FONT, COLOR_WHITE);
         display_draw_hline(0, y + 9, DISPLAY_WIDTH, COLOR_WHITE);
-        y += 11;
+        y = PAGE_CONTENT_Y;
         
         /* Page content */
-        int chars_per_line = 20;
-        int lines_visible = (DISPLAY_HEIGHT - y) / 9;
+        int lines_visible = (UI_CONTENT_HEIGHT - y) / PAGE_LINE_HEIGHT;
         
-        for (int i = 0; i < lines_visible; i++) {
-            int line_idx = s_scroll + i;
-            int offset = line_idx * chars_per_line;
-            
-            if (offset >= s_page_len) break;
+        for (int i = 0; i < lines_visible && s_state->scroll + i < s_state->line_count; i++) {
+            int line_idx = s_state->scroll + i;
             
-            char line[21];
-            strncpy(line, &s_page_text[offset], 20);
-            line[20] = '\0';
-            display_draw_string(2, y + i * 9, line, COLOR_WHITE, 1);
+            char line[256];
+            memcpy(line, &s_state->page_text[s_state->line_start[line_idx]], s_state->line_len[line_idx]);
+            line[s_state->line_len[line_idx]] = '\0';
+            display_draw_text(2, y + i * PAGE_LINE_HEIGHT, line, PAGE_FONT, COLOR_WHITE);
         }
         
         /* Link indicator at bottom */
-        if (s_link_count > 0) {
-            display_printf(2, DISPLAY_HEIGHT - 9, COLOR_WHITE, 1, 
-                          "Link %d/%d: %.12s", 
-                          s_selected_link + 1, s_link_count,
-                          s_links[s_selected_link].url);
+        if (s_state->link_count > 0) {
+            char link[MAX_URL_LEN + 16];
+            snprintf(link, sizeof(link), "Link %d/%d: %s",
+                     s_state->selected_link + 1, s_state->link_count,
+                     s_state->links[s_state->selected_link].url);
+            display_draw_text_fit(2, UI_CONTENT_HEIGHT - 9, PAGE_TEXT_WIDTH, link, PAGE_FONT, COLOR_WHITE);
         }
         break;
         
@@ -446,19 +505,19 @@ static void on_render(void)
         display_draw_hline(0, y + 9, DISPLAY_WIDTH, COLOR_WHITE);
         y += 12;
         
-        if (s_bookmark_count == 0) {
+        if (s_state->bookmark_count == 0) {
             display_draw_string(2, y, "No bookmarks", COLOR_WHITE, 1);
         } else {
-            int visible = (DISPLAY_HEIGHT - y) / 12;
+            int visible = (UI_CONTENT_HEIGHT - y) / 12;
             
-            for (int i = 0; i < visible && i < s_bookmark_count; i++) {
+            for (int i = 0; i < visible && i < s_state->bookmark_count; i++) {
                 int item_y = y + i * 12;
                 
-                if (i == s_scroll) {
+                if (i == s_state->scroll) {
                     display_fill_rect(0, item_y, DISPLAY_WIDTH, 11, COLOR_WHITE);
-                    display_draw_string(2, item_y + 1, s_bookmarks[i].title, COLOR_BLACK, 1);
+                    display_draw_string(2, item_y + 1, s_state->bookmarks[i].title, COLOR_BLACK, 1);
                 } else {
-                    display_draw_string(2, item_y + 1, s_bookmarks[i].title, COLOR_WHITE, 1);
+                    display_draw_string(2, item_y + 1, s_state->bookmarks[i].title, COLOR_WHITE, 1);
                 }
             }
         }
@@ -481,11 +540,13 @@ static void on_tick(uint32_t dt_ms)
 const ui_app_t app_browser = {
     .id = "browser",
     .name = "Web",
-    .icon = ICON_BROWSER,
+    .sprite = &SPRITE_ICON_BROWSER,
     .on_enter = on_enter,
     .on_exit = on_exit,
     .on_input = on_input,
     .on_render = on_render,
     .on_tick = on_tick,
+    .state_size = sizeof(browser_state_t),
+    .on_evict = on_evict,
 };
 
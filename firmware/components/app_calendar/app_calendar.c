@@ -19,8 +19,14 @@ static const char *TAG = "calendar";
  * ============================================================================ */
 
 #define MAX_EVENTS 20
+#define MINUTES_PER_DAY (24 * 60)
 #define EVENT_DIR "/sdcard/calendar"
 
+#define MONTH_VIEW_Y 2
+#define CELL_W 18
+#define CELL_H 8
+#define GRID_Y 22   /* Below the month header and day names */
+
 /* ============================================================================
  * Types
  * ============================================================================ */
@@ -57,6 +63,13 @@ static calendar_event_t s_events[MAX_EVENTS];
 static int s_event_count = 0;
 static int s_selected_event = 0;
 
+/* Month view without the selection, redrawn when the month or events change */
+static display_surface_t s_month_view;
+static int s_month_view_key = -1;
+
+/* Minute of the day reminders have been checked up to, -1 before the first check */
+static int s_reminders_checked = -1;
+
 /* ============================================================================
  * Date Utilities
  * ============================================================================ */
@@ -155,6 +168,8 @@ static void create_event(void)
     e->reminder = 15;
     
     s_event_count++;
+    display_surface_invalidate(&s_month_view);
+    ui_schedule_tick(&app_calendar, 0);     /* Its reminder may be due before the one scheduled */
     ESP_LOGI(TAG, "Created event on %d-%02d-%02d", e->year, e->month, e->day);
 }
 
@@ -169,11 +184,18 @@ static void on_enter(void)
     s_selected_day = s_day;
     s_mode = VIEW_MONTH;
     load_events();
+    ui_schedule_tick(&app_calendar, 0);     /* Find the first reminder */
+    
+    if (display_surface_create(&s_month_view, DISPLAY_WIDTH,
+                               UI_CONTENT_HEIGHT - MONTH_VIEW_Y) != ESP_OK) {
+        ESP_LOGW(TAG, "No memory for the month view, drawing it every frame");
+    }
 }
 
 static void on_exit(void)
 {
     ESP_LOGI(TAG, "Calendar exited");
+    display_surface_destroy(&s_month_view);
 }
 
 static void on_input(int8_t x, int8_t y, uint8_t buttons)
@@ -256,58 +278,80 @@ static void on_input(int8_t x, int8_t y, uint8_t buttons)
     }
 }
 
-static void on_render(void)
+static const char *months[] = {
+    "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+    "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
+};
+
+/**
+ * @brief Draw the month header, day names and day grid, with no day selected
+ */
+static void draw_month(int y)
 {
-    int y = UI_STATUS_BAR_HEIGHT + 2;
-    static const char *months[] = {
-        "Jan", "Feb", "Mar", "Apr", "May", "Jun",
-        "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
-    };
+    /* Month/Year header */
+    display_printf(2, y, COLOR_WHITE, 1, "%s %d", months[s_month - 1], s_year);
+    display_draw_hline(0, y + 9, DISPLAY_WIDTH, COLOR_WHITE);
+    y += 12;
     
-    if (s_mode == VIEW_MONTH) {
-        /* Month/Year header */
-        display_printf(2, y, COLOR_WHITE, 1, "%s %d", months[s_month - 1], s_year);
-        display_draw_hline(0, y + 9, DISPLAY_WIDTH, COLOR_WHITE);
-        y += 12;
-        
-        /* Day of week headers */
-        static const char *dow[] = {"S", "M", "T", "W", "T", "F", "S"};
-        for (int i = 0; i < 7; i++) {
-            display_draw_string(2 + i * 18, y, dow[i], COLOR_WHITE, 1);
-        }
-        y += 10;
-        
-        /* Calendar grid */
-        int dim = days_in_month(s_year, s_month);
-        int first_dow = day_of_week(s_year, s_month, 1);
-        int cell_w = 18;
-        int cell_h = 8;
+    /* Day of week headers */
+    static const char *dow[] = {"S", "M", "T", "W", "T", "F", "S"};
+    for (int i = 0; i < 7; i++) {
+        display_draw_string(2 + i * CELL_W, y, dow[i], COLOR_WHITE, 1);
+    }
+    y += 10;
+    
+    /* Calendar grid */
+    int dim = days_in_month(s_year, s_month);
+    int first_dow = day_of_week(s_year, s_month, 1);
+    
+    for (int d = 1; d <= dim; d++) {
+        int cell = first_dow + d - 1;
+        int cx = 2 + (cell % 7) * CELL_W;
+        int cy = y + (cell / 7) * CELL_H;
         
-        int row = 0;
-        int col = first_dow;
+        display_printf(cx, cy, COLOR_WHITE, 1, "%d", d);
         
-        for (int d = 1; d <= dim; d++) {
-            int cx = 2 + col * cell_w;
-            int cy = y + row * cell_h;
-            
-            if (d == s_selected_day) {
-                display_fill_rect(cx - 1, cy, cell_w - 2, cell_h, COLOR_WHITE);
-                display_printf(cx, cy, COLOR_BLACK, 1, "%d", d);
-            } else {
-                display_printf(cx, cy, COLOR_WHITE, 1, "%d", d);
-            }
-            
-            /* Event indicator */
-            if (count_events_on_day(s_year, s_month, d) > 0) {
-                display_draw_pixel(cx + 8, cy + 6, d == s_selected_day ? COLOR_BLACK : COLOR_WHITE);
-            }
-            
-            col++;
-            if (col > 6) {
-                col = 0;
-                row++;
-            }
+        /* Event indicator */
+        if (count_events_on_day(s_year, s_month, d) > 0) {
+            display_draw_pixel(cx + 8, cy + 6, COLOR_WHITE);
         }
+    }
+}
+
+static void render_month(void)
+{
+    /* Cached unless the month changed or there is no memory for it */
+    int key = s_year * 12 + s_month;
+    if (key != s_month_view_key) {
+        display_surface_invalidate(&s_month_view);
+        s_month_view_key = key;
+    }
+    
+    if (s_month_view.data && !s_month_view.valid &&
+        display_surface_begin(&s_month_view) == ESP_OK) {
+        draw_month(0);
+        display_surface_end();
+    }
+    
+    if (s_month_view.valid) {
+        display_blit_surface(0, MONTH_VIEW_Y, &s_month_view);
+    } else {
+        draw_month(MONTH_VIEW_Y);
+    }
+    
+    /* Selected day: its cell inverted */
+    int cell = day_of_week(s_year, s_month, 1) + s_selected_day - 1;
+    int cx = 2 + (cell % 7) * CELL_W;
+    int cy = MONTH_VIEW_Y + GRID_Y + (cell / 7) * CELL_H;
+    display_fill_rect(cx - 1, cy, CELL_W - 2, CELL_H, COLOR_INVERSE);
+}
+
+static void on_render(void)
+{
+    int y = MONTH_VIEW_Y;
+    
+    if (s_mode == VIEW_MONTH) {
+        render_month();
         
     } else if (s_mode == VIEW_DAY) {
         /* Day header */
@@ -378,36 +422,58 @@ static void on_render(void)
     }
 }
 
+/**
+ * @brief Minute of the day an event's reminder is due, -1 if it has none
+ */
+static int reminder_minute(const calendar_event_t *e)
+{
+    if (e->reminder == 0) return -1;
+    return (e->hour * 60 + e->minute - e->reminder + MINUTES_PER_DAY) % MINUTES_PER_DAY;
+}
+
+/*
+ * Ticks are scheduled for the start of the next reminder's minute. The
+ * status clock counts minutes of esp_timer time, so the wait is the rest of
+ * the current minute plus whole minutes. Reminders are fired for every
+ * minute passed since the last check, which also covers a late wake.
+ */
 static void on_tick(uint32_t dt_ms)
 {
-    /* Check for reminders */
-    static uint32_t check_interval = 0;
-    check_interval += dt_ms;
+    (void)dt_ms;
     
-    if (check_interval >= 60000) {  /* Check every minute */
-        check_interval = 0;
-        
-        const ui_status_t *status = ui_get_status();
-        int now_hour = status->hour;
-        int now_min = status->minute;
+    const ui_status_t *status = ui_get_status();
+    int now_total = status->hour * 60 + status->minute;
+    if (s_reminders_checked < 0) {
+        s_reminders_checked = now_total;
+    }
+    int passed = (now_total - s_reminders_checked + MINUTES_PER_DAY) % MINUTES_PER_DAY;
+    
+    int next = 0;
+    for (int i = 0; i < s_event_count; i++) {
+        int reminder_at = reminder_minute(&s_events[i]);
+        if (reminder_at < 0) continue;
         
-        for (int i = 0; i < s_event_count; i++) {
-            if (s_events[i].reminder > 0) {
-                int event_min = s_events[i].hour * 60 + s_events[i].minute;
-                int now_total = now_hour * 60 + now_min;
-                int reminder_at = event_min - s_events[i].reminder;
-                
-                if (now_total == reminder_at) {
-                    ui_notification_t notif = {
-                        .title = s_events[i].title,
-                        .body = "Reminder",
-                        .priority = UI_NOTIFY_HIGH,
-                        .duration_ms = 10000,
-                    };
-                    ui_notify(&notif);
-                }
-            }
+        int ahead = (reminder_at - s_reminders_checked + MINUTES_PER_DAY) % MINUTES_PER_DAY;
+        if (ahead > 0 && ahead <= passed) {
+            ui_notification_t notif = {
+                .title = s_events[i].title,
+                .body = "Reminder",
+                .priority = UI_NOTIFY_HIGH,
+                .duration_ms = 10000,
+            };
+            ui_notify(&notif);
         }
+        
+        /* Minutes from now to its next reminder, a full day if it is this minute */
+        int wait = (reminder_at - now_total + MINUTES_PER_DAY) % MINUTES_PER_DAY;
+        if (wait == 0) wait = MINUTES_PER_DAY;
+        if (next == 0 || wait < next) next = wait;
+    }
+    s_reminders_checked = now_total;
+    
+    if (next > 0) {
+        uint32_t ms_to_next_minute = 60000 - (uint32_t)(esp_timer_get_time() / 1000 % 60000);
+        ui_schedule_tick(&app_calendar, ms_to_next_minute + (uint32_t)(next - 1) * 60000);
     }
 }
 
@@ -420,7 +486,7 @@ static void on_tick(uint32_t dt_ms)
 const ui_app_t app_calendar = {
     .id = "calendar",
     .name = "Calendar",
-    .icon = ICON_CALENDAR,
+    .sprite = &SPRITE_ICON_CALENDAR,
     .on_enter = on_enter,
     .on_exit = on_exit,
     .on_input = on_input,
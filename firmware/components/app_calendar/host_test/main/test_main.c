@@ -0,0 +1,16 @@
+/**
+ * @file test_main.c
+ * @brief Calendar host tests - entry point
+ *
+ * Built for the linux target; the app draws on the in-memory host display.
+ */
+
+#include <stdlib.h>
+#include "unity.h"
+
+void app_main(void)
+{
+    UNITY_BEGIN();
+    unity_run_all_tests();
+    exit(UNITY_END());
+}
@@ -0,0 +1,174 @@
+/**
+ * @file test_month_view.c
+ * @brief Cached month view against drawing the month directly
+ *
+ * render_month() blits s_month_view when it holds the month and draws it
+ * with draw_month() when there is no memory for it. Both must put the
+ * same pixels on screen, for every month layout and with events shown.
+ * The benchmark times a frame's month view either way.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "unity.h"
+
+/* The month view and its cache are static, so the app is built in here */
+#include "../../app_calendar.c"
+
+#define FRAME_SIZE          (DISPLAY_WIDTH * DISPLAY_HEIGHT / 8)
+#define BENCH_FRAMES        2000
+
+static bool s_started = false;
+
+static void start_display(void)
+{
+    if (s_started) return;
+    
+    display_config_t config = { .type = DISPLAY_TYPE_HOST };
+    TEST_ASSERT_EQUAL(ESP_OK, display_init(&config));
+    s_started = true;
+}
+
+/**
+ * @brief Send the frame drawn so far and copy what reached the panel
+ */
+static void capture(uint8_t *out)
+{
+    display_stats_t stats;
+    
+    display_refresh();
+    for (;;) {
+        display_get_stats(&stats);
+        if (stats.done == stats.queued) break;
+        vTaskDelay(1);
+    }
+    memcpy(out, display_host_framebuffer(), FRAME_SIZE);
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+/**
+ * @brief One frame of the month view, in the viewport the UI gives apps
+ */
+static void render_frame(void)
+{
+    display_clear();
+    display_push_viewport(0, UI_STATUS_BAR_HEIGHT, DISPLAY_WIDTH, UI_CONTENT_HEIGHT);
+    render_month();
+    display_pop_clip();
+}
+
+static void add_event(int year, int month, int day)
+{
+    calendar_event_t *e = &s_events[s_event_count++];
+    memset(e, 0, sizeof(*e));
+    e->year = year;
+    e->month = month;
+    e->day = day;
+}
+
+static void show_month(int year, int month, int selected)
+{
+    s_year = year;
+    s_month = month;
+    s_selected_day = selected;
+}
+
+TEST_CASE("cached month view matches drawing it directly", "[calendar]")
+{
+    static uint8_t direct[FRAME_SIZE];
+    static uint8_t filled[FRAME_SIZE];
+    static uint8_t cached[FRAME_SIZE];
+    
+    start_display();
+    s_event_count = 0;
+    add_event(2025, 1, 1);
+    add_event(2025, 3, 31);
+    add_event(2025, 8, 17);
+    add_event(2024, 2, 29);
+    
+    /* Every first weekday and month length, leap February included */
+    static const int layouts[][2] = {
+        { 2025, 1 }, { 2025, 2 }, { 2025, 3 }, { 2025, 4 }, { 2025, 5 }, { 2025, 6 },
+        { 2025, 7 }, { 2025, 8 }, { 2025, 9 }, { 2025, 10 }, { 2025, 11 }, { 2025, 12 },
+        { 2024, 2 }, { 2026, 2 },
+    };
+    for (size_t i = 0; i < sizeof(layouts) / sizeof(layouts[0]); i++) {
+        char msg[32];
+        int year = layouts[i][0];
+        int month = layouts[i][1];
+        snprintf(msg, sizeof(msg), "%d-%02d", year, month);
+        show_month(year, month, days_in_month(year, month));
+        
+        /* No surface: draw_month() every frame */
+        display_surface_destroy(&s_month_view);
+        render_frame();
+        capture(direct);
+        
+        /* The first frame fills the surface, the next only blits it */
+        TEST_ASSERT_EQUAL(ESP_OK, display_surface_create(&s_month_view, DISPLAY_WIDTH,
+                                                         UI_CONTENT_HEIGHT - MONTH_VIEW_Y));
+        render_frame();
+        capture(filled);
+        TEST_ASSERT_TRUE(s_month_view.valid);
+        render_frame();
+        capture(cached);
+        
+        TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(direct, filled, FRAME_SIZE, msg);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(direct, cached, FRAME_SIZE, msg);
+    }
+    
+    display_surface_destroy(&s_month_view);
+    s_event_count = 0;
+}
+
+TEST_CASE("month view benchmark", "[calendar][bench]")
+{
+    static uint8_t direct[FRAME_SIZE];
+    static uint8_t cached[FRAME_SIZE];
+    
+    start_display();
+    s_event_count = 0;
+    add_event(2025, 3, 4);
+    add_event(2025, 3, 21);
+    show_month(2025, 3, 14);
+    
+    /* Direct: the whole month drawn each frame */
+    display_surface_destroy(&s_month_view);
+    uint64_t t0 = now_ns();
+    for (int i = 0; i < BENCH_FRAMES; i++) {
+        render_frame();
+    }
+    uint64_t t1 = now_ns();
+    capture(direct);
+    
+    /* Cached: filled once, then one blit per frame */
+    TEST_ASSERT_EQUAL(ESP_OK, display_surface_create(&s_month_view, DISPLAY_WIDTH,
+                                                     UI_CONTENT_HEIGHT - MONTH_VIEW_Y));
+    render_frame();
+    uint64_t t2 = now_ns();
+    for (int i = 0; i < BENCH_FRAMES; i++) {
+        render_frame();
+    }
+    uint64_t t3 = now_ns();
+    capture(cached);
+    
+    double direct_ns = (double)(t1 - t0) / BENCH_FRAMES;
+    double cached_ns = (double)(t3 - t2) / BENCH_FRAMES;
+    printf("%-14s %10s\n", "month view", "ns/frame");
+    printf("%-14s %10.1f\n", "draw_month", direct_ns);
+    printf("%-14s %10.1f  %.1fx\n", "s_month_view", cached_ns, direct_ns / cached_ns);
+    
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(direct, cached, FRAME_SIZE);
+    
+    display_surface_destroy(&s_month_view);
+    s_event_count = 0;
+}
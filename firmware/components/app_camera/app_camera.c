@@ -42,12 +42,17 @@ typedef enum {
  * State
  * ============================================================================ */
 
-static view_mode_t s_mode = VIEW_CAMERA;
-static photo_t s_photos[MAX_PHOTOS];
-static int s_photo_count = 0;
-static int s_selected = 0;
-static int s_scroll = 0;
-static int s_next_photo_num = 1;
+/* Gallery state, allocated by the UI while the app is open or warm */
+typedef struct {
+    view_mode_t mode;
+    photo_t photos[MAX_PHOTOS];
+    int photo_count;
+    int selected;
+    int scroll;
+    int next_photo_num;
+} camera_state_t;
+
+static camera_state_t *s_state = NULL;
 
 /* Camera state */
 static bool s_camera_ready = false;
@@ -64,7 +69,7 @@ static void ensure_photos_dir(void)
 
 static void scan_photos(void)
 {
-    s_photo_count = 0;
+    s_state->photo_count = 0;
     ensure_photos_dir();
     
     DIR *dir = opendir(PHOTOS_DIR);
@@ -76,12 +81,12 @@ static void scan_photos(void)
     struct dirent *entry;
     int max_num = 0;
     
-    while ((entry = readdir(dir)) != NULL && s_photo_count < MAX_PHOTOS) {
+    while ((entry = readdir(dir)) != NULL && s_state->photo_count < MAX_PHOTOS) {
         if (entry->d_name[0] == '.') continue;
         
         size_t len = strlen(entry->d_name);
         if (len > 4 && strcasecmp(entry->d_name + len - 4, ".jpg") == 0) {
-            strncpy(s_photos[s_photo_count].filename, entry->d_name, sizeof(s_photos[0].filename) - 1);
+            strncpy(s_state->photos[s_state->photo_count].filename, entry->d_name, sizeof(s_state->photos[0].filename) - 1);
             
             /* Track highest photo number */
             int num = 0;
@@ -89,13 +94,13 @@ static void scan_photos(void)
                 max_num = num;
             }
             
-            s_photo_count++;
+            s_state->photo_count++;
         }
     }
     
     closedir(dir);
-    s_next_photo_num = max_num + 1;
-    ESP_LOGI(TAG, "Found %d photos", s_photo_count);
+    s_state->next_photo_num = max_num + 1;
+    ESP_LOGI(TAG, "Found %d photos", s_state->photo_count);
 }
 
 /* ============================================================================
@@ -130,13 +135,13 @@ static void capture_photo(void)
     }
     
     char filename[48];
-    snprintf(filename, sizeof(filename), "%s/IMG_%04d.jpg", PHOTOS_DIR, s_next_photo_num);
+    snprintf(filename, sizeof(filename), "%s/IMG_%04d.jpg", PHOTOS_DIR, s_state->next_photo_num);
     
     /* TODO: Capture frame and save to SD */
     /* esp_camera_fb_get() -> write to file -> esp_camera_fb_return() */
     
     ESP_LOGI(TAG, "Captured: %s", filename);
-    s_next_photo_num++;
+    s_state->next_photo_num++;
     
     ui_notify_simple("Photo saved!");
     scan_photos();
@@ -144,16 +149,16 @@ static void capture_photo(void)
 
 static void delete_photo(int idx)
 {
-    if (idx < 0 || idx >= s_photo_count) return;
+    if (idx < 0 || idx >= s_state->photo_count) return;
     
     char path[64];
-    snprintf(path, sizeof(path), "%s/%s", PHOTOS_DIR, s_photos[idx].filename);
+    snprintf(path, sizeof(path), "%s/%s", PHOTOS_DIR, s_state->photos[idx].filename);
     
     if (remove(path) == 0) {
-        ESP_LOGI(TAG, "Deleted: %s", s_photos[idx].filename);
+        ESP_LOGI(TAG, "Deleted: %s", s_state->photos[idx].filename);
         scan_photos();
-        if (s_selected >= s_photo_count) {
-            s_selected = s_photo_count > 0 ? s_photo_count - 1 : 0;
+        if (s_state->selected >= s_state->photo_count) {
+            s_state->selected = s_state->photo_count > 0 ? s_state->photo_count - 1 : 0;
         }
     }
 }
@@ -165,9 +170,10 @@ static void delete_photo(int idx)
 static void on_enter(void)
 {
     ESP_LOGI(TAG, "Camera app entered");
+    s_state = ui_app_state(&app_camera);
     init_camera();
     scan_photos();
-    s_mode = VIEW_CAMERA;
+    s_state->mode = VIEW_CAMERA;
 }
 
 static void on_exit(void)
@@ -176,16 +182,22 @@ static void on_exit(void)
     stop_preview();
 }
 
+static void on_evict(void *state)
+{
+    (void)state;
+    s_state = NULL;     /* The photo list is rescanned on entry */
+}
+
 static void on_input(int8_t x, int8_t y, uint8_t buttons)
 {
     static uint32_t last_nav = 0;
     uint32_t now = esp_timer_get_time() / 1000;
     
     if (buttons & UI_BTN_BACK) {
-        if (s_mode == VIEW_PHOTO) {
-            s_mode = VIEW_GALLERY;
-        } else if (s_mode == VIEW_GALLERY) {
-            s_mode = VIEW_CAMERA;
+        if (s_state->mode == VIEW_PHOTO) {
+            s_state->mode = VIEW_GALLERY;
+        } else if (s_state->mode == VIEW_GALLERY) {
+            s_state->mode = VIEW_CAMERA;
             start_preview();
         } else {
             ui_go_back();
@@ -193,7 +205,7 @@ static void on_input(int8_t x, int8_t y, uint8_t buttons)
         return;
     }
     
-    switch (s_mode) {
+    switch (s_state->mode) {
     case VIEW_CAMERA:
         if (buttons & UI_BTN_PRESS) {
             capture_photo();
@@ -201,9 +213,9 @@ static void on_input(int8_t x, int8_t y, uint8_t buttons)
         
         if (buttons & UI_BTN_LONG) {
             stop_preview();
-            s_mode = VIEW_GALLERY;
-            s_selected = 0;
-            s_scroll = 0;
+            s_state->mode = VIEW_GALLERY;
+            s_state->selected = 0;
+            s_state->scroll = 0;
         }
         break;
         
@@ -211,39 +223,39 @@ static void on_input(int8_t x, int8_t y, uint8_t buttons)
         if (now - last_nav > 150) {
             int cols = 3;
             if (x > 30) {
-                s_selected = (s_selected + 1) % (s_photo_count > 0 ? s_photo_count : 1);
+                s_state->selected = (s_state->selected + 1) % (s_state->photo_count > 0 ? s_state->photo_count : 1);
                 last_nav = now;
             } else if (x < -30) {
-                s_selected = (s_selected - 1 + s_photo_count) % (s_photo_count > 0 ? s_photo_count : 1);
+                s_state->selected = (s_state->selected - 1 + s_state->photo_count) % (s_state->photo_count > 0 ? s_state->photo_count : 1);
                 last_nav = now;
-            } else if (y < -30 && s_selected + cols < s_photo_count) {
-                s_selected += cols;
+            } else if (y < -30 && s_state->selected + cols < s_state->photo_count) {
+                s_state->selected += cols;
                 last_nav = now;
-            } else if (y > 30 && s_selected >= cols) {
-                s_selected -= cols;
+            } else if (y > 30 && s_state->selected >= cols) {
+                s_state->selected -= cols;
                 last_nav = now;
             }
         }
         
         if (buttons & UI_BTN_PRESS) {
-            if (s_photo_count > 0) {
-                s_mode = VIEW_PHOTO;
+            if (s_state->photo_count > 0) {
+                s_state->mode = VIEW_PHOTO;
             }
         }
         
         if (buttons & UI_BTN_DOUBLE) {
-            delete_photo(s_selected);
+            delete_photo(s_state->selected);
         }
         break;
         
     case VIEW_PHOTO:
         /* Pan around large image */
         if (buttons & UI_BTN_DOUBLE) {
-            delete_photo(s_selected);
-            if (s_photo_count > 0) {
-                s_mode = VIEW_GALLERY;
+            delete_photo(s_state->selected);
+            if (s_state->photo_count > 0) {
+                s_state->mode = VIEW_GALLERY;
             } else {
-                s_mode = VIEW_CAMERA;
+                s_state->mode = VIEW_CAMERA;
             }
         }
         break;
@@ -252,31 +264,31 @@ static void on_input(int8_t x, int8_t y, uint8_t buttons)
 
 static void on_render(void)
 {
-    int y = UI_STATUS_BAR_HEIGHT + 2;
+    int y = 2;
     
-    switch (s_mode) {
+    switch (s_state->mode) {
     case VIEW_CAMERA:
         if (s_camera_ready) {
             /* TODO: Draw preview frame */
-            display_draw_rect(10, 15, 108, 45, COLOR_WHITE);
-            display_draw_string(35, 35, "Preview", COLOR_WHITE, 1);
+            display_draw_rect(10, 5, 108, 45, COLOR_WHITE);
+            display_draw_string(35, 25, "Preview", COLOR_WHITE, 1);
         } else {
-            display_draw_string(20, 25, "Camera", COLOR_WHITE, 1);
-            display_draw_string(20, 35, "not ready", COLOR_WHITE, 1);
+            display_draw_string(20, 15, "Camera", COLOR_WHITE, 1);
+            display_draw_string(20, 25, "not ready", COLOR_WHITE, 1);
         }
         
-        display_draw_string(2, DISPLAY_HEIGHT - 10, "Press: Photo", COLOR_WHITE, 1);
-        display_draw_string(70, DISPLAY_HEIGHT - 10, "Hold: Gallery", COLOR_WHITE, 1);
+        display_draw_string(2, UI_CONTENT_HEIGHT - 10, "Press: Photo", COLOR_WHITE, 1);
+        display_draw_string(70, UI_CONTENT_HEIGHT - 10, "Hold: Gallery", COLOR_WHITE, 1);
         break;
         
     case VIEW_GALLERY:
         display_draw_string(2, y, "Gallery", COLOR_WHITE, 1);
-        display_printf(60, y, COLOR_WHITE, 1, "(%d)", s_photo_count);
+        display_printf(60, y, COLOR_WHITE, 1, "(%d)", s_state->photo_count);
         display_draw_hline(0, y + 9, DISPLAY_WIDTH, COLOR_WHITE);
         y += 12;
         
-        if (s_photo_count == 0) {
-            display_draw_string(20, 30, "No photos", COLOR_WHITE, 1);
+        if (s_state->photo_count == 0) {
+            display_draw_string(20, 20, "No photos", COLOR_WHITE, 1);
         } else {
             /* Thumbnail grid (3 columns) */
             int cols = 3;
@@ -284,8 +296,8 @@ static void on_render(void)
             int th = 24;
             int gap = 2;
             
-            for (int i = 0; i < 6 && (s_scroll + i) < s_photo_count; i++) {
-                int idx = s_scroll + i;
+            for (int i = 0; i < 6 && (s_state->scroll + i) < s_state->photo_count; i++) {
+                int idx = s_state->scroll + i;
                 int col = i % cols;
                 int row = i / cols;
                 int tx = col * (tw + gap) + 2;
@@ -296,11 +308,11 @@ static void on_render(void)
                 
                 /* Photo number */
                 int num = 0;
-                sscanf(s_photos[idx].filename, "IMG_%d", &num);
+                sscanf(s_state->photos[idx].filename, "IMG_%d", &num);
                 display_printf(tx + 2, ty + 8, COLOR_WHITE, 1, "%d", num);
                 
                 /* Selection highlight */
-                if (idx == s_selected) {
+                if (idx == s_state->selected) {
                     display_draw_rect(tx - 1, ty - 1, tw + 2, th + 2, COLOR_WHITE);
                     display_draw_rect(tx - 2, ty - 2, tw + 4, th + 4, COLOR_WHITE);
                 }
@@ -309,12 +321,12 @@ static void on_render(void)
         break;
         
     case VIEW_PHOTO:
-        if (s_selected >= 0 && s_selected < s_photo_count) {
+        if (s_state->selected >= 0 && s_state->selected < s_state->photo_count) {
             /* TODO: Load and display JPEG (downscaled) */
-            display_draw_rect(0, 12, DISPLAY_WIDTH, 50, COLOR_WHITE);
+            display_draw_rect(0, 2, DISPLAY_WIDTH, 50, COLOR_WHITE);
             
             /* Show filename */
-            display_draw_string(2, DISPLAY_HEIGHT - 10, s_photos[s_selected].filename, COLOR_WHITE, 1);
+            display_draw_string(2, UI_CONTENT_HEIGHT - 10, s_state->photos[s_state->selected].filename, COLOR_WHITE, 1);
         }
         break;
     }
@@ -334,11 +346,13 @@ static void on_tick(uint32_t dt_ms)
 const ui_app_t app_camera = {
     .id = "camera",
     .name = "Camera",
-    .icon = ICON_CAMERA,
+    .sprite = &SPRITE_ICON_CAMERA,
     .on_enter = on_enter,
     .on_exit = on_exit,
     .on_input = on_input,
     .on_render = on_render,
     .on_tick = on_tick,
+    .state_size = sizeof(camera_state_t),
+    .on_evict = on_evict,
 };
 
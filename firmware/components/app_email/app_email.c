@@ -54,12 +54,22 @@ typedef enum {
  * State
  * ============================================================================ */
 
-static view_mode_t s_mode = VIEW_SETUP;
-static email_header_t s_inbox[MAX_EMAILS];
-static int s_inbox_count = 0;
-static int s_selected = 0;
-static int s_scroll = 0;
-static email_t s_current = {0};
+/* Mailbox and compose state, allocated by the UI while the app is open or warm */
+typedef struct {
+    view_mode_t mode;
+    email_header_t inbox[MAX_EMAILS];
+    int inbox_count;
+    int selected;
+    int scroll;
+    email_t current;
+    
+    char compose_to[MAX_ADDR_LEN];
+    char compose_subject[MAX_SUBJECT_LEN];
+    char compose_body[MAX_BODY_LEN];
+    int compose_field;
+} email_state_t;
+
+static email_state_t *s_state = NULL;
 
 /* Account config */
 static bool s_configured = false;
@@ -67,12 +77,6 @@ static char s_email_addr[MAX_ADDR_LEN] = "";
 static char s_imap_server[64] = "";
 static char s_smtp_server[64] = "";
 
-/* Compose state */
-static char s_compose_to[MAX_ADDR_LEN] = "";
-static char s_compose_subject[MAX_SUBJECT_LEN] = "";
-static char s_compose_body[MAX_BODY_LEN] = "";
-static int s_compose_field = 0;
-
 /* Loading state */
 static bool s_loading = false;
 
@@ -102,33 +106,33 @@ static void fetch_inbox(void)
      */
     
     /* Stub: Add demo emails */
-    s_inbox_count = 2;
-    strcpy(s_inbox[0].from, "test@example.com");
-    strcpy(s_inbox[0].subject, "Welcome!");
-    strcpy(s_inbox[0].date, "Nov 30");
-    s_inbox[0].read = false;
+    s_state->inbox_count = 2;
+    strcpy(s_state->inbox[0].from, "test@example.com");
+    strcpy(s_state->inbox[0].subject, "Welcome!");
+    strcpy(s_state->inbox[0].date, "Nov 30");
+    s_state->inbox[0].read = false;
     
-    strcpy(s_inbox[1].from, "news@update.com");
-    strcpy(s_inbox[1].subject, "Daily Update");
-    strcpy(s_inbox[1].date, "Nov 29");
-    s_inbox[1].read = true;
+    strcpy(s_state->inbox[1].from, "news@update.com");
+    strcpy(s_state->inbox[1].subject, "Daily Update");
+    strcpy(s_state->inbox[1].date, "Nov 29");
+    s_state->inbox[1].read = true;
     
     s_loading = false;
 }
 
 static void fetch_email(int idx)
 {
-    if (idx < 0 || idx >= s_inbox_count) return;
+    if (idx < 0 || idx >= s_state->inbox_count) return;
     
     s_loading = true;
     
     /* TODO: FETCH idx+1 BODY[TEXT] */
     
     /* Stub */
-    memcpy(&s_current.header, &s_inbox[idx], sizeof(email_header_t));
-    strcpy(s_current.body, "This is a sample email body.\n\nHello from the ESP32!");
+    memcpy(&s_state->current.header, &s_state->inbox[idx], sizeof(email_header_t));
+    strcpy(s_state->current.body, "This is a sample email body.\n\nHello from the ESP32!");
     
-    s_inbox[idx].read = true;
+    s_state->inbox[idx].read = true;
     s_loading = false;
 }
 
@@ -153,13 +157,13 @@ static void send_email(void)
      * 9. QUIT
      */
     
-    ESP_LOGI(TAG, "Sending to: %s", s_compose_to);
+    ESP_LOGI(TAG, "Sending to: %s", s_state->compose_to);
     ui_notify_simple("Email sent!");
     
     /* Clear compose */
-    s_compose_to[0] = '\0';
-    s_compose_subject[0] = '\0';
-    s_compose_body[0] = '\0';
+    s_state->compose_to[0] = '\0';
+    s_state->compose_subject[0] = '\0';
+    s_state->compose_body[0] = '\0';
 }
 
 /* ============================================================================
@@ -169,21 +173,21 @@ static void send_email(void)
 static void on_to_done(const char *text, bool confirmed)
 {
     if (confirmed && text) {
-        strncpy(s_compose_to, text, MAX_ADDR_LEN - 1);
+        strncpy(s_state->compose_to, text, MAX_ADDR_LEN - 1);
     }
 }
 
 static void on_subject_done(const char *text, bool confirmed)
 {
     if (confirmed && text) {
-        strncpy(s_compose_subject, text, MAX_SUBJECT_LEN - 1);
+        strncpy(s_state->compose_subject, text, MAX_SUBJECT_LEN - 1);
     }
 }
 
 static void on_body_done(const char *text, bool confirmed)
 {
     if (confirmed && text) {
-        strncpy(s_compose_body, text, MAX_BODY_LEN - 1);
+        strncpy(s_state->compose_body, text, MAX_BODY_LEN - 1);
     }
 }
 
@@ -201,13 +205,14 @@ static void on_email_done(const char *text, bool confirmed)
 static void on_enter(void)
 {
     ESP_LOGI(TAG, "Email app entered");
+    s_state = ui_app_state(&app_email);
     load_config();
     
     if (s_configured) {
-        s_mode = VIEW_INBOX;
+        s_state->mode = VIEW_INBOX;
         fetch_inbox();
     } else {
-        s_mode = VIEW_SETUP;
+        s_state->mode = VIEW_SETUP;
     }
 }
 
@@ -216,6 +221,15 @@ static void on_exit(void)
     ESP_LOGI(TAG, "Email app exited");
 }
 
+static void on_evict(void *state)
+{
+    email_state_t *st = state;
+    if (st->compose_to[0] || st->compose_subject[0] || st->compose_body[0]) {
+        ESP_LOGW(TAG, "Unsent draft to %s discarded", st->compose_to);
+    }
+    s_state = NULL;
+}
+
 static void on_input(int8_t x, int8_t y, uint8_t buttons)
 {
     static uint32_t last_nav = 0;
@@ -224,12 +238,12 @@ static void on_input(int8_t x, int8_t y, uint8_t buttons)
     if (s_loading) return;
     
     if (buttons & UI_BTN_BACK) {
-        switch (s_mode) {
+        switch (s_state->mode) {
         case VIEW_READ:
-            s_mode = VIEW_INBOX;
+            s_state->mode = VIEW_INBOX;
             break;
         case VIEW_COMPOSE:
-            s_mode = VIEW_INBOX;
+            s_state->mode = VIEW_INBOX;
             break;
         case VIEW_INBOX:
         case VIEW_SETUP:
@@ -239,7 +253,7 @@ static void on_input(int8_t x, int8_t y, uint8_t buttons)
         return;
     }
     
-    switch (s_mode) {
+    switch (s_state->mode) {
     case VIEW_SETUP:
         if (buttons & UI_BTN_PRESS) {
             ui_osk_config_t osk = {
@@ -255,32 +269,32 @@ static void on_input(int8_t x, int8_t y, uint8_t buttons)
         if (buttons & UI_BTN_LONG) {
             /* Demo mode - skip config */
             s_configured = true;
-            s_mode = VIEW_INBOX;
+            s_state->mode = VIEW_INBOX;
             fetch_inbox();
         }
         break;
         
     case VIEW_INBOX:
         if (now - last_nav > 150) {
-            if (y < -30 && s_selected < s_inbox_count - 1) {
-                s_selected++;
+            if (y < -30 && s_state->selected < s_state->inbox_count - 1) {
+                s_state->selected++;
                 last_nav = now;
-            } else if (y > 30 && s_selected > 0) {
-                s_selected--;
+            } else if (y > 30 && s_state->selected > 0) {
+                s_state->selected--;
                 last_nav = now;
             }
         }
         
         if (buttons & UI_BTN_PRESS) {
-            if (s_inbox_count > 0) {
-                fetch_email(s_selected);
-                s_mode = VIEW_READ;
+            if (s_state->inbox_count > 0) {
+                fetch_email(s_state->selected);
+                s_state->mode = VIEW_READ;
             }
         }
         
         if (buttons & UI_BTN_LONG) {
-            s_mode = VIEW_COMPOSE;
-            s_compose_field = 0;
+            s_state->mode = VIEW_COMPOSE;
+            s_state->compose_field = 0;
         }
         
         if (buttons & UI_BTN_DOUBLE) {
@@ -292,31 +306,31 @@ static void on_input(int8_t x, int8_t y, uint8_t buttons)
         /* Scroll body */
         if (now - last_nav > 150) {
             if (y < -30) {
-                s_scroll++;
+                s_state->scroll++;
                 last_nav = now;
-            } else if (y > 30 && s_scroll > 0) {
-                s_scroll--;
+            } else if (y > 30 && s_state->scroll > 0) {
+                s_state->scroll--;
                 last_nav = now;
             }
         }
         
         if (buttons & UI_BTN_LONG) {
             /* Reply */
-            snprintf(s_compose_to, MAX_ADDR_LEN, "%s", s_current.header.from);
-            snprintf(s_compose_subject, MAX_SUBJECT_LEN, "Re: %s", s_current.header.subject);
-            s_compose_body[0] = '\0';
-            s_mode = VIEW_COMPOSE;
-            s_compose_field = 2;  /* Jump to body */
+            snprintf(s_state->compose_to, MAX_ADDR_LEN, "%s", s_state->current.header.from);
+            snprintf(s_state->compose_subject, MAX_SUBJECT_LEN, "Re: %s", s_state->current.header.subject);
+            s_state->compose_body[0] = '\0';
+            s_state->mode = VIEW_COMPOSE;
+            s_state->compose_field = 2;  /* Jump to body */
         }
         break;
         
     case VIEW_COMPOSE:
         if (now - last_nav > 150) {
-            if (y < -30 && s_compose_field < 3) {
-                s_compose_field++;
+            if (y < -30 && s_state->compose_field < 3) {
+                s_state->compose_field++;
                 last_nav = now;
-            } else if (y > 30 && s_compose_field > 0) {
-                s_compose_field--;
+            } else if (y > 30 && s_state->compose_field > 0) {
+                s_state->compose_field--;
                 last_nav = now;
             }
         }
@@ -324,28 +338,28 @@ static void on_input(int8_t x, int8_t y, uint8_t buttons)
         if (buttons & UI_BTN_PRESS) {
             ui_osk_config_t osk = {0};
             
-            switch (s_compose_field) {
+            switch (s_state->compose_field) {
             case 0:
                 osk.title = "To:";
-                osk.initial_text = s_compose_to;
+                osk.initial_text = s_state->compose_to;
                 osk.max_length = MAX_ADDR_LEN - 1;
                 osk.callback = on_to_done;
                 break;
             case 1:
                 osk.title = "Subject:";
-                osk.initial_text = s_compose_subject;
+                osk.initial_text = s_state->compose_subject;
                 osk.max_length = MAX_SUBJECT_LEN - 1;
                 osk.callback = on_subject_done;
                 break;
             case 2:
                 osk.title = "Body:";
-                osk.initial_text = s_compose_body;
+                osk.initial_text = s_state->compose_body;
                 osk.max_length = MAX_BODY_LEN - 1;
                 osk.callback = on_body_done;
                 break;
             case 3:
                 send_email();
-                s_mode = VIEW_INBOX;
+                s_state->mode = VIEW_INBOX;
                 return;
             }
             
@@ -357,14 +371,14 @@ static void on_input(int8_t x, int8_t y, uint8_t buttons)
 
 static void on_render(void)
 {
-    int y = UI_STATUS_BAR_HEIGHT + 2;
+    int y = 2;
     
     if (s_loading) {
-        display_draw_string(40, 30, "Loading...", COLOR_WHITE, 1);
+        display_draw_string(40, 20, "Loading...", COLOR_WHITE, 1);
         return;
     }
     
-    switch (s_mode) {
+    switch (s_state->mode) {
     case VIEW_SETUP:
         display_draw_string(2, y, "Email Setup", COLOR_WHITE, 1);
         display_draw_hline(0, y + 9, DISPLAY_WIDTH, COLOR_WHITE);
@@ -379,24 +393,24 @@ static void on_render(void)
         
     case VIEW_INBOX:
         display_draw_string(2, y, "Inbox", COLOR_WHITE, 1);
-        display_printf(50, y, COLOR_WHITE, 1, "(%d)", s_inbox_count);
+        display_printf(50, y, COLOR_WHITE, 1, "(%d)", s_state->inbox_count);
         display_draw_hline(0, y + 9, DISPLAY_WIDTH, COLOR_WHITE);
         y += 12;
         
-        if (s_inbox_count == 0) {
+        if (s_state->inbox_count == 0) {
             display_draw_string(2, y, "No emails", COLOR_WHITE, 1);
             display_draw_string(2, y + 12, "Double: Refresh", COLOR_WHITE, 1);
         } else {
-            int visible = (DISPLAY_HEIGHT - y) / 12;
+            int visible = (UI_CONTENT_HEIGHT - y) / 12;
             
-            for (int i = 0; i < visible && i < s_inbox_count; i++) {
+            for (int i = 0; i < visible && i < s_state->inbox_count; i++) {
                 int item_y = y + i * 12;
-                email_header_t *h = &s_inbox[i];
+                email_header_t *h = &s_state->inbox[i];
                 
                 /* Unread indicator */
                 const char *indicator = h->read ? " " : "*";
                 
-                if (i == s_selected) {
+                if (i == s_state->selected) {
                     display_fill_rect(0, item_y, DISPLAY_WIDTH, 11, COLOR_WHITE);
                     display_printf(2, item_y + 1, COLOR_BLACK, 1, "%s%.16s", indicator, h->subject);
                 } else {
@@ -408,25 +422,25 @@ static void on_render(void)
         
     case VIEW_READ:
         /* Header */
-        display_printf(2, y, COLOR_WHITE, 1, "From: %.14s", s_current.header.from);
+        display_printf(2, y, COLOR_WHITE, 1, "From: %.14s", s_state->current.header.from);
         y += 10;
-        display_printf(2, y, COLOR_WHITE, 1, "Subj: %.14s", s_current.header.subject);
+        display_printf(2, y, COLOR_WHITE, 1, "Subj: %.14s", s_state->current.header.subject);
         y += 10;
         display_draw_hline(0, y, DISPLAY_WIDTH, COLOR_WHITE);
         y += 2;
         
         /* Body (scrollable) */
         int chars_per_line = 20;
-        int lines_visible = (DISPLAY_HEIGHT - y) / 9;
+        int lines_visible = (UI_CONTENT_HEIGHT - y) / 9;
         
         for (int i = 0; i < lines_visible; i++) {
-            int line_idx = s_scroll + i;
+            int line_idx = s_state->scroll + i;
             int offset = line_idx * chars_per_line;
             
-            if (offset >= (int)strlen(s_current.body)) break;
+            if (offset >= (int)strlen(s_state->current.body)) break;
             
             char line[21];
-            strncpy(line, &s_current.body[offset], 20);
+            strncpy(line, &s_state->current.body[offset], 20);
             line[20] = '\0';
             display_draw_string(2, y + i * 9, line, COLOR_WHITE, 1);
         }
@@ -438,34 +452,34 @@ static void on_render(void)
         y += 12;
         
         /* To field */
-        if (s_compose_field == 0) {
+        if (s_state->compose_field == 0) {
             display_fill_rect(0, y, DISPLAY_WIDTH, 10, COLOR_WHITE);
-            display_printf(2, y + 1, COLOR_BLACK, 1, "To: %.16s", s_compose_to[0] ? s_compose_to : "...");
+            display_printf(2, y + 1, COLOR_BLACK, 1, "To: %.16s", s_state->compose_to[0] ? s_state->compose_to : "...");
         } else {
-            display_printf(2, y + 1, COLOR_WHITE, 1, "To: %.16s", s_compose_to[0] ? s_compose_to : "...");
+            display_printf(2, y + 1, COLOR_WHITE, 1, "To: %.16s", s_state->compose_to[0] ? s_state->compose_to : "...");
         }
         y += 11;
         
         /* Subject */
-        if (s_compose_field == 1) {
+        if (s_state->compose_field == 1) {
             display_fill_rect(0, y, DISPLAY_WIDTH, 10, COLOR_WHITE);
-            display_printf(2, y + 1, COLOR_BLACK, 1, "Subj: %.14s", s_compose_subject[0] ? s_compose_subject : "...");
+            display_printf(2, y + 1, COLOR_BLACK, 1, "Subj: %.14s", s_state->compose_subject[0] ? s_state->compose_subject : "...");
         } else {
-            display_printf(2, y + 1, COLOR_WHITE, 1, "Subj: %.14s", s_compose_subject[0] ? s_compose_subject : "...");
+            display_printf(2, y + 1, COLOR_WHITE, 1, "Subj: %.14s", s_state->compose_subject[0] ? s_state->compose_subject : "...");
         }
         y += 11;
         
         /* Body preview */
-        if (s_compose_field == 2) {
+        if (s_state->compose_field == 2) {
             display_fill_rect(0, y, DISPLAY_WIDTH, 10, COLOR_WHITE);
-            display_printf(2, y + 1, COLOR_BLACK, 1, "Body: %.14s", s_compose_body[0] ? s_compose_body : "...");
+            display_printf(2, y + 1, COLOR_BLACK, 1, "Body: %.14s", s_state->compose_body[0] ? s_state->compose_body : "...");
         } else {
-            display_printf(2, y + 1, COLOR_WHITE, 1, "Body: %.14s", s_compose_body[0] ? s_compose_body : "...");
+            display_printf(2, y + 1, COLOR_WHITE, 1, "Body: %.14s", s_state->compose_body[0] ? s_state->compose_body : "...");
         }
         y += 11;
         
         /* Send button */
-        if (s_compose_field == 3) {
+        if (s_state->compose_field == 3) {
             display_fill_rect(40, y, 48, 12, COLOR_WHITE);
             display_draw_string(50, y + 2, "SEND", COLOR_BLACK, 1);
         } else {
@@ -488,11 +502,13 @@ static void on_tick(uint32_t dt_ms)
 const ui_app_t app_email = {
     .id = "email",
     .name = "Email",
-    .icon = ICON_EMAIL,
+    .sprite = &SPRITE_ICON_EMAIL,
     .on_enter = on_enter,
     .on_exit = on_exit,
     .on_input = on_input,
     .on_render = on_render,
     .on_tick = on_tick,
+    .state_size = sizeof(email_state_t),
+    .on_evict = on_evict,
 };
 
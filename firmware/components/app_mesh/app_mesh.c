@@ -21,6 +21,7 @@ static const char *TAG = "mesh_app";
 #define MAX_CONVERSATIONS 16
 #define MAX_MESSAGES 32
 #define MSG_DISPLAY_LEN 18
+#define MSG_LINE_HEIGHT 12
 
 /* ============================================================================
  * Types
@@ -70,6 +71,17 @@ static char s_compose_to[MESH_NODE_ID_LEN] = "^all";
  * Helpers
  * ============================================================================ */
 
+/**
+ * @brief Lock panel RAM rows to thread lines
+ *
+ * With the hardware scroll following the message scroll, a one-line step
+ * only sends the newly exposed message and the fixed name row.
+ */
+static void sync_hw_scroll(void)
+{
+    display_set_scroll(s_mode == VIEW_THREAD ? s_msg_scroll * MSG_LINE_HEIGHT : 0);
+}
+
 static conversation_t *find_conversation(const char *node_id)
 {
     for (int i = 0; i < s_convo_count; i++) {
@@ -148,6 +160,7 @@ static void on_compose_done(const char *text, bool confirmed)
     }
     
     s_mode = VIEW_THREAD;
+    sync_hw_scroll();
 }
 
 /* ============================================================================
@@ -166,6 +179,7 @@ static void on_enter(void)
         conversation_t *c = add_conversation("^all", "Broadcast");
         if (c) c->unread = 0;
     }
+    sync_hw_scroll();
 }
 
 static void on_exit(void)
@@ -186,6 +200,7 @@ static void on_input(int8_t x, int8_t y, uint8_t buttons)
         } else {
             ui_go_back();
         }
+        sync_hw_scroll();
         return;
     }
     
@@ -250,11 +265,13 @@ static void on_input(int8_t x, int8_t y, uint8_t buttons)
     default:
         break;
     }
+    
+    sync_hw_scroll();
 }
 
 static void on_render(void)
 {
-    int y = UI_STATUS_BAR_HEIGHT + 2;
+    int y = 2;
     
     switch (s_mode) {
     case VIEW_CONVERSATIONS:
@@ -267,7 +284,7 @@ static void on_render(void)
             display_draw_string(2, y, "No messages", COLOR_WHITE, 1);
             display_draw_string(2, y + 12, "Long: Nodes", COLOR_WHITE, 1);
         } else {
-            int visible = (DISPLAY_HEIGHT - y) / 12;
+            int visible = (UI_CONTENT_HEIGHT - y) / 12;
             
             for (int i = 0; i < visible && (s_scroll + i) < s_convo_count; i++) {
                 int idx = s_scroll + i;
@@ -307,11 +324,11 @@ static void on_render(void)
                 display_draw_string(2, y, "No messages", COLOR_WHITE, 1);
                 display_draw_string(2, y + 12, "Press: Compose", COLOR_WHITE, 1);
             } else {
-                int visible = (DISPLAY_HEIGHT - y) / 12;
+                int visible = (UI_CONTENT_HEIGHT - y) / MSG_LINE_HEIGHT;
                 
                 for (int i = 0; i < visible && (s_msg_scroll + i) < s_msg_count; i++) {
                     int idx = s_msg_scroll + i;
-                    int item_y = y + i * 12;
+                    int item_y = y + i * MSG_LINE_HEIGHT;
                     
                     /* Direction indicator */
                     const char *prefix = s_messages[idx].is_outgoing ? ">" : "<";
@@ -380,7 +397,7 @@ void app_mesh_on_message(const mesh_message_t *msg)
 const ui_app_t app_mesh = {
     .id = "mesh",
     .name = "Messages",
-    .icon = ICON_MESH,
+    .sprite = &SPRITE_ICON_MESH,
     .on_enter = on_enter,
     .on_exit = on_exit,
     .on_input = on_input,
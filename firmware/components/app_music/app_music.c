@@ -55,6 +55,7 @@ static int s_scroll = 0;
 static bool s_playing = false;
 static int s_current_track = -1;
 static uint32_t s_position_sec = 0;
+static uint32_t s_position_ms = 0;      /* Into the current second */
 static uint8_t s_volume = 80;
 
 /* ============================================================================
@@ -108,7 +109,9 @@ static void start_playback(int track_idx)
     
     s_current_track = track_idx;
     s_position_sec = 0;
+    s_position_ms = 0;
     s_playing = true;
+    ui_schedule_tick(&app_music, 1000);
     
     /* TODO: Initialize I2S and start MP3 decoder task */
     ESP_LOGI(TAG, "Playing: %s", s_tracks[track_idx].title);
@@ -123,6 +126,7 @@ static void stop_playback(void)
 {
     s_playing = false;
     s_position_sec = 0;
+    ui_cancel_tick(&app_music);
     
     /* TODO: Stop I2S and decoder task */
     
@@ -134,6 +138,7 @@ static void stop_playback(void)
 static void pause_playback(void)
 {
     s_playing = false;
+    ui_cancel_tick(&app_music);
     /* TODO: Pause I2S output */
 }
 
@@ -141,6 +146,7 @@ static void resume_playback(void)
 {
     if (s_current_track >= 0) {
         s_playing = true;
+        ui_schedule_tick(&app_music, 1000 - s_position_ms);
         /* TODO: Resume I2S output */
     }
 }
@@ -282,7 +288,7 @@ static void on_input(int8_t x, int8_t y, uint8_t buttons)
 
 static void on_render(void)
 {
-    int y = UI_STATUS_BAR_HEIGHT + 2;
+    int y = 2;
     
     if (s_mode == VIEW_BROWSER) {
         display_draw_string(2, y, "Music", COLOR_WHITE, 1);
@@ -294,7 +300,7 @@ static void on_render(void)
             display_draw_string(2, y, "No music found", COLOR_WHITE, 1);
             display_draw_string(2, y + 12, "Add to /music/", COLOR_WHITE, 1);
         } else {
-            int visible = (DISPLAY_HEIGHT - y) / 12;
+            int visible = (UI_CONTENT_HEIGHT - y) / 12;
             
             for (int i = 0; i < visible && (s_scroll + i) < s_track_count; i++) {
                 int idx = s_scroll + i;
@@ -353,31 +359,36 @@ static void on_render(void)
             display_draw_string(state_x, y, state, COLOR_WHITE, 1);
             
             /* Volume bar at bottom */
-            display_printf(2, DISPLAY_HEIGHT - 10, COLOR_WHITE, 1, "Vol:%d%%", s_volume);
-            display_draw_progress(50, DISPLAY_HEIGHT - 10, 60, 6, s_volume);
+            display_printf(2, UI_CONTENT_HEIGHT - 10, COLOR_WHITE, 1, "Vol:%d%%", s_volume);
+            display_draw_progress(50, UI_CONTENT_HEIGHT - 10, 60, 6, s_volume);
         }
     }
 }
 
 static void on_tick(uint32_t dt_ms)
 {
-    static uint32_t accum = 0;
+    if (!s_playing) return;
     
-    if (s_playing) {
-        accum += dt_ms;
-        if (accum >= 1000) {
-            s_position_sec++;
-            accum -= 1000;
-            
-            /* Check for end of track */
-            if (s_current_track >= 0 && s_current_track < s_track_count) {
-                track_t *t = &s_tracks[s_current_track];
-                if (t->duration_sec > 0 && s_position_sec >= t->duration_sec) {
-                    next_track();
-                }
+    s_position_ms += dt_ms;
+    while (s_position_ms >= 1000) {
+        s_position_sec++;
+        s_position_ms -= 1000;
+        if (ui_is_app_focused(&app_music)) {
+            ui_invalidate();    /* Position readout */
+        }
+        
+        /* Check for end of track */
+        if (s_current_track >= 0 && s_current_track < s_track_count) {
+            track_t *t = &s_tracks[s_current_track];
+            if (t->duration_sec > 0 && s_position_sec >= t->duration_sec) {
+                next_track();
+                return;
             }
         }
     }
+    
+    /* Next second of the position readout */
+    ui_schedule_tick(&app_music, 1000 - s_position_ms);
 }
 
 /* ============================================================================
@@ -387,7 +398,7 @@ static void on_tick(uint32_t dt_ms)
 const ui_app_t app_music = {
     .id = "music",
     .name = "Music",
-    .icon = ICON_MUSIC,
+    .sprite = &SPRITE_ICON_MUSIC,
     .on_enter = on_enter,
     .on_exit = on_exit,
     .on_input = on_input,
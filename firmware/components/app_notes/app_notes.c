@@ -7,6 +7,7 @@
 #include "ui.h"
 #include "display.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include <string.h>
 #include <stdio.h>
 #include <dirent.h>
@@ -23,6 +24,8 @@ static const char *TAG = "notes";
 #define MAX_NOTE_SIZE 2048
 #define MAX_LINES 256
 #define LINE_HEIGHT 10
+#define CONTENT_Y 14        /* Below the title bar */
+#define VISIBLE_LINES ((UI_CONTENT_HEIGHT - CONTENT_Y) / LINE_HEIGHT)
 
 /* ============================================================================
  * State
@@ -52,6 +55,18 @@ static int s_cursor_col = 0;
 static int s_view_scroll = 0;
 static char s_current_file[64] = "";
 
+/**
+ * @brief Lock panel RAM rows to list/text lines
+ *
+ * With the hardware scroll following the line scroll, a one-line step
+ * only sends the newly exposed line and the fixed title rows.
+ */
+static void sync_hw_scroll(void)
+{
+    int scroll = s_mode == VIEW_EDIT ? s_view_scroll : s_scroll;
+    display_set_scroll(scroll * LINE_HEIGHT);
+}
+
 /* ============================================================================
  * File Operations
  * ============================================================================ */
@@ -149,6 +164,7 @@ static void create_new_note(const char *name)
     s_cursor_col = 0;
     s_view_scroll = 0;
     s_mode = VIEW_EDIT;
+    sync_hw_scroll();
     
     save_note();  /* Create empty file */
     scan_notes();
@@ -304,6 +320,7 @@ static void on_enter(void)
     s_selected = 0;
     s_scroll = 0;
     scan_notes();
+    sync_hw_scroll();
 }
 
 static void on_exit(void)
@@ -324,6 +341,7 @@ static void on_input(int8_t x, int8_t y, uint8_t buttons)
             save_note();
             s_mode = VIEW_LIST;
             scan_notes();
+            sync_hw_scroll();
         } else {
             ui_go_back();
         }
@@ -369,6 +387,13 @@ static void on_input(int8_t x, int8_t y, uint8_t buttons)
             }
         }
         
+        /* Update scroll to keep selection visible */
+        if (s_selected < s_scroll) {
+            s_scroll = s_selected;
+        } else if (s_selected >= s_scroll + VISIBLE_LINES) {
+            s_scroll = s_selected - VISIBLE_LINES + 1;
+        }
+        
     } else {
         /* Editor navigation/input */
         if (now - last_nav > 80) {
@@ -400,18 +425,19 @@ static void on_input(int8_t x, int8_t y, uint8_t buttons)
         }
         
         /* Update scroll to keep cursor visible */
-        int visible_lines = (DISPLAY_HEIGHT - UI_STATUS_BAR_HEIGHT - 14) / LINE_HEIGHT;
         if (s_cursor_line < s_view_scroll) {
             s_view_scroll = s_cursor_line;
-        } else if (s_cursor_line >= s_view_scroll + visible_lines) {
-            s_view_scroll = s_cursor_line - visible_lines + 1;
+        } else if (s_cursor_line >= s_view_scroll + VISIBLE_LINES) {
+            s_view_scroll = s_cursor_line - VISIBLE_LINES + 1;
         }
     }
+    
+    sync_hw_scroll();
 }
 
 static void on_render(void)
 {
-    int y = UI_STATUS_BAR_HEIGHT + 2;
+    int y = 2;
     
     if (s_mode == VIEW_LIST) {
         /* Title */
@@ -424,7 +450,7 @@ static void on_render(void)
             display_draw_string(2, y, "No notes", COLOR_WHITE, 1);
             display_draw_string(2, y + 12, "Long press: New", COLOR_WHITE, 1);
         } else {
-            int visible = (DISPLAY_HEIGHT - y) / LINE_HEIGHT;
+            int visible = (UI_CONTENT_HEIGHT - y) / LINE_HEIGHT;
             
             for (int i = 0; i < visible && (s_scroll + i) < s_note_count; i++) {
                 int idx = s_scroll + i;
@@ -460,7 +486,7 @@ static void on_render(void)
         y += 12;
         
         /* Text content */
-        int visible_lines = (DISPLAY_HEIGHT - y) / LINE_HEIGHT;
+        int visible_lines = (UI_CONTENT_HEIGHT - y) / LINE_HEIGHT;
         int line = 0;
         int pos = 0;
         int line_start = 0;
@@ -519,7 +545,7 @@ static void on_tick(uint32_t dt_ms)
 const ui_app_t app_notes = {
     .id = "notes",
     .name = "Notes",
-    .icon = ICON_NOTES,
+    .sprite = &SPRITE_ICON_NOTES,
     .on_enter = on_enter,
     .on_exit = on_exit,
     .on_input = on_input,
@@ -5,9 +5,10 @@
 
 #include "app_settings.h"
 #include "ui.h"
+#include "ui_perf.h"
 #include "display.h"
+#include "control_link.h"
 #include "esp_log.h"
-#include "esp_wifi.h"
 #include "nvs_flash.h"
 #include "nvs.h"
 #include <string.h>
@@ -188,6 +189,15 @@ static void on_input(int8_t x, int8_t y, uint8_t buttons)
         }
         break;
         
+    case MENU_ABOUT:
+        /* Frame timings to the serial console */
+        if (buttons & UI_BTN_PRESS) {
+            ui_perf_dump_csv();
+        } else if (buttons & UI_BTN_LONG) {
+            ui_perf_reset();
+        }
+        break;
+    
     default:
         /* Other menus - just navigate */
         break;
@@ -196,7 +206,7 @@ static void on_input(int8_t x, int8_t y, uint8_t buttons)
 
 static void on_render(void)
 {
-    int y = UI_STATUS_BAR_HEIGHT + 2;
+    int y = 2;
     
     /* Title */
     const char *title = "Settings";
@@ -216,7 +226,7 @@ static void on_render(void)
     
     switch (s_menu_level) {
     case MENU_MAIN:
-        ui_draw_menu_list(0, y, DISPLAY_WIDTH, DISPLAY_HEIGHT - y,
+        ui_draw_menu_list(0, y, DISPLAY_WIDTH, UI_CONTENT_HEIGHT - y,
                           main_menu, MAIN_MENU_COUNT, s_selected, s_scroll);
         break;
         
@@ -250,6 +260,14 @@ static void on_render(void)
     case MENU_STORAGE:
         display_draw_string(2, y, "SD Card: ", COLOR_WHITE, 1);
         display_draw_string(60, y, "Not mounted", COLOR_WHITE, 1);
+        {
+            ui_app_mem_stats_t mem;
+            ui_get_app_mem_stats(&mem);
+            display_printf(2, y + 12, COLOR_WHITE, 1, "App RAM: %lu/%luK",
+                           (unsigned long)(mem.resident + 1023) / 1024,
+                           (unsigned long)mem.budget / 1024);
+            display_printf(2, y + 22, COLOR_WHITE, 1, "Warm: %lu", (unsigned long)mem.warm);
+        }
         break;
         
     case MENU_DATETIME:
@@ -264,6 +282,13 @@ static void on_render(void)
         display_draw_string(2, y, "Smart Device", COLOR_WHITE, 1);
         display_draw_string(2, y + 10, "Version: 0.1.0", COLOR_WHITE, 1);
         display_draw_string(2, y + 20, "ESP32-WROVER", COLOR_WHITE, 1);
+        {
+            ui_perf_hist_t frame;
+            if (ui_perf_get(UI_PERF_FRAME, &frame) && frame.count) {
+                display_printf(2, y + 30, COLOR_WHITE, 1, "Frame p95 %luus",
+                               (unsigned long)ui_perf_percentile(&frame, 95));
+            }
+        }
         break;
     }
 }
@@ -283,7 +308,7 @@ static void on_tick(uint32_t dt_ms)
 const ui_app_t app_settings = {
     .id = "settings",
     .name = "Settings",
-    .icon = ICON_SETTINGS,
+    .sprite = &SPRITE_ICON_SETTINGS,
     .on_enter = on_enter,
     .on_exit = on_exit,
     .on_input = on_input,
@@ -382,13 +382,13 @@ static void on_input(int8_t x, int8_t y, uint8_t buttons)
 
 static void on_render(void)
 {
-    int y = UI_STATUS_BAR_HEIGHT + 2;
+    int y = 2;
     
     if (s_won) {
-        display_draw_string(30, 25, "YOU WIN!", COLOR_WHITE, 1);
+        display_draw_string(30, 15, "YOU WIN!", COLOR_WHITE, 1);
         uint32_t elapsed = (esp_timer_get_time() / 1000000) - s_start_time;
-        display_printf(20, 40, COLOR_WHITE, 1, "Time: %d:%02d", elapsed / 60, elapsed % 60);
-        display_printf(20, 52, COLOR_WHITE, 1, "Moves: %d", s_moves);
+        display_printf(20, 30, COLOR_WHITE, 1, "Time: %d:%02d", elapsed / 60, elapsed % 60);
+        display_printf(20, 42, COLOR_WHITE, 1, "Moves: %d", s_moves);
         return;
     }
     
@@ -491,7 +491,7 @@ static void on_tick(uint32_t dt_ms)
 const ui_app_t app_solitaire = {
     .id = "solitaire",
     .name = "Cards",
-    .icon = ICON_SOLITAIRE,
+    .sprite = &SPRITE_ICON_SOLITAIRE,
     .on_enter = on_enter,
     .on_exit = on_exit,
     .on_input = on_input,
@@ -91,6 +91,7 @@ static void on_input_done(const char *text, bool confirmed)
         
         /* TODO: Make HTTP request to translation API */
         /* For now, simulate with placeholder */
+        ui_schedule_tick(&app_translate, 1000);
     }
 }
 
@@ -271,7 +272,7 @@ static void on_input(int8_t x, int8_t y, uint8_t buttons)
 
 static void on_render(void)
 {
-    int y = UI_STATUS_BAR_HEIGHT + 2;
+    int y = 2;
     
     switch (s_mode) {
     case VIEW_MAIN:
@@ -322,7 +323,7 @@ static void on_render(void)
             display_printf(2, y + 1, COLOR_WHITE, 1, "History (%d)", s_history_count);
         }
         
-        display_draw_string(2, DISPLAY_HEIGHT - 10, "Hold: Swap langs", COLOR_WHITE, 1);
+        display_draw_string(2, UI_CONTENT_HEIGHT - 10, "Hold: Swap langs", COLOR_WHITE, 1);
         break;
         
     case VIEW_SELECT_SRC:
@@ -345,8 +346,8 @@ static void on_render(void)
         break;
         
     case VIEW_TRANSLATING:
-        display_draw_string(30, 25, "Translating", COLOR_WHITE, 1);
-        display_draw_string(45, 40, "...", COLOR_WHITE, 1);
+        display_draw_string(30, 15, "Translating", COLOR_WHITE, 1);
+        display_draw_string(45, 30, "...", COLOR_WHITE, 1);
         break;
         
     case VIEW_RESULT:
@@ -400,15 +401,12 @@ static void on_render(void)
 
 static void on_tick(uint32_t dt_ms)
 {
+    (void)dt_ms;
+    
+    /* Simulated translation delay is over */
     if (s_translating) {
-        static uint32_t accum = 0;
-        accum += dt_ms;
-        
-        /* Simulate translation delay */
-        if (accum >= 1000) {
-            accum = 0;
-            do_translation();
-        }
+        do_translation();
+        ui_invalidate();
     }
 }
 
@@ -419,7 +417,7 @@ static void on_tick(uint32_t dt_ms)
 const ui_app_t app_translate = {
     .id = "translate",
     .name = "Translate",
-    .icon = ICON_TRANSLATE,
+    .sprite = &SPRITE_ICON_TRANSLATE,
     .on_enter = on_enter,
     .on_exit = on_exit,
     .on_input = on_input,
@@ -4,10 +4,16 @@
  */
 
 #include "control_link.h"
+#include "link_params.h"
+#include "link_reconnect.h"
 
 #include "esp_event.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
 #include "nvs_flash.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 
 #include "nimble/nimble_port.h"
 #include "nimble/nimble_port_freertos.h"
@@ -15,6 +21,9 @@
 #include "host/util/util.h"
 #include "services/gap/ble_svc_gap.h"
 
+#include <stdio.h>
+#include <string.h>
+
 ESP_EVENT_DEFINE_BASE(CONTROL_LINK_EVENT);
 
 static const char *TAG = "control_link";
@@ -22,40 +31,235 @@ static const char *TAG = "control_link";
 /* Partner device name to scan for */
 #define PARTNER_DEVICE_NAME     "TransPartner"
 
-/* Remote Input Service UUID: 4f9a0001-8c3f-4a0e-89a7-6d277cf9a000 */
-static const ble_uuid128_t remote_input_svc_uuid = BLE_UUID128_INIT(
-    0x00, 0xa0, 0xf9, 0x7c, 0x27, 0x6d, 0xa7, 0x89,
-    0x0e, 0x4a, 0x3f, 0x8c, 0x01, 0x00, 0x9a, 0x4f
-);
+/* Partner UUIDs are 4f9a00XX-8c3f-4a0e-89a7-6d277cf9a000 */
+#define PARTNER_UUID(id)        BLE_UUID128_INIT(0x00, 0xa0, 0xf9, 0x7c, 0x27, 0x6d, 0xa7, 0x89, \
+                                                 0x0e, 0x4a, 0x3f, 0x8c, (id), 0x00, 0x9a, 0x4f)
+
+/*
+ * Partner GATT database. One discovery pass resolves every characteristic
+ * of the three services and their CCCDs; the ones something here consumes
+ * are then subscribed. The table is cached in NVS per partner address
+ * along with the partner's GATT database hash, so reconnecting to an
+ * unchanged partner only reads the hash. A partner without a hash is
+ * trusted on its address alone, and a failed subscription sends it back
+ * through discovery. Discovery that fails drops the link, so the next
+ * connection starts it over.
+ */
+typedef enum {
+    SVC_MESH_RELAY,
+    SVC_REMOTE_INPUT,
+    SVC_COMMAND_SYNC,
+    SVC_COUNT,
+} partner_svc_t;
+
+typedef enum {
+    ATTR_MESH_INBOX,
+    ATTR_MESH_SEND,
+    ATTR_MESH_STATUS,
+    ATTR_MESH_NODE_LIST,
+    ATTR_JOYSTICK,
+    ATTR_KEYPAD,
+    ATTR_COMMAND,
+    ATTR_ACK,
+    ATTR_HEARTBEAT,
+    ATTR_COUNT,
+} partner_attr_t;
+
+#define CCCD_NOTIFY             0x0001
+#define CCCD_INDICATE           0x0002
+
+static const ble_uuid128_t s_svc_uuids[SVC_COUNT] = {
+    [SVC_MESH_RELAY] = PARTNER_UUID(0x30),
+    [SVC_REMOTE_INPUT] = PARTNER_UUID(0x01),
+    [SVC_COMMAND_SYNC] = PARTNER_UUID(0x20),
+};
+
+static const struct {
+    ble_uuid128_t uuid;
+    partner_svc_t svc;
+    uint16_t subscribe;                 /* CCCD value to write, 0 = none */
+} s_attr_defs[ATTR_COUNT] = {
+    [ATTR_MESH_INBOX] = { PARTNER_UUID(0x31), SVC_MESH_RELAY, CCCD_NOTIFY },
+    [ATTR_MESH_SEND] = { PARTNER_UUID(0x32), SVC_MESH_RELAY, 0 },
+    [ATTR_MESH_STATUS] = { PARTNER_UUID(0x33), SVC_MESH_RELAY, CCCD_NOTIFY },
+    [ATTR_MESH_NODE_LIST] = { PARTNER_UUID(0x34), SVC_MESH_RELAY, 0 },
+    [ATTR_JOYSTICK] = { PARTNER_UUID(0x02), SVC_REMOTE_INPUT, CCCD_NOTIFY },
+    [ATTR_KEYPAD] = { PARTNER_UUID(0x03), SVC_REMOTE_INPUT, 0 },
+    [ATTR_COMMAND] = { PARTNER_UUID(0x21), SVC_COMMAND_SYNC, 0 },
+    [ATTR_ACK] = { PARTNER_UUID(0x22), SVC_COMMAND_SYNC, 0 },
+    [ATTR_HEARTBEAT] = { PARTNER_UUID(0x23), SVC_COMMAND_SYNC, 0 },
+};
+
+/* Database Hash characteristic of the Generic Attribute service */
+#define GATT_DB_HASH_UUID       0x2B2A
+#define GATT_DB_HASH_LEN        16
+#define GATT_CCCD_UUID          0x2902
+
+/* Handle table as stored in NVS, one blob per partner address */
+#define LINK_NVS_NAMESPACE      "control_link"
+#define GATT_CACHE_VERSION      1
+
+typedef struct {
+    uint8_t version;
+    bool has_hash;
+    uint8_t db_hash[GATT_DB_HASH_LEN];
+    uint16_t val[ATTR_COUNT];           /* Characteristic value handles, 0 = absent */
+    uint16_t cccd[ATTR_COUNT];          /* Their CCCDs, 0 = none */
+} gatt_cache_t;
+
+/* Characteristics of one service seen so far, to place its CCCDs; a service with more fails */
+#define DISC_MAX_CHRS           8
 
-/* JoystickEvent characteristic UUID: 4f9a0002-8c3f-4a0e-89a7-6d277cf9a000 */
-static const ble_uuid128_t joystick_chr_uuid = BLE_UUID128_INIT(
-    0x00, 0xa0, 0xf9, 0x7c, 0x27, 0x6d, 0xa7, 0x89,
-    0x0e, 0x4a, 0x3f, 0x8c, 0x02, 0x00, 0x9a, 0x4f
-);
+/* Largest notification passed on to the notify handler */
+#define NOTIFY_BUF_LEN          512
+
+/*
+ * Joystick report: the partner's 8-byte JoystickEvent. Once the partner
+ * has estimated the clock offset from input ACKs, it adds its capture
+ * time (partner micros()) and this device's clock minus its own (int32).
+ * All little-endian.
+ */
+#define JOYSTICK_EVENT_LEN      8
+#define JOYSTICK_TIMED_LEN      16
+
+/*
+ * ACKs written to the partner. A plain ACK is the 4-byte seq; an input ACK
+ * adds when the report was received, delivered to the UI and shown, and
+ * when the ACK was sent, all esp_timer microseconds truncated to 32 bits.
+ * The partner uses the receive and send times to estimate the clock offset.
+ */
+#define ACK_LEN                 4
+#define INPUT_ACK_LEN           20
+
+/* Recent joystick reports, to find the receive time of a traced input */
+#define RX_LOG_LEN              16
+
+/*
+ * Connection profiles (see link_params.h for when each applies): 7.5-15 ms
+ * while the joystick is in use, 30-50 ms with slave latency once it is
+ * idle. Units: interval 1.25 ms, supervision timeout 10 ms.
+ */
+static const struct ble_gap_upd_params s_profiles[] = {
+    [LINK_PROFILE_ACTIVE] = {
+        .itvl_min = 6,                  /* 7.5 ms */
+        .itvl_max = 12,                 /* 15 ms */
+        .latency = 0,
+        .supervision_timeout = 200,     /* 2 s */
+    },
+    [LINK_PROFILE_IDLE] = {
+        .itvl_min = 24,                 /* 30 ms */
+        .itvl_max = 40,                 /* 50 ms */
+        .latency = 4,
+        .supervision_timeout = 400,     /* 4 s */
+    },
+};
+
+/*
+ * Reconnect policy (the scan schedule is in link_reconnect.h). The partner
+ * that last completed discovery is kept in NVS and white-listed, so no
+ * payload is parsed and the first report connects straight to the known
+ * address. Without a known partner the scan looks for PARTNER_DEVICE_NAME.
+ */
+#define PARTNER_ADDR_KEY        "partner"
+#define CONNECT_TIMEOUT_MS      3000
+#define RETRY_MS                1000    /* After the controller refused a scan or connection */
+
+/* Connection request: the active profile, so discovery runs fast too */
+static const struct ble_gap_conn_params s_connect_params = {
+    .scan_itvl = 0x0010,
+    .scan_window = 0x0010,
+    .itvl_min = 6,
+    .itvl_max = 12,
+    .latency = 0,
+    .supervision_timeout = 200,
+};
 
 /* State */
 static bool s_initialized = false;
 static bool s_scanning = false;
 static bool s_connected = false;
 static uint16_t s_conn_handle = 0;
-static uint16_t s_joystick_val_handle = 0;
+
+/*
+ * Partner attributes, only touched in the NimBLE host task. s_gatt_ready
+ * changes under s_link_lock, and s_gatt.val and s_conn_handle only while
+ * it is false, so a task sending ACKs can read all three under the lock.
+ */
+static gatt_cache_t s_gatt = {0};
+static bool s_gatt_ready = false;       /* Resolved and subscribed */
+static bool s_gatt_cached = false;      /* s_gatt came from NVS and is not proven yet */
+static ble_addr_t s_peer_addr;
+static struct ble_gatt_svc s_svc_range[SVC_COUNT];  /* start_handle 0 = not found */
+static int s_disc_svc = 0;              /* Service being walked */
+static uint16_t s_disc_chrs[DISC_MAX_CHRS]; /* Its characteristic value handles */
+static int s_disc_chr_count = 0;
+static int s_sub_next = 0;              /* Next attribute to subscribe */
+static bool s_hash_read = false;
+static uint8_t s_hash[GATT_DB_HASH_LEN];
+static int64_t s_gatt_start_us = 0;
+static bool s_gatt_failed = false;      /* Discovery gave up, the link is being dropped */
+
+/* Reconnect, only touched in the NimBLE host task */
+static ble_addr_t s_partner_addr;
+static link_reconnect_t s_reconnect = {0};
+static int64_t s_found_us = 0;          /* Partner advertisement seen */
+static struct ble_npl_callout s_retry_timer;
+
+/* Connection profile and PHY, only touched in the NimBLE host task */
+static link_params_t s_params = { .current = LINK_PROFILE_NONE, .wanted = LINK_PROFILE_NONE,
+                                  .pending = LINK_PROFILE_NONE };
+static struct ble_npl_callout s_idle_timer;
+
+/* Written by the host task, read by whichever task sends input ACKs */
+static control_link_joystick_t s_rx_log[RX_LOG_LEN];
+static unsigned s_rx_log_next = 0;
+
+/* Guards s_rx_log and s_gatt_ready against the tasks sending ACKs */
+static SemaphoreHandle_t s_link_lock = NULL;
 
 /* Callbacks */
 static void (*s_macro_handler)(const control_link_packet_t *packet) = NULL;
 static void (*s_joystick_handler)(const control_link_joystick_t *state) = NULL;
+static void (*s_ready_handler)(const control_link_handles_t *handles) = NULL;
+static void (*s_notify_handler)(uint16_t attr_handle, const uint8_t *data, size_t len) = NULL;
 
 /* Forward declarations */
 static void ble_host_task(void *param);
 static int ble_gap_event(struct ble_gap_event *event, void *arg);
 static void start_scan(void);
+static void note_input_activity(const control_link_joystick_t *state);
+
+static uint32_t get_le32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void put_le32(uint8_t *p, uint32_t v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+/**
+ * @brief Remember a report's timing until the UI has shown it
+ */
+static void log_rx(const control_link_joystick_t *state)
+{
+    xSemaphoreTake(s_link_lock, portMAX_DELAY);
+    s_rx_log[s_rx_log_next++ % RX_LOG_LEN] = *state;
+    xSemaphoreGive(s_link_lock);
+}
 
 /**
  * @brief Called when joystick notification received
  */
 static void on_joystick_notify(const uint8_t *data, size_t len)
 {
-    if (!s_joystick_handler || len < 8) {
+    uint32_t rx_us = (uint32_t)esp_timer_get_time();
+
+    if (!s_joystick_handler || len < JOYSTICK_EVENT_LEN) {
         return;
     }
 
@@ -64,85 +268,635 @@ static void on_joystick_notify(const uint8_t *data, size_t len)
         .y = (int8_t)data[1],
         .buttons = data[2],
         .layer = data[3],
-        .seq = (uint32_t)data[4] | ((uint32_t)data[5] << 8) | 
-               ((uint32_t)data[6] << 16) | ((uint32_t)data[7] << 24),
+        .seq = get_le32(&data[4]),
+        .rx_us = rx_us,
     };
 
+    /* Capture time on this device's clock (mod 2^32), once the partner knows the offset */
+    if (len >= JOYSTICK_TIMED_LEN) {
+        state.capture_us = get_le32(&data[8]) + get_le32(&data[12]);
+        state.capture_valid = true;
+    }
+
+    note_input_activity(&state);
+    log_rx(&state);
     s_joystick_handler(&state);
     esp_event_post(CONTROL_LINK_EVENT, CONTROL_LINK_EVENT_JOYSTICK, 
                    &state, sizeof(state), 0);
 }
 
+/* ============================================================================
+ * Connection Profiles
+ * ============================================================================ */
+
+static uint32_t now_ms(void)
+{
+    return ble_npl_time_ticks_to_ms32(ble_npl_time_get());
+}
+
+/**
+ * @brief Log the parameters the controller settled on
+ */
+static void log_conn_params(const char *why)
+{
+    struct ble_gap_conn_desc desc;
+    if (ble_gap_conn_find(s_conn_handle, &desc) != 0) {
+        return;
+    }
+    
+    ESP_LOGI(TAG, "%s: interval %u.%02u ms, latency %u, timeout %u ms (%s)", why,
+             desc.conn_itvl * 125 / 100, desc.conn_itvl * 125 % 100,
+             desc.conn_latency, desc.supervision_timeout * 10,
+             link_profile_name(s_params.current));
+}
+
+/**
+ * @brief Move the link towards a profile, one update at a time
+ */
+static void request_profile(link_profile_t profile)
+{
+    profile = link_params_want(&s_params, profile);
+    if (profile == LINK_PROFILE_NONE) {
+        return;
+    }
+    
+    int rc = ble_gap_update_params(s_conn_handle, &s_profiles[profile]);
+    if (rc == 0) {
+        link_params_sent(&s_params, profile);
+        ESP_LOGD(TAG, "Requesting %s profile", link_profile_name(profile));
+    } else {
+        ESP_LOGW(TAG, "Connection update failed: %d", rc);
+    }
+}
+
+/**
+ * @brief Connection update finished, whoever started it
+ */
+static void on_conn_update(int status)
+{
+    link_profile_t requested = s_params.pending;
+    link_profile_t next = link_params_updated(&s_params, status);
+    
+    if (status == 0) {
+        log_conn_params("Connection updated");
+    } else if (requested != LINK_PROFILE_NONE) {
+        ESP_LOGW(TAG, "%s profile rejected: %d", link_profile_name(requested), status);
+    }
+    
+    if (next != LINK_PROFILE_NONE) {
+        request_profile(next);
+    }
+}
+
+/**
+ * @brief Idle timer: relax the link once input has stopped
+ */
+static void on_idle_timer(struct ble_npl_event *ev)
+{
+    uint32_t left = link_params_idle_in(&s_params, now_ms());
+    if (left > 0) {
+        ble_npl_callout_reset(&s_idle_timer, ble_npl_time_ms_to_ticks32(left));
+        return;
+    }
+    request_profile(LINK_PROFILE_IDLE);
+}
+
+/**
+ * @brief A joystick report arrived: keep or make the link fast
+ */
+static void note_input_activity(const control_link_joystick_t *state)
+{
+    if (!link_params_input(&s_params, state->x, state->y, state->buttons, now_ms())) {
+        return;
+    }
+    
+    if (s_params.wanted != LINK_PROFILE_ACTIVE) {
+        request_profile(LINK_PROFILE_ACTIVE);
+    }
+    if (!ble_npl_callout_is_active(&s_idle_timer)) {
+        ble_npl_callout_reset(&s_idle_timer, ble_npl_time_ms_to_ticks32(LINK_IDLE_MS));
+    }
+}
+
+/**
+ * @brief Set up a new connection: 2M PHY, longer PDUs, idle timer
+ */
+static void on_link_up(void)
+{
+    /* The connection was made with the active profile's parameters */
+    link_params_up(&s_params, now_ms());
+    log_conn_params("Connected");
+    
+    /* 2M halves the air time of every packet; the controller stays on 1M if the partner cannot */
+    int rc = ble_gap_set_prefered_le_phy(s_conn_handle, BLE_GAP_LE_PHY_2M_MASK,
+                                         BLE_GAP_LE_PHY_2M_MASK, BLE_GAP_LE_PHY_CODED_ANY);
+    if (rc != 0) {
+        ESP_LOGW(TAG, "2M PHY request failed: %d", rc);
+    }
+    
+    /* Data length extension: mesh messages fit in one PDU instead of several */
+    rc = ble_gap_set_data_len(s_conn_handle, 251, 2120);
+    if (rc != 0) {
+        ESP_LOGW(TAG, "Data length request failed: %d", rc);
+    }
+    
+    ble_npl_callout_reset(&s_idle_timer, ble_npl_time_ms_to_ticks32(LINK_IDLE_MS));
+}
+
+/* ============================================================================
+ * Partner Address
+ * ============================================================================ */
+
+/**
+ * @brief Load the last partner from NVS and white-list it
+ */
+static void partner_load(void)
+{
+    nvs_handle_t nvs;
+    if (nvs_open(LINK_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+        return;
+    }
+    
+    size_t len = sizeof(s_partner_addr);
+    bool stored = nvs_get_blob(nvs, PARTNER_ADDR_KEY, &s_partner_addr, &len) == ESP_OK &&
+                  len == sizeof(s_partner_addr);
+    nvs_close(nvs);
+    
+    if (stored && ble_gap_wl_set(&s_partner_addr, 1) != 0) {
+        ESP_LOGW(TAG, "White list rejected, scanning by name");
+        stored = false;
+    }
+    link_reconnect_partner(&s_reconnect, stored);
+}
+
+/**
+ * @brief Keep a partner that completed discovery for the next reconnect
+ */
+static void partner_remember(const ble_addr_t *addr)
+{
+    if (s_reconnect.partner_known && ble_addr_cmp(addr, &s_partner_addr) == 0) {
+        return;
+    }
+    
+    nvs_handle_t nvs;
+    if (nvs_open(LINK_NVS_NAMESPACE, NVS_READWRITE, &nvs) == ESP_OK) {
+        nvs_set_blob(nvs, PARTNER_ADDR_KEY, addr, sizeof(*addr));
+        nvs_commit(nvs);
+        nvs_close(nvs);
+    }
+    
+    /* Not scanning while connected, so the white list can change */
+    s_partner_addr = *addr;
+    link_reconnect_partner(&s_reconnect, ble_gap_wl_set(&s_partner_addr, 1) == 0);
+    ESP_LOGI(TAG, "Partner %02x:%02x:%02x:%02x:%02x:%02x remembered",
+             addr->val[5], addr->val[4], addr->val[3], addr->val[2], addr->val[1], addr->val[0]);
+}
+
+/**
+ * @brief Whether an advertising report comes from the partner
+ */
+static bool is_partner_adv(const struct ble_gap_disc_desc *disc)
+{
+    if (s_reconnect.partner_known) {
+        /* The controller only reports the white-listed partner */
+        return disc->event_type == BLE_HCI_ADV_RPT_EVTYPE_ADV_IND ||
+               disc->event_type == BLE_HCI_ADV_RPT_EVTYPE_DIR_IND;
+    }
+    
+    if (disc->event_type != BLE_HCI_ADV_RPT_EVTYPE_ADV_IND &&
+        disc->event_type != BLE_HCI_ADV_RPT_EVTYPE_SCAN_RSP) {
+        return false;
+    }
+    
+    /* First pairing: only the name field, not a full parse */
+    const struct ble_hs_adv_field *name;
+    if (ble_hs_adv_find_field(BLE_HS_ADV_TYPE_COMP_NAME, disc->data, disc->length_data, &name) != 0) {
+        return false;
+    }
+    return name->length - 1 == sizeof(PARTNER_DEVICE_NAME) - 1 &&
+           memcmp(name->value, PARTNER_DEVICE_NAME, sizeof(PARTNER_DEVICE_NAME) - 1) == 0;
+}
+
+/* ============================================================================
+ * GATT Client
+ * ============================================================================ */
+
+static void gatt_discover_all(void);
+static void gatt_discover_next_svc(void);
+static void gatt_subscribe_next(void);
+
+/**
+ * @brief NVS key of a partner's handle table: "g" and the address in hex
+ */
+static void gatt_cache_key(const ble_addr_t *addr, char key[16])
+{
+    snprintf(key, 16, "g%02x%02x%02x%02x%02x%02x", addr->val[5], addr->val[4],
+             addr->val[3], addr->val[2], addr->val[1], addr->val[0]);
+}
+
+static bool gatt_cache_load(const ble_addr_t *addr, gatt_cache_t *cache)
+{
+    nvs_handle_t nvs;
+    if (nvs_open(LINK_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+        return false;
+    }
+    
+    char key[16];
+    gatt_cache_key(addr, key);
+    size_t len = sizeof(*cache);
+    esp_err_t ret = nvs_get_blob(nvs, key, cache, &len);
+    nvs_close(nvs);
+    return ret == ESP_OK && len == sizeof(*cache) && cache->version == GATT_CACHE_VERSION;
+}
+
+static void gatt_cache_store(const ble_addr_t *addr, const gatt_cache_t *cache)
+{
+    nvs_handle_t nvs;
+    if (nvs_open(LINK_NVS_NAMESPACE, NVS_READWRITE, &nvs) != ESP_OK) {
+        return;
+    }
+    
+    char key[16];
+    gatt_cache_key(addr, key);
+    if (cache) {
+        nvs_set_blob(nvs, key, cache, sizeof(*cache));
+    } else {
+        nvs_erase_key(nvs, key);
+    }
+    nvs_commit(nvs);
+    nvs_close(nvs);
+}
+
+/**
+ * @brief Handles in the public layout
+ */
+static void gatt_get_handles(control_link_handles_t *handles)
+{
+    *handles = (control_link_handles_t){
+        .conn_handle = s_conn_handle,
+        .mesh_inbox = s_gatt.val[ATTR_MESH_INBOX],
+        .mesh_send = s_gatt.val[ATTR_MESH_SEND],
+        .mesh_status = s_gatt.val[ATTR_MESH_STATUS],
+        .mesh_node_list = s_gatt.val[ATTR_MESH_NODE_LIST],
+        .joystick = s_gatt.val[ATTR_JOYSTICK],
+        .keypad = s_gatt.val[ATTR_KEYPAD],
+        .command = s_gatt.val[ATTR_COMMAND],
+        .ack = s_gatt.val[ATTR_ACK],
+        .heartbeat = s_gatt.val[ATTR_HEARTBEAT],
+    };
+}
+
+/**
+ * @brief Open or close the partner's attributes to the tasks sending ACKs
+ */
+static void gatt_set_ready(bool ready)
+{
+    xSemaphoreTake(s_link_lock, portMAX_DELAY);
+    s_gatt_ready = ready;
+    xSemaphoreGive(s_link_lock);
+}
+
 /**
- * @brief GATT attribute event callback
+ * @brief Handles resolved and notifications on: tell the rest of the firmware
  */
-static int on_gatt_attr(uint16_t conn_handle, const struct ble_gatt_error *error,
+static void gatt_ready(void)
+{
+    gatt_set_ready(true);
+    if (!s_gatt_cached) {
+        gatt_cache_store(&s_peer_addr, &s_gatt);
+    }
+    partner_remember(&s_peer_addr);
+    
+    /* Time to reconnect from link loss (or host sync), split into finding, connecting and GATT */
+    int64_t now = esp_timer_get_time();
+    ESP_LOGI(TAG, "Partner ready in %lu ms: scan %lu, connect %lu, GATT %lu (%s)",
+             (unsigned long)((now - s_reconnect.lost_us) / 1000),
+             (unsigned long)((s_found_us - s_reconnect.lost_us) / 1000),
+             (unsigned long)((s_gatt_start_us - s_found_us) / 1000),
+             (unsigned long)((now - s_gatt_start_us) / 1000),
+             s_gatt_cached ? "cached" : "discovered");
+    
+    control_link_handles_t handles;
+    gatt_get_handles(&handles);
+    if (s_ready_handler) {
+        s_ready_handler(&handles);
+    }
+    esp_event_post(CONTROL_LINK_EVENT, CONTROL_LINK_EVENT_READY, &handles, sizeof(handles), 0);
+}
+
+/**
+ * @brief A CCCD write finished
+ */
+static int on_subscribe(uint16_t conn_handle, const struct ble_gatt_error *error,
                         struct ble_gatt_attr *attr, void *arg)
 {
-    if (error->status == 0 && attr != NULL) {
-        /* Notification data */
-        on_joystick_notify(attr->om->om_data, attr->om->om_len);
+    partner_attr_t id = (partner_attr_t)(intptr_t)arg;
+    
+    if (conn_handle != s_conn_handle || !s_connected) {
+        return 0;
+    }
+    
+    if (error->status != 0 && s_gatt_cached) {
+        /* The cached table no longer matches the partner */
+        ESP_LOGW(TAG, "Subscribe failed with cached handles (%d), rediscovering", error->status);
+        gatt_cache_store(&s_peer_addr, NULL);
+        gatt_discover_all();
+        return 0;
     }
+    
+    if (error->status != 0) {
+        ESP_LOGE(TAG, "Subscribe to attribute %d failed: %d", id, error->status);
+    }
+    gatt_subscribe_next();
     return 0;
 }
 
 /**
- * @brief Called after subscribing to notifications
+ * @brief Write the next CCCD, or finish
  */
-static int on_subscribe(uint16_t conn_handle, const struct ble_gatt_error *error,
+static void gatt_subscribe_next(void)
+{
+    while (s_sub_next < ATTR_COUNT) {
+        partner_attr_t id = s_sub_next++;
+        uint16_t value = s_attr_defs[id].subscribe;
+        if (!value) {
+            continue;
+        }
+        if (!s_gatt.cccd[id]) {
+            ESP_LOGW(TAG, "Partner has no CCCD for attribute %d", id);
+            continue;
+        }
+        
+        uint8_t cccd[2] = { value & 0xFF, value >> 8 };
+        int rc = ble_gattc_write_flat(s_conn_handle, s_gatt.cccd[id], cccd, sizeof(cccd),
+                                      on_subscribe, (void *)(intptr_t)id);
+        if (rc == 0) {
+            return;
+        }
+        ESP_LOGE(TAG, "Subscribe to attribute %d failed: %d", id, rc);
+    }
+    
+    gatt_ready();
+}
+
+/**
+ * @brief Database hash read finished, or the partner has none
+ */
+static int on_hash_read(uint16_t conn_handle, const struct ble_gatt_error *error,
                         struct ble_gatt_attr *attr, void *arg)
 {
-    if (error->status == 0) {
-        ESP_LOGI(TAG, "Subscribed to joystick notifications");
+    if (conn_handle != s_conn_handle || !s_connected) {
+        return 0;
+    }
+    
+    if (error->status == 0 && attr) {
+        if (OS_MBUF_PKTLEN(attr->om) == GATT_DB_HASH_LEN) {
+            os_mbuf_copydata(attr->om, 0, GATT_DB_HASH_LEN, s_hash);
+            s_hash_read = true;
+        }
+        return 0;       /* The procedure ends with BLE_HS_EDONE */
+    }
+    
+    if (!s_gatt_cached) {
+        /* Just discovered: keep the hash with the table */
+        s_gatt.has_hash = s_hash_read;
+        memcpy(s_gatt.db_hash, s_hash, GATT_DB_HASH_LEN);
+    } else if (s_hash_read != s_gatt.has_hash ||
+               (s_hash_read && memcmp(s_hash, s_gatt.db_hash, GATT_DB_HASH_LEN) != 0)) {
+        ESP_LOGI(TAG, "Partner GATT database changed, rediscovering");
+        gatt_discover_all();
+        return 0;
+    }
+    
+    s_sub_next = 0;
+    gatt_subscribe_next();
+    return 0;
+}
+
+/**
+ * @brief Read the partner's database hash, wherever it is
+ */
+static void gatt_read_hash(void)
+{
+    s_hash_read = false;
+    int rc = ble_gattc_read_by_uuid(s_conn_handle, 1, 0xFFFF, BLE_UUID16_DECLARE(GATT_DB_HASH_UUID),
+                                    on_hash_read, NULL);
+    if (rc != 0) {
+        /* Go on as if the partner had no hash */
+        struct ble_gatt_error error = { .status = rc };
+        on_hash_read(s_conn_handle, &error, NULL, NULL);
+    }
+}
+
+/**
+ * @brief Discovery failed: drop the link, so the next connection starts over
+ *
+ * Without its handles the partner is of no use, and nothing else would
+ * try again while the link stays up.
+ */
+static void gatt_fail(const char *what, int rc)
+{
+    if (s_gatt_failed) {
+        return;
+    }
+    s_gatt_failed = true;
+    
+    ESP_LOGE(TAG, "%s failed: %d, disconnecting", what, rc);
+    rc = ble_gap_terminate(s_conn_handle, BLE_ERR_REM_USER_CONN_TERM);
+    if (rc != 0) {
+        ESP_LOGE(TAG, "Disconnect failed: %d", rc);
+    }
+}
+
+/**
+ * @brief A descriptor of the service being walked
+ *
+ * Walking the whole service also reports characteristic declarations and
+ * values; a CCCD belongs to the closest characteristic value before it.
+ */
+static int on_dsc_discovered(uint16_t conn_handle, const struct ble_gatt_error *error,
+                             uint16_t chr_val_handle, const struct ble_gatt_dsc *dsc, void *arg)
+{
+    if (conn_handle != s_conn_handle || !s_connected) {
+        return 0;
+    }
+    
+    if (error->status == 0 && dsc) {
+        if (ble_uuid_cmp(&dsc->uuid.u, BLE_UUID16_DECLARE(GATT_CCCD_UUID)) != 0) {
+            return 0;
+        }
+        
+        uint16_t owner = 0;
+        for (int i = 0; i < s_disc_chr_count; i++) {
+            if (s_disc_chrs[i] < dsc->handle && s_disc_chrs[i] > owner) {
+                owner = s_disc_chrs[i];
+            }
+        }
+        for (int id = 0; id < ATTR_COUNT && owner; id++) {
+            if (s_gatt.val[id] == owner) {
+                s_gatt.cccd[id] = dsc->handle;
+            }
+        }
+    } else if (error->status == BLE_HS_EDONE) {
+        s_disc_svc++;
+        gatt_discover_next_svc();
     } else {
-        ESP_LOGE(TAG, "Subscribe failed: %d", error->status);
+        gatt_fail("Descriptor discovery", error->status);
     }
     return 0;
 }
 
 /**
- * @brief Called when characteristic discovered
+ * @brief A characteristic of the service being walked
  */
-static int on_chr_discovered(uint16_t conn_handle,
-                             const struct ble_gatt_error *error,
+static int on_chr_discovered(uint16_t conn_handle, const struct ble_gatt_error *error,
                              const struct ble_gatt_chr *chr, void *arg)
 {
-    if (error->status == 0 && chr != NULL) {
-        /* Check if this is the joystick characteristic */
-        if (ble_uuid_cmp(&chr->uuid.u, &joystick_chr_uuid.u) == 0) {
-            ESP_LOGI(TAG, "Found joystick characteristic, handle=%d", chr->val_handle);
-            s_joystick_val_handle = chr->val_handle;
-            
-            /* Subscribe to notifications */
-            uint8_t value[2] = {0x01, 0x00};  /* Enable notifications */
-            ble_gattc_write_flat(conn_handle, chr->val_handle + 1, 
-                                 value, sizeof(value), on_subscribe, NULL);
+    if (conn_handle != s_conn_handle || !s_connected) {
+        return 0;
+    }
+    
+    if (error->status == 0 && chr) {
+        if (s_disc_chr_count == DISC_MAX_CHRS) {
+            /* Its CCCDs could not be placed; stop the walk */
+            ESP_LOGE(TAG, "Partner service %d has more than %d characteristics", s_disc_svc, DISC_MAX_CHRS);
+            gatt_fail("Characteristic discovery", BLE_HS_ENOMEM);
+            return BLE_HS_ENOMEM;
+        }
+        s_disc_chrs[s_disc_chr_count++] = chr->val_handle;
+        for (int id = 0; id < ATTR_COUNT; id++) {
+            if (s_attr_defs[id].svc == s_disc_svc &&
+                ble_uuid_cmp(&chr->uuid.u, &s_attr_defs[id].uuid.u) == 0) {
+                s_gatt.val[id] = chr->val_handle;
+            }
         }
     } else if (error->status == BLE_HS_EDONE) {
-        ESP_LOGI(TAG, "Characteristic discovery complete");
+        /* Then every descriptor of the service in one walk */
+        const struct ble_gatt_svc *svc = &s_svc_range[s_disc_svc];
+        int rc = ble_gattc_disc_all_dscs(conn_handle, svc->start_handle, svc->end_handle,
+                                         on_dsc_discovered, NULL);
+        if (rc != 0) {
+            gatt_fail("Descriptor discovery", rc);
+        }
+    } else {
+        gatt_fail("Characteristic discovery", error->status);
     }
     return 0;
 }
 
 /**
- * @brief Called when service discovered
+ * @brief Walk the next partner service found, or move on to the hash
+ */
+static void gatt_discover_next_svc(void)
+{
+    while (s_disc_svc < SVC_COUNT && s_svc_range[s_disc_svc].start_handle == 0) {
+        s_disc_svc++;
+    }
+    if (s_disc_svc == SVC_COUNT) {
+        gatt_read_hash();
+        return;
+    }
+    
+    const struct ble_gatt_svc *svc = &s_svc_range[s_disc_svc];
+    s_disc_chr_count = 0;
+    int rc = ble_gattc_disc_all_chrs(s_conn_handle, svc->start_handle, svc->end_handle,
+                                     on_chr_discovered, NULL);
+    if (rc != 0) {
+        gatt_fail("Characteristic discovery", rc);
+    }
+}
+
+/**
+ * @brief A primary service of the partner
  */
-static int on_svc_discovered(uint16_t conn_handle,
-                             const struct ble_gatt_error *error,
+static int on_svc_discovered(uint16_t conn_handle, const struct ble_gatt_error *error,
                              const struct ble_gatt_svc *svc, void *arg)
 {
-    if (error->status == 0 && svc != NULL) {
-        ESP_LOGI(TAG, "Found Remote Input service");
-        
-        /* Discover characteristics */
-        ble_gattc_disc_chrs_by_uuid(conn_handle, svc->start_handle, svc->end_handle,
-                                    &joystick_chr_uuid.u, on_chr_discovered, NULL);
+    if (conn_handle != s_conn_handle || !s_connected) {
+        return 0;
+    }
+    
+    if (error->status == 0 && svc) {
+        for (int i = 0; i < SVC_COUNT; i++) {
+            if (ble_uuid_cmp(&svc->uuid.u, &s_svc_uuids[i].u) == 0) {
+                s_svc_range[i] = *svc;
+            }
+        }
     } else if (error->status == BLE_HS_EDONE) {
-        ESP_LOGI(TAG, "Service discovery complete");
+        for (int i = 0; i < SVC_COUNT; i++) {
+            if (s_svc_range[i].start_handle == 0) {
+                ESP_LOGW(TAG, "Partner lacks service %d", i);
+            }
+        }
+        s_disc_svc = 0;
+        gatt_discover_next_svc();
+    } else {
+        gatt_fail("Service discovery", error->status);
     }
     return 0;
 }
 
+/**
+ * @brief Forget any table and discover the partner from scratch
+ */
+static void gatt_discover_all(void)
+{
+    memset(&s_gatt, 0, sizeof(s_gatt));
+    s_gatt.version = GATT_CACHE_VERSION;
+    s_gatt_cached = false;
+    memset(s_svc_range, 0, sizeof(s_svc_range));
+    
+    int rc = ble_gattc_disc_all_svcs(s_conn_handle, on_svc_discovered, NULL);
+    if (rc != 0) {
+        gatt_fail("Service discovery", rc);
+    }
+}
+
+/**
+ * @brief MTU exchanged: use the cached table if the partner still matches it
+ */
+static int on_mtu(uint16_t conn_handle, const struct ble_gatt_error *error, uint16_t mtu, void *arg)
+{
+    if (conn_handle != s_conn_handle || !s_connected) {
+        return 0;
+    }
+    
+    if (error->status == 0) {
+        ESP_LOGD(TAG, "MTU %u", mtu);
+    }
+    
+    if (gatt_cache_load(&s_peer_addr, &s_gatt)) {
+        s_gatt_cached = true;
+        gatt_read_hash();
+    } else {
+        gatt_discover_all();
+    }
+    return 0;
+}
+
+/**
+ * @brief Resolve the partner's attributes on a new connection
+ *
+ * The MTU goes first so discovery responses carry many entries each.
+ */
+static void gatt_start(void)
+{
+    struct ble_gap_conn_desc desc;
+    
+    gatt_set_ready(false);
+    s_gatt_cached = false;
+    s_gatt_failed = false;
+    s_gatt_start_us = esp_timer_get_time();
+    if (ble_gap_conn_find(s_conn_handle, &desc) == 0) {
+        s_peer_addr = desc.peer_id_addr;
+    }
+    
+    if (ble_gattc_exchange_mtu(s_conn_handle, on_mtu, NULL) != 0) {
+        struct ble_gatt_error error = { .status = BLE_HS_EALREADY };
+        on_mtu(s_conn_handle, &error, 0, NULL);
+    }
+}
+
 /**
  * @brief GAP event handler
  */
@@ -152,24 +906,19 @@ static int ble_gap_event(struct ble_gap_event *event, void *arg)
     
     switch (event->type) {
     case BLE_GAP_EVENT_DISC:
-        /* Check if this is our partner device */
-        if (event->disc.event_type == BLE_HCI_ADV_RPT_EVTYPE_ADV_IND ||
-            event->disc.event_type == BLE_HCI_ADV_RPT_EVTYPE_SCAN_RSP) {
+        if (s_scanning && is_partner_adv(&event->disc)) {
+            ESP_LOGI(TAG, "Found partner device");
+            s_found_us = esp_timer_get_time();
             
-            struct ble_hs_adv_fields fields;
-            ble_hs_adv_parse_fields(&fields, event->disc.data, event->disc.length_data);
+            /* Stop scanning and connect */
+            ble_gap_disc_cancel();
+            s_scanning = false;
             
-            if (fields.name != NULL && fields.name_len > 0) {
-                if (strncmp((char *)fields.name, PARTNER_DEVICE_NAME, fields.name_len) == 0) {
-                    ESP_LOGI(TAG, "Found partner device: %s", PARTNER_DEVICE_NAME);
-                    
-                    /* Stop scanning and connect */
-                    ble_gap_disc_cancel();
-                    s_scanning = false;
-                    
-                    ble_gap_connect(BLE_OWN_ADDR_PUBLIC, &event->disc.addr,
-                                    30000, NULL, ble_gap_event, NULL);
-                }
+            int rc = ble_gap_connect(BLE_OWN_ADDR_PUBLIC, &event->disc.addr, CONNECT_TIMEOUT_MS,
+                                     &s_connect_params, ble_gap_event, NULL);
+            if (rc != 0) {
+                ESP_LOGE(TAG, "Failed to connect: %d", rc);
+                ble_npl_callout_reset(&s_retry_timer, ble_npl_time_ms_to_ticks32(RETRY_MS));
             }
         }
         break;
@@ -179,12 +928,10 @@ static int ble_gap_event(struct ble_gap_event *event, void *arg)
             ESP_LOGI(TAG, "Connected to partner device");
             s_connected = true;
             s_conn_handle = event->connect.conn_handle;
+            on_link_up();
             
             esp_event_post(CONTROL_LINK_EVENT, CONTROL_LINK_EVENT_CONNECTED, NULL, 0, 0);
-            
-            /* Discover services */
-            ble_gattc_disc_svc_by_uuid(s_conn_handle, &remote_input_svc_uuid.u,
-                                       on_svc_discovered, NULL);
+            gatt_start();
         } else {
             ESP_LOGE(TAG, "Connection failed: %d", event->connect.status);
             start_scan();
@@ -193,10 +940,17 @@ static int ble_gap_event(struct ble_gap_event *event, void *arg)
 
     case BLE_GAP_EVENT_DISCONNECT:
         ESP_LOGW(TAG, "Disconnected from partner device");
+        gatt_set_ready(false);
         s_connected = false;
         s_conn_handle = 0;
-        s_joystick_val_handle = 0;
+        memset(&s_gatt, 0, sizeof(s_gatt));
+        link_params_down(&s_params);
+        ble_npl_callout_stop(&s_idle_timer);
+        link_reconnect_lost(&s_reconnect, esp_timer_get_time());
         
+        if (s_ready_handler) {
+            s_ready_handler(NULL);
+        }
         esp_event_post(CONTROL_LINK_EVENT, CONTROL_LINK_EVENT_DISCONNECTED, NULL, 0, 0);
         
         /* Restart scanning */
@@ -204,23 +958,41 @@ static int ble_gap_event(struct ble_gap_event *event, void *arg)
         break;
 
     case BLE_GAP_EVENT_DISC_COMPLETE:
-        ESP_LOGI(TAG, "Scan complete");
+        /* End of the fast phase: carry on at the low duty cycle */
         s_scanning = false;
-        if (!s_connected) {
-            /* Restart scan after a delay */
-            vTaskDelay(pdMS_TO_TICKS(1000));
-            start_scan();
+        start_scan();
+        break;
+
+    case BLE_GAP_EVENT_CONN_UPDATE:
+        on_conn_update(event->conn_update.status);
+        break;
+
+    case BLE_GAP_EVENT_PHY_UPDATE_COMPLETE:
+        link_params_phy(&s_params, event->phy_updated.status,
+                        event->phy_updated.tx_phy == BLE_GAP_LE_PHY_2M,
+                        event->phy_updated.rx_phy == BLE_GAP_LE_PHY_2M);
+        if (event->phy_updated.status == 0) {
+            ESP_LOGI(TAG, "PHY: tx %dM, rx %dM", s_params.tx_phy, s_params.rx_phy);
+        } else {
+            ESP_LOGW(TAG, "PHY update failed: %d", event->phy_updated.status);
         }
         break;
 
     case BLE_GAP_EVENT_NOTIFY_RX:
         /* Received notification from partner */
-        if (event->notify_rx.attr_handle == s_joystick_val_handle) {
+        if (event->notify_rx.attr_handle == s_gatt.val[ATTR_JOYSTICK]) {
             uint8_t buf[16];
             uint16_t len = OS_MBUF_PKTLEN(event->notify_rx.om);
             if (len > sizeof(buf)) len = sizeof(buf);
             os_mbuf_copydata(event->notify_rx.om, 0, len, buf);
             on_joystick_notify(buf, len);
+        } else if (s_notify_handler) {
+            /* Mesh relay and the rest go to whoever subscribed */
+            static uint8_t buf[NOTIFY_BUF_LEN];
+            uint16_t len = OS_MBUF_PKTLEN(event->notify_rx.om);
+            if (len > sizeof(buf)) len = sizeof(buf);
+            os_mbuf_copydata(event->notify_rx.om, 0, len, buf);
+            s_notify_handler(event->notify_rx.attr_handle, buf, len);
         }
         break;
 
@@ -232,38 +1004,54 @@ static int ble_gap_event(struct ble_gap_event *event, void *arg)
 }
 
 /**
- * @brief Start scanning for partner device
+ * @brief Start scanning for partner device, as the schedule says
  */
 static void start_scan(void)
 {
-    if (s_scanning || s_connected) {
+    if (s_scanning || s_connected || ble_gap_conn_active()) {
         return;
     }
     
+    link_scan_t scan;
+    link_reconnect_scan(&s_reconnect, esp_timer_get_time(), &scan);
+    
     struct ble_gap_disc_params scan_params = {
-        .itvl = 0x0010,
-        .window = 0x0010,
-        .filter_policy = BLE_HCI_SCAN_FILT_NO_WL,
+        .itvl = scan.itvl,
+        .window = scan.window,
+        .filter_policy = scan.white_list ? BLE_HCI_SCAN_FILT_USE_WL : BLE_HCI_SCAN_FILT_NO_WL,
         .limited = 0,
-        .passive = 0,
+        .passive = scan.passive,
         .filter_duplicates = 1,
     };
     
-    int rc = ble_gap_disc(BLE_OWN_ADDR_PUBLIC, 10000, &scan_params, ble_gap_event, NULL);
+    int32_t duration = scan.duration_ms ? (int32_t)scan.duration_ms : BLE_HS_FOREVER;
+    int rc = ble_gap_disc(BLE_OWN_ADDR_PUBLIC, duration, &scan_params, ble_gap_event, NULL);
     if (rc == 0) {
         s_scanning = true;
-        ESP_LOGI(TAG, "Scanning for partner device...");
+        ESP_LOGI(TAG, "Scanning for %s partner (%s)...",
+                 scan.white_list ? "known" : "any", scan.fast ? "fast" : "slow");
     } else {
         ESP_LOGE(TAG, "Failed to start scan: %d", rc);
+        ble_npl_callout_reset(&s_retry_timer, ble_npl_time_ms_to_ticks32(RETRY_MS));
     }
 }
 
+/**
+ * @brief Retry after a scan or connection the controller refused
+ */
+static void on_retry_timer(struct ble_npl_event *ev)
+{
+    start_scan();
+}
+
 /**
  * @brief BLE sync callback
  */
 static void on_ble_sync(void)
 {
-    /* Start scanning for partner */
+    /* Start scanning for partner, fast first */
+    partner_load();
+    link_reconnect_lost(&s_reconnect, esp_timer_get_time());
     start_scan();
 }
 
@@ -304,6 +1092,14 @@ esp_err_t control_link_init(void)
         return ret;
     }
     
+    ble_npl_callout_init(&s_idle_timer, nimble_port_get_dflt_eventq(), on_idle_timer, NULL);
+    ble_npl_callout_init(&s_retry_timer, nimble_port_get_dflt_eventq(), on_retry_timer, NULL);
+    
+    s_link_lock = xSemaphoreCreateMutex();
+    if (!s_link_lock) {
+        return ESP_ERR_NO_MEM;
+    }
+    
     /* Configure host callbacks */
     ble_hs_cfg.sync_cb = on_ble_sync;
     ble_hs_cfg.reset_cb = on_ble_reset;
@@ -332,11 +1128,73 @@ esp_err_t control_link_start_advertising(void)
     return ESP_OK;
 }
 
+/**
+ * @brief Write an ACK to the partner, without waiting for a response
+ */
+static esp_err_t write_ack(const uint8_t *data, size_t len)
+{
+    if (!s_link_lock) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    /* The host task may be dropping the link; a handle gone stale just fails the write */
+    xSemaphoreTake(s_link_lock, portMAX_DELAY);
+    bool ready = s_gatt_ready;
+    uint16_t conn = s_conn_handle;
+    uint16_t handle = s_gatt.val[ATTR_ACK];
+    xSemaphoreGive(s_link_lock);
+    if (!ready || handle == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    int rc = ble_gattc_write_no_rsp_flat(conn, handle, data, len);
+    if (rc != 0) {
+        ESP_LOGD(TAG, "ACK write failed: %d", rc);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
 esp_err_t control_link_send_ack(uint32_t seq)
 {
-    /* TODO: Send ACK back to partner if needed */
+    uint8_t ack[ACK_LEN];
+    put_le32(ack, seq);
     ESP_LOGD(TAG, "ACK seq %lu", (unsigned long)seq);
-    return ESP_OK;
+    return write_ack(ack, sizeof(ack));
+}
+
+esp_err_t control_link_ack_input(uint32_t seq, uint32_t input_us, uint32_t shown_us,
+                                 control_link_joystick_t *state)
+{
+    control_link_joystick_t found;
+    bool ok = false;
+    
+    if (!s_link_lock) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    xSemaphoreTake(s_link_lock, portMAX_DELAY);
+    for (int i = 0; i < RX_LOG_LEN && !ok; i++) {
+        if (s_rx_log[i].seq == seq && s_rx_log[i].rx_us != 0) {
+            found = s_rx_log[i];
+            ok = true;
+        }
+    }
+    xSemaphoreGive(s_link_lock);
+    if (!ok) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (state) {
+        *state = found;
+    }
+    
+    uint8_t ack[INPUT_ACK_LEN];
+    put_le32(&ack[0], seq);
+    put_le32(&ack[4], found.rx_us);
+    put_le32(&ack[8], input_us);
+    put_le32(&ack[12], shown_us);
+    put_le32(&ack[16], (uint32_t)esp_timer_get_time());
+    return write_ack(ack, sizeof(ack));
 }
 
 esp_err_t control_link_subscribe_macros(void (*handler)(const control_link_packet_t *packet))
@@ -357,6 +1215,24 @@ esp_err_t control_link_subscribe_joystick(void (*handler)(const control_link_joy
     return ESP_OK;
 }
 
+esp_err_t control_link_subscribe_ready(void (*handler)(const control_link_handles_t *handles))
+{
+    if (!handler) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_ready_handler = handler;
+    return ESP_OK;
+}
+
+esp_err_t control_link_subscribe_notify(void (*handler)(uint16_t attr_handle, const uint8_t *data, size_t len))
+{
+    if (!handler) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_notify_handler = handler;
+    return ESP_OK;
+}
+
 bool control_link_is_connected(void)
 {
     return s_connected;
@@ -0,0 +1,71 @@
+/**
+ * @file control_link_host.c
+ * @brief Control link stand-in for Linux builds
+ *
+ * There is no radio on the host. The link initializes, never finds the
+ * partner and stays disconnected, so nothing reaches the subscribed
+ * handlers; host builds feed joystick input to the UI directly.
+ */
+
+#include "control_link.h"
+
+#include "esp_event.h"
+#include "esp_log.h"
+
+ESP_EVENT_DEFINE_BASE(CONTROL_LINK_EVENT);
+
+static const char *TAG = "control_link";
+
+static bool s_initialized = false;
+
+esp_err_t control_link_init(void)
+{
+    if (s_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    s_initialized = true;
+    ESP_LOGI(TAG, "Host build: no BLE, partner stays disconnected");
+    return ESP_OK;
+}
+
+esp_err_t control_link_start_advertising(void)
+{
+    return s_initialized ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+esp_err_t control_link_send_ack(uint32_t seq)
+{
+    return ESP_ERR_INVALID_STATE;
+}
+
+esp_err_t control_link_ack_input(uint32_t seq, uint32_t input_us, uint32_t shown_us,
+                                 control_link_joystick_t *state)
+{
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t control_link_subscribe_macros(void (*handler)(const control_link_packet_t *packet))
+{
+    return handler ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t control_link_subscribe_joystick(void (*handler)(const control_link_joystick_t *state))
+{
+    return handler ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t control_link_subscribe_ready(void (*handler)(const control_link_handles_t *handles))
+{
+    return handler ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t control_link_subscribe_notify(void (*handler)(uint16_t attr_handle, const uint8_t *data, size_t len))
+{
+    return handler ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+bool control_link_is_connected(void)
+{
+    return false;
+}
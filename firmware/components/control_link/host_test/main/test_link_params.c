@@ -0,0 +1,194 @@
+/**
+ * @file test_link_params.c
+ * @brief Connection profiles and PHY: when the link asks for what
+ *
+ * Each test plays the events control_link.c passes on (connect, joystick
+ * reports, the idle timer, update and PHY completions) and checks the
+ * profile link_params asks it to request, if any, and what it records
+ * as in effect.
+ */
+
+#include "unity.h"
+#include "link_params.h"
+
+#define T0                  100000
+#define UPDATE_REJECTED     0x1e        /* Any non-zero status */
+
+static link_params_t s_lp;
+
+/* What the idle timer does when it fires */
+static link_profile_t idle_timer(uint32_t now)
+{
+    if (link_params_idle_in(&s_lp, now) > 0) {
+        return LINK_PROFILE_NONE;
+    }
+    return link_params_want(&s_lp, LINK_PROFILE_IDLE);
+}
+
+/* Request a profile and have the controller accept it */
+static void request(link_profile_t profile)
+{
+    TEST_ASSERT_EQUAL(profile, link_params_want(&s_lp, profile));
+    link_params_sent(&s_lp, profile);
+}
+
+TEST_CASE("a new link is active and goes idle after LINK_IDLE_MS without input", "[link]")
+{
+    link_params_up(&s_lp, T0);
+    TEST_ASSERT_TRUE(s_lp.connected);
+    TEST_ASSERT_EQUAL(LINK_PROFILE_ACTIVE, s_lp.current);
+    TEST_ASSERT_EQUAL(LINK_PROFILE_NONE, s_lp.pending);
+    TEST_ASSERT_EQUAL(LINK_PROFILE_NONE, link_params_want(&s_lp, LINK_PROFILE_ACTIVE));
+    
+    TEST_ASSERT_EQUAL_UINT32(LINK_IDLE_MS, link_params_idle_in(&s_lp, T0));
+    TEST_ASSERT_EQUAL_UINT32(1, link_params_idle_in(&s_lp, T0 + LINK_IDLE_MS - 1));
+    TEST_ASSERT_EQUAL(LINK_PROFILE_NONE, idle_timer(T0 + LINK_IDLE_MS - 1));
+    TEST_ASSERT_EQUAL(LINK_PROFILE_IDLE, idle_timer(T0 + LINK_IDLE_MS));
+    link_params_sent(&s_lp, LINK_PROFILE_IDLE);
+    TEST_ASSERT_EQUAL(LINK_PROFILE_IDLE, s_lp.pending);
+    TEST_ASSERT_EQUAL(LINK_PROFILE_ACTIVE, s_lp.current);
+    
+    TEST_ASSERT_EQUAL(LINK_PROFILE_NONE, link_params_updated(&s_lp, 0));
+    TEST_ASSERT_EQUAL(LINK_PROFILE_IDLE, s_lp.current);
+    TEST_ASSERT_EQUAL(LINK_PROFILE_NONE, s_lp.pending);
+    
+    /* Timed from the last input across the millisecond counter wrapping */
+    link_params_up(&s_lp, UINT32_MAX - 500);
+    TEST_ASSERT_EQUAL_UINT32(LINK_IDLE_MS - 1000, link_params_idle_in(&s_lp, 499));
+    TEST_ASSERT_EQUAL_UINT32(0, link_params_idle_in(&s_lp, LINK_IDLE_MS));
+}
+
+TEST_CASE("input makes an idle link active and idle repeats do not", "[link]")
+{
+    link_params_up(&s_lp, T0);
+    request(LINK_PROFILE_IDLE);
+    link_params_updated(&s_lp, 0);
+    
+    /* A partner repeating the centered report is not input */
+    TEST_ASSERT_FALSE(link_params_input(&s_lp, 0, 0, 0, T0 + 5000));
+    TEST_ASSERT_EQUAL_UINT32(0, link_params_idle_in(&s_lp, T0 + 5000));
+    
+    /* A move is, and so is letting go of it */
+    TEST_ASSERT_TRUE(link_params_input(&s_lp, 40, 0, 0, T0 + 6000));
+    TEST_ASSERT_EQUAL(LINK_PROFILE_ACTIVE, link_params_want(&s_lp, LINK_PROFILE_ACTIVE));
+    link_params_sent(&s_lp, LINK_PROFILE_ACTIVE);
+    TEST_ASSERT_TRUE(link_params_input(&s_lp, 0, 0, 0, T0 + 6100));
+    TEST_ASSERT_FALSE(link_params_input(&s_lp, 0, 0, 0, T0 + 6200));
+    TEST_ASSERT_TRUE(link_params_input(&s_lp, 0, 0, 0x01, T0 + 6300));
+    TEST_ASSERT_TRUE(link_params_input(&s_lp, 0, -3, 0, T0 + 6400));
+    TEST_ASSERT_TRUE(link_params_input(&s_lp, 0, 0, 0, T0 + 6500));
+    TEST_ASSERT_FALSE(link_params_input(&s_lp, 0, 0, 0, T0 + 6600));
+    
+    TEST_ASSERT_EQUAL(LINK_PROFILE_NONE, link_params_updated(&s_lp, 0));
+    TEST_ASSERT_EQUAL(LINK_PROFILE_ACTIVE, s_lp.current);
+    TEST_ASSERT_EQUAL_UINT32(LINK_IDLE_MS, link_params_idle_in(&s_lp, T0 + 6500));
+    
+    /* Input on an active link asks for nothing */
+    TEST_ASSERT_TRUE(link_params_input(&s_lp, 10, 10, 0, T0 + 7000));
+    TEST_ASSERT_EQUAL(LINK_PROFILE_NONE, link_params_want(&s_lp, LINK_PROFILE_ACTIVE));
+}
+
+TEST_CASE("one connection update is in flight and the last profile wanted follows", "[link]")
+{
+    link_params_up(&s_lp, T0);
+    request(LINK_PROFILE_IDLE);
+    
+    /* Input during the idle update: waits for it, then goes back */
+    TEST_ASSERT_TRUE(link_params_input(&s_lp, 40, 0, 0, T0 + 2100));
+    TEST_ASSERT_EQUAL(LINK_PROFILE_NONE, link_params_want(&s_lp, LINK_PROFILE_ACTIVE));
+    TEST_ASSERT_EQUAL(LINK_PROFILE_IDLE, s_lp.pending);
+    TEST_ASSERT_EQUAL(LINK_PROFILE_ACTIVE, link_params_updated(&s_lp, 0));
+    TEST_ASSERT_EQUAL(LINK_PROFILE_IDLE, s_lp.current);
+    link_params_sent(&s_lp, LINK_PROFILE_ACTIVE);
+    TEST_ASSERT_EQUAL(LINK_PROFILE_NONE, link_params_updated(&s_lp, 0));
+    TEST_ASSERT_EQUAL(LINK_PROFILE_ACTIVE, s_lp.current);
+    
+    /* Wanted and unwanted again before the update ends: nothing more */
+    request(LINK_PROFILE_IDLE);
+    TEST_ASSERT_EQUAL(LINK_PROFILE_NONE, link_params_want(&s_lp, LINK_PROFILE_ACTIVE));
+    TEST_ASSERT_EQUAL(LINK_PROFILE_NONE, link_params_want(&s_lp, LINK_PROFILE_IDLE));
+    TEST_ASSERT_EQUAL(LINK_PROFILE_NONE, link_params_updated(&s_lp, 0));
+    TEST_ASSERT_EQUAL(LINK_PROFILE_IDLE, s_lp.current);
+    
+    /* The controller refusing the request leaves nothing in flight; the next want asks again */
+    TEST_ASSERT_EQUAL(LINK_PROFILE_ACTIVE, link_params_want(&s_lp, LINK_PROFILE_ACTIVE));
+    TEST_ASSERT_EQUAL(LINK_PROFILE_NONE, s_lp.pending);
+    TEST_ASSERT_EQUAL(LINK_PROFILE_ACTIVE, link_params_want(&s_lp, LINK_PROFILE_ACTIVE));
+}
+
+TEST_CASE("a profile the peer rejects is not asked for again", "[link]")
+{
+    link_params_up(&s_lp, T0);
+    request(LINK_PROFILE_IDLE);
+    TEST_ASSERT_EQUAL(LINK_PROFILE_NONE, link_params_updated(&s_lp, UPDATE_REJECTED));
+    TEST_ASSERT_EQUAL(LINK_PROFILE_ACTIVE, s_lp.current);
+    TEST_ASSERT_EQUAL(LINK_PROFILE_ACTIVE, s_lp.wanted);
+    TEST_ASSERT_EQUAL(LINK_PROFILE_NONE, s_lp.pending);
+    
+    /* Rejected while input wanted the other one: stays where it is */
+    request(LINK_PROFILE_IDLE);
+    TEST_ASSERT_EQUAL(LINK_PROFILE_NONE, link_params_want(&s_lp, LINK_PROFILE_ACTIVE));
+    TEST_ASSERT_EQUAL(LINK_PROFILE_NONE, link_params_updated(&s_lp, UPDATE_REJECTED));
+    TEST_ASSERT_EQUAL(LINK_PROFILE_ACTIVE, s_lp.current);
+    
+    /* An update the peer starts puts its parameters in effect, and ours are asked for again */
+    TEST_ASSERT_EQUAL(LINK_PROFILE_ACTIVE, link_params_updated(&s_lp, 0));
+    TEST_ASSERT_EQUAL(LINK_PROFILE_NONE, s_lp.current);
+    TEST_ASSERT_EQUAL_STRING("peer", link_profile_name(s_lp.current));
+    link_params_sent(&s_lp, LINK_PROFILE_ACTIVE);
+    TEST_ASSERT_EQUAL(LINK_PROFILE_NONE, link_params_updated(&s_lp, 0));
+    TEST_ASSERT_EQUAL(LINK_PROFILE_ACTIVE, s_lp.current);
+    
+    /* One it starts and fails changes nothing */
+    TEST_ASSERT_EQUAL(LINK_PROFILE_NONE, link_params_updated(&s_lp, UPDATE_REJECTED));
+    TEST_ASSERT_EQUAL(LINK_PROFILE_ACTIVE, s_lp.current);
+}
+
+TEST_CASE("nothing is asked for without a connection", "[link]")
+{
+    link_params_up(&s_lp, T0);
+    request(LINK_PROFILE_IDLE);
+    link_params_down(&s_lp);
+    TEST_ASSERT_FALSE(s_lp.connected);
+    TEST_ASSERT_EQUAL(LINK_PROFILE_NONE, s_lp.current);
+    TEST_ASSERT_EQUAL(LINK_PROFILE_NONE, s_lp.pending);
+    TEST_ASSERT_EQUAL(LINK_PROFILE_NONE, link_params_want(&s_lp, LINK_PROFILE_ACTIVE));
+    TEST_ASSERT_EQUAL(LINK_PROFILE_NONE, link_params_want(&s_lp, LINK_PROFILE_IDLE));
+    
+    /* The next link starts over, whatever the last one wanted */
+    TEST_ASSERT_TRUE(link_params_input(&s_lp, 40, 0, 0, T0 + 3000));
+    link_params_up(&s_lp, T0 + 4000);
+    TEST_ASSERT_EQUAL(LINK_PROFILE_ACTIVE, s_lp.current);
+    TEST_ASSERT_EQUAL(LINK_PROFILE_ACTIVE, s_lp.wanted);
+    TEST_ASSERT_FALSE(link_params_input(&s_lp, 0, 0, 0, T0 + 4100));
+    TEST_ASSERT_EQUAL_UINT32(LINK_IDLE_MS - 100, link_params_idle_in(&s_lp, T0 + 4100));
+}
+
+TEST_CASE("the link stays on 1M unless a PHY update moves it to 2M", "[link]")
+{
+    link_params_up(&s_lp, T0);
+    TEST_ASSERT_EQUAL_UINT8(1, s_lp.tx_phy);
+    TEST_ASSERT_EQUAL_UINT8(1, s_lp.rx_phy);
+    
+    /* A partner without 2M: the update fails and 1M stays */
+    link_params_phy(&s_lp, UPDATE_REJECTED, true, true);
+    TEST_ASSERT_EQUAL_UINT8(1, s_lp.tx_phy);
+    TEST_ASSERT_EQUAL_UINT8(1, s_lp.rx_phy);
+    
+    link_params_phy(&s_lp, 0, true, true);
+    TEST_ASSERT_EQUAL_UINT8(2, s_lp.tx_phy);
+    TEST_ASSERT_EQUAL_UINT8(2, s_lp.rx_phy);
+    link_params_phy(&s_lp, UPDATE_REJECTED, false, false);
+    TEST_ASSERT_EQUAL_UINT8(2, s_lp.tx_phy);
+    
+    /* Each direction on its own */
+    link_params_phy(&s_lp, 0, true, false);
+    TEST_ASSERT_EQUAL_UINT8(2, s_lp.tx_phy);
+    TEST_ASSERT_EQUAL_UINT8(1, s_lp.rx_phy);
+    
+    /* A new connection starts on 1M */
+    link_params_down(&s_lp);
+    link_params_up(&s_lp, T0);
+    TEST_ASSERT_EQUAL_UINT8(1, s_lp.tx_phy);
+    TEST_ASSERT_EQUAL_UINT8(1, s_lp.rx_phy);
+}
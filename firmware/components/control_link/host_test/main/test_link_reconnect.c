@@ -0,0 +1,121 @@
+/**
+ * @file test_link_reconnect.c
+ * @brief Reconnect scans: fast, then slow, white-listed once the partner is known
+ *
+ * Times are esp_timer microseconds, as control_link.c passes them; each
+ * test checks the scan link_reconnect plans at points along the way.
+ */
+
+#include "unity.h"
+#include "link_reconnect.h"
+
+#define SEC                 1000000LL
+#define T0                  (1000 * SEC)
+
+static link_reconnect_t s_lr;
+
+static void assert_fast(const link_scan_t *scan, uint32_t duration_ms)
+{
+    TEST_ASSERT_TRUE(scan->fast);
+    TEST_ASSERT_EQUAL_UINT32(duration_ms, scan->duration_ms);
+    TEST_ASSERT_EQUAL(LINK_SCAN_FAST_ITVL, scan->itvl);
+    TEST_ASSERT_EQUAL(LINK_SCAN_FAST_WINDOW, scan->window);
+}
+
+static void assert_slow(const link_scan_t *scan)
+{
+    TEST_ASSERT_FALSE(scan->fast);
+    TEST_ASSERT_EQUAL_UINT32(0, scan->duration_ms);
+    TEST_ASSERT_EQUAL(LINK_SCAN_SLOW_ITVL, scan->itvl);
+    TEST_ASSERT_EQUAL(LINK_SCAN_SLOW_WINDOW, scan->window);
+}
+
+TEST_CASE("scans run fast for LINK_SCAN_FAST_MS after link loss, then slow with no end", "[link]")
+{
+    link_scan_t scan;
+    
+    link_reconnect_partner(&s_lr, false);
+    link_reconnect_lost(&s_lr, T0);
+    link_reconnect_scan(&s_lr, T0, &scan);
+    assert_fast(&scan, LINK_SCAN_FAST_MS);
+    link_reconnect_scan(&s_lr, T0 + 10 * SEC, &scan);
+    assert_fast(&scan, LINK_SCAN_FAST_MS - 10000);
+    link_reconnect_scan(&s_lr, T0 + LINK_SCAN_FAST_MS * 1000LL - 1000, &scan);
+    assert_fast(&scan, 1);
+    
+    link_reconnect_scan(&s_lr, T0 + LINK_SCAN_FAST_MS * 1000LL, &scan);
+    assert_slow(&scan);
+    link_reconnect_scan(&s_lr, T0 + 3600 * SEC, &scan);
+    assert_slow(&scan);
+    
+    /* Full duty, then about 5% */
+    TEST_ASSERT_EQUAL(LINK_SCAN_FAST_ITVL, LINK_SCAN_FAST_WINDOW);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(LINK_SCAN_SLOW_ITVL / 20, LINK_SCAN_SLOW_WINDOW);
+}
+
+TEST_CASE("the scan started when a fast one ends is slow", "[link]")
+{
+    link_scan_t scan;
+    
+    /* Wherever in a millisecond the link dropped and the fast scan started */
+    for (int64_t lost = T0; lost < T0 + 1000; lost += 137) {
+        for (int64_t start = lost; start < lost + 20 * SEC; start += 3 * SEC + 251) {
+            link_reconnect_lost(&s_lr, lost);
+            link_reconnect_scan(&s_lr, start, &scan);
+            TEST_ASSERT_TRUE(scan.fast);
+            link_reconnect_scan(&s_lr, start + scan.duration_ms * 1000LL, &scan);
+            assert_slow(&scan);
+        }
+    }
+    
+    /* Refused and retried mid-way: still fast, for what is left of the phase */
+    link_reconnect_lost(&s_lr, T0);
+    link_reconnect_scan(&s_lr, T0 + 12 * SEC, &scan);
+    assert_fast(&scan, LINK_SCAN_FAST_MS - 12000);
+}
+
+TEST_CASE("a known partner is scanned for on the white list, passively", "[link]")
+{
+    link_scan_t scan;
+    
+    /* First pairing: by name, which may only be in the scan response */
+    link_reconnect_partner(&s_lr, false);
+    link_reconnect_lost(&s_lr, T0);
+    link_reconnect_scan(&s_lr, T0, &scan);
+    TEST_ASSERT_FALSE(scan.white_list);
+    TEST_ASSERT_FALSE(scan.passive);
+    
+    /* Remembered once it completes discovery: white list for fast and slow scans */
+    link_reconnect_partner(&s_lr, true);
+    link_reconnect_lost(&s_lr, T0 + 100 * SEC);
+    link_reconnect_scan(&s_lr, T0 + 100 * SEC, &scan);
+    TEST_ASSERT_TRUE(scan.fast);
+    TEST_ASSERT_TRUE(scan.white_list);
+    TEST_ASSERT_TRUE(scan.passive);
+    link_reconnect_scan(&s_lr, T0 + 200 * SEC, &scan);
+    assert_slow(&scan);
+    TEST_ASSERT_TRUE(scan.white_list);
+    TEST_ASSERT_TRUE(scan.passive);
+    
+    /* White list refused: back to the name */
+    link_reconnect_partner(&s_lr, false);
+    link_reconnect_scan(&s_lr, T0 + 200 * SEC, &scan);
+    TEST_ASSERT_FALSE(scan.white_list);
+    TEST_ASSERT_FALSE(scan.passive);
+}
+
+TEST_CASE("every link loss starts the fast phase again", "[link]")
+{
+    link_scan_t scan;
+    
+    /* Host sync at boot counts as a loss */
+    link_reconnect_lost(&s_lr, 0);
+    link_reconnect_scan(&s_lr, 2 * SEC, &scan);
+    assert_fast(&scan, LINK_SCAN_FAST_MS - 2000);
+    link_reconnect_scan(&s_lr, 45 * SEC, &scan);
+    assert_slow(&scan);
+    
+    link_reconnect_lost(&s_lr, 50 * SEC);
+    link_reconnect_scan(&s_lr, 50 * SEC, &scan);
+    assert_fast(&scan, LINK_SCAN_FAST_MS);
+}
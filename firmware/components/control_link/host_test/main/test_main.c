@@ -0,0 +1,18 @@
+/**
+ * @file test_main.c
+ * @brief Control link host tests - entry point
+ *
+ * Built for the linux target. There is no BLE stack on the host; the
+ * tests drive the link policy modules with the events control_link.c
+ * would feed them and check what they ask it to do.
+ */
+
+#include <stdlib.h>
+#include "unity.h"
+
+void app_main(void)
+{
+    UNITY_BEGIN();
+    unity_run_all_tests();
+    exit(UNITY_END());
+}
@@ -2,6 +2,8 @@
 
 #include "esp_err.h"
 #include "esp_event.h"
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 ESP_EVENT_DECLARE_BASE(CONTROL_LINK_EVENT);
@@ -12,6 +14,7 @@ typedef enum {
     CONTROL_LINK_EVENT_MACRO,
     CONTROL_LINK_EVENT_SENSOR,
     CONTROL_LINK_EVENT_JOYSTICK,
+    CONTROL_LINK_EVENT_READY,       // Partner attributes resolved, data: control_link_handles_t
 } control_link_event_id_t;
 
 typedef struct {
@@ -26,11 +29,38 @@ typedef struct {
     uint8_t buttons;
     uint8_t layer;
     uint32_t seq;
+    uint32_t rx_us;         // When the report arrived (esp_timer, low 32 bits)
+    uint32_t capture_us;    // When the partner sampled it, on the same clock
+    bool capture_valid;     // capture_us is set (the partner knows the clock offset)
 } control_link_joystick_t;
 
+// Partner attribute (characteristic value) handles, 0 where the partner lacks one
+typedef struct {
+    uint16_t conn_handle;
+    uint16_t mesh_inbox;
+    uint16_t mesh_send;
+    uint16_t mesh_status;
+    uint16_t mesh_node_list;
+    uint16_t joystick;
+    uint16_t keypad;
+    uint16_t command;
+    uint16_t ack;
+    uint16_t heartbeat;
+} control_link_handles_t;
+
 esp_err_t control_link_init(void);
 esp_err_t control_link_start_advertising(void);
 esp_err_t control_link_send_ack(uint32_t seq);
+
+// ACK a joystick report once the UI has shown it, with its receive, input and
+// shown times; fills in the report as received. ESP_ERR_NOT_FOUND if it is too old.
+esp_err_t control_link_ack_input(uint32_t seq, uint32_t input_us, uint32_t shown_us,
+                                 control_link_joystick_t *state);
 esp_err_t control_link_subscribe_macros(void (*handler)(const control_link_packet_t *packet));
 esp_err_t control_link_subscribe_joystick(void (*handler)(const control_link_joystick_t *state));
+// Called in the BLE host task once the partner's attributes are resolved and
+// notifications are on, and with NULL when the link drops
+esp_err_t control_link_subscribe_ready(void (*handler)(const control_link_handles_t *handles));
+// Called in the BLE host task for notifications other than joystick reports
+esp_err_t control_link_subscribe_notify(void (*handler)(uint16_t attr_handle, const uint8_t *data, size_t len));
 bool control_link_is_connected(void);
@@ -0,0 +1,94 @@
+/**
+ * @file link_params.c
+ * @brief Connection profile and PHY state of the partner link
+ */
+
+#include "link_params.h"
+
+#include <string.h>
+
+static const char *s_profile_names[] = {
+    [LINK_PROFILE_ACTIVE] = "active",
+    [LINK_PROFILE_IDLE] = "idle",
+};
+
+const char *link_profile_name(link_profile_t profile)
+{
+    return profile == LINK_PROFILE_NONE ? "peer" : s_profile_names[profile];
+}
+
+void link_params_up(link_params_t *lp, uint32_t now_ms)
+{
+    memset(lp, 0, sizeof(*lp));
+    lp->connected = true;
+    lp->current = LINK_PROFILE_ACTIVE;
+    lp->wanted = LINK_PROFILE_ACTIVE;
+    lp->pending = LINK_PROFILE_NONE;
+    lp->last_input_ms = now_ms;
+    lp->tx_phy = 1;
+    lp->rx_phy = 1;
+}
+
+void link_params_down(link_params_t *lp)
+{
+    lp->connected = false;
+    lp->current = LINK_PROFILE_NONE;
+    lp->pending = LINK_PROFILE_NONE;
+}
+
+link_profile_t link_params_want(link_params_t *lp, link_profile_t profile)
+{
+    lp->wanted = profile;
+    if (!lp->connected || lp->pending != LINK_PROFILE_NONE || lp->current == profile) {
+        return LINK_PROFILE_NONE;
+    }
+    return profile;
+}
+
+void link_params_sent(link_params_t *lp, link_profile_t profile)
+{
+    lp->pending = profile;
+}
+
+link_profile_t link_params_updated(link_params_t *lp, int status)
+{
+    link_profile_t requested = lp->pending;
+    lp->pending = LINK_PROFILE_NONE;
+    
+    if (status == 0) {
+        /* An update the peer started leaves its parameters in effect */
+        lp->current = requested;
+    } else if (requested != LINK_PROFILE_NONE) {
+        /* Keep the current parameters rather than retrying what the peer refused */
+        lp->wanted = lp->current;
+    }
+    
+    return link_params_want(lp, lp->wanted);
+}
+
+bool link_params_input(link_params_t *lp, int8_t x, int8_t y, uint8_t buttons, uint32_t now_ms)
+{
+    bool active = x || y || buttons || lp->last_x || lp->last_y || lp->last_buttons;
+    lp->last_x = x;
+    lp->last_y = y;
+    lp->last_buttons = buttons;
+    if (active) {
+        lp->last_input_ms = now_ms;
+    }
+    return active;
+}
+
+uint32_t link_params_idle_in(const link_params_t *lp, uint32_t now_ms)
+{
+    uint32_t quiet = now_ms - lp->last_input_ms;
+    return quiet < LINK_IDLE_MS ? LINK_IDLE_MS - quiet : 0;
+}
+
+void link_params_phy(link_params_t *lp, int status, bool tx_2m, bool rx_2m)
+{
+    if (status != 0) {
+        return;
+    }
+    lp->tx_phy = tx_2m ? 2 : 1;
+    lp->rx_phy = rx_2m ? 2 : 1;
+}
@@ -0,0 +1,99 @@
+/**
+ * @file link_params.h
+ * @brief Connection profile and PHY state of the partner link (private to control_link)
+ *
+ * Decides which connection parameters the link should run at and when to
+ * ask for them; control_link.c makes the GAP calls. No BLE types here, so
+ * the decisions can be tested on the host.
+ *
+ * While the joystick is in use the link runs at the active profile, so a
+ * notification waits at most one short interval; after LINK_IDLE_MS without
+ * input it relaxes to the idle profile, with slave latency, so the partner
+ * can sleep through events when it has nothing to send. One update is in
+ * flight at a time, a profile wanted meanwhile is asked for when it ends,
+ * and a profile the peer rejects is not asked for again.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define LINK_IDLE_MS            2000
+
+typedef enum {
+    LINK_PROFILE_NONE = -1,
+    LINK_PROFILE_ACTIVE,
+    LINK_PROFILE_IDLE,
+} link_profile_t;
+
+typedef struct {
+    bool connected;
+    link_profile_t current;             /* In effect, NONE = the peer's choice */
+    link_profile_t wanted;
+    link_profile_t pending;             /* Update in flight */
+    uint32_t last_input_ms;
+    int8_t last_x;                      /* Last joystick report */
+    int8_t last_y;
+    uint8_t last_buttons;
+    uint8_t tx_phy;                     /* 1 or 2 (Mbit/s) */
+    uint8_t rx_phy;
+} link_params_t;
+
+/**
+ * @brief Name of a profile, for logs
+ */
+const char *link_profile_name(link_profile_t profile);
+
+/**
+ * @brief A connection was made, with the active profile's parameters on 1M
+ */
+void link_params_up(link_params_t *lp, uint32_t now_ms);
+
+/**
+ * @brief The connection dropped: nothing in effect or in flight
+ */
+void link_params_down(link_params_t *lp);
+
+/**
+ * @brief Move the link towards a profile
+ * @return The profile to request now, or LINK_PROFILE_NONE if none is due
+ *         (not connected, an update in flight, or already in effect)
+ */
+link_profile_t link_params_want(link_params_t *lp, link_profile_t profile);
+
+/**
+ * @brief The controller accepted an update request for a profile
+ */
+void link_params_sent(link_params_t *lp, link_profile_t profile);
+
+/**
+ * @brief A connection update finished, whoever started it
+ * @param status 0 on success, else the controller's or peer's error
+ * @return The profile to request next, or LINK_PROFILE_NONE
+ */
+link_profile_t link_params_updated(link_params_t *lp, int status);
+
+/**
+ * @brief A joystick report arrived
+ *
+ * A report that moves off center, holds a button or differs from the
+ * last one counts as input; a partner repeating an idle report does not.
+ *
+ * @return Whether it counted as input (the link should be active)
+ */
+bool link_params_input(link_params_t *lp, int8_t x, int8_t y, uint8_t buttons, uint32_t now_ms);
+
+/**
+ * @brief Time left before the link should go idle
+ * @return Milliseconds until LINK_IDLE_MS after the last input, 0 if due
+ */
+uint32_t link_params_idle_in(const link_params_t *lp, uint32_t now_ms);
+
+/**
+ * @brief A PHY update finished
+ *
+ * A failed update leaves the PHYs as they were: 1M unless the partner
+ * took 2M earlier in the connection.
+ */
+void link_params_phy(link_params_t *lp, int status, bool tx_2m, bool rx_2m);
@@ -0,0 +1,31 @@
+/**
+ * @file link_reconnect.c
+ * @brief Scan schedule for finding the partner again
+ */
+
+#include "link_reconnect.h"
+
+void link_reconnect_lost(link_reconnect_t *lr, int64_t now_us)
+{
+    lr->lost_us = now_us;
+}
+
+void link_reconnect_partner(link_reconnect_t *lr, bool white_listed)
+{
+    lr->partner_known = white_listed;
+}
+
+void link_reconnect_scan(const link_reconnect_t *lr, int64_t now_us, link_scan_t *scan)
+{
+    int64_t fast_left = LINK_SCAN_FAST_MS - (now_us - lr->lost_us) / 1000;
+    bool fast = fast_left > 0;
+    
+    *scan = (link_scan_t){
+        .fast = fast,
+        .duration_ms = fast ? (uint32_t)fast_left : 0,
+        .itvl = fast ? LINK_SCAN_FAST_ITVL : LINK_SCAN_SLOW_ITVL,
+        .window = fast ? LINK_SCAN_FAST_WINDOW : LINK_SCAN_SLOW_WINDOW,
+        .white_list = lr->partner_known,
+        .passive = lr->partner_known,   /* The name may only be in the scan response */
+    };
+}
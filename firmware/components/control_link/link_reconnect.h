@@ -0,0 +1,59 @@
+/**
+ * @file link_reconnect.h
+ * @brief Scan schedule for finding the partner again (private to control_link)
+ *
+ * Decides how control_link.c scans; it makes the GAP calls. No BLE types
+ * here, so the schedule can be tested on the host.
+ *
+ * The partner that last completed discovery is put on the controller's
+ * white list, so scans report nothing but its advertisements; without one
+ * the scan is active and looks for the partner's name. Scanning runs at
+ * full duty for the first LINK_SCAN_FAST_MS after the link drops (or after
+ * host sync), then at a low duty cycle with no end.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define LINK_SCAN_FAST_MS       30000
+#define LINK_SCAN_FAST_ITVL     0x0030  /* 30 ms */
+#define LINK_SCAN_FAST_WINDOW   0x0030  /* 30 ms, continuous */
+#define LINK_SCAN_SLOW_ITVL     0x0800  /* 1.28 s */
+#define LINK_SCAN_SLOW_WINDOW   0x0060  /* 60 ms, about 5%: one partner advertising interval */
+
+typedef struct {
+    bool partner_known;                 /* On the white list */
+    int64_t lost_us;                    /* Link dropped, or host synced */
+} link_reconnect_t;
+
+/* One scan, interval and window in 0.625 ms units */
+typedef struct {
+    bool fast;
+    uint32_t duration_ms;               /* 0 = until cancelled */
+    uint16_t itvl;
+    uint16_t window;
+    bool white_list;                    /* Report only the known partner */
+    bool passive;                       /* No scan requests: the name is not needed */
+} link_scan_t;
+
+/**
+ * @brief The link dropped, or the host synced: start over with fast scans
+ */
+void link_reconnect_lost(link_reconnect_t *lr, int64_t now_us);
+
+/**
+ * @brief Whether a partner is on the white list
+ *
+ * False when none is stored or the controller refused the white list.
+ */
+void link_reconnect_partner(link_reconnect_t *lr, bool white_listed);
+
+/**
+ * @brief The scan to run now
+ *
+ * A fast scan lasts until the end of the fast phase, so the scan started
+ * when it ends is a slow one.
+ */
+void link_reconnect_scan(const link_reconnect_t *lr, int64_t now_us, link_scan_t *scan);
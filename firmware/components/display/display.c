@@ -4,335 +4,1796 @@
  */
 
 #include "display.h"
-#include "driver/i2c.h"
+#include "display_backend.h"
+#include "display_font.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdatomic.h>
 
 static const char *TAG = "display";
 
-#define I2C_PORT I2C_NUM_0
-
-/* SSD1306 commands */
-#define CMD_DISPLAY_OFF         0xAE
-#define CMD_DISPLAY_ON          0xAF
-#define CMD_SET_CONTRAST        0x81
-#define CMD_NORMAL_DISPLAY      0xA6
-#define CMD_INVERT_DISPLAY      0xA7
-#define CMD_SET_MUX_RATIO       0xA8
-#define CMD_SET_DISPLAY_OFFSET  0xD3
-#define CMD_SET_START_LINE      0x40
-#define CMD_SET_SEG_REMAP       0xA0
-#define CMD_SET_COM_SCAN_DIR    0xC0
-#define CMD_SET_COM_PINS        0xDA
-#define CMD_SET_CLOCK_DIV       0xD5
-#define CMD_SET_PRECHARGE       0xD9
-#define CMD_SET_VCOM_DESELECT   0xDB
-#define CMD_CHARGE_PUMP         0x8D
-#define CMD_MEMORY_MODE         0x20
-#define CMD_SET_COLUMN_ADDR     0x21
-#define CMD_SET_PAGE_ADDR       0x22
-
-/* Display buffer */
-static uint8_t s_buffer[DISPLAY_WIDTH * DISPLAY_HEIGHT / 8];
-static uint8_t s_i2c_addr = 0x3C;
+#define FRAME_SIZE              (DISPLAY_WIDTH * DISPLAY_PAGES)
+#define BAND_SIZE               (DISPLAY_WIDTH * DISPLAY_BAND_PAGES)
+#define BAND_COUNT              ((DISPLAY_PAGES + DISPLAY_BAND_PAGES - 1) / DISPLAY_BAND_PAGES)
+
+/*
+ * Draw target: the back buffer, the current band on banded panels, or a
+ * surface. Page `s_page0` is at its start, it holds `s_target_pages` pages
+ * of `s_stride` columns. Word aligned for the span fast paths.
+ */
+static uint8_t *s_buffer = NULL;
+static int s_page0 = 0;
+static int s_target_pages = DISPLAY_PAGES;
+static int s_stride = DISPLAY_WIDTH;
+
+/*
+ * Full-frame panels (allocated at init): back buffer, the frame being sent
+ * by the flush task while the next one is drawn, and a copy of what the
+ * panel currently shows, used to find changed regions. The shadow belongs
+ * to whoever sends frames (the flush task, or display_render() on banded
+ * panels); other tasks only ask for it to be dropped through
+ * s_invalidate_req, which the sender takes up before its next frame.
+ */
+static uint8_t *s_back = NULL;
+static uint8_t *s_front = NULL;
+static uint8_t *s_shadow = NULL;
+static bool s_shadow_valid = false;
+static atomic_bool s_invalidate_req;
+
+/* Written by the drawing task and the flush task, read by anyone */
+static display_stats_t s_stats = {0};
+static SemaphoreHandle_t s_stats_lock = NULL;
+
+/*
+ * Hardware scroll: logical row y lives in panel RAM row
+ * (y + s_row_offset) % DISPLAY_HEIGHT, and the panel's start line undoes
+ * the rotation. A new offset takes effect at the next display_clear().
+ */
+static int s_row_offset = 0;
+static int s_row_offset_next = 0;
+static int s_front_row_offset = 0;      /* Offset of the frame in s_front */
+static int s_shadow_row_offset = 0;     /* Start line the panel is using */
+
+/*
+ * Banded panels: two band buffers, one drawn while the other is on the
+ * wire (static, so in DMA-capable internal RAM), and a hash per band to
+ * skip bands that did not change
+ */
+static bool s_banded = false;
+static uint8_t s_band_buf[2][BAND_SIZE] __attribute__((aligned(4)));
+static uint32_t s_band_hash[BAND_COUNT];
+
+/* Clip rectangle in screen coordinates (x1/y1 exclusive) and drawing origin */
+typedef struct {
+    int16_t x0, y0, x1, y1;
+    int16_t ox, oy;
+} clip_t;
+
+#define CLIP_FULL   { 0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT, 0, 0 }
+#define CLIP_NONE   { 0, 0, 0, 0, 0, 0 }
+
+/* Base clip: the screen, the band being drawn, or nothing without a target */
+static clip_t s_clip_base = CLIP_NONE;
+static clip_t s_clip = CLIP_NONE;
+static clip_t s_clip_stack[DISPLAY_CLIP_STACK_DEPTH];
+static int s_clip_depth = 0;
+static int s_clip_overflow = 0;     /* Pushes refused, so pops stay balanced */
+
+/* Draw target and clip state put aside while drawing into a surface */
+typedef struct {
+    display_surface_t *surface;     /* Enclosing surface, NULL for the screen */
+    uint8_t *buffer;
+    int page0;
+    int pages;
+    int stride;
+    int row_offset;
+    clip_t clip_base;
+    clip_t clip;
+    clip_t clip_stack[DISPLAY_CLIP_STACK_DEPTH];
+    int clip_depth;
+    int clip_overflow;
+} saved_target_t;
+
+static display_surface_t *s_surface = NULL;     /* Surface being drawn, NULL if none */
+static saved_target_t s_saved_targets[DISPLAY_SURFACE_DEPTH];
+static int s_surface_depth = 0;
+static display_surface_stats_t s_surface_stats = {0};
+
+/**
+ * @brief Start of a page in the draw target (the page must be inside the clip)
+ */
+static inline uint8_t *page_row(int page)
+{
+    return &s_buffer[(page - s_page0) * s_stride];
+}
+
+/**
+ * @brief Panel RAM row of a logical row (y >= 0)
+ */
+static inline int ram_row(int y)
+{
+    return (unsigned)(y + s_row_offset) % DISPLAY_HEIGHT;
+}
+
+/* Flush task */
+#define FLUSH_TASK_STACK        3072
+#define FLUSH_TASK_PRIORITY     5
+
+static TaskHandle_t s_flush_task = NULL;
+static SemaphoreHandle_t s_flush_idle = NULL;
+static volatile bool s_flush_stop = false;
+
+static esp_err_t start_flush_task(void);
+static void stop_flush_task(void);
 static bool s_initialized = false;
 static display_type_t s_type = DISPLAY_TYPE_SSD1306_I2C;
+static const display_backend_t *s_backend = NULL;
+
+/**
+ * @brief Point drawing and the base clip at `pages` pages from `page0`
+ */
+static void set_target(uint8_t *buf, int page0, int pages)
+{
+    s_buffer = buf;
+    s_page0 = page0;
+    s_target_pages = pages;
+    s_stride = DISPLAY_WIDTH;
+    
+    clip_t base = { 0, page0 * 8, DISPLAY_WIDTH, (page0 + pages) * 8, 0, 0 };
+    s_clip_base = base;
+    display_reset_clip();
+}
+
+static esp_err_t alloc_frames(void)
+{
+    s_back = malloc(FRAME_SIZE);
+    s_front = malloc(FRAME_SIZE);
+    s_shadow = malloc(FRAME_SIZE);
+    if (!s_back || !s_front || !s_shadow) return ESP_ERR_NO_MEM;
+    
+    set_target(s_back, 0, DISPLAY_PAGES);
+    return ESP_OK;
+}
 
-/* 6x8 font */
-static const uint8_t font6x8[] = {
-    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x5F,0x00,0x00,0x00,
-    0x00,0x07,0x00,0x07,0x00,0x00,0x14,0x7F,0x14,0x7F,0x14,0x00,
-    0x24,0x2A,0x7F,0x2A,0x12,0x00,0x23,0x13,0x08,0x64,0x62,0x00,
-    0x36,0x49,0x56,0x20,0x50,0x00,0x00,0x08,0x07,0x03,0x00,0x00,
-    0x00,0x1C,0x22,0x41,0x00,0x00,0x00,0x41,0x22,0x1C,0x00,0x00,
-    0x2A,0x1C,0x7F,0x1C,0x2A,0x00,0x08,0x08,0x3E,0x08,0x08,0x00,
-    0x00,0x80,0x70,0x30,0x00,0x00,0x08,0x08,0x08,0x08,0x08,0x00,
-    0x00,0x00,0x60,0x60,0x00,0x00,0x20,0x10,0x08,0x04,0x02,0x00,
-    0x3E,0x51,0x49,0x45,0x3E,0x00,0x00,0x42,0x7F,0x40,0x00,0x00,
-    0x72,0x49,0x49,0x49,0x46,0x00,0x21,0x41,0x49,0x4D,0x33,0x00,
-    0x18,0x14,0x12,0x7F,0x10,0x00,0x27,0x45,0x45,0x45,0x39,0x00,
-    0x3C,0x4A,0x49,0x49,0x31,0x00,0x41,0x21,0x11,0x09,0x07,0x00,
-    0x36,0x49,0x49,0x49,0x36,0x00,0x46,0x49,0x49,0x29,0x1E,0x00,
-    0x00,0x00,0x14,0x00,0x00,0x00,0x00,0x40,0x34,0x00,0x00,0x00,
-    0x00,0x08,0x14,0x22,0x41,0x00,0x14,0x14,0x14,0x14,0x14,0x00,
-    0x00,0x41,0x22,0x14,0x08,0x00,0x02,0x01,0x59,0x09,0x06,0x00,
-    0x3E,0x41,0x5D,0x59,0x4E,0x00,0x7C,0x12,0x11,0x12,0x7C,0x00,
-    0x7F,0x49,0x49,0x49,0x36,0x00,0x3E,0x41,0x41,0x41,0x22,0x00,
-    0x7F,0x41,0x41,0x41,0x3E,0x00,0x7F,0x49,0x49,0x49,0x41,0x00,
-    0x7F,0x09,0x09,0x09,0x01,0x00,0x3E,0x41,0x41,0x51,0x73,0x00,
-    0x7F,0x08,0x08,0x08,0x7F,0x00,0x00,0x41,0x7F,0x41,0x00,0x00,
-    0x20,0x40,0x41,0x3F,0x01,0x00,0x7F,0x08,0x14,0x22,0x41,0x00,
-    0x7F,0x40,0x40,0x40,0x40,0x00,0x7F,0x02,0x1C,0x02,0x7F,0x00,
-    0x7F,0x04,0x08,0x10,0x7F,0x00,0x3E,0x41,0x41,0x41,0x3E,0x00,
-    0x7F,0x09,0x09,0x09,0x06,0x00,0x3E,0x41,0x51,0x21,0x5E,0x00,
-    0x7F,0x09,0x19,0x29,0x46,0x00,0x26,0x49,0x49,0x49,0x32,0x00,
-    0x03,0x01,0x7F,0x01,0x03,0x00,0x3F,0x40,0x40,0x40,0x3F,0x00,
-    0x1F,0x20,0x40,0x20,0x1F,0x00,0x3F,0x40,0x38,0x40,0x3F,0x00,
-    0x63,0x14,0x08,0x14,0x63,0x00,0x03,0x04,0x78,0x04,0x03,0x00,
-    0x61,0x59,0x49,0x4D,0x43,0x00,0x00,0x7F,0x41,0x41,0x41,0x00,
-    0x02,0x04,0x08,0x10,0x20,0x00,0x00,0x41,0x41,0x41,0x7F,0x00,
-    0x04,0x02,0x01,0x02,0x04,0x00,0x40,0x40,0x40,0x40,0x40,0x00,
-    0x00,0x03,0x07,0x08,0x00,0x00,0x20,0x54,0x54,0x78,0x40,0x00,
-    0x7F,0x28,0x44,0x44,0x38,0x00,0x38,0x44,0x44,0x44,0x28,0x00,
-    0x38,0x44,0x44,0x28,0x7F,0x00,0x38,0x54,0x54,0x54,0x18,0x00,
-    0x00,0x08,0x7E,0x09,0x02,0x00,0x18,0xA4,0xA4,0x9C,0x78,0x00,
-    0x7F,0x08,0x04,0x04,0x78,0x00,0x00,0x44,0x7D,0x40,0x00,0x00,
-    0x20,0x40,0x40,0x3D,0x00,0x00,0x7F,0x10,0x28,0x44,0x00,0x00,
-    0x00,0x41,0x7F,0x40,0x00,0x00,0x7C,0x04,0x78,0x04,0x78,0x00,
-    0x7C,0x08,0x04,0x04,0x78,0x00,0x38,0x44,0x44,0x44,0x38,0x00,
-    0xFC,0x18,0x24,0x24,0x18,0x00,0x18,0x24,0x24,0x18,0xFC,0x00,
-    0x7C,0x08,0x04,0x04,0x08,0x00,0x48,0x54,0x54,0x54,0x24,0x00,
-    0x04,0x04,0x3F,0x44,0x24,0x00,0x3C,0x40,0x40,0x20,0x7C,0x00,
-    0x1C,0x20,0x40,0x20,0x1C,0x00,0x3C,0x40,0x30,0x40,0x3C,0x00,
-    0x44,0x28,0x10,0x28,0x44,0x00,0x4C,0x90,0x90,0x90,0x7C,0x00,
-    0x44,0x64,0x54,0x4C,0x44,0x00,0x00,0x08,0x36,0x41,0x00,0x00,
-    0x00,0x00,0x77,0x00,0x00,0x00,0x00,0x41,0x36,0x08,0x00,0x00,
-    0x02,0x01,0x02,0x04,0x02,0x00,0x3C,0x26,0x23,0x26,0x3C,0x00,
-};
-
-/* I2C helpers */
-static esp_err_t send_cmd(uint8_t cmd)
-{
-    uint8_t data[2] = {0x00, cmd};
-    return i2c_master_write_to_device(I2C_PORT, s_i2c_addr, data, 2, pdMS_TO_TICKS(100));
-}
-
-static esp_err_t send_data(const uint8_t *data, size_t len)
-{
-    uint8_t *buf = malloc(len + 1);
-    if (!buf) return ESP_ERR_NO_MEM;
-    
-    buf[0] = 0x40;
-    memcpy(buf + 1, data, len);
-    
-    esp_err_t ret = i2c_master_write_to_device(I2C_PORT, s_i2c_addr, buf, len + 1, pdMS_TO_TICKS(100));
-    free(buf);
+static void free_frames(void)
+{
+    set_target(NULL, 0, 0);
+    free(s_back);
+    free(s_front);
+    free(s_shadow);
+    s_back = s_front = s_shadow = NULL;
+}
+
+static void clear_frame(void *ctx)
+{
+    display_clear();
+}
+
+esp_err_t display_init(const display_config_t *config)
+{
+    if (s_initialized) {
+        ESP_LOGW(TAG, "Already initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    const display_backend_t *backend = NULL;
+    
+    if (!s_stats_lock) {
+        s_stats_lock = xSemaphoreCreateMutex();
+        if (!s_stats_lock) return ESP_ERR_NO_MEM;
+    }
+    
+    switch (config->type) {
+        case DISPLAY_TYPE_SSD1306_I2C:
+#if CONFIG_IDF_TARGET_LINUX
+            ESP_LOGE(TAG, "SSD1306 not available on this target");
+            return ESP_ERR_NOT_SUPPORTED;
+#else
+            backend = &display_backend_ssd1306_i2c;
+            break;
+#endif
+        case DISPLAY_TYPE_TRANSPARENT_SPI:
+#if CONFIG_IDF_TARGET_LINUX
+            ESP_LOGE(TAG, "Transparent SPI not available on this target");
+            return ESP_ERR_NOT_SUPPORTED;
+#else
+            backend = &display_backend_spi;
+            break;
+#endif
+        case DISPLAY_TYPE_HOST:
+            backend = config->host.banded ? &display_backend_host_banded : &display_backend_host;
+            break;
+        default:
+            return ESP_ERR_INVALID_ARG;
+    }
+    
+    s_type = config->type;
+    s_backend = backend;
+    s_banded = backend->band_queue != NULL;
+    
+    esp_err_t ret = s_banded ? ESP_OK : alloc_frames();
+    if (ret == ESP_OK) {
+        ret = backend->init(config);
+    }
+    
+    if (ret == ESP_OK && !s_banded) {
+        ret = start_flush_task();
+        if (ret != ESP_OK) backend->deinit();
+    }
+    
+    if (ret == ESP_OK) {
+        s_initialized = true;
+        s_shadow_valid = false;
+        atomic_store(&s_invalidate_req, false);
+        display_render(clear_frame, NULL);
+        
+        /* Characters outside the fonts come from the glyph partition, if one is flashed */
+        esp_err_t gret = display_glyphs_mount("glyphs");
+        if (gret != ESP_OK && gret != ESP_ERR_NOT_SUPPORTED) {
+            ESP_LOGI(TAG, "No glyph store: %s", esp_err_to_name(gret));
+        }
+    } else {
+        free_frames();
+    }
+    
     return ret;
 }
 
-static esp_err_t init_ssd1306_i2c(const display_config_t *config)
+void display_deinit(void)
+{
+    if (s_initialized) {
+        if (!s_banded) stop_flush_task();
+        display_power(false);
+        s_backend->deinit();
+        free_frames();
+        s_initialized = false;
+    }
+}
+
+bool display_is_banded(void)
+{
+    return s_banded;
+}
+
+void display_clear(void)
+{
+    if (!s_surface) s_row_offset = s_row_offset_next;
+    if (s_buffer) memset(s_buffer, 0, s_target_pages * s_stride);
+}
+
+esp_err_t display_set_scroll(int rows)
+{
+    if (s_banded) return ESP_ERR_NOT_SUPPORTED;
+    
+    rows %= DISPLAY_HEIGHT;
+    s_row_offset_next = rows < 0 ? rows + DISPLAY_HEIGHT : rows;
+    return ESP_OK;
+}
+
+/**
+ * @brief Find the changed column span of one page against the shadow copy
+ * @return false if the page is unchanged
+ */
+static bool find_dirty_span(const uint8_t *frame, int page, int16_t *x0, int16_t *x1)
+{
+    const uint8_t *cur = &frame[page * DISPLAY_WIDTH];
+    const uint8_t *old = &s_shadow[page * DISPLAY_WIDTH];
+    
+    if (!s_shadow_valid) {
+        *x0 = 0;
+        *x1 = DISPLAY_WIDTH - 1;
+        return true;
+    }
+    
+    int lo = 0;
+    while (lo < DISPLAY_WIDTH && cur[lo] == old[lo]) lo++;
+    if (lo == DISPLAY_WIDTH) return false;
+    
+    int hi = DISPLAY_WIDTH - 1;
+    while (hi > lo && cur[hi] == old[hi]) hi--;
+    
+    *x0 = lo;
+    *x1 = hi;
+    return true;
+}
+
+/* Wire cost of a dirty page beyond its data on the SSD1306: a 6-byte window
+ * command, and an address and a control byte for each of its two transactions */
+#define SPAN_OVERHEAD   10
+
+/**
+ * @brief Diff a frame against the shadow copy
+ * @return Approximate bytes the spans will cost on the wire
+ */
+static uint32_t find_dirty_spans(const uint8_t *frame, display_span_t *spans)
+{
+    uint32_t cost = 0;
+    
+    for (int page = 0; page < DISPLAY_PAGES; page++) {
+        if (find_dirty_span(frame, page, &spans[page].x0, &spans[page].x1)) {
+            cost += spans[page].x1 - spans[page].x0 + 1 + SPAN_OVERHEAD;
+        } else {
+            spans[page].x0 = -1;
+        }
+    }
+    return cost;
+}
+
+/**
+ * @brief Move a frame to another row offset, in place
+ *
+ * A page-format column is one 64-bit word with RAM row r at bit r, so
+ * changing the offset is a rotate of each column.
+ */
+static void rotate_frame(uint8_t *frame, int rows)
+{
+    rows = (unsigned)rows % DISPLAY_HEIGHT;
+    if (rows == 0) return;
+    
+    for (int x = 0; x < DISPLAY_WIDTH; x++) {
+        uint64_t col = 0;
+        for (int page = 0; page < DISPLAY_PAGES; page++) {
+            col |= (uint64_t)frame[page * DISPLAY_WIDTH + x] << (page * 8);
+        }
+        col = (col << rows) | (col >> (DISPLAY_HEIGHT - rows));
+        for (int page = 0; page < DISPLAY_PAGES; page++) {
+            frame[page * DISPLAY_WIDTH + x] = (uint8_t)(col >> (page * 8));
+        }
+    }
+}
+
+/**
+ * @brief Hand the changed parts of a frame to the backend
+ *
+ * Clean frames never reach the backend. The shadow only takes the spans
+ * the backend accepted, so a failed flush is retried in full.
+ *
+ * When the frame was drawn at a new scroll offset, it is also diffed
+ * rotated back to the panel's current start line, and whichever costs
+ * fewer bytes is sent. Views whose fixed header is large next to the
+ * scrolled area are then never worse off for asking for hardware scroll.
+ */
+static void flush_frame(uint8_t *frame)
+{
+    display_span_t spans[DISPLAY_PAGES];
+    uint32_t sent = 0;
+    int64_t start = esp_timer_get_time();
+    
+    if (atomic_exchange(&s_invalidate_req, false)) s_shadow_valid = false;
+    uint32_t cost = find_dirty_spans(frame, spans);
+    bool dirty = cost > 0;
+    
+    if (s_shadow_valid && s_front_row_offset != s_shadow_row_offset) {
+        int delta = s_shadow_row_offset - s_front_row_offset;
+        rotate_frame(frame, delta);
+        
+        display_span_t kept[DISPLAY_PAGES];
+        uint32_t kept_cost = find_dirty_spans(frame, kept);
+        if (kept_cost <= cost) {
+            memcpy(spans, kept, sizeof(spans));
+            dirty = kept_cost > 0;
+            s_front_row_offset = s_shadow_row_offset;
+        } else {
+            rotate_frame(frame, -delta);
+        }
+    }
+    
+    /* A new start line goes out with the frame drawn for it */
+    int start_line = -1;
+    if (!s_shadow_valid || s_front_row_offset != s_shadow_row_offset) {
+        start_line = s_front_row_offset;
+        dirty = true;
+    }
+    
+    esp_err_t ret = dirty ? s_backend->flush(frame, spans, start_line, &sent) : ESP_OK;
+    
+    if (ret != ESP_OK) {
+        /* Panel state is unknown now, resend everything next time */
+        ESP_LOGW(TAG, "Flush failed: %s", esp_err_to_name(ret));
+        s_shadow_valid = false;
+        return;
+    }
+    
+    for (int page = 0; page < DISPLAY_PAGES; page++) {
+        if (spans[page].x0 < 0) continue;
+        int idx = page * DISPLAY_WIDTH + spans[page].x0;
+        memcpy(&s_shadow[idx], &frame[idx], spans[page].x1 - spans[page].x0 + 1);
+    }
+    s_shadow_valid = true;
+    s_shadow_row_offset = s_front_row_offset;
+    
+    xSemaphoreTake(s_stats_lock, portMAX_DELAY);
+    s_stats.frames++;
+    s_stats.last_frame_bytes = sent;
+    s_stats.total_bytes += sent;
+    s_stats.last_flush_us = (uint32_t)(esp_timer_get_time() - start);
+    if (!dirty) s_stats.skipped_frames++;
+    xSemaphoreGive(s_stats_lock);
+}
+
+static void flush_task(void *arg)
+{
+    while (!s_flush_stop) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (s_flush_stop) break;
+        flush_frame(s_front);
+        xSemaphoreTake(s_stats_lock, portMAX_DELAY);
+        s_stats.last_done_us = (uint32_t)esp_timer_get_time();
+        s_stats.done++;
+        xSemaphoreGive(s_stats_lock);
+        xSemaphoreGive(s_flush_idle);
+    }
+    
+    xSemaphoreGive(s_flush_idle);
+    vTaskDelete(NULL);
+}
+
+static esp_err_t start_flush_task(void)
+{
+    s_flush_idle = xSemaphoreCreateBinary();
+    if (!s_flush_idle) return ESP_ERR_NO_MEM;
+    xSemaphoreGive(s_flush_idle);
+    
+    s_flush_stop = false;
+    if (xTaskCreate(flush_task, "disp_flush", FLUSH_TASK_STACK, NULL,
+                    FLUSH_TASK_PRIORITY, &s_flush_task) != pdPASS) {
+        vSemaphoreDelete(s_flush_idle);
+        s_flush_idle = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+static void stop_flush_task(void)
+{
+    if (!s_flush_task) return;
+    
+    /* Let the frame in flight finish, then wake the task so it exits */
+    xSemaphoreTake(s_flush_idle, portMAX_DELAY);
+    s_flush_stop = true;
+    xTaskNotifyGive(s_flush_task);
+    xSemaphoreTake(s_flush_idle, portMAX_DELAY);
+    
+    vSemaphoreDelete(s_flush_idle);
+    s_flush_idle = NULL;
+    s_flush_task = NULL;
+}
+
+void display_refresh(void)
+{
+    /* Banded panels are only updated through display_render() */
+    if (!s_initialized || s_banded) return;
+    
+    /* Wait for the previous frame to leave, then hand this one over */
+    int64_t start = esp_timer_get_time();
+    xSemaphoreTake(s_flush_idle, portMAX_DELAY);
+    uint32_t wait_us = (uint32_t)(esp_timer_get_time() - start);
+    
+    memcpy(s_front, s_back, FRAME_SIZE);
+    s_front_row_offset = s_row_offset;
+    
+    xSemaphoreTake(s_stats_lock, portMAX_DELAY);
+    s_stats.last_wait_us = wait_us;
+    s_stats.queued++;
+    xSemaphoreGive(s_stats_lock);
+    xTaskNotifyGive(s_flush_task);
+}
+
+/* ============================================================================
+ * Banded Rendering
+ * ============================================================================ */
+
+static uint32_t band_hash(const uint8_t *p, int len)
+{
+    uint32_t h = 2166136261u;       /* FNV-1a */
+    for (int i = 0; i < len; i++) {
+        h = (h ^ p[i]) * 16777619u;
+    }
+    return h;
+}
+
+/**
+ * @brief Draw the frame band by band, overlapping drawing with DMA
+ *
+ * Band N is drawn into one buffer while band N-1 is still being sent from
+ * the other. Before a buffer is reused, its previous transfer has to be
+ * done. Transfers complete in order, so that means waiting until only the
+ * other buffer's band (if any) is left in flight. Bands whose contents
+ * hash the same as last frame are not sent at all.
+ */
+static void render_banded(display_draw_fn_t draw, void *ctx)
+{
+    bool busy[2] = { false, false };
+    bool sent_any = false;
+    uint32_t sent = 0;
+    uint32_t wait_us = 0;
+    esp_err_t ret = ESP_OK;
+    int64_t start = esp_timer_get_time();
+    
+    if (atomic_exchange(&s_invalidate_req, false)) s_shadow_valid = false;
+    
+    for (int band = 0; band < BAND_COUNT; band++) {
+        int slot = band & 1;
+        int page0 = band * DISPLAY_BAND_PAGES;
+        int pages = DISPLAY_PAGES - page0 < DISPLAY_BAND_PAGES ?
+                    DISPLAY_PAGES - page0 : DISPLAY_BAND_PAGES;
+        
+        if (busy[slot]) {
+            int64_t t = esp_timer_get_time();
+            if (s_backend->band_wait(busy[slot ^ 1] ? 1 : 0) != ESP_OK) ret = ESP_FAIL;
+            wait_us += (uint32_t)(esp_timer_get_time() - t);
+            busy[slot] = false;
+        }
+        
+        set_target(s_band_buf[slot], page0, pages);
+        draw(ctx);
+        
+        uint32_t h = band_hash(s_band_buf[slot], pages * DISPLAY_WIDTH);
+        if (s_shadow_valid && h == s_band_hash[band]) continue;
+        
+        uint32_t bytes = 0;
+        if (s_backend->band_queue(s_band_buf[slot], page0, pages, &bytes) != ESP_OK) {
+            ret = ESP_FAIL;
+            continue;
+        }
+        s_band_hash[band] = h;
+        busy[slot] = true;
+        sent_any = true;
+        sent += bytes;
+    }
+    
+    if (s_backend->band_wait(0) != ESP_OK) ret = ESP_FAIL;
+    
+    /* Leave drawing outside display_render() harmless */
+    set_target(NULL, 0, 0);
+    
+    if (ret != ESP_OK) {
+        /* Panel state is unknown now, resend everything next time */
+        ESP_LOGW(TAG, "Band transfer failed");
+        s_shadow_valid = false;
+        return;
+    }
+    
+    s_shadow_valid = true;
+    
+    xSemaphoreTake(s_stats_lock, portMAX_DELAY);
+    s_stats.frames++;
+    s_stats.last_frame_bytes = sent;
+    s_stats.total_bytes += sent;
+    s_stats.last_flush_us = (uint32_t)(esp_timer_get_time() - start);
+    s_stats.last_wait_us = wait_us;
+    if (!sent_any) s_stats.skipped_frames++;
+    xSemaphoreGive(s_stats_lock);
+}
+
+void display_render(display_draw_fn_t draw, void *ctx)
+{
+    if (!s_initialized || !draw) return;
+    
+    if (s_banded) {
+        xSemaphoreTake(s_stats_lock, portMAX_DELAY);
+        s_stats.queued++;
+        xSemaphoreGive(s_stats_lock);
+        
+        render_banded(draw, ctx);
+        
+        xSemaphoreTake(s_stats_lock, portMAX_DELAY);
+        s_stats.last_done_us = (uint32_t)esp_timer_get_time();
+        s_stats.done++;
+        xSemaphoreGive(s_stats_lock);
+    } else {
+        draw(ctx);
+        display_refresh();
+    }
+}
+
+void display_invalidate(void)
+{
+    /* Taken up by the sender before its next frame, never lost to one in flight */
+    atomic_store(&s_invalidate_req, true);
+}
+
+void display_get_stats(display_stats_t *stats)
+{
+    if (!stats) return;
+    if (!s_stats_lock) {
+        *stats = s_stats;
+        return;
+    }
+    
+    /* Copy whole, so total_bytes and the counters come from one frame */
+    xSemaphoreTake(s_stats_lock, portMAX_DELAY);
+    *stats = s_stats;
+    xSemaphoreGive(s_stats_lock);
+}
+
+void display_set_brightness(uint8_t brightness)
+{
+    if (!s_initialized) return;
+    s_backend->contrast(brightness);
+}
+
+void display_power(bool on)
+{
+    if (!s_initialized) return;
+    s_backend->power(on);
+}
+
+/* ============================================================================
+ * Clipping
+ * ============================================================================ */
+
+static esp_err_t push_clip(int x, int y, int w, int h, bool translate)
+{
+    if (s_clip_depth >= DISPLAY_CLIP_STACK_DEPTH) {
+        s_clip_overflow++;
+        ESP_LOGW(TAG, "Clip stack full");
+        return ESP_ERR_NO_MEM;
+    }
+    s_clip_stack[s_clip_depth++] = s_clip;
+    
+    /* Incoming rect is relative to the current origin */
+    int x0 = x + s_clip.ox;
+    int y0 = y + s_clip.oy;
+    int x1 = x0 + (w > 0 ? w : 0);
+    int y1 = y0 + (h > 0 ? h : 0);
+    
+    if (translate) {
+        s_clip.ox = x0;
+        s_clip.oy = y0;
+    }
+    if (x0 > s_clip.x0) s_clip.x0 = x0;
+    if (y0 > s_clip.y0) s_clip.y0 = y0;
+    if (x1 < s_clip.x1) s_clip.x1 = x1;
+    if (y1 < s_clip.y1) s_clip.y1 = y1;
+    
+    /* Keep empty rects well-formed so every clip test rejects them */
+    if (s_clip.x1 < s_clip.x0) s_clip.x1 = s_clip.x0;
+    if (s_clip.y1 < s_clip.y0) s_clip.y1 = s_clip.y0;
+    return ESP_OK;
+}
+
+esp_err_t display_push_clip(int x, int y, int w, int h)
+{
+    return push_clip(x, y, w, h, false);
+}
+
+esp_err_t display_push_viewport(int x, int y, int w, int h)
+{
+    return push_clip(x, y, w, h, true);
+}
+
+void display_pop_clip(void)
+{
+    if (s_clip_overflow > 0) {
+        s_clip_overflow--;
+    } else if (s_clip_depth > 0) {
+        s_clip = s_clip_stack[--s_clip_depth];
+    }
+}
+
+void display_reset_clip(void)
+{
+    s_clip = s_clip_base;
+    s_clip_depth = 0;
+    s_clip_overflow = 0;
+}
+
+void display_get_clip(int *x, int *y, int *w, int *h)
+{
+    if (x) *x = s_clip.x0 - s_clip.ox;
+    if (y) *y = s_clip.y0 - s_clip.oy;
+    if (w) *w = s_clip.x1 - s_clip.x0;
+    if (h) *h = s_clip.y1 - s_clip.y0;
+}
+
+/* ============================================================================
+ * Surfaces
+ * ============================================================================ */
+
+static inline size_t surface_size(const display_surface_t *surface)
+{
+    return (size_t)surface->width * ((surface->height + 7) / 8);
+}
+
+esp_err_t display_surface_create(display_surface_t *surface, int width, int height)
+{
+    if (!surface || width <= 0 || width > DISPLAY_WIDTH ||
+        height <= 0 || height > DISPLAY_HEIGHT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    surface->width = width;
+    surface->height = height;
+    surface->valid = false;
+    surface->data = calloc(1, surface_size(surface));
+    if (!surface->data) return ESP_ERR_NO_MEM;
+    
+    s_surface_stats.live++;
+    s_surface_stats.bytes += surface_size(surface);
+    if (s_surface_stats.bytes > s_surface_stats.peak_bytes) {
+        s_surface_stats.peak_bytes = s_surface_stats.bytes;
+    }
+    return ESP_OK;
+}
+
+void display_surface_destroy(display_surface_t *surface)
+{
+    if (!surface || !surface->data) return;
+    if (surface == s_surface) display_surface_end();
+    
+    s_surface_stats.live--;
+    s_surface_stats.bytes -= surface_size(surface);
+    free(surface->data);
+    surface->data = NULL;
+    surface->valid = false;
+}
+
+esp_err_t display_surface_begin(display_surface_t *surface)
+{
+    if (!surface || !surface->data) return ESP_ERR_INVALID_ARG;
+    if (s_surface_depth >= DISPLAY_SURFACE_DEPTH) return ESP_ERR_INVALID_STATE;
+    if (surface == s_surface) return ESP_ERR_INVALID_STATE;
+    for (int i = 0; i < s_surface_depth; i++) {
+        if (s_saved_targets[i].surface == surface) return ESP_ERR_INVALID_STATE;
+    }
+    
+    saved_target_t *t = &s_saved_targets[s_surface_depth++];
+    t->surface = s_surface;
+    t->buffer = s_buffer;
+    t->page0 = s_page0;
+    t->pages = s_target_pages;
+    t->stride = s_stride;
+    t->row_offset = s_row_offset;
+    t->clip_base = s_clip_base;
+    t->clip = s_clip;
+    memcpy(t->clip_stack, s_clip_stack, sizeof(s_clip_stack));
+    t->clip_depth = s_clip_depth;
+    t->clip_overflow = s_clip_overflow;
+    
+    /* Surfaces are not scrolled: row y is row y */
+    s_surface = surface;
+    s_buffer = surface->data;
+    s_page0 = 0;
+    s_target_pages = (surface->height + 7) / 8;
+    s_stride = surface->width;
+    s_row_offset = 0;
+    
+    clip_t base = { 0, 0, surface->width, surface->height, 0, 0 };
+    s_clip_base = base;
+    display_reset_clip();
+    memset(surface->data, 0, surface_size(surface));
+    return ESP_OK;
+}
+
+void display_surface_end(void)
+{
+    if (!s_surface) return;
+    
+    s_surface->valid = true;
+    s_surface_stats.renders++;
+    
+    const saved_target_t *t = &s_saved_targets[--s_surface_depth];
+    s_surface = t->surface;
+    s_buffer = t->buffer;
+    s_page0 = t->page0;
+    s_target_pages = t->pages;
+    s_stride = t->stride;
+    s_row_offset = t->row_offset;
+    s_clip_base = t->clip_base;
+    s_clip = t->clip;
+    memcpy(s_clip_stack, t->clip_stack, sizeof(s_clip_stack));
+    s_clip_depth = t->clip_depth;
+    s_clip_overflow = t->clip_overflow;
+}
+
+void display_surface_invalidate(display_surface_t *surface)
+{
+    if (surface) surface->valid = false;
+}
+
+void display_blit_surface(int x, int y, const display_surface_t *surface)
+{
+    if (!surface || !surface->data || surface == s_surface) return;
+    s_surface_stats.blits++;
+    
+    x += s_clip.ox;
+    y += s_clip.oy;
+    int c0 = x < s_clip.x0 ? s_clip.x0 - x : 0;
+    int c1 = x + surface->width > s_clip.x1 ? s_clip.x1 - x : surface->width;
+    int r0 = y < s_clip.y0 ? s_clip.y0 - y : 0;
+    int r1 = y + surface->height > s_clip.y1 ? s_clip.y1 - y : surface->height;
+    if (c0 >= c1 || r0 >= r1) return;
+    
+    /*
+     * Copy runs of rows that stay inside one page of both the surface and
+     * the target. When the two line up, each run is a whole page and a
+     * plain memcpy; otherwise every column is shifted into place under a
+     * mask, two runs per surface page.
+     */
+    int w = c1 - c0;
+    for (int r = r0; r < r1; ) {
+        int row = ram_row(y + r);
+        int src_shift = r & 7;
+        int dst_shift = row & 7;
+        int n = 8 - (src_shift > dst_shift ? src_shift : dst_shift);
+        if (n > r1 - r) n = r1 - r;
+        
+        const uint8_t *src = &surface->data[(r >> 3) * surface->width + c0];
+        uint8_t *dst = &page_row(row >> 3)[x + c0];
+        if (n == 8) {
+            memcpy(dst, src, w);
+        } else {
+            uint8_t mask = (uint8_t)(((1 << n) - 1) << dst_shift);
+            for (int c = 0; c < w; c++) {
+                uint8_t bits = (uint8_t)((src[c] >> src_shift) << dst_shift);
+                dst[c] = (dst[c] & ~mask) | (bits & mask);
+            }
+        }
+        r += n;
+    }
+}
+
+void display_surface_get_stats(display_surface_stats_t *stats)
+{
+    if (stats) *stats = s_surface_stats;
+}
+
+/* ============================================================================
+ * Primitives
+ *
+ * Coordinates are relative to the current origin. Only the leaf writers
+ * (pixel, fill_rect and the blitters) translate and clip; everything else
+ * is built on top of them.
+ * ============================================================================ */
+
+void display_draw_pixel(int x, int y, display_color_t color)
+{
+    x += s_clip.ox;
+    y += s_clip.oy;
+    if (x < s_clip.x0 || x >= s_clip.x1 || y < s_clip.y0 || y >= s_clip.y1) return;
+    
+    y = ram_row(y);
+    uint8_t *p = &page_row(y >> 3)[x];
+    uint8_t bit = 1 << (y & 7);
+    
+    switch (color) {
+        case COLOR_WHITE: *p |= bit; break;
+        case COLOR_BLACK: *p &= ~bit; break;
+        case COLOR_INVERSE: *p ^= bit; break;
+    }
+}
+
+void display_draw_hline(int x, int y, int w, display_color_t color)
+{
+    display_fill_rect(x, y, w, 1, color);
+}
+
+void display_draw_vline(int x, int y, int h, display_color_t color)
+{
+    display_fill_rect(x, y, 1, h, color);
+}
+
+void display_draw_line(int x0, int y0, int x1, int y1, display_color_t color)
+{
+    int dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+    int dy = abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+    int err = dx - dy;
+    
+    while (1) {
+        display_draw_pixel(x0, y0, color);
+        if (x0 == x1 && y0 == y1) break;
+        int e2 = 2 * err;
+        if (e2 > -dy) { err -= dy; x0 += sx; }
+        if (e2 < dx) { err += dx; y0 += sy; }
+    }
+}
+
+void display_draw_rect(int x, int y, int w, int h, display_color_t color)
+{
+    display_draw_hline(x, y, w, color);
+    display_draw_hline(x, y + h - 1, w, color);
+    display_draw_vline(x, y, h, color);
+    display_draw_vline(x + w - 1, y, h, color);
+}
+
+/* ============================================================================
+ * Span Fast Paths
+ * ============================================================================ */
+
+/* Word access into the byte framebuffer without breaking strict aliasing */
+typedef uint32_t __attribute__((may_alias)) span_word_t;
+
+/* Replicate a page mask into all four bytes of a word */
+#define SPAN_SPLAT(mask)    ((uint32_t)(mask) * 0x01010101u)
+
+#define SPAN_APPLY(p, w, mask, op)                                      \
+    do {                                                                \
+        uint32_t wmask_ = SPAN_SPLAT(mask);                             \
+        while ((w) > 0 && ((uintptr_t)(p) & 3)) {                       \
+            *(p)++ op (mask); (w)--;                                    \
+        }                                                               \
+        for (; (w) >= 4; (w) -= 4, (p) += 4) {                          \
+            *(span_word_t *)(p) op wmask_;                              \
+        }                                                               \
+        while ((w)-- > 0) {                                             \
+            *(p)++ op (mask);                                           \
+        }                                                               \
+    } while (0)
+
+static inline void apply_byte(uint8_t *p, uint8_t bits, display_color_t color)
+{
+    switch (color) {
+        case COLOR_WHITE: *p |= bits; break;
+        case COLOR_BLACK: *p &= ~bits; break;
+        case COLOR_INVERSE: *p ^= bits; break;
+    }
+}
+
+/**
+ * @brief Apply a vertical bit mask to a run of adjacent columns in one page
+ * @param p First byte of the run
+ * @param w Number of columns
+ * @param mask Rows to affect within the page
+ * @param color Operation
+ */
+static void apply_span(uint8_t *p, int w, uint8_t mask, display_color_t color)
+{
+    switch (color) {
+        case COLOR_WHITE: SPAN_APPLY(p, w, mask, |=); break;
+        case COLOR_BLACK: { uint8_t inv = ~mask; SPAN_APPLY(p, w, inv, &=); break; }
+        case COLOR_INVERSE: SPAN_APPLY(p, w, mask, ^=); break;
+    }
+}
+
+/**
+ * @brief Rows [y0, y1) that fall inside a page, as a bit mask
+ */
+static inline uint8_t page_mask(int page, int y0, int y1)
+{
+    int lo = y0 - page * 8;
+    int hi = y1 - page * 8;
+    if (lo < 0) lo = 0;
+    if (hi > 8) hi = 8;
+    if (lo >= hi) return 0;
+    return (uint8_t)((0xFF << lo) & (0xFF >> (8 - hi)));
+}
+
+/**
+ * @brief Fill columns x0..x1-1 of panel RAM rows r0..r1-1 (already clipped)
+ */
+static void fill_ram_rows(int x0, int x1, int r0, int r1, display_color_t color)
+{
+    for (int page = r0 >> 3; page <= (r1 - 1) >> 3; page++) {
+        apply_span(&page_row(page)[x0], x1 - x0,
+                   page_mask(page, r0, r1), color);
+    }
+}
+
+void display_fill_rect(int x, int y, int w, int h, display_color_t color)
+{
+    x += s_clip.ox;
+    y += s_clip.oy;
+    int x0 = x < s_clip.x0 ? s_clip.x0 : x;
+    int y0 = y < s_clip.y0 ? s_clip.y0 : y;
+    int x1 = x + w > s_clip.x1 ? s_clip.x1 : x + w;
+    int y1 = y + h > s_clip.y1 ? s_clip.y1 : y + h;
+    if (x0 >= x1 || y0 >= y1) return;
+    
+    /* Rows that run past the bottom of panel RAM wrap to the top */
+    int r0 = ram_row(y0);
+    int r1 = r0 + (y1 - y0);
+    if (r1 > DISPLAY_HEIGHT) {
+        fill_ram_rows(x0, x1, 0, r1 - DISPLAY_HEIGHT, color);
+        r1 = DISPLAY_HEIGHT;
+    }
+    fill_ram_rows(x0, x1, r0, r1, color);
+}
+
+/* ============================================================================
+ * Circles and Arcs
+ * ============================================================================ */
+
+/*
+ * Draw target and clip for an outline, copied out of the globals so the
+ * byte writes of one run do not make the compiler reload them for the next
+ */
+typedef struct {
+    uint8_t *buf;
+    int page0;
+    int stride;
+    int row_offset;
+    int x0, y0, x1, y1;                 /* Clip rect in screen coordinates */
+    display_color_t color;
+} arc_target_t;
+
+/**
+ * @brief Pixels [x0, x1) of a row whose bit and page start are known
+ */
+static inline void arc_row_run(const arc_target_t *t, uint8_t *page, uint8_t bit, int x0, int x1)
+{
+    if (x0 < t->x0) x0 = t->x0;
+    if (x1 > t->x1) x1 = t->x1;
+    if (x0 >= x1) return;
+    
+    uint8_t *p = &page[x0];
+    int n = x1 - x0;
+    switch (t->color) {
+        case COLOR_WHITE: do { *p++ |= bit; } while (--n); break;
+        case COLOR_BLACK: do { *p++ &= ~bit; } while (--n); break;
+        case COLOR_INVERSE: do { *p++ ^= bit; } while (--n); break;
+    }
+}
+
+/**
+ * @brief The row runs of the left and right quadrants on screen row y
+ *
+ * Columns [cx + a, cx + b) on the right and their mirror image on the
+ * left; one bit across a run of bytes each.
+ */
+static inline void arc_rows(const arc_target_t *t, int y, int cx, int a, int b, bool left, bool right)
+{
+    if (y < t->y0 || y >= t->y1 || a >= b) return;
+    
+    int row = (unsigned)(y + t->row_offset) % DISPLAY_HEIGHT;
+    uint8_t *page = &t->buf[((row >> 3) - t->page0) * t->stride];
+    uint8_t bit = 1 << (row & 7);
+    if (right) arc_row_run(t, page, bit, cx + a, cx + b);
+    if (left) arc_row_run(t, page, bit, cx - b + 1, cx - a + 1);
+}
+
+/**
+ * @brief The column runs of the left and right quadrants over screen rows [y0, y1)
+ *
+ * Columns cx + dx and cx - dx; one masked byte per page each. Forced
+ * inline: on small circles a call per run costs more than the run.
+ */
+static inline __attribute__((always_inline))
+void arc_cols(const arc_target_t *t, int y0, int y1, int cx, int dx, bool left, bool right)
+{
+    if (y0 < t->y0) y0 = t->y0;
+    if (y1 > t->y1) y1 = t->y1;
+    right = right && cx + dx >= t->x0 && cx + dx < t->x1;
+    left = left && cx - dx >= t->x0 && cx - dx < t->x1;
+    if (!left && !right) return;
+    
+    int row = (unsigned)(y0 + t->row_offset) % DISPLAY_HEIGHT;
+    for (int n = y1 - y0; n > 0; ) {
+        int shift = row & 7;
+        int k = 8 - shift < n ? 8 - shift : n;
+        uint8_t *page = &t->buf[((row >> 3) - t->page0) * t->stride + cx];
+        uint8_t mask = (uint8_t)(((1 << k) - 1) << shift);
+        if (right) apply_byte(&page[dx], mask, t->color);
+        if (left) apply_byte(&page[-dx], mask, t->color);
+        n -= k;
+        row = (row + k) % DISPLAY_HEIGHT;
+    }
+}
+
+/**
+ * @brief Outline the selected quadrants of a circle
+ * @param axes Also draw the axis points, each one if either quadrant beside it is selected
+ *
+ * Walks the first octant with the midpoint rule. Consecutive points at the
+ * same x form a column run there and a row run in the mirrored octant, and
+ * each run is written whole: a masked byte per page for a column, one bit
+ * across a run of bytes for a row. The axis points extend the first runs
+ * through the axes and the point on the diagonal (y == x) is left out of
+ * the row run, so no pixel is touched twice and INVERSE outlines stay closed.
+ */
+static void draw_arc_quadrants(int cx, int cy, int r, uint8_t quads, bool axes, display_color_t color)
 {
-    int sda = config->i2c.sda_pin;
-    int scl = config->i2c.scl_pin;
-    s_i2c_addr = config->i2c.i2c_addr;
-    
-    i2c_config_t i2c_conf = {
-        .mode = I2C_MODE_MASTER,
-        .sda_io_num = sda,
-        .scl_io_num = scl,
-        .sda_pullup_en = GPIO_PULLUP_ENABLE,
-        .scl_pullup_en = GPIO_PULLUP_ENABLE,
-        .master.clk_speed = 400000,
+    const arc_target_t t = {
+        .buf = s_buffer, .page0 = s_page0, .stride = s_stride, .row_offset = s_row_offset,
+        .x0 = s_clip.x0, .y0 = s_clip.y0, .x1 = s_clip.x1, .y1 = s_clip.y1,
+        .color = color,
     };
+    bool tr = quads & DISPLAY_QUAD_TOP_RIGHT;
+    bool br = quads & DISPLAY_QUAD_BOTTOM_RIGHT;
+    bool bl = quads & DISPLAY_QUAD_BOTTOM_LEFT;
+    bool tl = quads & DISPLAY_QUAD_TOP_LEFT;
+    cx += s_clip.ox;
+    cy += s_clip.oy;
     
-    esp_err_t ret = i2c_param_config(I2C_PORT, &i2c_conf);
-    if (ret != ESP_OK) return ret;
-    
-    ret = i2c_driver_install(I2C_PORT, I2C_MODE_MASTER, 0, 0, 0);
-    if (ret != ESP_OK) return ret;
-    
-    /* Init sequence */
-    send_cmd(CMD_DISPLAY_OFF);
-    send_cmd(CMD_SET_CLOCK_DIV); send_cmd(0x80);
-    send_cmd(CMD_SET_MUX_RATIO); send_cmd(0x3F);
-    send_cmd(CMD_SET_DISPLAY_OFFSET); send_cmd(0x00);
-    send_cmd(CMD_SET_START_LINE | 0x00);
-    send_cmd(CMD_CHARGE_PUMP); send_cmd(0x14);
-    send_cmd(CMD_MEMORY_MODE); send_cmd(0x00);
-    send_cmd(CMD_SET_SEG_REMAP | (config->flip_horizontal ? 0x00 : 0x01));
-    send_cmd(CMD_SET_COM_SCAN_DIR | (config->flip_vertical ? 0x00 : 0x08));
-    send_cmd(CMD_SET_COM_PINS); send_cmd(0x12);
-    send_cmd(CMD_SET_CONTRAST); send_cmd(0xCF);
-    send_cmd(CMD_SET_PRECHARGE); send_cmd(0xF1);
-    send_cmd(CMD_SET_VCOM_DESELECT); send_cmd(0x40);
-    send_cmd(CMD_NORMAL_DISPLAY);
-    send_cmd(CMD_DISPLAY_ON);
-    
-    ESP_LOGI(TAG, "SSD1306 I2C initialized (addr=0x%02X, SDA=%d, SCL=%d)", s_i2c_addr, sda, scl);
-    return ESP_OK;
+    int x = r, y = 0, err = 0;
+    int run_x = r, run_y = axes ? 0 : 1;    /* Points at x == run_x so far, from y == run_y */
+    
+    for (;;) {
+        y++;
+        err += 1 + 2 * y;
+        if (2 * (err - x) + 1 > 0) { x--; err += 1 - 2 * x; }
+        if (x == run_x && x >= y) continue;
+        
+        /* Column runs over rows run_y..y-1, row runs over the same span short of the diagonal */
+        int end = y - (y - 1 == run_x);
+        if (run_y == 0) {
+            /* Through the axes: one column each side, one row top and bottom */
+            int n = y - 1;
+            int e = end - 1;
+            if (tr || br) arc_cols(&t, cy - (tr ? n : 0), cy + (br ? n : 0) + 1, cx, r, false, true);
+            if (tl || bl) arc_cols(&t, cy - (tl ? n : 0), cy + (bl ? n : 0) + 1, cx, r, true, false);
+            if (tl || tr) arc_rows(&t, cy - r, cx, -(tl ? e : 0), (tr ? e : 0) + 1, false, true);
+            if (bl || br) arc_rows(&t, cy + r, cx, -(bl ? e : 0), (br ? e : 0) + 1, false, true);
+        } else if (y > run_y) {
+            if (tr || tl) {
+                arc_cols(&t, cy - y + 1, cy - run_y + 1, cx, run_x, tl, tr);
+                arc_rows(&t, cy - run_x, cx, run_y, end, tl, tr);
+            }
+            if (br || bl) {
+                arc_cols(&t, cy + run_y, cy + y, cx, run_x, bl, br);
+                arc_rows(&t, cy + run_x, cx, run_y, end, bl, br);
+            }
+        }
+        if (x < y) break;
+        run_x = x;
+        run_y = y;
+    }
 }
 
-esp_err_t display_init(const display_config_t *config)
+void display_draw_circle(int cx, int cy, int r, display_color_t color)
 {
-    if (s_initialized) {
-        ESP_LOGW(TAG, "Already initialized");
-        return ESP_ERR_INVALID_STATE;
+    if (r < 0) return;
+    if (r == 0) {
+        display_draw_pixel(cx, cy, color);
+        return;
     }
     
-    s_type = config->type;
-    esp_err_t ret = ESP_FAIL;
+    draw_arc_quadrants(cx, cy, r, DISPLAY_QUAD_ALL, true, color);
+}
+
+/**
+ * @brief Fill one row of the selected quadrants
+ * @param lq Quadrant flags owning the left part of this row
+ * @param rq Quadrant flags owning the right part of this row
+ *
+ * The center column belongs to both halves, so the row is always a
+ * single span.
+ */
+static void fill_arc_row(int cx, int y, int dx, uint8_t quads,
+                         uint8_t lq, uint8_t rq, display_color_t color)
+{
+    bool l = quads & lq;
+    bool r = quads & rq;
+    if (!l && !r) return;
     
-    switch (config->type) {
-        case DISPLAY_TYPE_SSD1306_I2C:
-            ret = init_ssd1306_i2c(config);
-            break;
-        case DISPLAY_TYPE_TRANSPARENT_SPI:
-            ESP_LOGE(TAG, "Transparent SPI not yet implemented");
-            return ESP_ERR_NOT_SUPPORTED;
-        default:
-            return ESP_ERR_INVALID_ARG;
+    int x0 = l ? cx - dx : cx;
+    int x1 = r ? cx + dx : cx;
+    display_fill_rect(x0, y, x1 - x0 + 1, 1, color);
+}
+
+/**
+ * @brief Scanline fill of the selected quadrants
+ *
+ * Rows are emitted as spans through the fill fast path. Half-widths follow
+ * the same x*x + y*y <= r*r test as a per-pixel fill, tracked incrementally.
+ */
+static void fill_arc_quadrants(int cx, int cy, int r, uint8_t quads, display_color_t color)
+{
+    if (r < 0) return;
+    
+    int dx = r;
+    for (int dy = 0; dy <= r; dy++) {
+        while (dx * dx + dy * dy > r * r) dx--;
+        
+        if (dy == 0) {
+            fill_arc_row(cx, cy, dx, quads,
+                         DISPLAY_QUAD_TOP_LEFT | DISPLAY_QUAD_BOTTOM_LEFT,
+                         DISPLAY_QUAD_TOP_RIGHT | DISPLAY_QUAD_BOTTOM_RIGHT, color);
+            continue;
+        }
+        fill_arc_row(cx, cy - dy, dx, quads,
+                     DISPLAY_QUAD_TOP_LEFT, DISPLAY_QUAD_TOP_RIGHT, color);
+        fill_arc_row(cx, cy + dy, dx, quads,
+                     DISPLAY_QUAD_BOTTOM_LEFT, DISPLAY_QUAD_BOTTOM_RIGHT, color);
+    }
+}
+
+void display_fill_circle(int cx, int cy, int r, display_color_t color)
+{
+    fill_arc_quadrants(cx, cy, r, DISPLAY_QUAD_ALL, color);
+}
+
+void display_fill_arc(int cx, int cy, int r, uint8_t quadrants, display_color_t color)
+{
+    fill_arc_quadrants(cx, cy, r, quadrants, color);
+}
+
+void display_draw_arc(int cx, int cy, int r, uint8_t quadrants, display_color_t color)
+{
+    if (r <= 0) {
+        if (r == 0 && quadrants) display_draw_pixel(cx, cy, color);
+        return;
     }
     
-    if (ret == ESP_OK) {
-        display_clear();
-        display_refresh();
-        s_initialized = true;
+    draw_arc_quadrants(cx, cy, r, quadrants, true, color);
+}
+
+static int clamp_radius(int w, int h, int r)
+{
+    int max = (w < h ? w : h) / 2;
+    if (r > max) r = max;
+    return r < 0 ? 0 : r;
+}
+
+void display_draw_round_rect(int x, int y, int w, int h, int r, display_color_t color)
+{
+    if (w <= 0 || h <= 0) return;
+    if (w <= 2 || h <= 2) {
+        display_fill_rect(x, y, w, h, color);
+        return;
+    }
+    r = clamp_radius(w, h, r);
+    if (r == 0) {
+        /* Edges without shared corners, so INVERSE outlines stay closed */
+        display_fill_rect(x, y, w, 1, color);
+        display_fill_rect(x, y + h - 1, w, 1, color);
+        display_fill_rect(x, y + 1, 1, h - 2, color);
+        display_fill_rect(x + w - 1, y + 1, 1, h - 2, color);
+        return;
     }
     
-    return ret;
+    int right = x + w - 1 - r;
+    int bottom = y + h - 1 - r;
+    
+    display_fill_rect(x + r, y, w - 2 * r, 1, color);
+    display_fill_rect(x + r, y + h - 1, w - 2 * r, 1, color);
+    display_fill_rect(x, y + r, 1, h - 2 * r, color);
+    display_fill_rect(x + w - 1, y + r, 1, h - 2 * r, color);
+    
+    draw_arc_quadrants(x + r, y + r, r, DISPLAY_QUAD_TOP_LEFT, false, color);
+    draw_arc_quadrants(right, y + r, r, DISPLAY_QUAD_TOP_RIGHT, false, color);
+    draw_arc_quadrants(x + r, bottom, r, DISPLAY_QUAD_BOTTOM_LEFT, false, color);
+    draw_arc_quadrants(right, bottom, r, DISPLAY_QUAD_BOTTOM_RIGHT, false, color);
 }
 
-void display_deinit(void)
+void display_fill_round_rect(int x, int y, int w, int h, int r, display_color_t color)
 {
-    if (s_initialized) {
-        display_power(false);
-        i2c_driver_delete(I2C_PORT);
-        s_initialized = false;
+    if (w <= 0 || h <= 0) return;
+    r = clamp_radius(w, h, r);
+    
+    /* Straight middle band, then the two rounded caps */
+    display_fill_rect(x, y + r, w, h - 2 * r, color);
+    if (r == 0) return;
+    
+    int left = x + r;
+    int right = x + w - 1 - r;
+    int dx = r;
+    for (int dy = 1; dy <= r; dy++) {
+        while (dx * dx + dy * dy > r * r) dx--;
+        display_fill_rect(left - dx, y + r - dy, right - left + 2 * dx + 1, 1, color);
+        display_fill_rect(left - dx, y + h - 1 - r + dy, right - left + 2 * dx + 1, 1, color);
     }
 }
 
-void display_clear(void)
+/* ============================================================================
+ * Glyph Blitting
+ * ============================================================================ */
+
+#define GLYPH_CACHE_SLOTS       16      /* Power of two */
+#define GLYPH_MAX_SCALE         4       /* 8 * 4 rows still fits the 64-bit shift */
+
+/* Vertically expanded glyph columns for scaled text */
+typedef struct {
+    uint16_t key;                       /* (c << 3) | size, 0 = empty */
+    uint32_t cols[6];
+} glyph_cache_entry_t;
+
+static glyph_cache_entry_t s_glyph_cache[GLYPH_CACHE_SLOTS];
+
+/**
+ * @brief Merge a column of up to 32 rows into the framebuffer
+ * @param bits Column bits, bit 0 lands on row y
+ * @param height Number of rows in bits
+ *
+ * Page-aligned columns touch ceil(height / 8) bytes; unaligned ones are
+ * shifted once and split across one extra page.
+ */
+static void blit_column(int x, int y, uint32_t bits, int height, display_color_t color)
 {
-    memset(s_buffer, 0, sizeof(s_buffer));
+    x += s_clip.ox;
+    y += s_clip.oy;
+    if (x < s_clip.x0 || x >= s_clip.x1 || !bits) return;
+    
+    uint64_t col = bits;
+    if (y < s_clip.y0) {
+        int skip = s_clip.y0 - y;
+        if (skip >= height) return;
+        col >>= skip;
+        height -= skip;
+        y = s_clip.y0;
+    }
+    if (y + height > s_clip.y1) {
+        height = s_clip.y1 - y;
+        if (height <= 0) return;
+        col &= (1ULL << height) - 1;
+    }
+    
+    int row = ram_row(y);
+    col <<= (row & 7);
+    for (int page = row >> 3; col; col >>= 8, page = (page + 1) % DISPLAY_PAGES) {
+        if (col & 0xFF) apply_byte(&page_row(page)[x], (uint8_t)col, color);
+    }
 }
 
-void display_refresh(void)
+/**
+ * @brief Merge 8-row column bytes (one per column) into the framebuffer
+ */
+static void blit_bytes(int x, int y, const uint8_t *cols, int w, display_color_t color)
 {
-    if (!s_initialized) return;
+    x += s_clip.ox;
+    y += s_clip.oy;
+    if (y <= s_clip.y0 - 8 || y >= s_clip.y1) return;
+    
+    int c0 = x < s_clip.x0 ? s_clip.x0 - x : 0;
+    int c1 = x + w > s_clip.x1 ? s_clip.x1 - x : w;
+    if (c0 >= c1) return;
     
-    send_cmd(CMD_SET_COLUMN_ADDR); send_cmd(0); send_cmd(127);
-    send_cmd(CMD_SET_PAGE_ADDR); send_cmd(0); send_cmd(7);
-    send_data(s_buffer, sizeof(s_buffer));
+    /* Rows r0..r1-1 of the column survive the clip */
+    int r0 = s_clip.y0 > y ? s_clip.y0 - y : 0;
+    int r1 = s_clip.y1 < y + 8 ? s_clip.y1 - y : 8;
+    
+    /* Place them at their panel RAM row, straddling two pages at most */
+    int row = ram_row(y + r0);
+    int shift = row & 7;
+    uint16_t mask = (uint16_t)(((1 << (r1 - r0)) - 1) << shift);
+    uint8_t upper_mask = (uint8_t)mask;
+    uint8_t lower_mask = (uint8_t)(mask >> 8);
+    uint8_t *upper = upper_mask ? &page_row(row >> 3)[x] : NULL;
+    uint8_t *lower = lower_mask ? &page_row(((row >> 3) + 1) % DISPLAY_PAGES)[x] : NULL;
+    
+    for (int c = c0; c < c1; c++) {
+        uint16_t v = (uint16_t)((cols[c] >> r0) << shift);
+        if (upper) apply_byte(&upper[c], (uint8_t)v & upper_mask, color);
+        if (lower) apply_byte(&lower[c], (uint8_t)(v >> 8) & lower_mask, color);
+    }
 }
 
-void display_set_brightness(uint8_t brightness)
+/**
+ * @brief Columns of a printable character in the fixed 6x8 font
+ */
+static inline const uint8_t *fixed_glyph(char c)
 {
-    if (!s_initialized) return;
-    send_cmd(CMD_SET_CONTRAST);
-    send_cmd(brightness);
+    const display_font_t *f = &display_fonts[DISPLAY_FONT_6X8];
+    return &f->cols[f->offset[(uint8_t)c - f->first]];
 }
 
-void display_power(bool on)
+/**
+ * @brief Get glyph columns stretched vertically by size, cached
+ */
+static const uint32_t *expanded_glyph(char c, uint8_t size)
 {
-    if (!s_initialized) return;
-    send_cmd(on ? CMD_DISPLAY_ON : CMD_DISPLAY_OFF);
+    uint16_t key = ((uint16_t)(uint8_t)c << 3) | size;
+    /* Mix the size in below the mask, so a character at two sizes takes two slots */
+    glyph_cache_entry_t *e = &s_glyph_cache[((uint8_t)c + size * 7) & (GLYPH_CACHE_SLOTS - 1)];
+    if (e->key == key) return e->cols;
+    
+    const uint8_t *glyph = fixed_glyph(c);
+    uint32_t run = (1u << size) - 1;
+    
+    for (int col = 0; col < 6; col++) {
+        uint32_t out = 0;
+        for (int row = 0; row < 8; row++) {
+            if (glyph[col] & (1 << row)) out |= run << (row * size);
+        }
+        e->cols[col] = out;
+    }
+    e->key = key;
+    return e->cols;
 }
 
-void display_draw_pixel(int x, int y, display_color_t color)
+void display_draw_char(int x, int y, char c, display_color_t color, uint8_t size)
 {
-    if (x < 0 || x >= DISPLAY_WIDTH || y < 0 || y >= DISPLAY_HEIGHT) return;
+    if (c < 32 || c > 127) c = '?';
+    const uint8_t *glyph = fixed_glyph(c);
     
-    int idx = x + (y / 8) * DISPLAY_WIDTH;
-    uint8_t bit = 1 << (y & 7);
+    if (size == 1) {
+        blit_bytes(x, y, glyph, 6, color);
+        return;
+    }
     
-    switch (color) {
-        case COLOR_WHITE: s_buffer[idx] |= bit; break;
-        case COLOR_BLACK: s_buffer[idx] &= ~bit; break;
-        case COLOR_INVERSE: s_buffer[idx] ^= bit; break;
+    if (size > GLYPH_MAX_SCALE) {
+        for (int col = 0; col < 6; col++) {
+            for (int row = 0; row < 8; row++) {
+                if (glyph[col] & (1 << row)) {
+                    display_fill_rect(x + col * size, y + row * size, size, size, color);
+                }
+            }
+        }
+        return;
+    }
+    
+    if (size == 0) return;
+    
+    const uint32_t *cols = expanded_glyph(c, size);
+    for (int col = 0; col < 6; col++) {
+        for (int i = 0; i < size; i++) {
+            blit_column(x + col * size + i, y, cols[col], 8 * size, color);
+        }
     }
 }
 
-void display_draw_hline(int x, int y, int w, display_color_t color)
+/**
+ * @brief Decode one UTF-8 sequence and step past it
+ *
+ * Malformed or truncated sequences give U+FFFD and consume what was read,
+ * so decoding always makes progress and never steps over a '\0'.
+ */
+static uint32_t utf8_next(const char **p)
+{
+    const uint8_t *s = (const uint8_t *)*p;
+    uint32_t cp = s[0];
+    
+    if (cp < 0x80) {
+        *p += 1;
+        return cp;
+    }
+    int n = cp < 0xC2 ? 0 : cp < 0xE0 ? 1 : cp < 0xF0 ? 2 : cp < 0xF5 ? 3 : 0;
+    if (!n) {
+        *p += 1;
+        return 0xFFFD;
+    }
+    
+    cp &= 0x3F >> n;
+    for (int i = 1; i <= n; i++) {
+        if ((s[i] & 0xC0) != 0x80) {
+            *p += i;
+            return 0xFFFD;
+        }
+        cp = cp << 6 | (s[i] & 0x3F);
+    }
+    *p += n + 1;
+    return cp;
+}
+
+/**
+ * @brief Draw a glyph store glyph, page by page
+ */
+static void draw_store_glyph(int x, int y, const display_glyph_t *glyph, display_color_t color)
 {
-    for (int i = 0; i < w; i++) display_draw_pixel(x + i, y, color);
+    for (int p = 0; p < glyph->pages; p++) {
+        blit_bytes(x, y + p * 8, glyph->cols + p * glyph->width, glyph->width, color);
+    }
 }
 
-void display_draw_vline(int x, int y, int h, display_color_t color)
+void display_draw_string(int x, int y, const char *str, display_color_t color, uint8_t size)
 {
-    for (int i = 0; i < h; i++) display_draw_pixel(x, y + i, color);
+    int cx = x;
+    while (*str) {
+        if (*str == '\n') {
+            cx = x;
+            y += 8 * size;
+            str++;
+            continue;
+        }
+        
+        uint32_t cp = utf8_next(&str);
+        display_glyph_t glyph;
+        if (cp >= 0x80 && size == 1 && display_glyphs_find(cp, &glyph)) {
+            draw_store_glyph(cx, y, &glyph, color);
+            cx += glyph.width;
+        } else {
+            display_draw_char(cx, y, cp < 0x80 ? (char)cp : '?', color, size);
+            cx += 6 * size;
+        }
+    }
 }
 
-void display_draw_line(int x0, int y0, int x1, int y1, display_color_t color)
+void display_printf(int x, int y, display_color_t color, uint8_t size, const char *fmt, ...)
 {
-    int dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
-    int dy = abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
-    int err = dx - dy;
+    char buf[128];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    display_draw_string(x, y, buf, color, size);
+}
+
+/* ============================================================================
+ * Proportional Text
+ * ============================================================================ */
+
+#define FIT_CACHE_SLOTS         16      /* Power of two */
+#define FIT_CACHE_PREFIX        8
+
+/*
+ * Remembered display_fit_chars() results, keyed by a hash of the text. The
+ * hashed length and first bytes are kept too and checked on a hit, so a
+ * hash collision has to get past them as well to return a wrong fit.
+ */
+typedef struct {
+    uint32_t hash;
+    int16_t max_width;
+    uint8_t font;
+    bool truncated;
+    uint16_t chars;
+    uint16_t len;
+    char prefix[FIT_CACHE_PREFIX];
+} fit_cache_entry_t;
+
+static fit_cache_entry_t s_fit_cache[FIT_CACHE_SLOTS];
+
+static inline const display_font_t *get_font(display_font_id_t font)
+{
+    return &display_fonts[(unsigned)font < DISPLAY_FONT_COUNT ? font : DISPLAY_FONT_6X8];
+}
+
+static inline int glyph_index(const display_font_t *f, uint32_t c)
+{
+    uint32_t i = c - f->first;
+    return i < f->count ? (int)i : '?' - f->first;
+}
+
+/**
+ * @brief Kerning adjustment between two glyphs
+ */
+static inline int kern_adjust(const display_font_t *f, int left, int right)
+{
+    if (!f->kern_index) return 0;
     
-    while (1) {
-        display_draw_pixel(x0, y0, color);
-        if (x0 == x1 && y0 == y1) break;
-        int e2 = 2 * err;
-        if (e2 > -dy) { err -= dy; x0 += sx; }
-        if (e2 < dx) { err += dx; y0 += sy; }
+    const display_kern_t *k = &f->kern[f->kern_index[left]];
+    const display_kern_t *end = &f->kern[f->kern_index[left + 1]];
+    for (; k < end && k->right <= right; k++) {
+        if (k->right == right) return k->adjust;
     }
+    return 0;
 }
 
-void display_draw_rect(int x, int y, int w, int h, display_color_t color)
+/**
+ * @brief Draw one glyph (ellipsis included) with a byte blit
+ */
+static inline void draw_glyph(int x, int y, const display_font_t *f, int g, display_color_t color)
 {
-    display_draw_hline(x, y, w, color);
-    display_draw_hline(x, y + h - 1, w, color);
-    display_draw_vline(x, y, h, color);
-    display_draw_vline(x + w - 1, y, h, color);
+    int start = f->offset[g];
+    int w = f->offset[g + 1] - start;
+    if (w > 0) blit_bytes(x, y, &f->cols[start], w, color);
 }
 
-void display_fill_rect(int x, int y, int w, int h, display_color_t color)
+/* One character of text: a font glyph, or a glyph store glyph when glyph < 0 */
+typedef struct {
+    uint32_t cp;
+    int glyph;
+    int kern;                           /* Against the previous font glyph */
+    int advance;
+    display_glyph_t store;
+} text_char_t;
+
+/**
+ * @brief Decode the next character and resolve it to a glyph
+ *
+ * ASCII stays on the font tables. Anything else is looked up in the glyph
+ * store and falls back to the font's '?'. Store glyphs are not kerned.
+ */
+static inline void next_char(const display_font_t *f, const char **p, int prev, text_char_t *c)
+{
+    uint32_t cp = (uint8_t)**p;
+    if (cp < 0x80) (*p)++;
+    else cp = utf8_next(p);
+    
+    c->cp = cp;
+    if (cp >= 0x80 && display_glyphs_find(cp, &c->store)) {
+        c->glyph = -1;
+        c->kern = 0;
+        c->advance = c->store.width;
+        return;
+    }
+    c->glyph = glyph_index(f, cp);
+    c->kern = prev >= 0 ? kern_adjust(f, prev, c->glyph) : 0;
+    c->advance = f->advance[c->glyph];
+}
+
+/* CJK radicals onwards; such text may break between any two characters */
+static inline bool is_cjk(uint32_t cp)
 {
-    for (int i = 0; i < h; i++) display_draw_hline(x, y + i, w, color);
+    return cp >= 0x2E80;
 }
 
-void display_draw_circle(int cx, int cy, int r, display_color_t color)
+int display_font_line_height(display_font_id_t font)
 {
-    int x = r, y = 0, err = 0;
-    while (x >= y) {
-        display_draw_pixel(cx + x, cy + y, color);
-        display_draw_pixel(cx + y, cy + x, color);
-        display_draw_pixel(cx - y, cy + x, color);
-        display_draw_pixel(cx - x, cy + y, color);
-        display_draw_pixel(cx - x, cy - y, color);
-        display_draw_pixel(cx - y, cy - x, color);
-        display_draw_pixel(cx + y, cy - x, color);
-        display_draw_pixel(cx + x, cy - y, color);
-        y++;
-        err += 1 + 2 * y;
-        if (2 * (err - x) + 1 > 0) { x--; err += 1 - 2 * x; }
+    return get_font(font)->line_height;
+}
+
+int display_measure_chars(const char *str, int len, display_font_id_t font)
+{
+    const display_font_t *f = get_font(font);
+    const char *p = str;
+    int width = 0;
+    int prev = -1;
+    
+    while (p - str < len && *p && *p != '\n') {
+        text_char_t c;
+        next_char(f, &p, prev, &c);
+        width += c.kern + c.advance;
+        prev = c.glyph;
     }
+    return width;
 }
 
-void display_fill_circle(int cx, int cy, int r, display_color_t color)
+int display_measure_string(const char *str, display_font_id_t font)
+{
+    return display_measure_chars(str, INT32_MAX, font);
+}
+
+/**
+ * @brief Hash of the part of a string that can decide a fit
+ *
+ * No font character moves the pen less than min_step, kerning included,
+ * so text past the first max_width / min_step + 1 characters is cut anyway.
+ * Glyph store characters may be narrower, so once one turns up the limit
+ * becomes max_width + 1 characters. The character that ends the hashed part
+ * goes in too, so a line that ends there differs from one that goes on.
+ * The number of bytes hashed before it is returned in len.
+ */
+static uint32_t fit_hash(const char *str, int max_width, const display_font_t *f, int *len)
+{
+    int limit = max_width / f->min_step + 1;
+    uint32_t h = 2166136261u;
+    int chars = 0;
+    int i = 0;
+    
+    for (; str[i] && str[i] != '\n'; i++) {
+        uint8_t b = str[i];
+        if (b >= 0x80) limit = max_width + 1;
+        /* Continuation bytes belong to the character before them */
+        if ((b & 0xC0) != 0x80 && chars++ == limit) break;
+        h = (h ^ b) * 16777619u;
+    }
+    *len = i;
+    return (h ^ (uint8_t)str[i]) * 16777619u;
+}
+
+void display_text_reset_cache(void)
 {
-    for (int y = -r; y <= r; y++) {
-        for (int x = -r; x <= r; x++) {
-            if (x * x + y * y <= r * r) display_draw_pixel(cx + x, cy + y, color);
+    memset(s_fit_cache, 0, sizeof(s_fit_cache));
+}
+
+int display_fit_chars(const char *str, int max_width, display_font_id_t font, bool *truncated)
+{
+    if ((unsigned)font >= DISPLAY_FONT_COUNT) font = DISPLAY_FONT_6X8;
+    const display_font_t *f = &display_fonts[font];
+    
+    int len;
+    uint32_t hash = fit_hash(str, max_width, f, &len);
+    int prefix = len < FIT_CACHE_PREFIX ? len : FIT_CACHE_PREFIX;
+    fit_cache_entry_t *e = &s_fit_cache[(hash ^ max_width ^ font) & (FIT_CACHE_SLOTS - 1)];
+    if (e->hash == hash && e->max_width == max_width && e->font == font &&
+        e->len == len && memcmp(e->prefix, str, prefix) == 0) {
+        if (truncated) *truncated = e->truncated;
+        return e->chars;
+    }
+    
+    /* Walk until the text overflows, remembering the last cut that leaves room for "..." */
+    int ellipsis = f->advance[f->count];
+    const char *p = str;
+    int width = 0;
+    int prev = -1;
+    int cut = 0;
+    bool overflow = false;
+    
+    while (*p && *p != '\n') {
+        const char *start = p;
+        text_char_t c;
+        next_char(f, &p, prev, &c);
+        int next = width + c.kern + c.advance;
+        if (next > max_width) {
+            p = start;
+            overflow = true;
+            break;
         }
+        width = next;
+        prev = c.glyph;
+        if (width + ellipsis <= max_width) cut = p - str;
     }
+    
+    /* A following line also counts as cut off */
+    overflow = overflow || *p == '\n';
+    int chars = overflow ? cut : p - str;
+    
+    e->hash = hash;
+    e->max_width = max_width;
+    e->font = font;
+    e->truncated = overflow;
+    e->chars = chars;
+    e->len = len;
+    memcpy(e->prefix, str, prefix);
+    
+    if (truncated) *truncated = overflow;
+    return chars;
 }
 
-void display_draw_char(int x, int y, char c, display_color_t color, uint8_t size)
+int display_wrap_chars(const char *str, int max_width, display_font_id_t font)
 {
-    if (c < 32 || c > 127) c = '?';
-    const uint8_t *glyph = &font6x8[(c - 32) * 6];
+    const display_font_t *f = get_font(font);
+    const char *p = str;
+    int width = 0;
+    int prev = -1;
+    int brk = 0;
     
-    for (int col = 0; col < 6; col++) {
-        uint8_t line = glyph[col];
-        for (int row = 0; row < 8; row++) {
-            if (line & (1 << row)) {
-                if (size == 1) display_draw_pixel(x + col, y + row, color);
-                else display_fill_rect(x + col * size, y + row * size, size, size, color);
-            }
+    while (*p && *p != '\n') {
+        const char *start = p;
+        if (*p == ' ') brk = p - str;
+        text_char_t c;
+        next_char(f, &p, prev, &c);
+        width += c.kern + c.advance;
+        if (width > max_width && *start != ' ') {
+            /* Break at the last space or CJK character, or mid-word if there is none */
+            if (brk > 0) return brk;
+            return start > str ? start - str : p - str;
         }
+        /* CJK text has no spaces; a line may end after any of its characters */
+        if (is_cjk(c.cp)) brk = p - str;
+        prev = c.glyph;
     }
+    return p - str;
 }
 
-void display_draw_string(int x, int y, const char *str, display_color_t color, uint8_t size)
+/**
+ * @brief Draw up to len bytes of one line, returning the pen advance
+ */
+static int draw_line(int x, int y, const char *str, int len, const display_font_t *f,
+                     display_color_t color)
 {
-    int cx = x;
-    while (*str) {
-        if (*str == '\n') { cx = x; y += 8 * size; }
-        else { display_draw_char(cx, y, *str, color, size); cx += 6 * size; }
-        str++;
+    const char *p = str;
+    int pen = 0;
+    int prev = -1;
+    
+    while (p - str < len && *p && *p != '\n') {
+        text_char_t c;
+        next_char(f, &p, prev, &c);
+        pen += c.kern;
+        if (c.glyph >= 0) draw_glyph(x + pen, y, f, c.glyph, color);
+        else draw_store_glyph(x + pen, y, &c.store, color);
+        pen += c.advance;
+        prev = c.glyph;
     }
+    return pen;
 }
 
-void display_printf(int x, int y, display_color_t color, uint8_t size, const char *fmt, ...)
+int display_draw_text(int x, int y, const char *str, display_font_id_t font, display_color_t color)
+{
+    const display_font_t *f = get_font(font);
+    int pen = 0;
+    
+    for (;;) {
+        pen = draw_line(x, y, str, INT32_MAX, f, color);
+        const char *nl = strchr(str, '\n');
+        if (!nl) break;
+        str = nl + 1;
+        y += f->line_height;
+    }
+    return pen;
+}
+
+int display_draw_text_fit(int x, int y, int max_width, const char *str,
+                          display_font_id_t font, display_color_t color)
+{
+    const display_font_t *f = get_font(font);
+    bool truncated;
+    int chars = display_fit_chars(str, max_width, font, &truncated);
+    
+    int pen = draw_line(x, y, str, chars, f, color);
+    if (truncated) {
+        draw_glyph(x + pen, y, f, f->count, color);
+        pen += f->advance[f->count];
+    }
+    return pen;
+}
+
+int display_text_printf(int x, int y, display_font_id_t font, display_color_t color,
+                        const char *fmt, ...)
 {
     char buf[128];
     va_list args;
     va_start(args, fmt);
     vsnprintf(buf, sizeof(buf), fmt, args);
     va_end(args);
-    display_draw_string(x, y, buf, color, size);
+    return display_draw_text(x, y, buf, font, color);
 }
 
 void display_draw_progress(int x, int y, int w, int h, int progress)
@@ -403,12 +1864,8 @@ void display_draw_message(int x, int y, const char *from, const char *message, b
     /* From name */
     display_printf(x, y, COLOR_WHITE, 1, "%s:", from);
     
-    /* Message (truncate if needed) */
-    char buf[22];
-    strncpy(buf, message, sizeof(buf) - 1);
-    buf[sizeof(buf) - 1] = '\0';
-    
-    display_draw_string(x, y + 10, buf, COLOR_WHITE, 1);
+    /* Message, cut with an ellipsis if needed */
+    display_draw_text_fit(x, y + 10, DISPLAY_WIDTH - x, message, DISPLAY_FONT_PROP, COLOR_WHITE);
     
     /* Direction indicator */
     if (is_incoming) {
@@ -422,20 +1879,33 @@ void display_draw_bitmap(int x, int y, const uint8_t *bitmap, int w, int h, disp
 {
     if (!bitmap) return;
     
-    /* Bitmap is packed horizontally, 8 pixels per byte */
+    /* Bitmap is packed horizontally, 8 pixels per byte; set runs become spans */
     int bytes_per_row = (w + 7) / 8;
     
-    for (int row = 0; row < h; row++) {
-        for (int col = 0; col < w; col++) {
-            int byte_idx = row * bytes_per_row + col / 8;
-            int bit_idx = 7 - (col % 8);
-            if (bitmap[byte_idx] & (1 << bit_idx)) {
-                display_draw_pixel(x + col, y + row, color);
+    for (int row = 0; row < h; row++, bitmap += bytes_per_row) {
+        int run = -1;
+        for (int col = 0; col <= w; col++) {
+            bool set = col < w && (bitmap[col >> 3] & (0x80 >> (col & 7)));
+            if (set && run < 0) {
+                run = col;
+            } else if (!set && run >= 0) {
+                display_fill_rect(x + run, y + row, col - run, 1, color);
+                run = -1;
             }
         }
     }
 }
 
+void display_draw_sprite(int x, int y, const display_sprite_t *sprite, display_color_t color)
+{
+    if (!sprite || !sprite->data) return;
+    
+    const uint8_t *page = sprite->data;
+    for (int py = 0; py < sprite->height; py += 8, page += sprite->width) {
+        blit_bytes(x, y + py, page, sprite->width, color);
+    }
+}
+
 void display_draw_text_input(int x, int y, int w, const char *text, int cursor_pos)
 {
     /* Input box */
@@ -0,0 +1,75 @@
+/**
+ * @file display_backend.h
+ * @brief Panel backend interface (private to the display component)
+ *
+ * display.c owns the framebuffer, drawing, dirty tracking and the flush
+ * task. A backend only moves finished page-format frames to a panel.
+ *
+ * Full-frame backends implement flush(). Banded backends implement
+ * band_queue() / band_wait() instead and never see a whole frame.
+ */
+
+#pragma once
+
+#include "display.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DISPLAY_PAGES           (DISPLAY_HEIGHT / 8)
+
+/**
+ * @brief Changed column range of one page
+ */
+typedef struct {
+    int16_t x0;                     /**< First changed column, -1 if the page is clean */
+    int16_t x1;                     /**< Last changed column (inclusive) */
+} display_span_t;
+
+/**
+ * @brief Backend operations
+ */
+typedef struct {
+    const char *name;
+    
+    /** Bring up the bus and the panel */
+    esp_err_t (*init)(const display_config_t *config);
+    
+    /** Release the bus (the panel has already been powered off) */
+    void (*deinit)(void);
+    
+    /**
+     * Send the dirty spans of a frame (DISPLAY_PAGES entries, possibly all
+     * empty) and, if `start_line` is not -1, switch the panel to that RAM
+     * start line in the same transfer. The frame stays valid until the
+     * call returns. Reports the bytes put on the wire, commands included.
+     */
+    esp_err_t (*flush)(const uint8_t *frame, const display_span_t *spans,
+                       int start_line, uint32_t *bytes);
+    
+    /**
+     * Queue one band of `pages` pages starting at `page` and return without
+     * waiting for the transfer. The band buffer stays untouched until a
+     * band_wait() shows it has been sent. Reports the bytes queued.
+     */
+    esp_err_t (*band_queue)(const uint8_t *band, int page, int pages, uint32_t *bytes);
+    
+    /** Block until at most `pending` queued bands are still in flight */
+    esp_err_t (*band_wait)(int pending);
+    
+    void (*power)(bool on);
+    void (*contrast)(uint8_t level);
+} display_backend_t;
+
+#if !CONFIG_IDF_TARGET_LINUX
+extern const display_backend_t display_backend_ssd1306_i2c;
+extern const display_backend_t display_backend_spi;
+#endif
+extern const display_backend_t display_backend_host;
+extern const display_backend_t display_backend_host_banded;
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,77 @@
+/**
+ * @file display_font.h
+ * @brief Font tables and glyph store lookup (private to the display component)
+ *
+ * The tables are generated at build time by tools/font_gen.py from the
+ * glyph sources in fonts/ and live in flash. Glyph columns are page-format
+ * bytes (bit 0 = top row), so any glyph is drawn with one byte blit.
+ */
+
+#pragma once
+
+#include "display.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Kerning pair, listed under its left glyph
+ */
+typedef struct {
+    uint8_t right;                  /**< Glyph index of the right glyph */
+    int8_t adjust;                  /**< Added to the left glyph's advance */
+} display_kern_t;
+
+/**
+ * @brief Font tables
+ *
+ * Glyph i covers columns offset[i] .. offset[i + 1] - 1 of cols. Index
+ * `count` is the ellipsis glyph.
+ */
+typedef struct {
+    const uint8_t *cols;
+    const uint16_t *offset;         /**< count + 2 entries */
+    const uint8_t *advance;         /**< Pen advance per glyph, count + 1 entries */
+    const uint16_t *kern_index;     /**< Pairs of glyph i are kern[kern_index[i] .. kern_index[i + 1]), NULL if none */
+    const display_kern_t *kern;     /**< Sorted by right glyph within each left glyph */
+    uint8_t first;                  /**< Character code of glyph 0 */
+    uint8_t count;                  /**< Glyphs, not counting the ellipsis */
+    uint8_t height;                 /**< Rows of ink */
+    uint8_t line_height;            /**< Baseline-to-baseline distance */
+    uint8_t min_step;               /**< Smallest pen move of a character, kerning included */
+} display_font_t;
+
+extern const display_font_t display_fonts[DISPLAY_FONT_COUNT];
+
+/**
+ * @brief A glyph from the glyph store
+ *
+ * `pages` pages of `width` column bytes, page after page. The glyph's cell
+ * is `width` columns wide, spacing included.
+ */
+typedef struct {
+    const uint8_t *cols;
+    uint8_t width;
+    uint8_t pages;
+} display_glyph_t;
+
+/**
+ * @brief Look a codepoint up in the glyph store
+ * @return false if no store is attached or it lacks the codepoint
+ */
+bool display_glyphs_find(uint32_t codepoint, display_glyph_t *glyph);
+
+/**
+ * @brief Rows of the glyph store's glyphs, 0 without a store
+ */
+int display_glyphs_height(void);
+
+/**
+ * @brief Drop cached text layout, for when the glyph store changes
+ */
+void display_text_reset_cache(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,232 @@
+/**
+ * @file display_glyphs.c
+ * @brief Glyph store for characters outside the built-in fonts
+ *
+ * The store is an image built by tools/bdf2glyphs.py and flashed to the
+ * "glyphs" data partition. It is memory-mapped and read in place:
+ *
+ *   header   "GLY1", height, count, bitmap offset, image size
+ *   index    count x { codepoint, bitmap offset << 8 | width }, sorted
+ *   bitmaps  per glyph, ceil(height / 8) pages of `width` column bytes
+ *
+ * Lookups binary-search the index. Recently drawn glyphs (and codepoints
+ * found missing) are kept in a small LRU in DRAM, so redrawing the same
+ * text does not touch flash.
+ */
+
+#include "display.h"
+#include "display_font.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+#include <string.h>
+
+#if !CONFIG_IDF_TARGET_LINUX
+#include "esp_partition.h"
+#endif
+
+static const char *TAG = "glyphs";
+
+#define GLYPHS_MAGIC            "GLY1"
+#define GLYPHS_MAX_HEIGHT       32
+
+#define LRU_SLOTS               32
+#define LRU_BYTES               32      /* A 16x16 glyph is copied, bigger ones stay in flash */
+
+typedef struct {
+    char magic[4];
+    uint8_t height;
+    uint8_t reserved[3];
+    uint32_t count;
+    uint32_t bitmap_offset;
+    uint32_t image_size;
+} glyphs_header_t;
+
+typedef struct {
+    uint32_t codepoint;
+    uint32_t bitmap;                    /* Offset into the bitmaps << 8 | width */
+} glyphs_entry_t;
+
+static const glyphs_header_t *s_header = NULL;
+static const glyphs_entry_t *s_index = NULL;
+static const uint8_t *s_bitmaps = NULL;
+static int s_pages = 0;
+
+#if !CONFIG_IDF_TARGET_LINUX
+static esp_partition_mmap_handle_t s_mmap = 0;
+static bool s_mapped = false;
+#endif
+
+/* LRU of resolved glyphs; width 0 marks a codepoint the store lacks */
+typedef struct {
+    uint32_t codepoint;                 /* 0 = empty */
+    uint32_t used;
+    const uint8_t *cols;
+    uint8_t width;
+    uint8_t copy[LRU_BYTES];
+} lru_entry_t;
+
+static lru_entry_t s_lru[LRU_SLOTS];
+static uint32_t s_lru_clock = 0;
+static display_glyph_stats_t s_stats = {0};
+
+static void lru_reset(void)
+{
+    memset(s_lru, 0, sizeof(s_lru));
+    s_lru_clock = 0;
+    display_text_reset_cache();
+}
+
+esp_err_t display_glyphs_attach(const void *image, size_t size)
+{
+    const glyphs_header_t *h = image;
+    
+    if (size < sizeof(*h) || memcmp(h->magic, GLYPHS_MAGIC, 4) != 0) {
+        ESP_LOGW(TAG, "No glyph store image");
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (h->height == 0 || h->height > GLYPHS_MAX_HEIGHT || h->image_size > size ||
+        sizeof(*h) + (uint64_t)h->count * sizeof(glyphs_entry_t) > h->bitmap_offset ||
+        h->bitmap_offset > h->image_size) {
+        ESP_LOGE(TAG, "Corrupt glyph store header");
+        return ESP_ERR_INVALID_SIZE;
+    }
+    
+    s_header = h;
+    s_index = (const glyphs_entry_t *)(h + 1);
+    s_bitmaps = (const uint8_t *)image + h->bitmap_offset;
+    s_pages = (h->height + 7) / 8;
+    s_stats.glyphs = h->count;
+    lru_reset();
+    
+    ESP_LOGI(TAG, "Glyph store: %lu glyphs, %d rows, %lu bytes",
+             (unsigned long)h->count, h->height, (unsigned long)h->image_size);
+    return ESP_OK;
+}
+
+void display_glyphs_detach(void)
+{
+    s_header = NULL;
+    s_index = NULL;
+    s_bitmaps = NULL;
+    s_stats.glyphs = 0;
+    lru_reset();
+
+#if !CONFIG_IDF_TARGET_LINUX
+    if (s_mapped) {
+        esp_partition_munmap(s_mmap);
+        s_mapped = false;
+    }
+#endif
+}
+
+esp_err_t display_glyphs_mount(const char *label)
+{
+#if CONFIG_IDF_TARGET_LINUX
+    (void)label;
+    return ESP_ERR_NOT_SUPPORTED;
+#else
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                           ESP_PARTITION_SUBTYPE_ANY, label);
+    if (!part) return ESP_ERR_NOT_FOUND;
+    
+    /* Map only as much as the image uses */
+    glyphs_header_t h;
+    esp_err_t ret = esp_partition_read(part, 0, &h, sizeof(h));
+    if (ret != ESP_OK) return ret;
+    if (memcmp(h.magic, GLYPHS_MAGIC, 4) != 0) return ESP_ERR_NOT_FOUND;
+    if (h.image_size > part->size) return ESP_ERR_INVALID_SIZE;
+    
+    display_glyphs_detach();
+    
+    const void *image;
+    ret = esp_partition_mmap(part, 0, h.image_size, ESP_PARTITION_MMAP_DATA, &image, &s_mmap);
+    if (ret != ESP_OK) return ret;
+    s_mapped = true;
+    
+    ret = display_glyphs_attach(image, h.image_size);
+    if (ret != ESP_OK) display_glyphs_detach();
+    return ret;
+#endif
+}
+
+int display_glyphs_height(void)
+{
+    return s_header ? s_header->height : 0;
+}
+
+/**
+ * @brief Binary search of the mapped index
+ */
+static const glyphs_entry_t *index_find(uint32_t cp)
+{
+    int lo = 0;
+    int hi = (int)s_header->count - 1;
+    
+    while (lo <= hi) {
+        int mid = (lo + hi) >> 1;
+        uint32_t v = s_index[mid].codepoint;
+        if (v == cp) return &s_index[mid];
+        if (v < cp) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return NULL;
+}
+
+bool display_glyphs_find(uint32_t cp, display_glyph_t *glyph)
+{
+    if (!s_header || cp == 0) return false;
+    
+    s_stats.lookups++;
+    uint32_t now = ++s_lru_clock;
+    
+    lru_entry_t *victim = &s_lru[0];
+    for (int i = 0; i < LRU_SLOTS; i++) {
+        lru_entry_t *e = &s_lru[i];
+        if (e->codepoint == cp) {
+            s_stats.cache_hits++;
+            e->used = now;
+            if (!e->width) return false;
+            glyph->cols = e->cols;
+            glyph->width = e->width;
+            glyph->pages = s_pages;
+            return true;
+        }
+        if (e->used < victim->used) victim = e;
+    }
+    
+    /* Miss: search flash, then take over the least recently used slot */
+    const glyphs_entry_t *entry = index_find(cp);
+    victim->codepoint = cp;
+    victim->used = now;
+    victim->width = 0;
+    if (!entry) {
+        s_stats.not_found++;
+        return false;
+    }
+    
+    uint8_t width = entry->bitmap & 0xFF;
+    uint32_t offset = entry->bitmap >> 8;
+    size_t bytes = (size_t)width * s_pages;
+    if (!width || s_header->bitmap_offset + offset + bytes > s_header->image_size) {
+        s_stats.not_found++;
+        return false;
+    }
+    
+    const uint8_t *cols = &s_bitmaps[offset];
+    if (bytes <= LRU_BYTES) {
+        memcpy(victim->copy, cols, bytes);
+        cols = victim->copy;
+    }
+    victim->cols = cols;
+    victim->width = width;
+    
+    glyph->cols = cols;
+    glyph->width = width;
+    glyph->pages = s_pages;
+    return true;
+}
+
+void display_glyphs_get_stats(display_glyph_stats_t *stats)
+{
+    *stats = s_stats;
+}
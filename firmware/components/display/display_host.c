@@ -0,0 +1,200 @@
+/**
+ * @file display_host.c
+ * @brief In-memory framebuffer backend
+ *
+ * Stands in for the panel on Linux builds and in benchmarks: flushes land
+ * in a RAM copy of the panel, optionally written out as PBM images. The
+ * banded variant takes bands like the SPI panel, for testing that path.
+ */
+
+#include "display_backend.h"
+#include "esp_log.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "display_host";
+
+static uint8_t s_panel[DISPLAY_WIDTH * DISPLAY_PAGES];
+static const char *s_dump_dir = NULL;
+static uint32_t s_dump_every = 1;
+static uint32_t s_flushes = 0;
+static uint32_t s_dumped = 0;
+static int s_start_line = 0;
+static uint32_t s_transactions = 0;
+static bool s_band_frame_dirty = false;
+
+/*
+ * Queued bands are only copied when retired by host_band_wait(), like a
+ * DMA transfer reading the buffer late, so early buffer reuse shows up
+ */
+#define HOST_BAND_QUEUE     4
+
+typedef struct {
+    const uint8_t *band;
+    int page;
+    int pages;
+} host_band_t;
+
+static host_band_t s_band_queue[HOST_BAND_QUEUE];
+static int s_bands_in_flight = 0;
+
+/**
+ * @brief Write the panel as a binary PBM (P4), lit pixels as ink
+ */
+static void dump_pbm(void)
+{
+    char path[128];
+    snprintf(path, sizeof(path), "%s/frame_%06lu.pbm", s_dump_dir, (unsigned long)s_dumped);
+    
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        ESP_LOGW(TAG, "Cannot write %s", path);
+        s_dump_dir = NULL;
+        return;
+    }
+    
+    fprintf(f, "P4\n%d %d\n", DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    uint8_t row[DISPLAY_WIDTH / 8];
+    for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+        /* Screen row y shows RAM row y + start line, like the controller */
+        int r = (y + s_start_line) % DISPLAY_HEIGHT;
+        const uint8_t *page = &s_panel[(r >> 3) * DISPLAY_WIDTH];
+        uint8_t bit = 1 << (r & 7);
+        memset(row, 0, sizeof(row));
+        for (int x = 0; x < DISPLAY_WIDTH; x++) {
+            if (page[x] & bit) row[x >> 3] |= 0x80 >> (x & 7);
+        }
+        fwrite(row, 1, sizeof(row), f);
+    }
+    fclose(f);
+    s_dumped++;
+}
+
+static esp_err_t host_init(const display_config_t *config)
+{
+    memset(s_panel, 0, sizeof(s_panel));
+    s_dump_dir = config->host.dump_dir;
+    s_dump_every = config->host.dump_every ? config->host.dump_every : 1;
+    s_flushes = 0;
+    s_dumped = 0;
+    s_start_line = 0;
+    s_transactions = 0;
+    s_bands_in_flight = 0;
+    s_band_frame_dirty = false;
+    
+    ESP_LOGI(TAG, "Host framebuffer initialized (dump=%s)", s_dump_dir ? s_dump_dir : "off");
+    return ESP_OK;
+}
+
+static void host_deinit(void)
+{
+}
+
+static esp_err_t host_flush(const uint8_t *frame, const display_span_t *spans,
+                            int start_line, uint32_t *bytes)
+{
+    uint32_t sent = 0;
+    
+    if (start_line >= 0) {
+        s_start_line = start_line;
+        s_transactions++;
+        sent++;
+    }
+    
+    for (int page = 0; page < DISPLAY_PAGES; page++) {
+        if (spans[page].x0 < 0) continue;
+        int idx = page * DISPLAY_WIDTH + spans[page].x0;
+        int len = spans[page].x1 - spans[page].x0 + 1;
+        memcpy(&s_panel[idx], &frame[idx], len);
+        s_transactions++;
+        sent += len;
+    }
+    
+    if (s_dump_dir && s_flushes++ % s_dump_every == 0) {
+        dump_pbm();
+    }
+    
+    *bytes = sent;
+    return ESP_OK;
+}
+
+static esp_err_t host_band_queue(const uint8_t *band, int page, int pages, uint32_t *bytes)
+{
+    if (s_bands_in_flight == HOST_BAND_QUEUE) return ESP_ERR_NO_MEM;
+    
+    host_band_t *q = &s_band_queue[s_bands_in_flight++];
+    q->band = band;
+    q->page = page;
+    q->pages = pages;
+    s_band_frame_dirty = true;
+    s_transactions++;
+    *bytes = pages * DISPLAY_WIDTH;
+    return ESP_OK;
+}
+
+static esp_err_t host_band_wait(int pending)
+{
+    /* Retire the oldest bands first */
+    int done = s_bands_in_flight - pending;
+    if (done > 0) {
+        for (int i = 0; i < done; i++) {
+            const host_band_t *q = &s_band_queue[i];
+            memcpy(&s_panel[q->page * DISPLAY_WIDTH], q->band, q->pages * DISPLAY_WIDTH);
+        }
+        memmove(s_band_queue, &s_band_queue[done], pending * sizeof(s_band_queue[0]));
+        s_bands_in_flight = pending;
+    }
+    
+    /* Waiting for everything ends a frame */
+    if (pending == 0 && s_band_frame_dirty) {
+        s_band_frame_dirty = false;
+        if (s_dump_dir && s_flushes++ % s_dump_every == 0) {
+            dump_pbm();
+        }
+    }
+    return ESP_OK;
+}
+
+static void host_power(bool on)
+{
+    ESP_LOGD(TAG, "Power %s", on ? "on" : "off");
+}
+
+static void host_contrast(uint8_t level)
+{
+    ESP_LOGD(TAG, "Contrast %u", level);
+}
+
+const display_backend_t display_backend_host = {
+    .name = "host",
+    .init = host_init,
+    .deinit = host_deinit,
+    .flush = host_flush,
+    .power = host_power,
+    .contrast = host_contrast,
+};
+
+const display_backend_t display_backend_host_banded = {
+    .name = "host-banded",
+    .init = host_init,
+    .deinit = host_deinit,
+    .band_queue = host_band_queue,
+    .band_wait = host_band_wait,
+    .power = host_power,
+    .contrast = host_contrast,
+};
+
+const uint8_t *display_host_framebuffer(void)
+{
+    return s_panel;
+}
+
+int display_host_start_line(void)
+{
+    return s_start_line;
+}
+
+uint32_t display_host_transactions(void)
+{
+    return s_transactions;
+}
@@ -0,0 +1,234 @@
+/**
+ * @file display_spi.c
+ * @brief Transparent OLED over SPI backend (banded, DMA)
+ *
+ * The panel uses an SSD1309-class controller: same page addressing as the
+ * SSD1306, 4-wire SPI with a D/C line, no internal charge pump. Bands are
+ * queued as a window command plus one DMA data transfer and complete in
+ * order.
+ */
+
+#include "display_backend.h"
+#include "driver/spi_master.h"
+#include "driver/gpio.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+static const char *TAG = "oled_spi";
+
+#define SPI_HOST_ID             SPI2_HOST
+#define SPI_CLOCK_HZ            (10 * 1000 * 1000)
+
+/* Command + data transaction per band, two bands in flight */
+#define BANDS_IN_FLIGHT         2
+#define SPI_QUEUE_SIZE          (BANDS_IN_FLIGHT * 2)
+
+/* Panel commands */
+#define CMD_DISPLAY_OFF         0xAE
+#define CMD_DISPLAY_ON          0xAF
+#define CMD_SET_CONTRAST        0x81
+#define CMD_NORMAL_DISPLAY      0xA6
+#define CMD_SET_MUX_RATIO       0xA8
+#define CMD_SET_DISPLAY_OFFSET  0xD3
+#define CMD_SET_START_LINE      0x40
+#define CMD_SET_SEG_REMAP       0xA0
+#define CMD_SET_COM_SCAN_DIR    0xC0
+#define CMD_SET_COM_PINS        0xDA
+#define CMD_SET_CLOCK_DIV       0xD5
+#define CMD_SET_PRECHARGE       0xD9
+#define CMD_SET_VCOM_DESELECT   0xDB
+#define CMD_MEMORY_MODE         0x20
+#define CMD_SET_COLUMN_ADDR     0x21
+#define CMD_SET_PAGE_ADDR       0x22
+
+static spi_device_handle_t s_dev = NULL;
+static int s_dc_pin = -1;
+static int s_rst_pin = -1;
+
+/* Descriptors and window commands must live until their result is
+ * collected. They are used in a ring, one slot per queued transaction;
+ * a band takes two slots unless queueing its data failed. */
+static spi_transaction_t s_trans[SPI_QUEUE_SIZE];
+static uint8_t s_windows[SPI_QUEUE_SIZE][6];
+static int s_next_slot = 0;
+static int s_trans_queued = 0;      /* Queued transactions not yet collected */
+static int s_bands_queued = 0;      /* Of those, band data transfers */
+
+/* D/C level travels in the transaction's user field */
+static void IRAM_ATTR spi_pre_cb(spi_transaction_t *t)
+{
+    gpio_set_level(s_dc_pin, (int)(intptr_t)t->user);
+}
+
+static esp_err_t send_cmds(const uint8_t *cmds, size_t len)
+{
+    spi_transaction_t t = {
+        .length = len * 8,
+        .tx_buffer = cmds,
+        .user = (void *)0,
+    };
+    return spi_device_polling_transmit(s_dev, &t);
+}
+
+static esp_err_t spi_init(const display_config_t *config)
+{
+    const display_spi_config_t *spi = &config->spi;
+    s_dc_pin = spi->dc_pin;
+    s_rst_pin = spi->rst_pin;
+    
+    gpio_config_t io_conf = {
+        .pin_bit_mask = 1ULL << s_dc_pin,
+        .mode = GPIO_MODE_OUTPUT,
+    };
+    if (s_rst_pin >= 0) io_conf.pin_bit_mask |= 1ULL << s_rst_pin;
+    esp_err_t ret = gpio_config(&io_conf);
+    if (ret != ESP_OK) return ret;
+    
+    spi_bus_config_t bus = {
+        .mosi_io_num = spi->mosi_pin,
+        .miso_io_num = -1,
+        .sclk_io_num = spi->sclk_pin,
+        .quadwp_io_num = -1,
+        .quadhd_io_num = -1,
+        .max_transfer_sz = DISPLAY_WIDTH * DISPLAY_BAND_PAGES,
+    };
+    ret = spi_bus_initialize(SPI_HOST_ID, &bus, SPI_DMA_CH_AUTO);
+    if (ret != ESP_OK) return ret;
+    
+    spi_device_interface_config_t dev = {
+        .clock_speed_hz = SPI_CLOCK_HZ,
+        .mode = 0,
+        .spics_io_num = spi->cs_pin,
+        .queue_size = SPI_QUEUE_SIZE,
+        .pre_cb = spi_pre_cb,
+    };
+    ret = spi_bus_add_device(SPI_HOST_ID, &dev, &s_dev);
+    if (ret != ESP_OK) {
+        spi_bus_free(SPI_HOST_ID);
+        return ret;
+    }
+    
+    if (s_rst_pin >= 0) {
+        gpio_set_level(s_rst_pin, 0);
+        vTaskDelay(pdMS_TO_TICKS(1));
+        gpio_set_level(s_rst_pin, 1);
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+    
+    /* Init sequence; horizontal addressing so a band window fills in one run */
+    const uint8_t init_cmds[] = {
+        CMD_DISPLAY_OFF,
+        CMD_SET_CLOCK_DIV, 0x80,
+        CMD_SET_MUX_RATIO, DISPLAY_HEIGHT - 1,
+        CMD_SET_DISPLAY_OFFSET, 0x00,
+        CMD_SET_START_LINE | 0x00,
+        CMD_MEMORY_MODE, 0x00,
+        CMD_SET_SEG_REMAP | (config->flip_horizontal ? 0x00 : 0x01),
+        CMD_SET_COM_SCAN_DIR | (config->flip_vertical ? 0x00 : 0x08),
+        CMD_SET_COM_PINS, 0x12,
+        CMD_SET_CONTRAST, 0xCF,
+        CMD_SET_PRECHARGE, 0xF1,
+        CMD_SET_VCOM_DESELECT, 0x40,
+        CMD_NORMAL_DISPLAY,
+        CMD_DISPLAY_ON,
+    };
+    ret = send_cmds(init_cmds, sizeof(init_cmds));
+    if (ret != ESP_OK) {
+        spi_bus_remove_device(s_dev);
+        spi_bus_free(SPI_HOST_ID);
+        s_dev = NULL;
+        return ret;
+    }
+    
+    s_next_slot = 0;
+    s_trans_queued = 0;
+    s_bands_queued = 0;
+    ESP_LOGI(TAG, "SPI OLED initialized (MOSI=%d, SCLK=%d, CS=%d, DC=%d)",
+             spi->mosi_pin, spi->sclk_pin, spi->cs_pin, s_dc_pin);
+    return ESP_OK;
+}
+
+static void spi_deinit(void)
+{
+    spi_bus_remove_device(s_dev);
+    spi_bus_free(SPI_HOST_ID);
+    s_dev = NULL;
+}
+
+/**
+ * @brief Queue one transaction in the next ring slot and count it
+ */
+static esp_err_t queue_trans(const void *tx, size_t len, int dc)
+{
+    spi_transaction_t *t = &s_trans[s_next_slot];
+    *t = (spi_transaction_t) {
+        .length = len * 8,
+        .tx_buffer = tx,
+        .user = (void *)(intptr_t)dc,
+    };
+    
+    esp_err_t ret = spi_device_queue_trans(s_dev, t, portMAX_DELAY);
+    if (ret != ESP_OK) return ret;
+    
+    s_next_slot = (s_next_slot + 1) % SPI_QUEUE_SIZE;
+    s_trans_queued++;
+    if (dc) s_bands_queued++;
+    return ESP_OK;
+}
+
+static esp_err_t spi_band_queue(const uint8_t *band, int page, int pages, uint32_t *bytes)
+{
+    if (s_trans_queued > SPI_QUEUE_SIZE - 2) return ESP_ERR_INVALID_STATE;
+    
+    uint8_t *w = s_windows[s_next_slot];
+    w[0] = CMD_SET_COLUMN_ADDR; w[1] = 0;    w[2] = DISPLAY_WIDTH - 1;
+    w[3] = CMD_SET_PAGE_ADDR;   w[4] = page; w[5] = page + pages - 1;
+    
+    /* A window command that went out without its data is still counted,
+     * so its slot is not reused before its result is collected */
+    esp_err_t ret = queue_trans(w, sizeof(s_windows[0]), 0);
+    if (ret == ESP_OK) ret = queue_trans(band, pages * DISPLAY_WIDTH, 1);
+    if (ret != ESP_OK) return ret;
+    
+    *bytes = sizeof(s_windows[0]) + pages * DISPLAY_WIDTH;
+    return ESP_OK;
+}
+
+static esp_err_t spi_band_wait(int pending)
+{
+    /* Results come back in order; also collect window commands left
+     * without data, so the ring has room for the bands allowed in flight */
+    while (s_bands_queued > pending || s_trans_queued > 2 * s_bands_queued) {
+        spi_transaction_t *done;
+        esp_err_t ret = spi_device_get_trans_result(s_dev, &done, pdMS_TO_TICKS(100));
+        if (ret != ESP_OK) return ret;
+        
+        /* Counted one by one, so a timeout leaves the counts exact */
+        s_trans_queued--;
+        if (done->user) s_bands_queued--;
+    }
+    return ESP_OK;
+}
+
+static void spi_power(bool on)
+{
+    uint8_t cmd = on ? CMD_DISPLAY_ON : CMD_DISPLAY_OFF;
+    send_cmds(&cmd, 1);
+}
+
+static void spi_contrast(uint8_t level)
+{
+    uint8_t cmds[2] = { CMD_SET_CONTRAST, level };
+    send_cmds(cmds, sizeof(cmds));
+}
+
+const display_backend_t display_backend_spi = {
+    .name = "oled-spi",
+    .init = spi_init,
+    .deinit = spi_deinit,
+    .band_queue = spi_band_queue,
+    .band_wait = spi_band_wait,
+    .power = spi_power,
+    .contrast = spi_contrast,
+};
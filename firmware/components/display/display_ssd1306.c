@@ -0,0 +1,171 @@
+/**
+ * @file display_ssd1306.c
+ * @brief SSD1306 128x64 over I2C backend
+ */
+
+#include "display_backend.h"
+#include "driver/i2c.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+
+static const char *TAG = "ssd1306";
+
+#define I2C_PORT I2C_NUM_0
+
+/* SSD1306 commands */
+#define CMD_DISPLAY_OFF         0xAE
+#define CMD_DISPLAY_ON          0xAF
+#define CMD_SET_CONTRAST        0x81
+#define CMD_NORMAL_DISPLAY      0xA6
+#define CMD_INVERT_DISPLAY      0xA7
+#define CMD_SET_MUX_RATIO       0xA8
+#define CMD_SET_DISPLAY_OFFSET  0xD3
+#define CMD_SET_START_LINE      0x40
+#define CMD_SET_SEG_REMAP       0xA0
+#define CMD_SET_COM_SCAN_DIR    0xC0
+#define CMD_SET_COM_PINS        0xDA
+#define CMD_SET_CLOCK_DIV       0xD5
+#define CMD_SET_PRECHARGE       0xD9
+#define CMD_SET_VCOM_DESELECT   0xDB
+#define CMD_CHARGE_PUMP         0x8D
+#define CMD_MEMORY_MODE         0x20
+#define CMD_SET_COLUMN_ADDR     0x21
+#define CMD_SET_PAGE_ADDR       0x22
+
+static uint8_t s_i2c_addr = 0x3C;
+
+/* I2C helpers */
+static esp_err_t send_cmd(uint8_t cmd)
+{
+    uint8_t data[2] = {0x00, cmd};
+    return i2c_master_write_to_device(I2C_PORT, s_i2c_addr, data, 2, pdMS_TO_TICKS(100));
+}
+
+static esp_err_t ssd1306_init(const display_config_t *config)
+{
+    int sda = config->i2c.sda_pin;
+    int scl = config->i2c.scl_pin;
+    s_i2c_addr = config->i2c.i2c_addr;
+    
+    i2c_config_t i2c_conf = {
+        .mode = I2C_MODE_MASTER,
+        .sda_io_num = sda,
+        .scl_io_num = scl,
+        .sda_pullup_en = GPIO_PULLUP_ENABLE,
+        .scl_pullup_en = GPIO_PULLUP_ENABLE,
+        .master.clk_speed = 400000,
+    };
+    
+    esp_err_t ret = i2c_param_config(I2C_PORT, &i2c_conf);
+    if (ret != ESP_OK) return ret;
+    
+    ret = i2c_driver_install(I2C_PORT, I2C_MODE_MASTER, 0, 0, 0);
+    if (ret != ESP_OK) return ret;
+    
+    /* Init sequence */
+    send_cmd(CMD_DISPLAY_OFF);
+    send_cmd(CMD_SET_CLOCK_DIV); send_cmd(0x80);
+    send_cmd(CMD_SET_MUX_RATIO); send_cmd(0x3F);
+    send_cmd(CMD_SET_DISPLAY_OFFSET); send_cmd(0x00);
+    send_cmd(CMD_SET_START_LINE | 0x00);
+    send_cmd(CMD_CHARGE_PUMP); send_cmd(0x14);
+    send_cmd(CMD_MEMORY_MODE); send_cmd(0x00);
+    send_cmd(CMD_SET_SEG_REMAP | (config->flip_horizontal ? 0x00 : 0x01));
+    send_cmd(CMD_SET_COM_SCAN_DIR | (config->flip_vertical ? 0x00 : 0x08));
+    send_cmd(CMD_SET_COM_PINS); send_cmd(0x12);
+    send_cmd(CMD_SET_CONTRAST); send_cmd(0xCF);
+    send_cmd(CMD_SET_PRECHARGE); send_cmd(0xF1);
+    send_cmd(CMD_SET_VCOM_DESELECT); send_cmd(0x40);
+    send_cmd(CMD_NORMAL_DISPLAY);
+    send_cmd(CMD_DISPLAY_ON);
+    
+    ESP_LOGI(TAG, "SSD1306 I2C initialized (addr=0x%02X, SDA=%d, SCL=%d)", s_i2c_addr, sda, scl);
+    return ESP_OK;
+}
+
+static void ssd1306_deinit(void)
+{
+    i2c_driver_delete(I2C_PORT);
+}
+
+/**
+ * @brief Send the dirty spans as one I2C command link
+ *
+ * Each dirty page becomes an addressing command followed, after a repeated
+ * start, by its data run; a start line change is appended last. The link
+ * lives in static storage and the runs are referenced in place, so a flush
+ * neither allocates nor copies. Every transaction is counted with its
+ * address and control bytes.
+ */
+static esp_err_t ssd1306_flush(const uint8_t *frame, const display_span_t *spans,
+                               int start_line, uint32_t *bytes)
+{
+    /* Two transactions (window + data) per page, plus the start line */
+    static uint8_t link_buf[I2C_LINK_RECOMMENDED_SIZE(DISPLAY_PAGES * 2 + 1)];
+    
+    /* Window commands must outlive the command link */
+    static uint8_t windows[DISPLAY_PAGES][6];
+    
+    uint8_t addr = (s_i2c_addr << 1) | I2C_MASTER_WRITE;
+    uint32_t sent = 0;
+    
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(link_buf, sizeof(link_buf));
+    if (!cmd) return ESP_ERR_NO_MEM;
+    
+    for (int page = 0; page < DISPLAY_PAGES; page++) {
+        int x0 = spans[page].x0;
+        int x1 = spans[page].x1;
+        if (x0 < 0) continue;
+        
+        uint8_t *w = windows[page];
+        w[0] = CMD_SET_COLUMN_ADDR; w[1] = x0; w[2] = x1;
+        w[3] = CMD_SET_PAGE_ADDR;   w[4] = page; w[5] = page;
+        
+        int len = x1 - x0 + 1;
+        i2c_master_start(cmd);
+        i2c_master_write_byte(cmd, addr, true);
+        i2c_master_write_byte(cmd, 0x00, true);
+        i2c_master_write(cmd, w, sizeof(windows[0]), true);
+        i2c_master_start(cmd);
+        i2c_master_write_byte(cmd, addr, true);
+        i2c_master_write_byte(cmd, 0x40, true);
+        i2c_master_write(cmd, &frame[page * DISPLAY_WIDTH + x0], len, true);
+        sent += (2 + sizeof(windows[0])) + (2 + len);
+    }
+    
+    /* After the data, so the new rows are in RAM when they come into view */
+    if (start_line >= 0) {
+        i2c_master_start(cmd);
+        i2c_master_write_byte(cmd, addr, true);
+        i2c_master_write_byte(cmd, 0x00, true);
+        i2c_master_write_byte(cmd, CMD_SET_START_LINE | start_line, true);
+        sent += 2 + 1;
+    }
+    
+    i2c_master_stop(cmd);
+    esp_err_t ret = i2c_master_cmd_begin(I2C_PORT, cmd, pdMS_TO_TICKS(100));
+    i2c_cmd_link_delete_static(cmd);
+    
+    *bytes = sent;
+    return ret;
+}
+
+static void ssd1306_power(bool on)
+{
+    send_cmd(on ? CMD_DISPLAY_ON : CMD_DISPLAY_OFF);
+}
+
+static void ssd1306_contrast(uint8_t level)
+{
+    send_cmd(CMD_SET_CONTRAST);
+    send_cmd(level);
+}
+
+const display_backend_t display_backend_ssd1306_i2c = {
+    .name = "ssd1306-i2c",
+    .init = ssd1306_init,
+    .deinit = ssd1306_deinit,
+    .flush = ssd1306_flush,
+    .power = ssd1306_power,
+    .contrast = ssd1306_contrast,
+};
@@ -0,0 +1,70 @@
+/**
+ * @file ref_draw.c
+ * @brief Per-pixel reference drawing for the display host tests
+ */
+
+#include "ref_draw.h"
+
+void ref_draw_pixel(uint8_t *frame, int x, int y, display_color_t color)
+{
+    if (x < 0 || x >= DISPLAY_WIDTH || y < 0 || y >= DISPLAY_HEIGHT) return;
+    
+    int idx = x + (y / 8) * DISPLAY_WIDTH;
+    uint8_t bit = 1 << (y & 7);
+    
+    switch (color) {
+        case COLOR_WHITE: frame[idx] |= bit; break;
+        case COLOR_BLACK: frame[idx] &= ~bit; break;
+        case COLOR_INVERSE: frame[idx] ^= bit; break;
+    }
+}
+
+void ref_draw_hline(uint8_t *frame, int x, int y, int w, display_color_t color)
+{
+    for (int i = 0; i < w; i++) ref_draw_pixel(frame, x + i, y, color);
+}
+
+void ref_draw_vline(uint8_t *frame, int x, int y, int h, display_color_t color)
+{
+    for (int i = 0; i < h; i++) ref_draw_pixel(frame, x, y + i, color);
+}
+
+void ref_draw_rect(uint8_t *frame, int x, int y, int w, int h, display_color_t color)
+{
+    ref_draw_hline(frame, x, y, w, color);
+    ref_draw_hline(frame, x, y + h - 1, w, color);
+    ref_draw_vline(frame, x, y, h, color);
+    ref_draw_vline(frame, x + w - 1, y, h, color);
+}
+
+void ref_fill_rect(uint8_t *frame, int x, int y, int w, int h, display_color_t color)
+{
+    for (int i = 0; i < h; i++) ref_draw_hline(frame, x, y + i, w, color);
+}
+
+void ref_draw_circle(uint8_t *frame, int cx, int cy, int r, display_color_t color)
+{
+    int x = r, y = 0, err = 0;
+    while (x >= y) {
+        ref_draw_pixel(frame, cx + x, cy + y, color);
+        ref_draw_pixel(frame, cx + y, cy + x, color);
+        ref_draw_pixel(frame, cx - y, cy + x, color);
+        ref_draw_pixel(frame, cx - x, cy + y, color);
+        ref_draw_pixel(frame, cx - x, cy - y, color);
+        ref_draw_pixel(frame, cx - y, cy - x, color);
+        ref_draw_pixel(frame, cx + y, cy - x, color);
+        ref_draw_pixel(frame, cx + x, cy - y, color);
+        y++;
+        err += 1 + 2 * y;
+        if (2 * (err - x) + 1 > 0) { x--; err += 1 - 2 * x; }
+    }
+}
+
+void ref_fill_circle(uint8_t *frame, int cx, int cy, int r, display_color_t color)
+{
+    for (int y = -r; y <= r; y++) {
+        for (int x = -r; x <= r; x++) {
+            if (x * x + y * y <= r * r) ref_draw_pixel(frame, cx + x, cy + y, color);
+        }
+    }
+}
@@ -0,0 +1,22 @@
+/**
+ * @file ref_draw.h
+ * @brief Per-pixel reference drawing for the display host tests
+ *
+ * The display's drawing functions as they were before the span and
+ * scanline fast paths, working on a plain page-format frame. The fast
+ * paths have to produce the same pixels (see test_shapes.c for the one
+ * deliberate difference).
+ */
+
+#pragma once
+
+#include "display.h"
+#include <stdint.h>
+
+void ref_draw_pixel(uint8_t *frame, int x, int y, display_color_t color);
+void ref_draw_hline(uint8_t *frame, int x, int y, int w, display_color_t color);
+void ref_draw_vline(uint8_t *frame, int x, int y, int h, display_color_t color);
+void ref_draw_rect(uint8_t *frame, int x, int y, int w, int h, display_color_t color);
+void ref_fill_rect(uint8_t *frame, int x, int y, int w, int h, display_color_t color);
+void ref_draw_circle(uint8_t *frame, int cx, int cy, int r, display_color_t color);
+void ref_fill_circle(uint8_t *frame, int cx, int cy, int r, display_color_t color);
@@ -0,0 +1,96 @@
+/**
+ * @file test_alloc.c
+ * @brief The refresh path must not touch the heap
+ *
+ * malloc, calloc, realloc and free are wrapped at link time (see
+ * CMakeLists.txt) and counted while a test has counting switched on.
+ */
+
+#include <stddef.h>
+#include <stdatomic.h>
+#include "unity.h"
+#include "test_display.h"
+
+#define ALLOC_WARMUP_FRAMES     4
+#define ALLOC_FRAMES            200
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+static atomic_bool s_counting;
+static atomic_uint s_allocs;
+static atomic_uint s_frees;
+
+void *__wrap_malloc(size_t size)
+{
+    if (atomic_load(&s_counting)) atomic_fetch_add(&s_allocs, 1);
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+    if (atomic_load(&s_counting)) atomic_fetch_add(&s_allocs, 1);
+    return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    if (atomic_load(&s_counting)) atomic_fetch_add(&s_allocs, 1);
+    return __real_realloc(ptr, size);
+}
+
+void __wrap_free(void *ptr)
+{
+    if (atomic_load(&s_counting) && ptr) atomic_fetch_add(&s_frees, 1);
+    __real_free(ptr);
+}
+
+/* A frame that differs from the last one, so every refresh sends spans */
+static void draw_frame(int n)
+{
+    display_clear();
+    display_fill_rect(n % DISPLAY_WIDTH, 0, 17, DISPLAY_HEIGHT, COLOR_WHITE);
+    display_draw_hline(0, n % DISPLAY_HEIGHT, DISPLAY_WIDTH, COLOR_INVERSE);
+    display_draw_string(2, 2, "alloc", COLOR_INVERSE, 1 + n % 2);
+}
+
+static void draw_frame_cb(void *ctx)
+{
+    draw_frame(*(int *)ctx);
+}
+
+TEST_CASE("refresh does not allocate after warm-up", "[display]")
+{
+    test_display_start();
+    
+    for (int n = 0; n < ALLOC_WARMUP_FRAMES; n++) {
+        draw_frame(n);
+        display_refresh();
+    }
+    test_display_sync();
+    
+    display_stats_t before, after;
+    display_get_stats(&before);
+    atomic_store(&s_allocs, 0);
+    atomic_store(&s_frees, 0);
+    atomic_store(&s_counting, true);
+    
+    for (int n = 0; n < ALLOC_FRAMES; n++) {
+        if (n & 1) {
+            display_render(draw_frame_cb, &n);
+        } else {
+            draw_frame(n);
+            display_refresh();
+        }
+    }
+    test_display_sync();
+    
+    atomic_store(&s_counting, false);
+    display_get_stats(&after);
+    
+    TEST_ASSERT_EQUAL(ALLOC_FRAMES, after.frames - before.frames);
+    TEST_ASSERT_EQUAL(0, atomic_load(&s_allocs));
+    TEST_ASSERT_EQUAL(0, atomic_load(&s_frees));
+}
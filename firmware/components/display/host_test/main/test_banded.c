@@ -0,0 +1,153 @@
+/**
+ * @file test_banded.c
+ * @brief Banded rendering against full frames on random scenes
+ *
+ * A banded panel runs the draw callback once per band, with the target
+ * and clip cut to that band, so every primitive that crosses a band edge
+ * is drawn in pieces. The pieces have to add up to the frame the
+ * full-frame path draws in one go: each random scene is rendered both
+ * ways and the panels compared.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "unity.h"
+#include "test_display.h"
+
+#define SCENE_COUNT         200
+#define SCENE_OPS           24
+
+/* Small surface blitted into some scenes; created before either pass */
+static display_surface_t s_surface;
+
+static const char *const s_texts[] = {
+    "Hello", "band edge", "Wg|jy", "0123456789", "@#%&", "a much longer line of text",
+};
+
+/* Anywhere on screen, a little past each edge */
+static int rand_x(uint32_t *seed)
+{
+    return (int)(test_rand(seed) % (DISPLAY_WIDTH + 20)) - 10;
+}
+
+static int rand_y(uint32_t *seed)
+{
+    return (int)(test_rand(seed) % (DISPLAY_HEIGHT + 20)) - 10;
+}
+
+static int rand_size(uint32_t *seed, int max)
+{
+    return 1 + (int)(test_rand(seed) % max);
+}
+
+/**
+ * @brief Draw a random scene
+ *
+ * Everything comes from the scene seed, copied first, so every band and
+ * both passes draw the same thing.
+ */
+static void draw_scene(void *ctx)
+{
+    uint32_t seed = *(const uint32_t *)ctx;
+    int clips = 0;
+    
+    display_clear();
+    for (int i = 0; i < SCENE_OPS; i++) {
+        display_color_t color = (display_color_t)(test_rand(&seed) % 3);
+        int x = rand_x(&seed);
+        int y = rand_y(&seed);
+        int w = rand_size(&seed, DISPLAY_WIDTH / 2);
+        int h = rand_size(&seed, DISPLAY_HEIGHT / 2);
+        
+        switch (test_rand(&seed) % 14) {
+            case 0:
+                display_fill_rect(x, y, w, h, color);
+                break;
+            case 1:
+                display_draw_rect(x, y, w, h, color);
+                break;
+            case 2:
+                display_fill_round_rect(x, y, w, h, rand_size(&seed, 8), color);
+                break;
+            case 3:
+                display_draw_circle(x, y, rand_size(&seed, 30), color);
+                break;
+            case 4:
+                display_fill_circle(x, y, rand_size(&seed, 30), color);
+                break;
+            case 5:
+                display_draw_line(x, y, rand_x(&seed), rand_y(&seed), color);
+                break;
+            case 6:
+                display_draw_string(x, y, s_texts[test_rand(&seed) % 6], color, rand_size(&seed, 3));
+                break;
+            case 7:
+                display_draw_text(x, y, s_texts[test_rand(&seed) % 6],
+                                  (display_font_id_t)(test_rand(&seed) % DISPLAY_FONT_COUNT), color);
+                break;
+            case 8: {
+                uint8_t bits[4 * 2];
+                for (int b = 0; b < (int)sizeof(bits); b++) bits[b] = (uint8_t)test_rand(&seed);
+                display_draw_bitmap(x, y, bits, 13, 4, color);
+                break;
+            }
+            case 9: {
+                uint8_t data[2 * 9];
+                for (int b = 0; b < (int)sizeof(data); b++) data[b] = (uint8_t)test_rand(&seed);
+                display_sprite_t sprite = { .width = 9, .height = 15, .data = data };
+                display_draw_sprite(x, y, &sprite, color);
+                break;
+            }
+            case 10:
+                if (display_push_clip(x, y, w, h) == ESP_OK) clips++;
+                break;
+            case 11:
+                if (display_push_viewport(x, y, w, h) == ESP_OK) clips++;
+                break;
+            case 12:
+                if (clips > 0) {
+                    display_pop_clip();
+                    clips--;
+                }
+                break;
+            case 13:
+                /* Redrawn every band, like a surface an app rebuilds each frame */
+                display_surface_begin(&s_surface);
+                display_fill_circle(12, 10, 9, COLOR_WHITE);
+                display_draw_string(2, 6, "sf", COLOR_INVERSE, 1);
+                display_surface_end();
+                display_blit_surface(x, y, &s_surface);
+                break;
+        }
+    }
+    display_reset_clip();
+}
+
+TEST_CASE("banded rendering matches full frames on random scenes", "[display]")
+{
+    static uint8_t banded[SCENE_COUNT][TEST_FRAME_SIZE];
+    char msg[32];
+    
+    TEST_ASSERT_EQUAL(ESP_OK, display_surface_create(&s_surface, 30, 21));
+    
+    test_display_restart(true);
+    TEST_ASSERT_TRUE(display_is_banded());
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_SUPPORTED, display_set_scroll(0));
+    for (uint32_t i = 0; i < SCENE_COUNT; i++) {
+        uint32_t seed = 0x9E3779B9u + i;
+        display_render(draw_scene, &seed);
+        memcpy(banded[i], display_host_framebuffer(), TEST_FRAME_SIZE);
+    }
+    
+    test_display_restart(false);
+    TEST_ASSERT_FALSE(display_is_banded());
+    for (uint32_t i = 0; i < SCENE_COUNT; i++) {
+        uint32_t seed = 0x9E3779B9u + i;
+        display_render(draw_scene, &seed);
+        test_display_sync();
+        snprintf(msg, sizeof(msg), "scene %u", (unsigned)i);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(banded[i], display_host_framebuffer(), TEST_FRAME_SIZE, msg);
+    }
+    
+    display_surface_destroy(&s_surface);
+}
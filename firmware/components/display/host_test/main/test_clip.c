@@ -0,0 +1,155 @@
+/**
+ * @file test_clip.c
+ * @brief Clip and viewport stack: nesting, overflow and unbalanced pops
+ *
+ * Each push intersects with the clip below it, a viewport also moves the
+ * origin, and a pop restores exactly what its push saved. A push past the
+ * stack depth fails but still takes a pop, and pops with nothing pushed
+ * leave the full screen in place, so one unbalanced caller cannot strand
+ * the next frame in someone else's clip.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "unity.h"
+#include "test_display.h"
+#include "ref_draw.h"
+
+typedef struct {
+    int x, y, w, h;
+} clip_rect_t;
+
+static clip_rect_t get_clip(void)
+{
+    clip_rect_t r;
+    display_get_clip(&r.x, &r.y, &r.w, &r.h);
+    return r;
+}
+
+static void assert_clip(int x, int y, int w, int h, const char *msg)
+{
+    clip_rect_t r = get_clip();
+    TEST_ASSERT_EQUAL_MESSAGE(x, r.x, msg);
+    TEST_ASSERT_EQUAL_MESSAGE(y, r.y, msg);
+    TEST_ASSERT_EQUAL_MESSAGE(w, r.w, msg);
+    TEST_ASSERT_EQUAL_MESSAGE(h, r.h, msg);
+}
+
+/**
+ * @brief Fill everything the active clip lets through, from origin (0, 0)
+ *
+ * The fill starts at the origin, so a wrong origin shows as well as a
+ * wrong clip.
+ */
+static void fill_visible(void)
+{
+    display_fill_rect(-DISPLAY_WIDTH, -DISPLAY_HEIGHT, 3 * DISPLAY_WIDTH, 3 * DISPLAY_HEIGHT, COLOR_WHITE);
+    display_draw_pixel(0, 0, COLOR_INVERSE);
+}
+
+/**
+ * @brief Frame expected from fill_visible() with a screen clip rect and origin
+ */
+static void ref_visible(uint8_t *frame, int x, int y, int w, int h, int ox, int oy)
+{
+    memset(frame, 0, TEST_FRAME_SIZE);
+    ref_fill_rect(frame, x, y, w, h, COLOR_WHITE);
+    if (ox >= x && ox < x + w && oy >= y && oy < y + h) ref_draw_pixel(frame, ox, oy, COLOR_INVERSE);
+}
+
+static void check_visible(int x, int y, int w, int h, int ox, int oy, const char *msg)
+{
+    static uint8_t ref[TEST_FRAME_SIZE];
+    static uint8_t out[TEST_FRAME_SIZE];
+    
+    ref_visible(ref, x, y, w, h, ox, oy);
+    display_clear();
+    fill_visible();
+    test_display_capture(out);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(ref, out, TEST_FRAME_SIZE, msg);
+}
+
+TEST_CASE("nested clips and viewports intersect and pop back", "[display]")
+{
+    test_display_start();
+    display_reset_clip();
+    
+    /* The UI's app viewport */
+    TEST_ASSERT_EQUAL(ESP_OK, display_push_viewport(0, 10, DISPLAY_WIDTH, 54));
+    assert_clip(0, 0, DISPLAY_WIDTH, 54, "app viewport");
+    check_visible(0, 10, DISPLAY_WIDTH, 54, 0, 10, "app viewport");
+    
+    /* A clip inside it keeps the origin; its rect is in viewport coordinates */
+    TEST_ASSERT_EQUAL(ESP_OK, display_push_clip(20, 5, 30, 20));
+    assert_clip(20, 5, 30, 20, "clip in viewport");
+    check_visible(20, 15, 30, 20, 0, 10, "clip in viewport");
+    
+    /* A viewport reaching past the clip is cut to it and moves the origin */
+    TEST_ASSERT_EQUAL(ESP_OK, display_push_viewport(40, 10, 50, 50));
+    assert_clip(0, 0, 10, 15, "viewport in clip");
+    check_visible(40, 20, 10, 15, 40, 20, "viewport in clip");
+    
+    /* Outside everything: empty, and nothing is drawn */
+    TEST_ASSERT_EQUAL(ESP_OK, display_push_clip(-30, -30, 10, 10));
+    clip_rect_t empty = get_clip();
+    TEST_ASSERT_TRUE(empty.w == 0 || empty.h == 0);
+    check_visible(0, 0, 0, 0, 0, 0, "empty clip");
+    
+    /* Each pop restores what its push saved */
+    display_pop_clip();
+    assert_clip(0, 0, 10, 15, "pop to viewport in clip");
+    display_pop_clip();
+    assert_clip(20, 5, 30, 20, "pop to clip in viewport");
+    check_visible(20, 15, 30, 20, 0, 10, "pop to clip in viewport");
+    display_pop_clip();
+    assert_clip(0, 0, DISPLAY_WIDTH, 54, "pop to app viewport");
+    display_pop_clip();
+    assert_clip(0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT, "pop to screen");
+    check_visible(0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT, 0, 0, "pop to screen");
+}
+
+TEST_CASE("clip stack overflow and underflow leave a usable clip", "[display]")
+{
+    char msg[32];
+    
+    test_display_start();
+    display_reset_clip();
+    
+    /* Fill the stack, each viewport one pixel further in */
+    for (int i = 0; i < DISPLAY_CLIP_STACK_DEPTH; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, display_push_viewport(1, 1, DISPLAY_WIDTH, DISPLAY_HEIGHT));
+    }
+    int d = DISPLAY_CLIP_STACK_DEPTH;
+    check_visible(d, d, DISPLAY_WIDTH - d, DISPLAY_HEIGHT - d, d, d, "full stack");
+    
+    /* Pushes past the depth fail and leave the clip alone, but still take a pop */
+    TEST_ASSERT_EQUAL(ESP_ERR_NO_MEM, display_push_clip(0, 0, 4, 4));
+    TEST_ASSERT_EQUAL(ESP_ERR_NO_MEM, display_push_viewport(2, 2, 4, 4));
+    check_visible(d, d, DISPLAY_WIDTH - d, DISPLAY_HEIGHT - d, d, d, "failed pushes");
+    display_pop_clip();
+    display_pop_clip();
+    check_visible(d, d, DISPLAY_WIDTH - d, DISPLAY_HEIGHT - d, d, d, "failed pushes popped");
+    
+    for (int i = DISPLAY_CLIP_STACK_DEPTH - 1; i >= 0; i--) {
+        display_pop_clip();
+        snprintf(msg, sizeof(msg), "depth %d", i);
+        assert_clip(0, 0, DISPLAY_WIDTH - i, DISPLAY_HEIGHT - i, msg);
+    }
+    
+    /* More pops than pushes: still the whole screen from its corner */
+    display_pop_clip();
+    display_pop_clip();
+    assert_clip(0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT, "underflow");
+    check_visible(0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT, 0, 0, "underflow");
+    
+    /* And the stack works as before */
+    TEST_ASSERT_EQUAL(ESP_OK, display_push_viewport(8, 8, 16, 16));
+    check_visible(8, 8, 16, 16, 8, 8, "push after underflow");
+    display_pop_clip();
+    
+    /* An app that leaves clips pushed is reset by the next frame */
+    TEST_ASSERT_EQUAL(ESP_OK, display_push_clip(0, 0, 4, 4));
+    TEST_ASSERT_EQUAL(ESP_OK, display_push_viewport(1, 1, 2, 2));
+    display_reset_clip();
+    check_visible(0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT, 0, 0, "reset");
+}
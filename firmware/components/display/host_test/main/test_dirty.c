@@ -0,0 +1,104 @@
+/**
+ * @file test_dirty.c
+ * @brief display_refresh() sends only what changed
+ *
+ * The host backend counts the bytes and the writes a panel would get, so
+ * each refresh can be checked against the spans it should have sent: one
+ * write per changed page, covering its first to last changed column, and
+ * nothing at all for a clean frame.
+ */
+
+#include <string.h>
+#include "unity.h"
+#include "test_display.h"
+
+/* Transfer counters gained by one refresh */
+typedef struct {
+    uint32_t frames;
+    uint32_t skipped;
+    uint32_t bytes;
+    uint32_t writes;
+} refresh_cost_t;
+
+static void draw_scene(void)
+{
+    display_clear();
+    display_fill_rect(0, 0, DISPLAY_WIDTH, 10, COLOR_WHITE);
+    display_draw_string(4, 20, "dirty spans", COLOR_WHITE, 1);
+    display_draw_circle(100, 44, 12, COLOR_WHITE);
+}
+
+/* The scene with pixels changed in pages 0 and 5 */
+static void draw_changes(void)
+{
+    draw_scene();
+    display_draw_pixel(10, 42, COLOR_WHITE);
+    display_draw_pixel(100, 47, COLOR_INVERSE);
+    display_draw_pixel(0, 0, COLOR_BLACK);
+}
+
+/**
+ * @brief Refresh what has been drawn and report what it cost
+ */
+static refresh_cost_t refresh_cost(void)
+{
+    display_stats_t before, after;
+    test_display_sync();
+    display_get_stats(&before);
+    uint32_t writes = display_host_transactions();
+    
+    display_refresh();
+    test_display_sync();
+    display_get_stats(&after);
+    
+    refresh_cost_t cost = {
+        .frames = after.frames - before.frames,
+        .skipped = after.skipped_frames - before.skipped_frames,
+        .bytes = (uint32_t)(after.total_bytes - before.total_bytes),
+        .writes = display_host_transactions() - writes,
+    };
+    TEST_ASSERT_EQUAL_UINT32(cost.bytes, after.last_frame_bytes);
+    return cost;
+}
+
+TEST_CASE("refresh sends only the changed span of each page", "[display]")
+{
+    static uint8_t frame[TEST_FRAME_SIZE];
+    
+    test_display_start();
+    draw_scene();
+    refresh_cost();
+    
+    /* Same frame again: nothing reaches the panel */
+    draw_scene();
+    refresh_cost_t cost = refresh_cost();
+    TEST_ASSERT_EQUAL_UINT32(1, cost.frames);
+    TEST_ASSERT_EQUAL_UINT32(1, cost.skipped);
+    TEST_ASSERT_EQUAL_UINT32(0, cost.bytes);
+    TEST_ASSERT_EQUAL_UINT32(0, cost.writes);
+    
+    /* One pixel: one byte in one write */
+    draw_scene();
+    display_draw_pixel(70, 30, COLOR_WHITE);
+    cost = refresh_cost();
+    TEST_ASSERT_EQUAL_UINT32(0, cost.skipped);
+    TEST_ASSERT_EQUAL_UINT32(1, cost.bytes);
+    TEST_ASSERT_EQUAL_UINT32(1, cost.writes);
+    
+    /* Changes at both ends of page 5 send the columns between them too,
+     * page 0 only its changed column, and page 3 goes back to the scene */
+    draw_changes();
+    cost = refresh_cost();
+    TEST_ASSERT_EQUAL_UINT32((100 - 10 + 1) + 1 + 1, cost.bytes);
+    TEST_ASSERT_EQUAL_UINT32(3, cost.writes);
+    
+    /* After an invalidate every page goes out whole, with the start line,
+     * and finds the panel already showing the frame the spans built */
+    memcpy(frame, display_host_framebuffer(), TEST_FRAME_SIZE);
+    display_invalidate();
+    draw_changes();
+    cost = refresh_cost();
+    TEST_ASSERT_EQUAL_UINT32(TEST_FRAME_SIZE + 1, cost.bytes);
+    TEST_ASSERT_EQUAL_UINT32(DISPLAY_HEIGHT / 8 + 1, cost.writes);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(frame, display_host_framebuffer(), TEST_FRAME_SIZE);
+}
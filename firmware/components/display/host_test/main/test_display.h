@@ -0,0 +1,44 @@
+/**
+ * @file test_display.h
+ * @brief Shared helpers for the display host tests
+ */
+
+#pragma once
+
+#include "display.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TEST_FRAME_SIZE     (DISPLAY_WIDTH * DISPLAY_HEIGHT / 8)
+
+/**
+ * @brief Bring up the full-frame host backend (no-op if already up)
+ */
+void test_display_start(void);
+
+/**
+ * @brief Bring the host backend up again, banded or full-frame
+ *
+ * Tests that switch to banded have to switch back before they return.
+ */
+void test_display_restart(bool banded);
+
+/**
+ * @brief Send the frame drawn so far and copy what reached the panel
+ */
+void test_display_capture(uint8_t *out);
+
+/**
+ * @brief Wait until every queued refresh has been flushed
+ */
+void test_display_sync(void);
+
+/**
+ * @brief Monotonic time in nanoseconds, for benchmarks
+ */
+uint64_t test_now_ns(void);
+
+/**
+ * @brief Deterministic pseudo-random numbers (xorshift32)
+ */
+uint32_t test_rand(uint32_t *state);
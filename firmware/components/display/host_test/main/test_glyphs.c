@@ -0,0 +1,237 @@
+/**
+ * @file test_glyphs.c
+ * @brief Glyph store lookups, from a UTF-8 string to the drawn columns
+ *
+ * The store is test_glyphs.bdf put through tools/bdf2glyphs.py at build
+ * time. Its glyphs have distinct widths, so measuring a string in the 6x8
+ * font (6 pixels per character, '?' included) shows what each sequence
+ * decoded to and whether the store had it. The benchmark times lookups
+ * that the 32-slot LRU serves against ones it cannot hold.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "unity.h"
+#include "test_display.h"
+#include "ref_draw.h"
+
+#define GLYPHS_LRU_SLOTS    32          /* display_glyphs.c LRU_SLOTS */
+#define CJK_FIRST           0x4E00      /* U+4E00-U+4E2F are in the store */
+#define CJK_COUNT           48
+#define BENCH_PASSES        2000
+
+/* Advances in the test font */
+#define W_ASCII             6           /* Also the '?' drawn for anything missing */
+#define W_E_ACUTE           5
+#define W_ZHE               7
+#define W_A_HIRAGANA        11
+#define W_CJK               8
+#define W_SMILEY            10
+
+extern const uint8_t test_glyphs_start[] asm("_binary_test_glyphs_bin_start");
+extern const uint8_t test_glyphs_end[] asm("_binary_test_glyphs_bin_end");
+
+/* Rows of two glyphs as in the BDF, drawn at an x offset, MSB = left */
+static const uint8_t s_e_acute_rows[8] = { 0x10, 0x20, 0x70, 0x88, 0xF8, 0x80, 0x70, 0x00 };
+static const uint8_t s_smiley_rows[8] = { 0x3C, 0x42, 0xA5, 0x81, 0xA5, 0x99, 0x42, 0x3C };
+
+static void attach_store(void)
+{
+    test_display_start();
+    TEST_ASSERT_EQUAL(ESP_OK, display_glyphs_attach(test_glyphs_start,
+                                                    test_glyphs_end - test_glyphs_start));
+}
+
+/**
+ * @brief Lookup counters gained since `before`
+ */
+static display_glyph_stats_t stats_since(const display_glyph_stats_t *before)
+{
+    display_glyph_stats_t now;
+    display_glyphs_get_stats(&now);
+    now.lookups -= before->lookups;
+    now.cache_hits -= before->cache_hits;
+    now.not_found -= before->not_found;
+    return now;
+}
+
+/**
+ * @brief UTF-8 for one codepoint of up to three bytes
+ */
+static void encode_utf8(uint32_t cp, char *out)
+{
+    if (cp < 0x800) {
+        *out++ = (char)(0xC0 | cp >> 6);
+    } else {
+        *out++ = (char)(0xE0 | cp >> 12);
+        *out++ = (char)(0x80 | (cp >> 6 & 0x3F));
+    }
+    *out++ = (char)(0x80 | (cp & 0x3F));
+    *out = '\0';
+}
+
+/**
+ * @brief The first `count` CJK glyphs of the store as one string
+ */
+static void cjk_string(int count, char *out)
+{
+    for (int i = 0; i < count; i++) {
+        encode_utf8(CJK_FIRST + i, out);
+        out += strlen(out);
+    }
+}
+
+TEST_CASE("glyph store decodes UTF-8 of every length", "[display]")
+{
+    attach_store();
+    
+    display_glyph_stats_t stats;
+    display_glyphs_get_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(52, stats.glyphs);
+    
+    TEST_ASSERT_EQUAL(W_E_ACUTE, display_measure_string("\xC3\xA9", DISPLAY_FONT_6X8));
+    TEST_ASSERT_EQUAL(W_ZHE, display_measure_string("\xD0\x96", DISPLAY_FONT_6X8));
+    TEST_ASSERT_EQUAL(W_A_HIRAGANA, display_measure_string("\xE3\x81\x82", DISPLAY_FONT_6X8));
+    TEST_ASSERT_EQUAL(W_CJK, display_measure_string("\xE4\xB8\xAD", DISPLAY_FONT_6X8));
+    TEST_ASSERT_EQUAL(W_SMILEY, display_measure_string("\xF0\x9F\x98\x80", DISPLAY_FONT_6X8));
+    
+    /* Mixed with ASCII, which stays on the font */
+    TEST_ASSERT_EQUAL(W_ASCII + W_E_ACUTE + W_CJK + W_ASCII + W_SMILEY,
+                      display_measure_string("a\xC3\xA9\xE4\xB8\x80z\xF0\x9F\x98\x80", DISPLAY_FONT_6X8));
+    
+    /* The image's bitmaps land where the BDF put them */
+    static uint8_t ref[TEST_FRAME_SIZE];
+    static uint8_t out[TEST_FRAME_SIZE];
+    memset(ref, 0, sizeof(ref));
+    for (int y = 0; y < 8; y++) {
+        for (int x = 0; x < 8; x++) {
+            if (s_e_acute_rows[y] & 0x80 >> x) ref_draw_pixel(ref, 10 + x, 20 + y, COLOR_WHITE);
+            if (s_smiley_rows[y] & 0x80 >> x) ref_draw_pixel(ref, 15 + 1 + x, 20 + y, COLOR_WHITE);
+        }
+    }
+    display_clear();
+    display_draw_string(10, 20, "\xC3\xA9\xF0\x9F\x98\x80", COLOR_WHITE, 1);
+    test_display_capture(out);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(ref, out, TEST_FRAME_SIZE);
+    
+    display_glyphs_detach();
+}
+
+TEST_CASE("glyph store draws '?' for missing and malformed text", "[display]")
+{
+    attach_store();
+    
+    /* Well formed but not in the store: U+00DF, U+20AC, U+1F601 */
+    display_glyph_stats_t before;
+    display_glyphs_get_stats(&before);
+    TEST_ASSERT_EQUAL(W_ASCII, display_measure_string("\xC3\x9F", DISPLAY_FONT_6X8));
+    TEST_ASSERT_EQUAL(W_ASCII, display_measure_string("\xE2\x82\xAC", DISPLAY_FONT_6X8));
+    TEST_ASSERT_EQUAL(W_ASCII, display_measure_string("\xF0\x9F\x98\x81", DISPLAY_FONT_6X8));
+    display_glyph_stats_t d = stats_since(&before);
+    TEST_ASSERT_EQUAL_UINT32(3, d.lookups);
+    TEST_ASSERT_EQUAL_UINT32(3, d.not_found);
+    
+    /* Each malformed sequence is one '?' for the bytes read, then decoding resumes */
+    static const struct {
+        const char *text;
+        int width;
+    } cases[] = {
+        { "\x80", W_ASCII },                                    /* Lone continuation */
+        { "\xC3", W_ASCII },                                    /* Cut short by the end */
+        { "\xE4\xB8", W_ASCII },
+        { "\xF0\x9F\x98", W_ASCII },
+        { "\xC3(", W_ASCII + W_ASCII },                         /* Not a continuation */
+        { "\xE4(\xC3\xA9", W_ASCII + W_ASCII + W_E_ACUTE },
+        { "\xC0\xAF", W_ASCII + W_ASCII },                      /* Overlong '/' */
+        { "\xF5\x80\x80\x80", 4 * W_ASCII },                    /* Past U+10FFFF */
+        { "\xFF" "a", W_ASCII + W_ASCII },
+        { "\xC3\xA9\xC3", W_E_ACUTE + W_ASCII },
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        char msg[32];
+        snprintf(msg, sizeof(msg), "case %u", (unsigned)i);
+        TEST_ASSERT_EQUAL_MESSAGE(cases[i].width,
+                                  display_measure_string(cases[i].text, DISPLAY_FONT_6X8), msg);
+    }
+    
+    /* A sequence cut short never steps over the terminator into what follows */
+    const char cut[] = "\xE4\xB8\0\xC3\xA9";
+    TEST_ASSERT_EQUAL(W_ASCII, display_measure_string(cut, DISPLAY_FONT_6X8));
+    
+    display_glyphs_detach();
+    
+    /* Without a store everything beyond ASCII is '?' */
+    TEST_ASSERT_EQUAL(W_ASCII + W_ASCII, display_measure_string("\xC3\xA9\xE4\xB8\xAD", DISPLAY_FONT_6X8));
+}
+
+TEST_CASE("glyph store LRU keeps hits and misses", "[display]")
+{
+    static char text[CJK_COUNT * 3 + 1];
+    attach_store();
+    
+    /* Found and missing codepoints are both remembered */
+    display_glyph_stats_t before;
+    display_glyphs_get_stats(&before);
+    display_measure_string("\xE4\xB8\xAD\xC3\x9F", DISPLAY_FONT_6X8);
+    display_measure_string("\xE4\xB8\xAD\xC3\x9F", DISPLAY_FONT_6X8);
+    display_glyph_stats_t d = stats_since(&before);
+    TEST_ASSERT_EQUAL_UINT32(4, d.lookups);
+    TEST_ASSERT_EQUAL_UINT32(2, d.cache_hits);
+    TEST_ASSERT_EQUAL_UINT32(1, d.not_found);
+    
+    /* A working set that fits: the second pass is all hits */
+    attach_store();
+    cjk_string(GLYPHS_LRU_SLOTS, text);
+    display_glyphs_get_stats(&before);
+    TEST_ASSERT_EQUAL(GLYPHS_LRU_SLOTS * W_CJK, display_measure_string(text, DISPLAY_FONT_6X8));
+    TEST_ASSERT_EQUAL(GLYPHS_LRU_SLOTS * W_CJK, display_measure_string(text, DISPLAY_FONT_6X8));
+    d = stats_since(&before);
+    TEST_ASSERT_EQUAL_UINT32(2 * GLYPHS_LRU_SLOTS, d.lookups);
+    TEST_ASSERT_EQUAL_UINT32(GLYPHS_LRU_SLOTS, d.cache_hits);
+    TEST_ASSERT_EQUAL_UINT32(0, d.not_found);
+    
+    /* Cycling through more than the LRU holds evicts each glyph before its
+     * next use, so every lookup goes to the image */
+    attach_store();
+    cjk_string(CJK_COUNT, text);
+    display_glyphs_get_stats(&before);
+    TEST_ASSERT_EQUAL(CJK_COUNT * W_CJK, display_measure_string(text, DISPLAY_FONT_6X8));
+    TEST_ASSERT_EQUAL(CJK_COUNT * W_CJK, display_measure_string(text, DISPLAY_FONT_6X8));
+    d = stats_since(&before);
+    TEST_ASSERT_EQUAL_UINT32(2 * CJK_COUNT, d.lookups);
+    TEST_ASSERT_EQUAL_UINT32(0, d.cache_hits);
+    
+    display_glyphs_detach();
+}
+
+TEST_CASE("glyph store lookup benchmark", "[display][bench]")
+{
+    static char text[CJK_COUNT * 3 + 1];
+    
+    printf("%-24s %8s %10s %10s\n", "working set", "glyphs", "ns/glyph", "hit rate");
+    for (int pass = 0; pass < 2; pass++) {
+        /* The LRU serves the first set; the second defeats it */
+        int count = pass == 0 ? GLYPHS_LRU_SLOTS : CJK_COUNT;
+        attach_store();
+        cjk_string(count, text);
+        display_measure_string(text, DISPLAY_FONT_6X8);
+        
+        display_glyph_stats_t before;
+        display_glyphs_get_stats(&before);
+        long width = 0;
+        uint64_t t0 = test_now_ns();
+        for (int i = 0; i < BENCH_PASSES; i++) {
+            width += display_measure_string(text, DISPLAY_FONT_6X8);
+        }
+        uint64_t t1 = test_now_ns();
+        display_glyph_stats_t d = stats_since(&before);
+        
+        TEST_ASSERT_EQUAL(count * W_CJK * BENCH_PASSES, width);
+        TEST_ASSERT_EQUAL_UINT32(count * BENCH_PASSES, d.lookups);
+        TEST_ASSERT_EQUAL_UINT32(pass == 0 ? d.lookups : 0, d.cache_hits);
+        printf("%-24s %8d %10.1f %9.0f%%\n", pass == 0 ? "fits the LRU" : "larger than the LRU",
+               count, (double)(t1 - t0) / d.lookups, 100.0 * d.cache_hits / d.lookups);
+    }
+    
+    display_glyphs_detach();
+}
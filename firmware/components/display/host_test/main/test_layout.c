@@ -0,0 +1,190 @@
+/**
+ * @file test_layout.c
+ * @brief Measuring, fitting and wrapping text in every font
+ *
+ * display_measure_chars() is the yardstick: a fit or a wrap is right if
+ * what it keeps measures within the width and one more character would
+ * not. Kerning is checked to be a per-pair adjustment, so widths of the
+ * proportional fonts add up character by character. The fit cache is
+ * checked to tell apart two strings whose hashes collide.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "unity.h"
+#include "test_display.h"
+
+static const char *const s_samples[] = {
+    "Hello, World",
+    "iiiiiiiiii WWWWWWWW",
+    "AVATAR To Tyre Wave",
+    "the quick brown fox jumps over the lazy dog",
+    "a supercalifragilisticexpialidocious word",
+    "\nafter a leading newline",
+    "two\nlines",
+    "",
+    " leading and trailing spaces ",
+};
+
+#define SAMPLE_COUNT        (sizeof(s_samples) / sizeof(s_samples[0]))
+
+static int line_len(const char *str)
+{
+    const char *nl = strchr(str, '\n');
+    return nl ? (int)(nl - str) : (int)strlen(str);
+}
+
+/**
+ * @brief Width of the ellipsis display_draw_text_fit() ends a cut line with
+ */
+static int ellipsis_width(display_font_id_t font)
+{
+    static const char *text = "a line far too long to fit into twenty pixels";
+    int chars = display_fit_chars(text, 20, font, NULL);
+    display_clear();
+    return display_draw_text_fit(0, 0, 20, text, font, COLOR_WHITE) - display_measure_chars(text, chars, font);
+}
+
+/**
+ * @brief Reference fit: the whole line if it fits and is the last one,
+ *        else the longest prefix that leaves room for the ellipsis
+ */
+static int ref_fit(const char *str, int max_width, display_font_id_t font, bool *truncated)
+{
+    int len = line_len(str);
+    *truncated = str[len] == '\n' || display_measure_chars(str, len, font) > max_width;
+    if (!*truncated) return len;
+    
+    int ellipsis = ellipsis_width(font);
+    int n = 0;
+    while (n < len && display_measure_chars(str, n + 1, font) + ellipsis <= max_width) n++;
+    return n;
+}
+
+/**
+ * @brief Reference wrap: break at the last space before the first
+ *        character that overflows, or just before it if there is none
+ */
+static int ref_wrap(const char *str, int max_width, display_font_id_t font)
+{
+    int len = line_len(str);
+    int brk = 0;
+    for (int i = 0; i < len; i++) {
+        if (str[i] == ' ') {
+            brk = i;
+        } else if (display_measure_chars(str, i + 1, font) > max_width) {
+            if (brk > 0) return brk;
+            return i > 0 ? i : 1;
+        }
+    }
+    return len;
+}
+
+TEST_CASE("measured widths add up per character and kerning pair", "[display]")
+{
+    char msg[64];
+    
+    test_display_start();
+    
+    /* The fixed font is 6 pixels a character, the proportional ones are not */
+    TEST_ASSERT_EQUAL(6 * 10, display_measure_string("iiiiiiiiii", DISPLAY_FONT_6X8));
+    TEST_ASSERT_EQUAL(6 * 10, display_measure_string("WWWWWWWWWW", DISPLAY_FONT_6X8));
+    for (int font = DISPLAY_FONT_PROP; font < DISPLAY_FONT_COUNT; font++) {
+        TEST_ASSERT_LESS_THAN(display_measure_string("WWWWWWWWWW", font),
+                              display_measure_string("iiiiiiiiii", font));
+    }
+    
+    for (int font = 0; font < DISPLAY_FONT_COUNT; font++) {
+        for (size_t i = 0; i < SAMPLE_COUNT; i++) {
+            const char *str = s_samples[i];
+            int len = line_len(str);
+            
+            /* Each character's own width, plus the kerning of each pair */
+            int width = 0;
+            for (int c = 0; c < len; c++) {
+                width += display_measure_chars(&str[c], 1, font);
+                if (c > 0) {
+                    width += display_measure_chars(&str[c - 1], 2, font) -
+                             display_measure_chars(&str[c - 1], 1, font) -
+                             display_measure_chars(&str[c], 1, font);
+                }
+            }
+            snprintf(msg, sizeof(msg), "font %d sample %u", font, (unsigned)i);
+            TEST_ASSERT_EQUAL_MESSAGE(width, display_measure_string(str, font), msg);
+            TEST_ASSERT_EQUAL_MESSAGE(width, display_measure_chars(str, 1000, font), msg);
+        }
+        
+        /* Nothing before a leading newline */
+        TEST_ASSERT_EQUAL(0, display_measure_string("\nabc", font));
+    }
+}
+
+TEST_CASE("fit and wrap keep what measures within the width", "[display]")
+{
+    char msg[64];
+    
+    test_display_start();
+    
+    for (int font = 0; font < DISPLAY_FONT_COUNT; font++) {
+        for (size_t i = 0; i < SAMPLE_COUNT; i++) {
+            for (int w = 0; w <= DISPLAY_WIDTH; w += 3) {
+                const char *str = s_samples[i];
+                bool truncated, ref_truncated;
+                snprintf(msg, sizeof(msg), "font %d sample %u width %d", font, (unsigned)i, w);
+                
+                int ref = ref_fit(str, w, font, &ref_truncated);
+                TEST_ASSERT_EQUAL_MESSAGE(ref, display_fit_chars(str, w, font, &truncated), msg);
+                TEST_ASSERT_EQUAL_MESSAGE(ref_truncated, truncated, msg);
+                
+                /* Again from the cache */
+                TEST_ASSERT_EQUAL_MESSAGE(ref, display_fit_chars(str, w, font, &truncated), msg);
+                TEST_ASSERT_EQUAL_MESSAGE(ref_truncated, truncated, msg);
+                
+                TEST_ASSERT_EQUAL_MESSAGE(ref_wrap(str, w, font), display_wrap_chars(str, w, font), msg);
+            }
+        }
+    }
+}
+
+TEST_CASE("fit and wrap handle a leading newline and an overlong word", "[display]")
+{
+    bool truncated;
+    
+    test_display_start();
+    
+    for (int font = 0; font < DISPLAY_FONT_COUNT; font++) {
+        /* A leading newline: an empty first line that is cut off */
+        TEST_ASSERT_EQUAL(0, display_fit_chars("\nnext", 100, font, &truncated));
+        TEST_ASSERT_TRUE(truncated);
+        TEST_ASSERT_EQUAL(0, display_wrap_chars("\nnext", 100, font));
+        
+        /* A word wider than the line is broken where it overflows */
+        const char *word = "Incomprehensibilities";
+        int n = display_wrap_chars(word, 40, font);
+        TEST_ASSERT_GREATER_THAN(0, n);
+        TEST_ASSERT_LESS_OR_EQUAL(40, display_measure_chars(word, n, font));
+        TEST_ASSERT_GREATER_THAN(40, display_measure_chars(word, n + 1, font));
+        
+        /* After a short word, the long one moves to the next line */
+        TEST_ASSERT_EQUAL(2, display_wrap_chars("An Incomprehensibilities", 40, font));
+        
+        /* Even when no character fits, wrapping takes one */
+        TEST_ASSERT_EQUAL(1, display_wrap_chars(word, 0, font));
+    }
+}
+
+TEST_CASE("fit cache tells apart strings whose hashes collide", "[display]")
+{
+    /* Same FNV-1a hash, so the same cache slot; different lengths, both fit whole */
+    static const char *a = "ezasqg";
+    static const char *b = "bpvhthqclvpvrhgr";
+    bool truncated;
+    
+    test_display_start();
+    
+    TEST_ASSERT_EQUAL(strlen(a), display_fit_chars(a, DISPLAY_WIDTH, DISPLAY_FONT_6X8, &truncated));
+    TEST_ASSERT_FALSE(truncated);
+    TEST_ASSERT_EQUAL(strlen(b), display_fit_chars(b, DISPLAY_WIDTH, DISPLAY_FONT_6X8, &truncated));
+    TEST_ASSERT_FALSE(truncated);
+    TEST_ASSERT_EQUAL(strlen(a), display_fit_chars(a, DISPLAY_WIDTH, DISPLAY_FONT_6X8, &truncated));
+}
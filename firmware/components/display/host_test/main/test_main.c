@@ -0,0 +1,77 @@
+/**
+ * @file test_main.c
+ * @brief Display host tests - entry point and shared helpers
+ *
+ * Built for the linux target; the display runs on the in-memory host
+ * backend and tests compare what reaches its panel copy.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "unity.h"
+#include "test_display.h"
+
+static bool s_started = false;
+
+void test_display_start(void)
+{
+    if (s_started) return;
+    
+    display_config_t config = { .type = DISPLAY_TYPE_HOST };
+    TEST_ASSERT_EQUAL(ESP_OK, display_init(&config));
+    test_display_sync();
+    s_started = true;
+}
+
+void test_display_restart(bool banded)
+{
+    display_deinit();
+    
+    display_config_t config = { .type = DISPLAY_TYPE_HOST, .host.banded = banded };
+    TEST_ASSERT_EQUAL(ESP_OK, display_init(&config));
+    test_display_sync();
+    s_started = true;
+}
+
+void test_display_sync(void)
+{
+    display_stats_t stats;
+    for (;;) {
+        display_get_stats(&stats);
+        if (stats.done == stats.queued) return;
+        vTaskDelay(1);
+    }
+}
+
+void test_display_capture(uint8_t *out)
+{
+    display_refresh();
+    test_display_sync();
+    memcpy(out, display_host_framebuffer(), TEST_FRAME_SIZE);
+}
+
+uint64_t test_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+uint32_t test_rand(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+void app_main(void)
+{
+    UNITY_BEGIN();
+    unity_run_all_tests();
+    exit(UNITY_END());
+}
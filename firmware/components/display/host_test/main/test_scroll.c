@@ -0,0 +1,146 @@
+/**
+ * @file test_scroll.c
+ * @brief Hardware scroll against redrawing a text view in place
+ *
+ * With display_set_scroll() following a text view's line scroll, the
+ * lines that stay on screen keep their panel RAM rows, so a one-line
+ * step sends the new line and the start line instead of every line that
+ * moved. Both ways have to show the same screen.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "unity.h"
+#include "test_display.h"
+
+#define LINE_HEIGHT         8
+#define VIEW_LINES          (DISPLAY_HEIGHT / LINE_HEIGHT)
+#define TEXT_LINES          40
+#define STEPS               (TEXT_LINES - VIEW_LINES)
+#define HEADER_HEIGHT       10
+
+static char s_lines[TEXT_LINES][22];
+
+static void make_lines(void)
+{
+    uint32_t seed = 0x5C2011;
+    for (int i = 0; i < TEXT_LINES; i++) {
+        int len = 4 + test_rand(&seed) % 17;
+        for (int c = 0; c < len; c++) s_lines[i][c] = 'a' + test_rand(&seed) % 26;
+        s_lines[i][len] = '\0';
+    }
+}
+
+/**
+ * @brief Draw the view scrolled down by `scroll` lines, with or without a fixed header
+ */
+static void draw_view(int scroll, bool header)
+{
+    int top = header ? HEADER_HEIGHT : 0;
+    
+    display_clear();
+    display_push_viewport(0, top, DISPLAY_WIDTH, DISPLAY_HEIGHT - top);
+    for (int i = 0; i < VIEW_LINES; i++) {
+        display_draw_string(0, i * LINE_HEIGHT, s_lines[scroll + i], COLOR_WHITE, 1);
+    }
+    display_pop_clip();
+    if (header) {
+        display_fill_rect(0, 0, DISPLAY_WIDTH, HEADER_HEIGHT, COLOR_BLACK);
+        display_draw_string(2, 1, "Header", COLOR_WHITE, 1);
+        display_draw_hline(0, HEADER_HEIGHT - 1, DISPLAY_WIDTH, COLOR_WHITE);
+    }
+}
+
+/**
+ * @brief The screen as shown: RAM row y + start line appears at row y
+ */
+static void capture_screen(uint8_t *out)
+{
+    const uint8_t *panel = display_host_framebuffer();
+    int start = display_host_start_line();
+    
+    memset(out, 0, TEST_FRAME_SIZE);
+    for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+        int r = (y + start) % DISPLAY_HEIGHT;
+        for (int x = 0; x < DISPLAY_WIDTH; x++) {
+            if (panel[(r >> 3) * DISPLAY_WIDTH + x] & (1 << (r & 7))) {
+                out[(y >> 3) * DISPLAY_WIDTH + x] |= 1 << (y & 7);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Scroll through the view one line at a time
+ *
+ * Records or checks the screen after every step and returns the bytes
+ * sent for the steps (not for the first frame).
+ */
+static uint32_t scroll_through(bool hw, bool header, uint8_t screens[][TEST_FRAME_SIZE], bool check)
+{
+    static uint8_t screen[TEST_FRAME_SIZE];
+    display_stats_t before, after;
+    uint32_t total = 0;
+    char msg[48];
+    
+    for (int s = 0; s <= STEPS; s++) {
+        display_set_scroll(hw ? s * LINE_HEIGHT : 0);
+        draw_view(s, header);
+        test_display_sync();
+        display_get_stats(&before);
+        uint32_t writes = display_host_transactions();
+        display_refresh();
+        test_display_sync();
+        display_get_stats(&after);
+        
+        if (s > 0) {
+            uint32_t bytes = (uint32_t)(after.total_bytes - before.total_bytes);
+            total += bytes;
+            
+            /* Without a header only the new line's page changes, plus the start line */
+            if (hw && !header) {
+                snprintf(msg, sizeof(msg), "step %d", s);
+                TEST_ASSERT_EQUAL_UINT32_MESSAGE(2, display_host_transactions() - writes, msg);
+                TEST_ASSERT_LESS_OR_EQUAL_UINT32_MESSAGE(DISPLAY_WIDTH + 1, bytes, msg);
+            }
+        }
+        
+        if (check) {
+            capture_screen(screen);
+            snprintf(msg, sizeof(msg), "hw %d header %d step %d", hw, header, s);
+            TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(screens[s], screen, TEST_FRAME_SIZE, msg);
+        } else {
+            capture_screen(screens[s]);
+        }
+    }
+    return total;
+}
+
+TEST_CASE("one-line hardware scroll sends less than a redraw and shows the same", "[display]")
+{
+    static uint8_t screens[STEPS + 1][TEST_FRAME_SIZE];
+    
+    test_display_start();
+    make_lines();
+    
+    printf("\nBytes per one-line scroll step (host backend)\n");
+    printf("%-12s %10s %10s\n", "view", "redraw", "hw scroll");
+    for (int header = 0; header < 2; header++) {
+        display_invalidate();
+        uint32_t redraw = scroll_through(false, header, screens, false);
+        display_invalidate();
+        uint32_t hw = scroll_through(true, header, screens, true);
+        printf("%-12s %10lu %10lu\n", header ? "with header" : "text only",
+               (unsigned long)(redraw / STEPS), (unsigned long)(hw / STEPS));
+        TEST_ASSERT_LESS_THAN_UINT32(redraw, hw);
+    }
+    
+    /* Leave the panel unscrolled for the other tests; a blank frame costs
+     * the same at any start line, so only a full resend moves it back */
+    display_set_scroll(0);
+    display_invalidate();
+    display_clear();
+    display_refresh();
+    test_display_sync();
+    TEST_ASSERT_EQUAL(0, display_host_start_line());
+}
@@ -0,0 +1,322 @@
+/**
+ * @file test_shapes.c
+ * @brief Circles, round rects and arcs against golden images
+ *
+ * Each primitive is drawn on a sheet of radii and edge cases, once per
+ * color: WHITE on black, BLACK on white and INVERSE across a half-lit
+ * background. The three frames go top to bottom into one 128x192 PBM
+ * that has to match golden/<primitive>.pbm byte for byte.
+ *
+ * Circles are also drawn with the per-pixel reference and have to match
+ * it, except for INVERSE outlines: the reference plots the octant
+ * boundary pixels twice, which toggles them back off. The outline is
+ * written as runs that never overlap, so an INVERSE circle on black
+ * equals a WHITE one.
+ *
+ * To regenerate the golden images after an intended change, run with
+ * DISPLAY_GOLDEN_DIR pointing at host_test/main/golden and check the
+ * new images by eye before committing them.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "unity.h"
+#include "test_display.h"
+#include "ref_draw.h"
+
+#define SHEET_COLORS        3
+#define PBM_HEADER          "P4\n128 192\n"
+#define PBM_ROW_BYTES       (DISPLAY_WIDTH / 8)
+#define PBM_SIZE            (sizeof(PBM_HEADER) - 1 + PBM_ROW_BYTES * DISPLAY_HEIGHT * SHEET_COLORS)
+
+#define BENCH_CALLS         20000
+#define BENCH_ROUNDS        5
+
+extern const uint8_t _binary_draw_circle_pbm_start[], _binary_draw_circle_pbm_end[];
+extern const uint8_t _binary_fill_circle_pbm_start[], _binary_fill_circle_pbm_end[];
+extern const uint8_t _binary_draw_round_rect_pbm_start[], _binary_draw_round_rect_pbm_end[];
+extern const uint8_t _binary_fill_round_rect_pbm_start[], _binary_fill_round_rect_pbm_end[];
+extern const uint8_t _binary_draw_arc_pbm_start[], _binary_draw_arc_pbm_end[];
+extern const uint8_t _binary_fill_arc_pbm_start[], _binary_fill_arc_pbm_end[];
+
+static const display_color_t s_sheet_colors[SHEET_COLORS] = {
+    COLOR_WHITE, COLOR_BLACK, COLOR_INVERSE,
+};
+
+/* Reference frame the ref_* circle wrappers draw into */
+static uint8_t s_ref[TEST_FRAME_SIZE];
+
+typedef void (*circle_fn_t)(int cx, int cy, int r, display_color_t color);
+typedef void (*round_rect_fn_t)(int x, int y, int w, int h, int r, display_color_t color);
+typedef void (*arc_fn_t)(int cx, int cy, int r, uint8_t quadrants, display_color_t color);
+
+static void ref_draw_circle_fn(int cx, int cy, int r, display_color_t color)
+{
+    ref_draw_circle(s_ref, cx, cy, r, color);
+}
+
+static void ref_fill_circle_fn(int cx, int cy, int r, display_color_t color)
+{
+    ref_fill_circle(s_ref, cx, cy, r, color);
+}
+
+/* ============================================================================
+ * Sheets
+ * ============================================================================ */
+
+/**
+ * @brief Background a color shows up on, on the display and the reference
+ */
+static void draw_background(display_color_t color)
+{
+    display_clear();
+    memset(s_ref, 0, sizeof(s_ref));
+    
+    int w = color == COLOR_BLACK ? DISPLAY_WIDTH : color == COLOR_INVERSE ? DISPLAY_WIDTH / 2 : 0;
+    display_fill_rect(0, 0, w, DISPLAY_HEIGHT, COLOR_WHITE);
+    ref_fill_rect(s_ref, 0, 0, w, DISPLAY_HEIGHT, COLOR_WHITE);
+}
+
+/* Radii 0-11 in a row, then larger ones running off the bottom and right */
+static void circle_sheet(circle_fn_t fn, display_color_t color)
+{
+    static const int radii[] = { 0, 1, 2, 3, 4, 5, 6, 7, 9, 11 };
+    int x = 1;
+    for (size_t i = 0; i < sizeof(radii) / sizeof(radii[0]); i++) {
+        fn(x + radii[i], 12, radii[i], color);
+        x += 2 * radii[i] + 3;
+    }
+    
+    fn(20, 44, 14, color);
+    fn(60, 44, 19, color);
+    fn(110, 50, 25, color);
+    fn(1, 58, 5, color);
+}
+
+/* Radius 0 up to and past half the short side, thin and clipped rects */
+static void round_rect_sheet(round_rect_fn_t fn, display_color_t color)
+{
+    int x = 1;
+    for (int r = 0; r <= 6; r++) {
+        fn(x, 1, 2 * r + 6, 2 * r + 4, r, color);
+        x += 2 * r + 8;
+    }
+    
+    fn(1, 22, 30, 10, 9, color);        /* Radius clamped to 5 */
+    fn(34, 22, 1, 12, 3, color);
+    fn(38, 22, 2, 12, 3, color);
+    fn(43, 22, 12, 2, 3, color);
+    fn(43, 27, 12, 3, 3, color);
+    fn(58, 22, 0, 10, 3, color);
+    fn(60, 22, 40, 24, 8, color);
+    fn(-6, 36, 30, 20, 6, color);
+    fn(104, 40, 40, 40, 12, color);
+}
+
+/* Every quadrant set at one radius, then the small and large cases */
+static void arc_sheet(arc_fn_t fn, display_color_t color)
+{
+    for (uint8_t q = 1; q <= DISPLAY_QUAD_ALL; q++) {
+        int i = q - 1;
+        fn(8 + (i % 8) * 15, 8 + (i / 8) * 15, 6, q, color);
+    }
+    
+    fn(8, 40, 0, DISPLAY_QUAD_ALL, color);
+    fn(14, 40, 0, 0, color);
+    fn(20, 40, 1, DISPLAY_QUAD_TOP_RIGHT | DISPLAY_QUAD_BOTTOM_LEFT, color);
+    fn(28, 40, 2, DISPLAY_QUAD_ALL, color);
+    fn(38, 40, 3, DISPLAY_QUAD_TOP_LEFT, color);
+    fn(64, 52, 18, DISPLAY_QUAD_TOP_LEFT | DISPLAY_QUAD_TOP_RIGHT, color);
+    fn(122, 58, 20, DISPLAY_QUAD_ALL, color);
+}
+
+/* ============================================================================
+ * Golden Images
+ * ============================================================================ */
+
+/**
+ * @brief Append a page-format frame to a PBM as 64 rows, lit pixels as ink
+ */
+static void frame_to_pbm(const uint8_t *frame, uint8_t *rows)
+{
+    memset(rows, 0, PBM_ROW_BYTES * DISPLAY_HEIGHT);
+    for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+        const uint8_t *page = &frame[(y >> 3) * DISPLAY_WIDTH];
+        uint8_t bit = 1 << (y & 7);
+        for (int x = 0; x < DISPLAY_WIDTH; x++) {
+            if (page[x] & bit) rows[y * PBM_ROW_BYTES + (x >> 3)] |= 0x80 >> (x & 7);
+        }
+    }
+}
+
+/**
+ * @brief Compare a sheet image with its golden image, or write it
+ */
+static void check_golden(const char *name, const uint8_t *pbm,
+                         const uint8_t *golden, const uint8_t *golden_end)
+{
+    const char *dir = getenv("DISPLAY_GOLDEN_DIR");
+    if (dir) {
+        char path[256];
+        snprintf(path, sizeof(path), "%s/%s.pbm", dir, name);
+        FILE *f = fopen(path, "wb");
+        TEST_ASSERT_NOT_NULL(f);
+        fwrite(pbm, 1, PBM_SIZE, f);
+        fclose(f);
+        printf("Wrote %s\n", path);
+        return;
+    }
+    
+    TEST_ASSERT_EQUAL_MESSAGE(PBM_SIZE, golden_end - golden, name);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(golden, pbm, PBM_SIZE, name);
+}
+
+/* A primitive and the sheet that exercises it */
+typedef struct {
+    circle_fn_t circle;
+    round_rect_fn_t round_rect;
+    arc_fn_t arc;
+} sheet_t;
+
+/**
+ * @brief Draw a primitive's sheet in every color through the display
+ */
+static void render_sheet(const sheet_t *sheet, uint8_t *pbm)
+{
+    static uint8_t frame[TEST_FRAME_SIZE];
+    
+    memcpy(pbm, PBM_HEADER, sizeof(PBM_HEADER) - 1);
+    uint8_t *rows = pbm + sizeof(PBM_HEADER) - 1;
+    
+    for (int i = 0; i < SHEET_COLORS; i++) {
+        display_color_t color = s_sheet_colors[i];
+        draw_background(color);
+        if (sheet->circle) circle_sheet(sheet->circle, color);
+        if (sheet->round_rect) round_rect_sheet(sheet->round_rect, color);
+        if (sheet->arc) arc_sheet(sheet->arc, color);
+        test_display_capture(frame);
+        frame_to_pbm(frame, rows + i * PBM_ROW_BYTES * DISPLAY_HEIGHT);
+    }
+}
+
+TEST_CASE("circles match golden images and the per-pixel reference", "[display]")
+{
+    static uint8_t pbm[PBM_SIZE];
+    static uint8_t frame[TEST_FRAME_SIZE];
+    char msg[64];
+    
+    test_display_start();
+    
+    render_sheet(&(sheet_t){ .circle = display_fill_circle }, pbm);
+    check_golden("fill_circle", pbm, _binary_fill_circle_pbm_start, _binary_fill_circle_pbm_end);
+    render_sheet(&(sheet_t){ .circle = display_draw_circle }, pbm);
+    check_golden("draw_circle", pbm, _binary_draw_circle_pbm_start, _binary_draw_circle_pbm_end);
+    
+    for (int i = 0; i < SHEET_COLORS; i++) {
+        display_color_t color = s_sheet_colors[i];
+        
+        draw_background(color);
+        circle_sheet(display_fill_circle, color);
+        circle_sheet(ref_fill_circle_fn, color);
+        test_display_capture(frame);
+        snprintf(msg, sizeof(msg), "fill_circle color %d", color);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(s_ref, frame, TEST_FRAME_SIZE, msg);
+        
+        if (color == COLOR_INVERSE) continue;
+        draw_background(color);
+        circle_sheet(display_draw_circle, color);
+        circle_sheet(ref_draw_circle_fn, color);
+        test_display_capture(frame);
+        snprintf(msg, sizeof(msg), "draw_circle color %d", color);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(s_ref, frame, TEST_FRAME_SIZE, msg);
+    }
+    
+    /* INVERSE outlines plot every pixel exactly once */
+    draw_background(COLOR_WHITE);
+    circle_sheet(display_draw_circle, COLOR_INVERSE);
+    circle_sheet(ref_draw_circle_fn, COLOR_WHITE);
+    test_display_capture(frame);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(s_ref, frame, TEST_FRAME_SIZE);
+}
+
+TEST_CASE("round rects match golden images", "[display]")
+{
+    static uint8_t pbm[PBM_SIZE];
+    
+    test_display_start();
+    
+    render_sheet(&(sheet_t){ .round_rect = display_draw_round_rect }, pbm);
+    check_golden("draw_round_rect", pbm,
+                 _binary_draw_round_rect_pbm_start, _binary_draw_round_rect_pbm_end);
+    render_sheet(&(sheet_t){ .round_rect = display_fill_round_rect }, pbm);
+    check_golden("fill_round_rect", pbm,
+                 _binary_fill_round_rect_pbm_start, _binary_fill_round_rect_pbm_end);
+}
+
+TEST_CASE("arcs match golden images", "[display]")
+{
+    static uint8_t pbm[PBM_SIZE];
+    
+    test_display_start();
+    
+    render_sheet(&(sheet_t){ .arc = display_draw_arc }, pbm);
+    check_golden("draw_arc", pbm, _binary_draw_arc_pbm_start, _binary_draw_arc_pbm_end);
+    render_sheet(&(sheet_t){ .arc = display_fill_arc }, pbm);
+    check_golden("fill_arc", pbm, _binary_fill_arc_pbm_start, _binary_fill_arc_pbm_end);
+}
+
+/* ============================================================================
+ * Benchmark
+ * ============================================================================ */
+
+static uint64_t time_circles(circle_fn_t fn, int r, display_color_t color)
+{
+    uint32_t seed = 0x1234567;
+    uint64_t t0 = test_now_ns();
+    for (int i = 0; i < BENCH_CALLS; i++) {
+        int cx = (int)(test_rand(&seed) % DISPLAY_WIDTH);
+        int cy = (int)(test_rand(&seed) % DISPLAY_HEIGHT);
+        fn(cx, cy, r, color);
+    }
+    return test_now_ns() - t0;
+}
+
+/**
+ * @brief Time a primitive against its reference and print the row
+ *
+ * Rounds alternate between the two and each keeps its fastest, so a
+ * round that lost the CPU counts against neither.
+ */
+static void bench_circles(const char *name, circle_fn_t fn, circle_fn_t ref, int r, display_color_t color)
+{
+    static uint8_t frame[TEST_FRAME_SIZE];
+    uint64_t best_new = UINT64_MAX, best_old = UINT64_MAX;
+    
+    draw_background(COLOR_WHITE);
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        uint64_t t = time_circles(fn, r, color);
+        if (t < best_new) best_new = t;
+        t = time_circles(ref, r, color);
+        if (t < best_old) best_old = t;
+    }
+    double new_ns = (double)best_new / BENCH_CALLS;
+    double old_ns = (double)best_old / BENCH_CALLS;
+    printf("%-12s %6d %10.1f %10.1f %7.1fx\n", name, r, new_ns, old_ns, old_ns / new_ns);
+    
+    test_display_capture(frame);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(s_ref, frame, TEST_FRAME_SIZE);
+}
+
+TEST_CASE("circle benchmark", "[display][bench]")
+{
+    static const int radii[] = { 2, 4, 8, 16, 31 };
+    
+    test_display_start();
+    
+    printf("%-12s %6s %10s %10s %8s\n", "primitive", "radius", "new ns", "old ns", "speedup");
+    for (size_t i = 0; i < sizeof(radii) / sizeof(radii[0]); i++) {
+        bench_circles("fill_circle", display_fill_circle, ref_fill_circle_fn, radii[i], COLOR_INVERSE);
+        bench_circles("draw_circle", display_draw_circle, ref_draw_circle_fn, radii[i], COLOR_WHITE);
+    }
+}
@@ -0,0 +1,153 @@
+/**
+ * @file test_spans.c
+ * @brief Span fast paths against the per-pixel reference
+ *
+ * fill_rect, hline, vline and rect are drawn through the display API and
+ * through ref_draw.c on the same background, in every color, and the
+ * frames have to match. The benchmark times both paths on the same shapes.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "unity.h"
+#include "test_display.h"
+#include "ref_draw.h"
+
+#define SPAN_FRAMES         100         /* Frames compared per primitive and color */
+#define SPAN_OPS            8           /* Shapes per frame */
+#define SPAN_BENCH_OPS      20000
+
+typedef enum {
+    SPAN_FILL_RECT,
+    SPAN_HLINE,
+    SPAN_VLINE,
+    SPAN_RECT,
+    SPAN_KIND_COUNT
+} span_kind_t;
+
+static const char *const s_kind_names[SPAN_KIND_COUNT] = {
+    "fill_rect", "hline", "vline", "rect",
+};
+
+static const char *const s_color_names[] = { "BLACK", "WHITE", "INVERSE" };
+
+/* A shape, partly off-screen or empty now and then */
+typedef struct {
+    int x, y, w, h;
+} span_shape_t;
+
+static void next_shape(uint32_t *seed, span_shape_t *s)
+{
+    s->x = (int)(test_rand(seed) % (DISPLAY_WIDTH + 32)) - 16;
+    s->y = (int)(test_rand(seed) % (DISPLAY_HEIGHT + 32)) - 16;
+    s->w = (int)(test_rand(seed) % 102) - 2;
+    s->h = (int)(test_rand(seed) % 70) - 2;
+}
+
+static void draw_api(span_kind_t kind, const span_shape_t *s, display_color_t color)
+{
+    switch (kind) {
+        case SPAN_FILL_RECT: display_fill_rect(s->x, s->y, s->w, s->h, color); break;
+        case SPAN_HLINE: display_draw_hline(s->x, s->y, s->w, color); break;
+        case SPAN_VLINE: display_draw_vline(s->x, s->y, s->h, color); break;
+        case SPAN_RECT: display_draw_rect(s->x, s->y, s->w, s->h, color); break;
+        default: break;
+    }
+}
+
+static void draw_ref(uint8_t *frame, span_kind_t kind, const span_shape_t *s, display_color_t color)
+{
+    switch (kind) {
+        case SPAN_FILL_RECT: ref_fill_rect(frame, s->x, s->y, s->w, s->h, color); break;
+        case SPAN_HLINE: ref_draw_hline(frame, s->x, s->y, s->w, color); break;
+        case SPAN_VLINE: ref_draw_vline(frame, s->x, s->y, s->h, color); break;
+        case SPAN_RECT: ref_draw_rect(frame, s->x, s->y, s->w, s->h, color); break;
+        default: break;
+    }
+}
+
+/**
+ * @brief Same noise on the display and the reference frame
+ */
+static void draw_noise(uint8_t *ref, uint32_t seed)
+{
+    display_clear();
+    memset(ref, 0, TEST_FRAME_SIZE);
+    for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+        for (int x = 0; x < DISPLAY_WIDTH; x++) {
+            if (test_rand(&seed) & 1) {
+                display_draw_pixel(x, y, COLOR_WHITE);
+                ref_draw_pixel(ref, x, y, COLOR_WHITE);
+            }
+        }
+    }
+}
+
+TEST_CASE("span fills match the per-pixel reference", "[display]")
+{
+    static uint8_t ref[TEST_FRAME_SIZE];
+    static uint8_t out[TEST_FRAME_SIZE];
+    char msg[64];
+    
+    test_display_start();
+    uint32_t seed = 0x2545F491;
+    
+    for (int kind = 0; kind < SPAN_KIND_COUNT; kind++) {
+        for (int color = COLOR_BLACK; color <= COLOR_INVERSE; color++) {
+            for (int frame = 0; frame < SPAN_FRAMES; frame++) {
+                draw_noise(ref, test_rand(&seed));
+                for (int i = 0; i < SPAN_OPS; i++) {
+                    span_shape_t s;
+                    next_shape(&seed, &s);
+                    draw_api(kind, &s, color);
+                    draw_ref(ref, kind, &s, color);
+                }
+                
+                test_display_capture(out);
+                snprintf(msg, sizeof(msg), "%s %s frame %d",
+                         s_kind_names[kind], s_color_names[color], frame);
+                TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(ref, out, TEST_FRAME_SIZE, msg);
+            }
+        }
+    }
+}
+
+TEST_CASE("span fills benchmark", "[display][bench]")
+{
+    static span_shape_t shapes[SPAN_BENCH_OPS];
+    static uint8_t ref[TEST_FRAME_SIZE];
+    static uint8_t out[TEST_FRAME_SIZE];
+    
+    test_display_start();
+    uint32_t seed = 0x9E3779B9;
+    for (int i = 0; i < SPAN_BENCH_OPS; i++) {
+        next_shape(&seed, &shapes[i]);
+    }
+    
+    printf("%-10s %-8s %10s %10s %8s\n", "primitive", "color", "span ns", "pixel ns", "speedup");
+    for (int kind = 0; kind < SPAN_KIND_COUNT; kind++) {
+        for (int color = COLOR_BLACK; color <= COLOR_INVERSE; color++) {
+            display_clear();
+            uint64_t t0 = test_now_ns();
+            for (int i = 0; i < SPAN_BENCH_OPS; i++) {
+                draw_api(kind, &shapes[i], color);
+            }
+            uint64_t t1 = test_now_ns();
+            
+            memset(ref, 0, sizeof(ref));
+            for (int i = 0; i < SPAN_BENCH_OPS; i++) {
+                draw_ref(ref, kind, &shapes[i], color);
+            }
+            uint64_t t2 = test_now_ns();
+            
+            double span_ns = (double)(t1 - t0) / SPAN_BENCH_OPS;
+            double pixel_ns = (double)(t2 - t1) / SPAN_BENCH_OPS;
+            printf("%-10s %-8s %10.1f %10.1f %7.1fx\n", s_kind_names[kind], s_color_names[color],
+                   span_ns, pixel_ns, pixel_ns / span_ns);
+            
+            /* Both paths drew the same shapes, so they end on the same frame */
+            test_display_capture(out);
+            TEST_ASSERT_EQUAL_HEX8_ARRAY(ref, out, TEST_FRAME_SIZE);
+        }
+    }
+}
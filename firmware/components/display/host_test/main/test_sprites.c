@@ -0,0 +1,94 @@
+/**
+ * @file test_sprites.c
+ * @brief Page-native sprites against the same image as a bitmap
+ *
+ * display_draw_sprite() merges whole column bytes, shifted across two
+ * pages when y is off the page grid, while display_draw_bitmap() fills
+ * its set runs row by row. Given the same image they have to leave the
+ * same frame at every page offset, past every screen edge and inside a
+ * clip rect, in all three colors.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "unity.h"
+#include "test_display.h"
+
+#define IMAGE_W             13
+#define IMAGE_H             11
+#define IMAGE_PAGES         ((IMAGE_H + 7) / 8)
+#define BITMAP_ROW_BYTES    ((IMAGE_W + 7) / 8)
+
+/**
+ * @brief A random image in both layouts; sprite rows past IMAGE_H stay zero
+ */
+static void make_image(uint32_t *seed, uint8_t *bitmap, uint8_t *sprite)
+{
+    memset(bitmap, 0, IMAGE_H * BITMAP_ROW_BYTES);
+    memset(sprite, 0, IMAGE_PAGES * IMAGE_W);
+    for (int y = 0; y < IMAGE_H; y++) {
+        for (int x = 0; x < IMAGE_W; x++) {
+            if (test_rand(seed) & 1) {
+                bitmap[y * BITMAP_ROW_BYTES + (x >> 3)] |= 0x80 >> (x & 7);
+                sprite[(y >> 3) * IMAGE_W + x] |= 1 << (y & 7);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Half-lit background, so BLACK and INVERSE show on both halves
+ */
+static void draw_background(void)
+{
+    display_clear();
+    display_fill_rect(0, 0, DISPLAY_WIDTH / 2, DISPLAY_HEIGHT, COLOR_WHITE);
+}
+
+TEST_CASE("sprites match the same image drawn as a bitmap", "[display]")
+{
+    static uint8_t by_bitmap[TEST_FRAME_SIZE];
+    static uint8_t by_sprite[TEST_FRAME_SIZE];
+    uint8_t bitmap[IMAGE_H * BITMAP_ROW_BYTES];
+    uint8_t data[IMAGE_PAGES * IMAGE_W];
+    display_sprite_t sprite = { .width = IMAGE_W, .height = IMAGE_H, .data = data };
+    uint32_t seed = 0xC0FFEE;
+    char msg[48];
+    
+    /* Every page offset, then every edge and corner; the last ones fall off entirely */
+    static const int spots[][2] = {
+        { 40, 0 }, { 40, 1 }, { 40, 2 }, { 40, 3 }, { 40, 4 }, { 40, 5 }, { 40, 6 }, { 40, 7 },
+        { 57, 29 }, { -5, 20 }, { DISPLAY_WIDTH - 6, 20 }, { 30, -7 }, { 30, -3 },
+        { 30, DISPLAY_HEIGHT - 4 }, { -9, -9 }, { DISPLAY_WIDTH - 2, DISPLAY_HEIGHT - 1 },
+        { -IMAGE_W, 10 }, { 10, DISPLAY_HEIGHT },
+    };
+    static const display_color_t colors[] = { COLOR_WHITE, COLOR_BLACK, COLOR_INVERSE };
+    
+    test_display_start();
+    
+    for (int clip = 0; clip < 2; clip++) {
+        for (size_t i = 0; i < sizeof(spots) / sizeof(spots[0]); i++) {
+            for (size_t c = 0; c < sizeof(colors) / sizeof(colors[0]); c++) {
+                int x = spots[i][0];
+                int y = spots[i][1];
+                make_image(&seed, bitmap, data);
+                
+                /* The second pass also cuts through the images with a clip rect off the page grid */
+                draw_background();
+                if (clip) display_push_clip(3, 5, 80, 30);
+                display_draw_bitmap(x, y, bitmap, IMAGE_W, IMAGE_H, colors[c]);
+                if (clip) display_pop_clip();
+                test_display_capture(by_bitmap);
+                
+                draw_background();
+                if (clip) display_push_clip(3, 5, 80, 30);
+                display_draw_sprite(x, y, &sprite, colors[c]);
+                if (clip) display_pop_clip();
+                test_display_capture(by_sprite);
+                
+                snprintf(msg, sizeof(msg), "at (%d, %d) color %d clip %d", x, y, colors[c], clip);
+                TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(by_bitmap, by_sprite, TEST_FRAME_SIZE, msg);
+            }
+        }
+    }
+}
@@ -0,0 +1,101 @@
+/**
+ * @file test_surfaces.c
+ * @brief Nested surfaces composite like drawing straight to the screen
+ *
+ * The UI caches its scene in a surface while apps cache parts of their
+ * picture in surfaces of their own, drawn inside it. A frame blitted from
+ * the nested surfaces has to match the same content drawn directly, with
+ * the inner surface's area cleared and clipped as a blit would leave it.
+ */
+
+#include <string.h>
+#include "unity.h"
+#include "test_display.h"
+
+/* Inner surface, placed off the page grid so its blit is shifted */
+#define INNER_X             21
+#define INNER_Y             13
+#define INNER_W             70
+#define INNER_H             30
+
+/**
+ * @brief Content under and around the inner surface
+ */
+static void draw_outer(void)
+{
+    display_fill_rect(0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT / 2, COLOR_WHITE);
+    display_fill_circle(100, 40, 20, COLOR_INVERSE);
+    display_draw_string(2, 50, "outer", COLOR_INVERSE, 1);
+}
+
+/**
+ * @brief Content of the inner surface at (dx, dy); parts of it fall outside
+ */
+static void draw_inner(int dx, int dy)
+{
+    display_draw_round_rect(dx, dy, INNER_W, INNER_H, 6, COLOR_WHITE);
+    display_fill_circle(dx + INNER_W - 4, dy + 10, 12, COLOR_WHITE);
+    display_draw_string(dx + 4, dy + 4, "inner", COLOR_WHITE, 1);
+    display_fill_rect(dx + 10, dy + 14, 30, 12, COLOR_INVERSE);
+}
+
+/**
+ * @brief Drawn last, over both
+ */
+static void draw_top(void)
+{
+    display_draw_line(0, DISPLAY_HEIGHT - 1, DISPLAY_WIDTH - 1, 0, COLOR_INVERSE);
+}
+
+TEST_CASE("nested surfaces match drawing directly", "[display]")
+{
+    static uint8_t direct[TEST_FRAME_SIZE];
+    static uint8_t nested[TEST_FRAME_SIZE];
+    display_surface_t outer = {0};
+    display_surface_t inner = {0};
+    display_surface_t third = {0};
+    
+    test_display_start();
+    
+    display_clear();
+    draw_outer();
+    display_fill_rect(INNER_X, INNER_Y, INNER_W, INNER_H, COLOR_BLACK);
+    display_push_clip(INNER_X, INNER_Y, INNER_W, INNER_H);
+    draw_inner(INNER_X, INNER_Y);
+    display_pop_clip();
+    draw_top();
+    test_display_capture(direct);
+    
+    TEST_ASSERT_EQUAL(ESP_OK, display_surface_create(&outer, DISPLAY_WIDTH, DISPLAY_HEIGHT));
+    TEST_ASSERT_EQUAL(ESP_OK, display_surface_create(&inner, INNER_W, INNER_H));
+    TEST_ASSERT_EQUAL(ESP_OK, display_surface_create(&third, 8, 8));
+    
+    TEST_ASSERT_EQUAL(ESP_OK, display_surface_begin(&outer));
+    draw_outer();
+    TEST_ASSERT_EQUAL(ESP_OK, display_surface_begin(&inner));
+    
+    /* Nesting is limited, and a surface cannot be drawn into itself */
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, display_surface_begin(&third));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, display_surface_begin(&inner));
+    
+    draw_inner(0, 0);
+    display_surface_end();
+    display_blit_surface(INNER_X, INNER_Y, &inner);
+    draw_top();
+    display_surface_end();
+    
+    display_clear();
+    display_blit_surface(0, 0, &outer);
+    test_display_capture(nested);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(direct, nested, TEST_FRAME_SIZE);
+    
+    /* Drawing goes back to the screen after the outermost end */
+    display_clear();
+    display_draw_pixel(5, 5, COLOR_WHITE);
+    test_display_capture(nested);
+    TEST_ASSERT_EQUAL_HEX8(0x20, nested[5]);
+    
+    display_surface_destroy(&third);
+    display_surface_destroy(&inner);
+    display_surface_destroy(&outer);
+}
@@ -0,0 +1,87 @@
+/**
+ * @file test_text.c
+ * @brief Text drawing against glyphs blown up pixel by pixel
+ *
+ * Scaled 6x8 characters come from a small cache of vertically expanded
+ * columns, one slot per character and size. Every size of a character has
+ * to look like its size 1 glyph with each pixel drawn as a size x size
+ * block, however the sizes and characters share the slots.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "unity.h"
+#include "test_display.h"
+#include "ref_draw.h"
+
+#define GLYPH_W             6
+#define GLYPH_H             8
+
+/**
+ * @brief Pixels of a character at size 1, as drawn by the display
+ */
+static void glyph_pixels(char c, bool lit[GLYPH_W][GLYPH_H])
+{
+    static uint8_t frame[TEST_FRAME_SIZE];
+    
+    display_clear();
+    display_draw_char(0, 0, c, COLOR_WHITE, 1);
+    test_display_capture(frame);
+    for (int x = 0; x < GLYPH_W; x++) {
+        for (int y = 0; y < GLYPH_H; y++) {
+            lit[x][y] = frame[x] & (1 << y);
+        }
+    }
+}
+
+/**
+ * @brief Reference for a scaled character: one block per pixel of the size 1 glyph
+ */
+static void ref_scaled_char(uint8_t *frame, int x, int y, char c, int size, display_color_t color)
+{
+    bool lit[GLYPH_W][GLYPH_H];
+    glyph_pixels(c, lit);
+    for (int gx = 0; gx < GLYPH_W; gx++) {
+        for (int gy = 0; gy < GLYPH_H; gy++) {
+            if (lit[gx][gy]) ref_fill_rect(frame, x + gx * size, y + gy * size, size, size, color);
+        }
+    }
+}
+
+TEST_CASE("scaled characters match the size 1 glyph blown up", "[display]")
+{
+    static uint8_t ref[TEST_FRAME_SIZE];
+    static uint8_t out[TEST_FRAME_SIZE];
+    char msg[48];
+    
+    /* A character at two sizes, then another whose slot one of them shares */
+    static const struct {
+        char c;
+        uint8_t size;
+    } runs[][3] = {
+        { { 'A', 2 }, { 'A', 3 }, { 'H', 2 } },     /* 'A' + 3 * 7 and 'H' + 2 * 7 share a slot */
+        { { 'g', 3 }, { 'g', 4 }, { 'n', 3 } },
+        { { '@', 4 }, { '@', 2 }, { '2', 4 } },
+        { { '~', 2 }, { '~', 4 }, { '~', 3 } },
+    };
+    
+    test_display_start();
+    
+    for (size_t i = 0; i < sizeof(runs) / sizeof(runs[0]); i++) {
+        memset(ref, 0, sizeof(ref));
+        for (int j = 0; j < 3; j++) {
+            ref_scaled_char(ref, 2 + j * 40, 3 + j * 5, runs[i][j].c, runs[i][j].size, COLOR_WHITE);
+        }
+        
+        /* Each run twice, so the second pass draws from whatever the first left cached */
+        for (int pass = 0; pass < 2; pass++) {
+            display_clear();
+            for (int j = 0; j < 3; j++) {
+                display_draw_char(2 + j * 40, 3 + j * 5, runs[i][j].c, COLOR_WHITE, runs[i][j].size);
+            }
+            test_display_capture(out);
+            snprintf(msg, sizeof(msg), "run %u pass %d", (unsigned)i, pass);
+            TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(ref, out, TEST_FRAME_SIZE, msg);
+        }
+    }
+}
@@ -5,6 +5,7 @@
  * Supports multiple display backends:
  * - I2C SSD1306 128x64 (for testing)
  * - SPI Transparent OLED 128x64 (production)
+ * - In-memory framebuffer (host builds and benchmarks)
  */
 
 #pragma once
@@ -23,12 +24,33 @@ extern "C" {
 #define DISPLAY_WIDTH       128
 #define DISPLAY_HEIGHT      64
 
+/**
+ * @brief Maximum nesting of display_push_clip() / display_push_viewport()
+ */
+#define DISPLAY_CLIP_STACK_DEPTH    8
+
+/**
+ * @brief Maximum nesting of display_surface_begin()
+ */
+#define DISPLAY_SURFACE_DEPTH       2
+
+/**
+ * @brief Band height in 8-row pages for banded panels
+ *
+ * Banded panels render through two band buffers of
+ * DISPLAY_WIDTH * DISPLAY_BAND_PAGES bytes instead of full frames.
+ */
+#ifndef DISPLAY_BAND_PAGES
+#define DISPLAY_BAND_PAGES          2
+#endif
+
 /**
  * @brief Display type selection
  */
 typedef enum {
     DISPLAY_TYPE_SSD1306_I2C,       ///< I2C SSD1306 (test OLED)
     DISPLAY_TYPE_TRANSPARENT_SPI,   ///< SPI Transparent OLED (production)
+    DISPLAY_TYPE_HOST,              ///< In-memory framebuffer, no hardware
 } display_type_t;
 
 /**
@@ -41,7 +63,7 @@ typedef struct {
 } display_i2c_config_t;
 
 /**
- * @brief SPI display configuration (for future transparent OLED)
+ * @brief SPI display configuration (SSD1309-class transparent OLED, banded)
  */
 typedef struct {
     int mosi_pin;
@@ -51,6 +73,15 @@ typedef struct {
     int rst_pin;
 } display_spi_config_t;
 
+/**
+ * @brief Host framebuffer configuration
+ */
+typedef struct {
+    const char *dump_dir;   ///< Write each flushed frame here as frame_NNNNNN.pbm (NULL = off)
+    uint32_t dump_every;    ///< Only dump every Nth flushed frame (0 = every frame)
+    bool banded;            ///< Render in bands like the SPI panel instead of full frames
+} display_host_config_t;
+
 /**
  * @brief Display configuration
  */
@@ -59,6 +90,7 @@ typedef struct {
     union {
         display_i2c_config_t i2c;
         display_spi_config_t spi;
+        display_host_config_t host;
     };
     bool flip_horizontal;
     bool flip_vertical;
@@ -73,6 +105,93 @@ typedef enum {
     COLOR_INVERSE = 2
 } display_color_t;
 
+/**
+ * @brief Page-native sprite
+ *
+ * Same layout as the framebuffer: ceil(height / 8) pages of `width` column
+ * bytes, bit 0 = top row of the page. Rows past `height` must be zero.
+ */
+typedef struct {
+    uint8_t width;
+    uint8_t height;
+    const uint8_t *data;
+} display_sprite_t;
+
+/**
+ * @brief Off-screen surface
+ *
+ * Same layout as the framebuffer and sprites, at most the screen's size.
+ * Drawing calls made between display_surface_begin() and _end() land in
+ * the surface, which display_blit_surface() then copies to the screen.
+ */
+typedef struct {
+    uint8_t width;
+    uint8_t height;
+    bool valid;                     ///< Drawn and not invalidated since
+    uint8_t *data;
+} display_surface_t;
+
+/**
+ * @brief Fonts for the display_*_text() calls
+ *
+ * Generated at build time from the glyph sources in the component's fonts/
+ * directory. The proportional fonts trim each glyph to its ink and kern
+ * letter pairs; on running text PROP fits about a fifth more on a line than
+ * 6x8, SMALL about two thirds more.
+ */
+typedef enum {
+    DISPLAY_FONT_6X8 = 0,           ///< Fixed 6x8, the font of display_draw_string()
+    DISPLAY_FONT_PROP,              ///< Proportional, 8 rows, 9-row line
+    DISPLAY_FONT_BOLD,              ///< Bold proportional, 8 rows, 9-row line
+    DISPLAY_FONT_SMALL,             ///< Proportional, 5-row capitals, 7-row line
+    DISPLAY_FONT_COUNT
+} display_font_id_t;
+
+/**
+ * @brief Glyph store counters
+ */
+typedef struct {
+    uint32_t glyphs;                ///< Glyphs in the attached store, 0 if none
+    uint32_t lookups;               ///< Codepoints looked up
+    uint32_t cache_hits;            ///< Lookups answered from the DRAM LRU
+    uint32_t not_found;             ///< Lookups the store had no glyph for
+} display_glyph_stats_t;
+
+/**
+ * @brief Surface counters
+ */
+typedef struct {
+    uint32_t live;                  ///< Surfaces allocated now
+    uint32_t bytes;                 ///< Bytes held by them
+    uint32_t peak_bytes;            ///< Most bytes held at once
+    uint32_t renders;               ///< Times a surface was drawn
+    uint32_t blits;                 ///< Times a surface was copied out
+} display_surface_stats_t;
+
+/**
+ * @brief Transfer statistics
+ */
+typedef struct {
+    uint32_t frames;                ///< Number of refreshes that reached the panel
+    uint32_t skipped_frames;        ///< Refreshes where nothing had changed
+    uint32_t last_frame_bytes;      ///< Bytes sent by the most recent refresh (commands + data)
+    uint64_t total_bytes;           ///< Bytes sent since init
+    uint32_t last_flush_us;         ///< Duration of the most recent flush
+    uint32_t last_wait_us;          ///< Time drawing waited for the previous flush (or band DMA)
+    uint32_t queued;                ///< Refreshes handed over, including skipped and failed ones
+    uint32_t done;                  ///< Of those, refreshes that have finished
+    uint32_t last_done_us;          ///< esp_timer time (low 32 bits) the most recent one finished
+} display_stats_t;
+
+/**
+ * @brief Quadrant flags for arcs
+ */
+#define DISPLAY_QUAD_TOP_RIGHT      0x01
+#define DISPLAY_QUAD_BOTTOM_RIGHT   0x02
+#define DISPLAY_QUAD_BOTTOM_LEFT    0x04
+#define DISPLAY_QUAD_TOP_LEFT       0x08
+#define DISPLAY_QUAD_ALL            0x0F
+
 /**
  * @brief Initialize display
  * @param config Display configuration
@@ -85,6 +204,14 @@ esp_err_t display_init(const display_config_t *config);
  */
 void display_deinit(void);
 
+/**
+ * @brief Whether the panel is drawn in bands
+ *
+ * Banded panels have no frame buffer and are updated only through
+ * display_render(), which draws each frame once per band.
+ */
+bool display_is_banded(void);
+
 /**
  * @brief Clear display buffer
  */
@@ -92,9 +219,87 @@ void display_clear(void);
 
 /**
  * @brief Push buffer to display
+ *
+ * Only the column span of each page that differs from the last
+ * transmitted frame is sent. The frame is copied and sent by a flush
+ * task, so drawing the next frame can start immediately; the call only
+ * blocks if the previous frame is still being sent.
  */
 void display_refresh(void);
 
+/**
+ * @brief Set the hardware scroll position of the panel
+ *
+ * Logical row y is stored in panel RAM row (y + rows) % DISPLAY_HEIGHT
+ * and the controller's display start line is moved to match, so the
+ * screen looks the same. When a text view passes its scroll position in
+ * pixels, the lines that stay on screen keep their RAM rows across a
+ * scroll step. Only the newly exposed rows and any fixed headers are then
+ * resent. Takes effect at the next display_clear(), so call it when the
+ * scroll position changes, before the frame is drawn. The offset is a
+ * hint: a frame is sent at the panel's current start line instead when
+ * that costs fewer bytes.
+ * @param rows Scroll position in pixel rows (any value, taken modulo the height)
+ * @return ESP_ERR_NOT_SUPPORTED on banded panels (no offset is applied)
+ */
+esp_err_t display_set_scroll(int rows);
+
+/**
+ * @brief Draw callback for display_render()
+ */
+typedef void (*display_draw_fn_t)(void *ctx);
+
+/**
+ * @brief Draw and send a frame
+ *
+ * Full-frame panels call `draw` once and then display_refresh(). Banded
+ * panels call it once per band, with the clip limited to that band, and
+ * send each band by DMA while the next one is drawn. `draw` must therefore
+ * clear and redraw the whole frame without changing any state. This is the
+ * only way to update a banded panel.
+ */
+void display_render(display_draw_fn_t draw, void *ctx);
+
+/**
+ * @brief Force the next refresh to resend the whole frame
+ *
+ * May be called from any task. If a frame is already being sent, the
+ * request is taken up by that frame or the next one, never dropped.
+ */
+void display_invalidate(void);
+
+/**
+ * @brief Get transfer statistics
+ *
+ * The copy is taken under the lock the flush task updates them with, so
+ * the counters all describe the same point in time.
+ * @param stats Output
+ */
+void display_get_stats(display_stats_t *stats);
+
+/**
+ * @brief Contents of the host framebuffer backend
+ *
+ * Panel RAM after the last completed flush, in the same page format as the
+ * drawing buffer. Screen row y shows RAM row
+ * (y + display_host_start_line()) % DISPLAY_HEIGHT. Only meaningful with
+ * DISPLAY_TYPE_HOST.
+ */
+const uint8_t *display_host_framebuffer(void);
+
+/**
+ * @brief RAM start line of the host framebuffer backend
+ */
+int display_host_start_line(void);
+
+/**
+ * @brief Writes the host framebuffer backend has taken since init
+ *
+ * One per page span, band or start line change: the transactions a panel
+ * would see. Only meaningful with DISPLAY_TYPE_HOST.
+ */
+uint32_t display_host_transactions(void);
+
 /**
  * @brief Set brightness (0-255)
  */
@@ -105,8 +310,111 @@ void display_set_brightness(uint8_t brightness);
  */
 void display_power(bool on);
 
+/* ============================================================================
+ * Clipping
+ * ============================================================================ */
+
+/**
+ * @brief Restrict drawing to a rectangle
+ *
+ * The rectangle is given in current coordinates and intersected with the
+ * active clip. Coordinates of later drawing calls are unchanged. Every
+ * push must be matched by display_pop_clip(), even if it failed.
+ * @return ESP_ERR_NO_MEM if the stack is full (drawing stays unclipped by it)
+ */
+esp_err_t display_push_clip(int x, int y, int w, int h);
+
+/**
+ * @brief Restrict drawing to a rectangle and move the origin to its corner
+ *
+ * Like display_push_clip(), but afterwards (0, 0) addresses the top-left
+ * pixel of the rectangle.
+ */
+esp_err_t display_push_viewport(int x, int y, int w, int h);
+
+/**
+ * @brief Restore the clip and origin saved by the matching push
+ */
+void display_pop_clip(void);
+
+/**
+ * @brief Drop all clips and reset the origin to the screen corner
+ */
+void display_reset_clip(void);
+
+/**
+ * @brief Get the active clip rectangle in current coordinates
+ */
+void display_get_clip(int *x, int *y, int *w, int *h);
+
+/* ============================================================================
+ * Surfaces
+ *
+ * Static content (a month grid, card faces, a settings page) can be drawn
+ * into a surface once and copied to the screen every frame after that:
+ *
+ *     if (!grid.valid) {
+ *         display_surface_begin(&grid);
+ *         ...draw...
+ *         display_surface_end();
+ *     }
+ *     display_blit_surface(0, 12, &grid);
+ *
+ * Call display_surface_invalidate() when the content's inputs change.
+ * ============================================================================ */
+
+/**
+ * @brief Allocate a cleared surface
+ * @return ESP_ERR_INVALID_ARG if it would be larger than the screen
+ */
+esp_err_t display_surface_create(display_surface_t *surface, int width, int height);
+
+/**
+ * @brief Free a surface's pixels
+ */
+void display_surface_destroy(display_surface_t *surface);
+
+/**
+ * @brief Draw into a surface until display_surface_end()
+ *
+ * Clears the surface. Drawing starts at its top-left corner with no clip
+ * pushed; the previous target's clips and origin come back at the end. A
+ * surface may be begun while another is being drawn (and blitted into
+ * it), up to DISPLAY_SURFACE_DEPTH levels.
+ * @return ESP_ERR_INVALID_STATE if surfaces are nested too deep or this
+ *         one is already being drawn
+ */
+esp_err_t display_surface_begin(display_surface_t *surface);
+
+/**
+ * @brief Go back to the previous target (the screen, or the enclosing
+ *        surface) and mark the surface valid
+ */
+void display_surface_end(void);
+
+/**
+ * @brief Mark a surface as needing to be drawn again
+ */
+void display_surface_invalidate(display_surface_t *surface);
+
+/**
+ * @brief Copy a surface to the screen, replacing what was under it
+ *
+ * Clear pixels are copied too. Rows that line up with the screen's pages
+ * are copied a page at a time, others are shifted into place.
+ */
+void display_blit_surface(int x, int y, const display_surface_t *surface);
+
+/**
+ * @brief Get surface counters
+ */
+void display_surface_get_stats(display_surface_stats_t *stats);
+
 /* ============================================================================
  * Drawing Functions
+ *
+ * Coordinates are relative to the current origin and output is limited to
+ * the current clip rectangle (the whole screen unless a clip is pushed).
  * ============================================================================ */
 
 void display_draw_pixel(int x, int y, display_color_t color);
@@ -117,6 +425,20 @@ void display_draw_rect(int x, int y, int w, int h, display_color_t color);
 void display_fill_rect(int x, int y, int w, int h, display_color_t color);
 void display_draw_circle(int cx, int cy, int r, display_color_t color);
 void display_fill_circle(int cx, int cy, int r, display_color_t color);
+void display_draw_round_rect(int x, int y, int w, int h, int r, display_color_t color);
+void display_fill_round_rect(int x, int y, int w, int h, int r, display_color_t color);
+
+/**
+ * @brief Outline selected quadrants of a circle
+ * @param quadrants DISPLAY_QUAD_* flags
+ */
+void display_draw_arc(int cx, int cy, int r, uint8_t quadrants, display_color_t color);
+
+/**
+ * @brief Fill selected quadrants of a circle (pie sectors)
+ * @param quadrants DISPLAY_QUAD_* flags
+ */
+void display_fill_arc(int cx, int cy, int r, uint8_t quadrants, display_color_t color);
 
 /**
  * @brief Draw a bitmap
@@ -129,18 +451,31 @@ void display_fill_circle(int cx, int cy, int r, display_color_t color);
  */
 void display_draw_bitmap(int x, int y, const uint8_t *bitmap, int w, int h, display_color_t color);
 
+/**
+ * @brief Draw a page-native sprite
+ *
+ * Set bits are merged a byte at a time; clear bits are transparent.
+ * @param x X position
+ * @param y Y position
+ * @param sprite Sprite to draw
+ * @param color Color to draw
+ */
+void display_draw_sprite(int x, int y, const display_sprite_t *sprite, display_color_t color);
+
 /**
  * @brief Draw character
  * @param x X position
  * @param y Y position  
- * @param c Character
+ * @param c Character (ASCII; other bytes draw '?', strings take UTF-8)
  * @param color Color
  * @param size Size multiplier (1=6x8, 2=12x16)
  */
 void display_draw_char(int x, int y, char c, display_color_t color, uint8_t size);
 
 /**
- * @brief Draw string
+ * @brief Draw UTF-8 string in the 6x8 font
+ *
+ * Glyph store characters are drawn at size 1 only, '?' at larger sizes.
  */
 void display_draw_string(int x, int y, const char *str, display_color_t color, uint8_t size);
 
@@ -149,6 +484,90 @@ void display_draw_string(int x, int y, const char *str, display_color_t color, u
  */
 void display_printf(int x, int y, display_color_t color, uint8_t size, const char *fmt, ...);
 
+/**
+ * @brief Line spacing of a font in pixel rows
+ */
+int display_font_line_height(display_font_id_t font);
+
+/**
+ * @brief Width of the first line of a string
+ * @return Pen advance in pixels, kerning included (the spacing after the
+ *         last glyph counts, so widths of adjacent runs add up)
+ */
+int display_measure_string(const char *str, display_font_id_t font);
+
+/**
+ * @brief Width of at most len bytes of the first line of a string
+ */
+int display_measure_chars(const char *str, int len, display_font_id_t font);
+
+/**
+ * @brief Number of bytes that fit in max_width, leaving room for an ellipsis if cut
+ *
+ * Never splits a UTF-8 sequence. Results are cached by the text's content,
+ * so fitting the same labels every frame costs one hash pass.
+ * @param truncated Set when the text (or its first line) does not fit; may be NULL
+ */
+int display_fit_chars(const char *str, int max_width, display_font_id_t font, bool *truncated);
+
+/**
+ * @brief Number of bytes of the first line when wrapping at max_width
+ *
+ * Breaks at the last space that fits (the space is not included), after
+ * a CJK character (those lines have no spaces), or mid-word when a word is
+ * wider than the line. Stops at '\n'. Always takes at least one character
+ * of non-empty text, so a wrap loop makes progress.
+ */
+int display_wrap_chars(const char *str, int max_width, display_font_id_t font);
+
+/**
+ * @brief Draw text in a font; '\n' starts a new line
+ * @return Pen advance of the last line
+ */
+int display_draw_text(int x, int y, const char *str, display_font_id_t font, display_color_t color);
+
+/**
+ * @brief Draw the first line of text cut to max_width, ending in an ellipsis if cut
+ * @return Width drawn
+ */
+int display_draw_text_fit(int x, int y, int max_width, const char *str,
+                          display_font_id_t font, display_color_t color);
+
+/**
+ * @brief Printf in a font
+ * @return Pen advance of the last line
+ */
+int display_text_printf(int x, int y, display_font_id_t font, display_color_t color,
+                        const char *fmt, ...);
+
+/**
+ * @brief Map a glyph store partition for characters beyond ASCII
+ *
+ * The text calls take UTF-8. Characters outside the built-in fonts are
+ * drawn from the glyph store (an image built by tools/bdf2glyphs.py),
+ * read in place from flash; without one they show as '?'.
+ * display_init() mounts the "glyphs" partition if there is one.
+ * @param label Data partition label
+ * @return ESP_ERR_NOT_FOUND if the partition is missing or holds no image
+ */
+esp_err_t display_glyphs_mount(const char *label);
+
+/**
+ * @brief Use a glyph store image already in memory (host builds)
+ * @param image Image, must stay valid until detached
+ */
+esp_err_t display_glyphs_attach(const void *image, size_t size);
+
+/**
+ * @brief Stop using the glyph store (and unmap its partition)
+ */
+void display_glyphs_detach(void);
+
+/**
+ * @brief Get glyph store counters
+ */
+void display_glyphs_get_stats(display_glyph_stats_t *stats);
+
 /**
  * @brief Draw progress bar
  */
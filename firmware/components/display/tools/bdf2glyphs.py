@@ -0,0 +1,143 @@
+#!/usr/bin/env python3
+"""
+Build a glyph store image for the display's "glyphs" partition from a BDF font.
+
+The built-in fonts only cover ASCII; everything else drawn by the display
+text functions is looked up in this image. Glyphs are placed on a cell of
+the font's bounding box height (FONT_ASCENT + FONT_DESCENT) and stored as
+page-format column bytes (bit 0 = top row), one page after another:
+
+  header   "GLY1", u8 height, 3 pad, u32 count, u32 bitmap offset, u32 image size
+  index    count x { u32 codepoint, u32 bitmap offset << 8 | width }, sorted
+  bitmaps  per glyph, ceil(height / 8) pages of `width` bytes
+
+All fields are little-endian. A glyph's width is its DWIDTH, so spacing is
+part of the cell. The built-in fonts have 8 and 9 pixel lines; an 8 row
+font such as Misaki sits in them, taller ones need taller lines.
+
+Usage: bdf2glyphs.py [--range FIRST-LAST ...] <font.bdf> <glyphs.bin>
+
+Ranges are hex codepoints (e.g. --range 3000-30FF --range 4E00-9FFF) and
+default to everything from U+0080 up. Flash the image with `idf.py flash`
+(it is picked up as firmware/glyphs.bin) or esptool's write_flash at the
+glyphs partition offset.
+"""
+
+import argparse
+import struct
+
+MAGIC = b"GLY1"
+MAX_HEIGHT = 32
+HEADER = struct.Struct("<4sB3xIII")
+ENTRY = struct.Struct("<II")
+
+
+def parse_bdf(path):
+    """Font ascent and descent, and (codepoint, advance, bbx, rows) per glyph"""
+    ascent = descent = None
+    glyphs = []
+    with open(path, encoding="latin-1") as f:
+        lines = iter(f.read().splitlines())
+    for line in lines:
+        key, _, rest = line.partition(" ")
+        if key == "FONT_ASCENT":
+            ascent = int(rest)
+        elif key == "FONT_DESCENT":
+            descent = int(rest)
+        elif key == "FONTBOUNDINGBOX" and ascent is None:
+            w, h, x, y = map(int, rest.split())
+            ascent, descent = h + y, -y
+        elif key == "STARTCHAR":
+            cp, advance, bbx, rows = -1, 0, (0, 0, 0, 0), []
+            for line in lines:
+                key, _, rest = line.partition(" ")
+                if key == "ENCODING":
+                    cp = int(rest.split()[0])
+                elif key == "DWIDTH":
+                    advance = int(rest.split()[0])
+                elif key == "BBX":
+                    bbx = tuple(map(int, rest.split()))
+                elif key == "BITMAP":
+                    for line in lines:
+                        if line.startswith("ENDCHAR"):
+                            break
+                        rows.append(int(line, 16) if line.strip() else 0)
+                    break
+            if cp >= 0:
+                glyphs.append((cp, advance, bbx, rows))
+    if ascent is None or descent is None:
+        raise SystemExit(f"{path}: no FONT_ASCENT / FONT_DESCENT or FONTBOUNDINGBOX")
+    return ascent, descent, glyphs
+
+
+def render(advance, bbx, rows, ascent, height):
+    """Page-format columns of one glyph on its cell"""
+    bw, bh, bx, by = bbx
+    width = max(1, min(advance, 255))
+    pages = (height + 7) // 8
+    cols = [[0] * width for _ in range(pages)]
+    row_bytes = (bw + 7) // 8
+    for r, bits in enumerate(rows[:bh]):
+        y = ascent - (by + bh) + r
+        if not 0 <= y < height:
+            continue
+        for c in range(bw):
+            x = bx + c
+            if 0 <= x < width and bits & (1 << (row_bytes * 8 - 1 - c)):
+                cols[y // 8][x] |= 1 << (y % 8)
+    return width, bytes(b for page in cols for b in page)
+
+
+def in_ranges(cp, ranges):
+    return any(lo <= cp <= hi for lo, hi in ranges)
+
+
+def parse_range(text):
+    lo, _, hi = text.partition("-")
+    return int(lo, 16), int(hi or lo, 16)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    ap.add_argument("--range", action="append", type=parse_range, dest="ranges",
+                    help="hex codepoint range FIRST-LAST, repeatable")
+    ap.add_argument("bdf")
+    ap.add_argument("out")
+    args = ap.parse_args()
+    ranges = args.ranges or [(0x80, 0x10FFFF)]
+
+    ascent, descent, glyphs = parse_bdf(args.bdf)
+    height = ascent + descent
+    if not 0 < height <= MAX_HEIGHT:
+        raise SystemExit(f"{args.bdf}: {height} rows, at most {MAX_HEIGHT} supported")
+
+    chosen = {}
+    for cp, advance, bbx, rows in glyphs:
+        if in_ranges(cp, ranges):
+            chosen[cp] = render(advance, bbx, rows, ascent, height)
+
+    index = []
+    bitmaps = bytearray()
+    for cp in sorted(chosen):
+        width, data = chosen[cp]
+        index.append(ENTRY.pack(cp, len(bitmaps) << 8 | width))
+        bitmaps += data
+    if len(bitmaps) >= 1 << 24:
+        raise SystemExit("bitmaps exceed 16 MiB, narrow the ranges")
+
+    bitmap_offset = HEADER.size + ENTRY.size * len(index)
+    size = (bitmap_offset + len(bitmaps) + 3) & ~3
+    image = bytearray(HEADER.pack(MAGIC, height, len(index), bitmap_offset, size))
+    for entry in index:
+        image += entry
+    image += bitmaps
+    image += bytes(size - len(image))
+
+    with open(args.out, "wb") as f:
+        f.write(image)
+    print(f"{args.out}: {len(index)} glyphs, {height} rows, {size} bytes "
+          f"(index {ENTRY.size * len(index)}, bitmaps {len(bitmaps)})")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,232 @@
+#!/usr/bin/env python3
+"""
+Generate the display fonts from the glyph sources in fonts/*.inc.
+
+A source holds fixed-size cells of column bytes (bit 0 = top row) for the
+codes 32..127. Each output font is built from one source:
+
+  fixed         cells used as they are, every advance is the cell width
+  proportional  blank columns trimmed, advance = ink width + 1, kerned
+  bold          proportional, each column also smeared one pixel right
+
+Kerning pairs between letters, digits and '.' / ',' are found from the
+glyph outlines: where the facing sides of two glyphs leave more than one
+blank column on every row they share (rows diagonally next to each other
+count too), the pair is pulled together by up to MAX_KERN pixels.
+
+Every font also gets an ellipsis glyph after its last code: three dots on
+the bottom row of the source's '.'.
+
+Usage: font_gen.py <fonts dir> <output.c>
+"""
+
+import os
+import re
+import sys
+
+FIRST = 32
+COUNT = 96
+TRACKING = 1
+MAX_KERN = 2
+KERNED = set(b"0123456789.,ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz")
+
+# enum suffix, source, cell width, ink rows, line height, style, space advance
+FONTS = [
+    ("6X8", "font6x8.inc", 6, 8, 8, "fixed", 6),
+    ("PROP", "font6x8.inc", 6, 8, 9, "proportional", 3),
+    ("BOLD", "font6x8.inc", 6, 8, 9, "bold", 3),
+    ("SMALL", "font5x6.inc", 5, 6, 7, "proportional", 2),
+]
+
+
+def parse(path, cell):
+    with open(path) as f:
+        text = re.sub(r"/\*.*?\*/", "", f.read(), flags=re.S)
+    data = [int(tok, 16) for tok in re.findall(r"0[xX]([0-9a-fA-F]+)", text)]
+    if len(data) != cell * COUNT:
+        raise SystemExit(f"{path}: {len(data)} bytes, expected {cell * COUNT}")
+    return [data[i * cell:(i + 1) * cell] for i in range(COUNT)]
+
+
+def trim(cols):
+    first = next((i for i, c in enumerate(cols) if c), None)
+    if first is None:
+        return []
+    last = max(i for i, c in enumerate(cols) if c)
+    return cols[first:last + 1]
+
+
+def embolden(cols):
+    if not cols:
+        return []
+    return [(cols[i] if i < len(cols) else 0) | (cols[i - 1] if i > 0 else 0)
+            for i in range(len(cols) + 1)]
+
+
+def ellipsis(cells, dot_width):
+    dot = trim(cells[ord(".") - FIRST])
+    low = max(bit for bit in range(8) if any(c & (1 << bit) for c in dot))
+    cols = []
+    for i in range(3):
+        cols += [0] * (i > 0) + [1 << low] * dot_width
+    return cols
+
+
+def profile(cols, rows, from_right):
+    """Blank columns between the glyph edge and the ink, per row (None = no ink)"""
+    order = list(reversed(cols)) if from_right else cols
+    out = []
+    for row in range(rows):
+        bit = 1 << row
+        out.append(next((i for i, c in enumerate(order) if c & bit), None))
+    return out
+
+
+def kern_pair(right, left, rows):
+    """Adjustment for a glyph with right profile `right` followed by one with left profile `left`"""
+    shared = False
+    gap = None
+    for row in range(rows):
+        if right[row] is None:
+            continue
+        for other in (row - 1, row, row + 1):
+            if 0 <= other < rows and left[other] is not None:
+                g = right[row] + TRACKING + left[other]
+                gap = g if gap is None else min(gap, g)
+                if other == row:
+                    shared = True
+    if not shared or gap is None or gap <= TRACKING:
+        return 0
+    return -min(gap - TRACKING, MAX_KERN)
+
+
+def build(cells, cell, rows, style, space):
+    glyphs = []
+    for i, cols in enumerate(cells + [None]):
+        if i == COUNT:
+            cols = ellipsis(cells, 2 if style == "bold" else 1)
+        elif style != "fixed":
+            cols = trim(cols)
+            if style == "bold":
+                cols = embolden(cols)
+        if style == "fixed":
+            cols = list(cols) + [0] * (cell - len(cols))
+            glyphs.append((cols, cell))
+            continue
+        advance = space if i == 0 else len(cols) + TRACKING
+        glyphs.append((cols, advance))
+
+    kerns = []
+    if style != "fixed":
+        rights = [profile(c, rows, True) for c, _ in glyphs[:COUNT]]
+        lefts = [profile(c, rows, False) for c, _ in glyphs[:COUNT]]
+        for a in range(1, COUNT):
+            pairs = []
+            for b in range(1, COUNT):
+                if FIRST + a not in KERNED or FIRST + b not in KERNED:
+                    continue
+                adj = kern_pair(rights[a], lefts[b], rows)
+                if adj:
+                    pairs.append((b, adj))
+            kerns.append(pairs)
+        kerns.insert(0, [])
+    return glyphs, kerns
+
+
+def min_step(glyphs, kerns):
+    """Smallest pen move of any character, kerning included"""
+    steps = []
+    for i, (_, advance) in enumerate(glyphs[:COUNT]):
+        pairs = kerns[i] if kerns else []
+        steps.append(advance + min([adj for _, adj in pairs], default=0))
+    return max(1, min(steps))
+
+
+def emit_font(out, name, glyphs, kerns, rows, line_height):
+    lower = name.lower()
+    offsets = [0]
+    out.append("static const uint8_t font_%s_cols[] = {" % lower)
+    for i, (cols, _) in enumerate(glyphs):
+        offsets.append(offsets[-1] + len(cols))
+        if cols:
+            label = "ellipsis" if i == COUNT else repr(chr(FIRST + i))
+            out.append("    %s,  /* %s */" % (", ".join("0x%02X" % c for c in cols), label))
+    out.append("};")
+    out.append("")
+    out.append("static const uint16_t font_%s_offset[] = {" % lower)
+    for i in range(0, len(offsets), 16):
+        out.append("    " + ", ".join(str(o) for o in offsets[i:i + 16]) + ",")
+    out.append("};")
+    out.append("")
+    out.append("static const uint8_t font_%s_advance[] = {" % lower)
+    advances = [a for _, a in glyphs]
+    for i in range(0, len(advances), 16):
+        out.append("    " + ", ".join(str(a) for a in advances[i:i + 16]) + ",")
+    out.append("};")
+    out.append("")
+
+    kern_index = "NULL"
+    kern_table = "NULL"
+    total = sum(len(p) for p in kerns)
+    if total:
+        index = [0]
+        for pairs in kerns:
+            index.append(index[-1] + len(pairs))
+        out.append("static const uint16_t font_%s_kern_index[] = {" % lower)
+        for i in range(0, len(index), 16):
+            out.append("    " + ", ".join(str(v) for v in index[i:i + 16]) + ",")
+        out.append("};")
+        out.append("")
+        out.append("static const display_kern_t font_%s_kern[] = {" % lower)
+        for a, pairs in enumerate(kerns):
+            if pairs:
+                out.append("    /* %r */ %s," % (chr(FIRST + a), ", ".join(
+                    "{%d, %d}" % (b, adj) for b, adj in pairs)))
+        out.append("};")
+        out.append("")
+        kern_index = "font_%s_kern_index" % lower
+        kern_table = "font_%s_kern" % lower
+
+    return ("    [DISPLAY_FONT_%s] = {\n"
+            "        .cols = font_%s_cols,\n"
+            "        .offset = font_%s_offset,\n"
+            "        .advance = font_%s_advance,\n"
+            "        .kern_index = %s,\n"
+            "        .kern = %s,\n"
+            "        .first = %d,\n"
+            "        .count = %d,\n"
+            "        .height = %d,\n"
+            "        .line_height = %d,\n"
+            "        .min_step = %d,\n"
+            "    },") % (name, lower, lower, lower, kern_index, kern_table,
+                         FIRST, COUNT, rows, line_height, min_step(glyphs, kerns))
+
+
+def main():
+    if len(sys.argv) != 3:
+        raise SystemExit(__doc__)
+    src_dir, out_path = sys.argv[1], sys.argv[2]
+
+    out = [
+        "/* Generated by font_gen.py from %s - do not edit */" % ", ".join(
+            sorted({src for _, src, *_ in FONTS})),
+        "",
+        '#include "display_font.h"',
+        "",
+    ]
+    entries = []
+    for name, src, cell, rows, line_height, style, space in FONTS:
+        cells = parse(os.path.join(src_dir, src), cell)
+        glyphs, kerns = build(cells, cell, rows, style, space)
+        entries.append(emit_font(out, name, glyphs, kerns, rows, line_height))
+
+    out.append("const display_font_t display_fonts[DISPLAY_FONT_COUNT] = {")
+    out.extend(entries)
+    out.append("};")
+    out.append("")
+    with open(out_path, "w") as f:
+        f.write("\n".join(out))
+
+
+if __name__ == "__main__":
+    main()
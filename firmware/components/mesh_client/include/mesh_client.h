@@ -110,11 +110,22 @@ typedef void (*mesh_status_cb_t)(const mesh_status_t *status);
  */
 typedef void (*mesh_send_complete_cb_t)(uint32_t seq, bool success);
 
+/**
+ * @brief Mesh Relay attribute handles on the partner
+ */
+typedef struct {
+    uint16_t conn_handle;                   /**< BLE connection */
+    uint16_t inbox_char_handle;             /**< MeshInbox value (notify) */
+    uint16_t send_char_handle;              /**< MeshSend value (write) */
+    uint16_t status_char_handle;            /**< MeshStatus value (read, notify) */
+    uint16_t node_list_char_handle;         /**< NodeList value (read) */
+} mesh_client_handles_t;
+
 /**
  * @brief Initialize the mesh client
  *
- * Sets up BLE GATT client for the Mesh Relay service.
- * Must be called after BLE stack initialization.
+ * The BLE link owner resolves the Mesh Relay service and hands over its
+ * handles with mesh_client_set_handles().
  *
  * @return ESP_OK on success, error code otherwise
  */
@@ -127,6 +138,26 @@ esp_err_t mesh_client_init(void);
  */
 esp_err_t mesh_client_deinit(void);
 
+/**
+ * @brief Set the Mesh Relay handles of the connected partner
+ *
+ * Call once MeshInbox and MeshStatus notifications are enabled.
+ *
+ * @param handles Resolved handles, or NULL when the link drops
+ */
+void mesh_client_set_handles(const mesh_client_handles_t *handles);
+
+/**
+ * @brief Feed a notification received from the partner
+ *
+ * Notifications on other handles are ignored.
+ *
+ * @param char_handle Characteristic value handle
+ * @param data Notification payload
+ * @param len Payload length
+ */
+void mesh_client_on_notification(uint16_t char_handle, const uint8_t *data, size_t len);
+
 /**
  * @brief Check if mesh client is connected to partner device
  *
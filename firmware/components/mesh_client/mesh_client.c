@@ -129,12 +129,31 @@ static void handle_status_notification(const uint8_t *data, size_t len)
     }
 }
 
-/**
- * @brief BLE GATT notification callback (to be connected to BLE stack)
- * 
- * This is a stub that should be connected to your BLE GATT client
- * notification handler in control_link or a dedicated BLE module.
- */
+void mesh_client_set_handles(const mesh_client_handles_t *handles)
+{
+    if (!s_state.initialized) {
+        return;
+    }
+    
+    if (handles) {
+        s_state.conn_handle = handles->conn_handle;
+        s_state.inbox_char_handle = handles->inbox_char_handle;
+        s_state.send_char_handle = handles->send_char_handle;
+        s_state.status_char_handle = handles->status_char_handle;
+        s_state.node_list_char_handle = handles->node_list_char_handle;
+        ESP_LOGI(TAG, "Mesh Relay handles: inbox=%u send=%u status=%u nodes=%u",
+                 handles->inbox_char_handle, handles->send_char_handle,
+                 handles->status_char_handle, handles->node_list_char_handle);
+    } else {
+        s_state.conn_handle = 0;
+        s_state.inbox_char_handle = 0;
+        s_state.send_char_handle = 0;
+        s_state.status_char_handle = 0;
+        s_state.node_list_char_handle = 0;
+        s_state.connected = false;
+    }
+}
+
 void mesh_client_on_notification(uint16_t char_handle, const uint8_t *data, size_t len)
 {
     if (!s_state.initialized) {
@@ -186,10 +205,9 @@ esp_err_t mesh_client_init(void)
     
     ESP_LOGI(TAG, "Mesh client initialized");
     
-    /* TODO: Register with BLE GATT client to discover Mesh Relay service
-     * and subscribe to MeshInbox and MeshStatus notifications.
-     * This depends on how control_link manages BLE connections.
-     */
+    /* Handles and notifications arrive through mesh_client_set_handles()
+     * and mesh_client_on_notification() once the BLE link resolves the
+     * Mesh Relay service. */
     
     return ESP_OK;
 }
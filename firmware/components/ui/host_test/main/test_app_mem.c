@@ -0,0 +1,187 @@
+/**
+ * @file test_app_mem.c
+ * @brief App state: warm relaunches, cold launches, LRU eviction
+ *
+ * Apps declare a state_size and find their state with ui_app_state() from
+ * on_enter. Closed apps stay warm up to CONFIG_UI_APP_WARM_APPS and within
+ * CONFIG_UI_APP_MEM_BUDGET, least recently closed evicted first; these
+ * tests assume the values in sdkconfig.defaults.
+ */
+
+#include <string.h>
+#include "unity.h"
+#include "test_ui.h"
+#include "sdkconfig.h"
+
+#define SMALL_STATE         256
+#define HALF_STATE          (CONFIG_UI_APP_MEM_BUDGET / 2)
+#define MEM_APP_COUNT       6
+
+enum { APP_A, APP_B, APP_C, APP_BIG1, APP_BIG2, APP_HUGE };
+
+static const ui_app_t s_mem_apps[MEM_APP_COUNT];
+static void *s_entered[MEM_APP_COUNT];      /* State each app saw in its last on_enter */
+static int s_evicted[16];
+static int s_evict_count;
+
+#define MEM_APP_FNS(n) \
+    static void enter_##n(void) { s_entered[n] = ui_app_state(&s_mem_apps[n]); } \
+    static void evict_##n(void *state) \
+    { \
+        TEST_ASSERT_EQUAL_PTR(ui_app_state(&s_mem_apps[n]), state); \
+        s_evicted[s_evict_count++] = n; \
+    }
+MEM_APP_FNS(APP_A) MEM_APP_FNS(APP_B) MEM_APP_FNS(APP_C)
+MEM_APP_FNS(APP_BIG1) MEM_APP_FNS(APP_BIG2) MEM_APP_FNS(APP_HUGE)
+
+#define MEM_APP(n, app_id, size) \
+    [n] = { .id = app_id, .name = app_id, .state_size = size, .on_enter = enter_##n, .on_evict = evict_##n }
+
+static const ui_app_t s_mem_apps[MEM_APP_COUNT] = {
+    MEM_APP(APP_A, "a", SMALL_STATE),
+    MEM_APP(APP_B, "b", SMALL_STATE),
+    MEM_APP(APP_C, "c", SMALL_STATE),
+    MEM_APP(APP_BIG1, "big1", HALF_STATE),
+    MEM_APP(APP_BIG2, "big2", HALF_STATE),
+    MEM_APP(APP_HUGE, "huge", CONFIG_UI_APP_MEM_BUDGET + 1),
+};
+
+static void start_mem(void)
+{
+    test_ui_start();
+    for (int i = 0; i < MEM_APP_COUNT; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, ui_register_app(&s_mem_apps[i]));
+    }
+    memset(s_entered, 0, sizeof(s_entered));
+    s_evict_count = 0;
+}
+
+/* Launch and close again */
+static void visit(int app)
+{
+    TEST_ASSERT_EQUAL(ESP_OK, ui_launch_app(s_mem_apps[app].id));
+    ui_go_back();
+}
+
+static bool all_bytes(const void *state, uint8_t value, size_t size)
+{
+    const uint8_t *p = state;
+    for (size_t i = 0; i < size; i++) {
+        if (p[i] != value) return false;
+    }
+    return true;
+}
+
+TEST_CASE("app state survives a warm relaunch", "[ui]")
+{
+    ui_app_mem_stats_t stats;
+    
+    start_mem();
+    TEST_ASSERT_EQUAL(ESP_OK, ui_launch_app("a"));
+    void *state = s_entered[APP_A];
+    TEST_ASSERT_NOT_NULL(state);
+    TEST_ASSERT_TRUE(all_bytes(state, 0, SMALL_STATE));
+    memset(state, 0xA5, SMALL_STATE);
+    ui_go_back();
+    
+    /* Closed but warm: still resident */
+    ui_get_app_mem_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.warm);
+    TEST_ASSERT_EQUAL_UINT32(SMALL_STATE, stats.resident);
+    TEST_ASSERT_EQUAL(SMALL_STATE, ui_get_app_resident(APP_A));
+    TEST_ASSERT_EQUAL_PTR(state, ui_app_state(&s_mem_apps[APP_A]));
+    
+    /* Reopened as it was left */
+    s_entered[APP_A] = NULL;
+    TEST_ASSERT_EQUAL(ESP_OK, ui_launch_app("a"));
+    TEST_ASSERT_EQUAL_PTR(state, s_entered[APP_A]);
+    TEST_ASSERT_TRUE(all_bytes(state, 0xA5, SMALL_STATE));
+    ui_get_app_mem_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.hits);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.warm);
+    
+    /* An app opened over it keeps both open; closing the top one warms only it */
+    TEST_ASSERT_EQUAL(ESP_OK, ui_launch_app("b"));
+    ui_get_app_mem_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(2 * SMALL_STATE, stats.resident);
+    ui_go_back();
+    ui_get_app_mem_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.warm);
+    ui_go_back();
+    ui_get_app_mem_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.warm);
+    TEST_ASSERT_EQUAL(0, s_evict_count);
+}
+
+TEST_CASE("app state is zeroed on a cold launch", "[ui]")
+{
+    ui_app_mem_stats_t stats;
+    
+    start_mem();
+    TEST_ASSERT_EQUAL(ESP_OK, ui_launch_app("a"));
+    memset(s_entered[APP_A], 0xA5, SMALL_STATE);
+    ui_go_back();
+    
+    /* Two more closed apps push it past the warm limit */
+    visit(APP_B);
+    visit(APP_C);
+    TEST_ASSERT_EQUAL(1, s_evict_count);
+    TEST_ASSERT_EQUAL(APP_A, s_evicted[0]);
+    TEST_ASSERT_NULL(ui_app_state(&s_mem_apps[APP_A]));
+    TEST_ASSERT_EQUAL(0, ui_get_app_resident(APP_A));
+    
+    /* Evicted: a new, zeroed state */
+    TEST_ASSERT_EQUAL(ESP_OK, ui_launch_app("a"));
+    TEST_ASSERT_NOT_NULL(s_entered[APP_A]);
+    TEST_ASSERT_TRUE(all_bytes(s_entered[APP_A], 0, SMALL_STATE));
+    memset(s_entered[APP_A], 0xA5, SMALL_STATE);
+    ui_go_back();
+    ui_get_app_mem_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.hits);
+    
+    /* ui_init() drops every state, so the next launch is cold too */
+    start_mem();
+    TEST_ASSERT_EQUAL(ESP_OK, ui_launch_app("a"));
+    TEST_ASSERT_TRUE(all_bytes(s_entered[APP_A], 0, SMALL_STATE));
+    ui_get_app_mem_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(SMALL_STATE, stats.resident);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.hits);
+}
+
+TEST_CASE("app state is evicted least recently used first", "[ui]")
+{
+    ui_app_mem_stats_t stats;
+    
+    /* Past the warm limit: a was reopened after b, so b goes */
+    start_mem();
+    visit(APP_A);
+    visit(APP_B);
+    visit(APP_A);
+    visit(APP_C);
+    TEST_ASSERT_EQUAL(1, s_evict_count);
+    TEST_ASSERT_EQUAL(APP_B, s_evicted[0]);
+    TEST_ASSERT_EQUAL(SMALL_STATE, ui_get_app_resident(APP_A));
+    TEST_ASSERT_EQUAL(0, ui_get_app_resident(APP_B));
+    TEST_ASSERT_EQUAL(SMALL_STATE, ui_get_app_resident(APP_C));
+    
+    /* Over the budget: the older of two half-budget states makes room */
+    start_mem();
+    visit(APP_BIG1);
+    visit(APP_BIG2);
+    ui_get_app_mem_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(CONFIG_UI_APP_MEM_BUDGET, stats.resident);
+    visit(APP_A);
+    TEST_ASSERT_EQUAL(1, s_evict_count);
+    TEST_ASSERT_EQUAL(APP_BIG1, s_evicted[0]);
+    ui_get_app_mem_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(HALF_STATE + SMALL_STATE, stats.resident);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(stats.budget, stats.peak);
+    
+    /* Bigger than the whole budget: refused, and nothing evicted for it */
+    TEST_ASSERT_EQUAL(ESP_ERR_NO_MEM, ui_launch_app("huge"));
+    ui_get_app_mem_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.failures);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.warm);
+    TEST_ASSERT_EQUAL(1, s_evict_count);
+    TEST_ASSERT_FALSE(ui_is_app_focused(&s_mem_apps[APP_HUGE]));
+}
@@ -0,0 +1,234 @@
+/**
+ * @file test_input.c
+ * @brief Lock-free input queue: wraparound, overflow and a live producer
+ *
+ * ui_post_input() is the single producer and ui_process_input() the single
+ * consumer. Button events go through the ring in order and are dropped,
+ * and counted, when it is full; axis-only reports replace one not yet
+ * taken. Each report carries its sequence number in x and y, so the test
+ * app can tell exactly what reached it and in which order.
+ */
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "unity.h"
+#include "test_ui.h"
+
+#define SEEN_MAX            8192
+#define THREAD_REPORTS      6000
+
+typedef struct {
+    int seq;
+    uint8_t buttons;
+} seen_t;
+
+static seen_t s_seen[SEEN_MAX];
+static int s_seen_count;
+
+/* Sequence numbers up to 12799 in the two axes */
+static int8_t seq_x(int seq) { return seq % 100; }
+static int8_t seq_y(int seq) { return seq / 100; }
+
+/**
+ * @brief Buttons of the nth button event
+ *
+ * PRESS, DOUBLE and LONG combinations, never HOME or BACK. Any run of up
+ * to six events differs from the one before it, so events refused by a
+ * full ring still count as button events rather than axis reports.
+ */
+static uint8_t event_buttons(int n)
+{
+    return 1 + n % 7;
+}
+
+static void record_input(int8_t x, int8_t y, uint8_t buttons)
+{
+    if (s_seen_count < SEEN_MAX) {
+        s_seen[s_seen_count++] = (seen_t){ .seq = y * 100 + x, .buttons = buttons };
+    }
+}
+
+static const ui_app_t s_input_app = {
+    .id = "input",
+    .name = "Input",
+    .on_input = record_input,
+};
+
+/**
+ * @brief Fresh UI with the recording app open and the queue empty
+ *
+ * The producer remembers the buttons of its last report across ui_init(),
+ * so two reports with different buttons leave it at 0 whatever it was.
+ */
+static void start_input_app(void)
+{
+    test_ui_start();
+    TEST_ASSERT_EQUAL(ESP_OK, ui_register_app(&s_input_app));
+    TEST_ASSERT_EQUAL(ESP_OK, ui_launch_app("input"));
+    ui_post_input(0, 0, UI_BTN_LONG);
+    ui_post_input(0, 0, 0);
+    ui_process_input();
+    s_seen_count = 0;
+}
+
+static void assert_seen_in_order(int first, int count)
+{
+    char msg[32];
+    
+    TEST_ASSERT_EQUAL(count, s_seen_count);
+    for (int i = 0; i < count; i++) {
+        snprintf(msg, sizeof(msg), "event %d", first + i);
+        TEST_ASSERT_EQUAL_MESSAGE(first + i, s_seen[i].seq, msg);
+        TEST_ASSERT_EQUAL_MESSAGE(event_buttons(first + i), s_seen[i].buttons, msg);
+    }
+}
+
+TEST_CASE("input ring delivers every button event in order across wraparound", "[ui]")
+{
+    ui_input_stats_t before, after;
+    
+    start_input_app();
+    ui_get_input_stats(&before);
+    
+    /* Every batch size up to a full ring, so the ring wraps at every offset */
+    int seq = 0;
+    for (int batch = 1; batch <= UI_INPUT_QUEUE_LEN; batch++) {
+        s_seen_count = 0;
+        for (int i = 0; i < batch; i++, seq++) {
+            TEST_ASSERT_TRUE(ui_post_input(seq_x(seq), seq_y(seq), event_buttons(seq)));
+        }
+        ui_get_input_stats(&after);
+        TEST_ASSERT_EQUAL_UINT32(batch, after.depth);
+        
+        ui_process_input();
+        assert_seen_in_order(seq - batch, batch);
+        ui_get_input_stats(&after);
+        TEST_ASSERT_EQUAL_UINT32(0, after.depth);
+    }
+    
+    ui_get_input_stats(&after);
+    TEST_ASSERT_EQUAL_UINT32(before.dropped, after.dropped);
+    TEST_ASSERT_EQUAL_UINT32(UI_INPUT_QUEUE_LEN, after.max_depth);
+}
+
+TEST_CASE("full input ring drops and counts new button events, axis reports coalesce", "[ui]")
+{
+    ui_input_stats_t before, after;
+    
+    start_input_app();
+    ui_get_input_stats(&before);
+    
+    /* The ring takes UI_INPUT_QUEUE_LEN events, the rest are refused */
+    for (int seq = 0; seq < UI_INPUT_QUEUE_LEN + 5; seq++) {
+        bool ok = ui_post_input(seq_x(seq), seq_y(seq), event_buttons(seq));
+        TEST_ASSERT_EQUAL(seq < UI_INPUT_QUEUE_LEN, ok);
+    }
+    ui_get_input_stats(&after);
+    TEST_ASSERT_EQUAL_UINT32(5, after.dropped - before.dropped);
+    TEST_ASSERT_EQUAL_UINT32(UI_INPUT_QUEUE_LEN + 5, after.posted - before.posted);
+    TEST_ASSERT_EQUAL_UINT32(UI_INPUT_QUEUE_LEN, after.depth);
+    
+    /* The accepted ones all arrive, and the ring takes events again */
+    ui_process_input();
+    assert_seen_in_order(0, UI_INPUT_QUEUE_LEN);
+    s_seen_count = 0;
+    int seq = UI_INPUT_QUEUE_LEN;
+    TEST_ASSERT_TRUE(ui_post_input(seq_x(seq), seq_y(seq), event_buttons(seq)));
+    
+    /* Axis reports with the same buttons: only the newest is delivered, after the event */
+    uint8_t held = event_buttons(seq);
+    for (int i = 1; i <= 5; i++) {
+        TEST_ASSERT_TRUE(ui_post_input(seq_x(seq + i), seq_y(seq + i), held));
+    }
+    ui_process_input();
+    TEST_ASSERT_EQUAL(2, s_seen_count);
+    TEST_ASSERT_EQUAL(seq, s_seen[0].seq);
+    TEST_ASSERT_EQUAL(seq + 5, s_seen[1].seq);
+    TEST_ASSERT_EQUAL(held, s_seen[1].buttons);
+    ui_get_input_stats(&before);
+    TEST_ASSERT_EQUAL_UINT32(4, before.coalesced - after.coalesced);
+}
+
+/* Filled in by the producer task before it sets s_producer_done */
+static uint8_t s_posted_buttons[THREAD_REPORTS];
+static bool s_posted_event[THREAD_REPORTS];     /* Accepted as a button event */
+static uint32_t s_producer_dropped;
+static atomic_bool s_producer_done;
+
+/**
+ * @brief Post a button event every fourth report and axis reports between
+ *
+ * Keeps its own copy of the queue's rule: a report is a button event when
+ * its buttons differ from the last accepted event's.
+ */
+static void producer_task(void *arg)
+{
+    uint8_t accepted = 0;
+    int events = 0;
+    
+    for (int seq = 0; seq < THREAD_REPORTS; seq++) {
+        uint8_t buttons = seq % 4 == 0 ? event_buttons(events++) : accepted;
+        bool event = buttons != accepted;
+        bool ok = ui_post_input(seq_x(seq), seq_y(seq), buttons);
+        
+        s_posted_buttons[seq] = buttons;
+        s_posted_event[seq] = event && ok;
+        if (event && ok) accepted = buttons;
+        if (event && !ok) s_producer_dropped++;
+        
+        if (seq % 16 == 15) vTaskDelay(1);
+    }
+    atomic_store(&s_producer_done, true);
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("input queue keeps order with a producer task posting concurrently", "[ui]")
+{
+    ui_input_stats_t before, after;
+    TaskHandle_t task;
+    char msg[48];
+    
+    start_input_app();
+    ui_get_input_stats(&before);
+    s_producer_dropped = 0;
+    atomic_store(&s_producer_done, false);
+    
+    /* Now and then the consumer stalls long enough for the ring to fill */
+    TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(producer_task, "producer", 4096, NULL, 5, &task));
+    for (int round = 0; !atomic_load(&s_producer_done); round++) {
+        ui_process_input();
+        vTaskDelay(round % 32 == 31 ? 40 : 1);
+    }
+    ui_process_input();
+    ui_get_input_stats(&after);
+    
+    TEST_ASSERT_EQUAL_UINT32(THREAD_REPORTS, after.posted - before.posted);
+    TEST_ASSERT_EQUAL_UINT32(s_producer_dropped, after.dropped - before.dropped);
+    TEST_ASSERT_EQUAL_UINT32(0, after.depth);
+    
+    /* Strictly in posting order, each with the buttons held when it was posted */
+    int last = -1;
+    for (int i = 0; i < s_seen_count; i++) {
+        int seq = s_seen[i].seq;
+        snprintf(msg, sizeof(msg), "delivery %d (report %d)", i, seq);
+        TEST_ASSERT_GREATER_THAN_MESSAGE(last, seq, msg);
+        TEST_ASSERT_EQUAL_MESSAGE(s_posted_buttons[seq], s_seen[i].buttons, msg);
+        
+        /* No accepted button event skipped in between */
+        for (int skipped = last + 1; skipped < seq; skipped++) {
+            snprintf(msg, sizeof(msg), "button event %d lost", skipped);
+            TEST_ASSERT_FALSE_MESSAGE(s_posted_event[skipped], msg);
+        }
+        last = seq;
+    }
+    for (int skipped = last + 1; skipped < THREAD_REPORTS; skipped++) {
+        TEST_ASSERT_FALSE(s_posted_event[skipped]);
+    }
+    
+    printf("%d reports, %d delivered, %lu coalesced, %lu dropped, deepest %lu\n",
+           THREAD_REPORTS, s_seen_count, (unsigned long)(after.coalesced - before.coalesced),
+           (unsigned long)(after.dropped - before.dropped), (unsigned long)after.max_depth);
+}
@@ -0,0 +1,183 @@
+/**
+ * @file test_layers.c
+ * @brief Composition layers against drawing every frame directly
+ *
+ * On a full-frame panel the scene and the status bar are drawn into
+ * layers and copied into each frame; on a banded panel there are no
+ * layers and both are drawn straight into every band. The same session
+ * (menu, status changes, an app, a dialog, the keyboard, a notification
+ * sliding in) is played on both, on a virtual clock, and every frame has
+ * to come out the same.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "unity.h"
+#include "test_ui.h"
+
+#define MAX_FRAMES          24
+#define STEP_MS             200
+
+static int s_pos;
+static int s_renders;
+
+/* Text and shapes across the band edges, moved by the joystick */
+static void layers_render(void)
+{
+    s_renders++;
+    display_draw_text(2, 1, "Layer test", DISPLAY_FONT_PROP, COLOR_WHITE);
+    display_fill_round_rect(4 + s_pos, 14, 40, 20, 5, COLOR_WHITE);
+    display_draw_string(8 + s_pos, 20, "band", COLOR_INVERSE, 1);
+    display_draw_circle(96, 28, 18 - s_pos % 8, COLOR_WHITE);
+    display_draw_line(0, UI_CONTENT_HEIGHT - 1, DISPLAY_WIDTH - 1, 0, COLOR_INVERSE);
+}
+
+static void layers_input(int8_t x, int8_t y, uint8_t buttons)
+{
+    s_pos += x / 20;
+    ui_invalidate();
+}
+
+static void osk_done(const char *text, bool confirmed)
+{
+}
+
+static const ui_app_t s_layers_app = {
+    .id = "layers",
+    .name = "Layers",
+    .on_render = layers_render,
+    .on_input = layers_input,
+};
+
+static const ui_app_t s_other_app = {
+    .id = "other",
+    .name = "Other",
+};
+
+typedef struct {
+    uint8_t frames[MAX_FRAMES][TEST_FRAME_SIZE];
+    int renders[MAX_FRAMES];            /* on_render calls for each frame */
+    int count;
+} session_t;
+
+/**
+ * @brief Let `ms` pass, then render and keep the frame
+ */
+static void step(session_t *s, uint32_t ms)
+{
+    TEST_ASSERT_LESS_THAN(MAX_FRAMES, s->count);
+    test_time_advance(ms);
+    ui_tick(ms);
+    
+    int before = s_renders;
+    test_ui_frame(s->frames[s->count]);
+    s->renders[s->count] = s_renders - before;
+    s->count++;
+}
+
+/* Joystick push and release, through the input handlers directly */
+static void push(int8_t x, int8_t y, uint8_t buttons)
+{
+    ui_input(x, y, buttons);
+    ui_input(0, 0, 0);
+}
+
+static void play_session(session_t *s)
+{
+    ui_status_t status = { .battery_percent = 80, .hour = 9, .minute = 41 };
+    
+    test_time_freeze();
+    TEST_ASSERT_EQUAL(ESP_OK, ui_register_app(&s_layers_app));
+    TEST_ASSERT_EQUAL(ESP_OK, ui_register_app(&s_other_app));
+    s_pos = 0;
+    s->count = 0;
+    
+    /* Menu, a selection move, status changes */
+    step(s, STEP_MS);
+    push(60, 0, 0);
+    step(s, STEP_MS);
+    ui_update_status(&status);
+    step(s, STEP_MS);
+    status.ble_connected = true;
+    status.minute = 42;
+    ui_update_status(&status);
+    step(s, STEP_MS);
+    
+    /* The app, moved about */
+    TEST_ASSERT_EQUAL(ESP_OK, ui_launch_app("layers"));
+    step(s, STEP_MS);
+    for (int i = 0; i < 3; i++) {
+        push(60, 0, 0);
+        step(s, STEP_MS);
+    }
+    
+    /* A dialog over it, its selection moved, closed */
+    ui_dialog_t dialog = {
+        .title = "Delete?",
+        .message = "Remove all items",
+        .buttons = { { "Yes", NULL }, { "No", NULL } },
+        .button_count = 2,
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, ui_show_dialog(&dialog));
+    step(s, STEP_MS);
+    push(60, 0, 0);
+    step(s, STEP_MS);
+    push(0, 0, UI_BTN_BACK);
+    step(s, STEP_MS);
+    
+    /* The keyboard, a key moved to, cancelled */
+    ui_osk_config_t osk = { .title = "Name", .initial_text = "abc", .max_length = 16, .callback = osk_done };
+    TEST_ASSERT_EQUAL(ESP_OK, ui_show_osk(&osk));
+    step(s, STEP_MS);
+    push(60, 0, 0);
+    step(s, STEP_MS);
+    push(0, 0, UI_BTN_BACK);
+    step(s, STEP_MS);
+    
+    /* A notification sliding in over the app, held, then tapped away */
+    ui_notify_simple("Hello there");
+    step(s, 0);
+    step(s, 100);
+    step(s, STEP_MS);
+    push(0, 0, UI_BTN_PRESS);
+    step(s, STEP_MS);
+    
+    /* Back to the menu */
+    push(0, 0, UI_BTN_HOME);
+    step(s, STEP_MS);
+}
+
+TEST_CASE("frames drawn from layers match frames drawn directly", "[ui]")
+{
+    static session_t banded, full;
+    display_surface_stats_t surfaces;
+    char msg[32];
+    
+    /* Banded: no layers allocated, the scene drawn once per band */
+    test_ui_restart(true);
+    TEST_ASSERT_TRUE(display_is_banded());
+    display_surface_get_stats(&surfaces);
+    TEST_ASSERT_EQUAL_UINT32(0, surfaces.live);
+    play_session(&banded);
+    
+    /* Full frame: the layers, and on_render only when the app changed */
+    test_ui_restart(false);
+    display_surface_get_stats(&surfaces);
+    TEST_ASSERT_EQUAL_UINT32(2, surfaces.live);
+    play_session(&full);
+    
+    TEST_ASSERT_EQUAL(banded.count, full.count);
+    int banded_renders = 0, full_renders = 0;
+    for (int i = 0; i < full.count; i++) {
+        snprintf(msg, sizeof(msg), "frame %d", i);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(banded.frames[i], full.frames[i], TEST_FRAME_SIZE, msg);
+        banded_renders += banded.renders[i];
+        full_renders += full.renders[i];
+    }
+    TEST_ASSERT_LESS_THAN(banded_renders, full_renders);
+    printf("%d frames, on_render called %d times banded, %d times from layers\n",
+           full.count, banded_renders, full_renders);
+    
+    /* Leave a full-frame panel with fresh layers for the other tests */
+    test_ui_start();
+}
@@ -0,0 +1,89 @@
+/**
+ * @file test_main.c
+ * @brief UI host tests - entry point and shared helpers
+ *
+ * Built for the linux target; the UI draws on the in-memory host display.
+ * esp_timer_get_time() is wrapped at link time (see CMakeLists.txt) so
+ * tests that depend on timing can run the UI on a virtual clock.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "unity.h"
+#include "test_ui.h"
+
+static bool s_display_started = false;
+static bool s_display_banded = false;
+
+/* Never goes back, so statics the UI keeps across ui_init() see time pass */
+static volatile bool s_virtual_time = false;
+static volatile int64_t s_virtual_us = 1000000000;
+
+int64_t __real_esp_timer_get_time(void);
+
+int64_t __wrap_esp_timer_get_time(void)
+{
+    return s_virtual_time ? s_virtual_us : __real_esp_timer_get_time();
+}
+
+void test_ui_restart(bool banded)
+{
+    display_deinit();
+    
+    display_config_t config = { .type = DISPLAY_TYPE_HOST, .host.banded = banded };
+    TEST_ASSERT_EQUAL(ESP_OK, display_init(&config));
+    s_display_started = true;
+    s_display_banded = banded;
+    s_virtual_time = false;
+    TEST_ASSERT_EQUAL(ESP_OK, ui_init());
+}
+
+void test_ui_start(void)
+{
+    if (!s_display_started || s_display_banded) {
+        test_ui_restart(false);
+        return;
+    }
+    s_virtual_time = false;
+    TEST_ASSERT_EQUAL(ESP_OK, ui_init());
+}
+
+void test_ui_frame(uint8_t *out)
+{
+    display_stats_t stats;
+    
+    ui_render();
+    for (;;) {
+        display_get_stats(&stats);
+        if (stats.done == stats.queued) break;
+        vTaskDelay(1);
+    }
+    memcpy(out, display_host_framebuffer(), TEST_FRAME_SIZE);
+}
+
+void test_time_freeze(void)
+{
+    s_virtual_time = true;
+}
+
+void test_time_advance(uint32_t ms)
+{
+    s_virtual_us += (int64_t)ms * 1000;
+}
+
+uint64_t test_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+void app_main(void)
+{
+    UNITY_BEGIN();
+    unity_run_all_tests();
+    exit(UNITY_END());
+}
@@ -0,0 +1,237 @@
+/**
+ * @file test_notify.c
+ * @brief Notification queue: priority order, coalescing, eviction
+ *
+ * Every notification gets its own on_tap, and the queue is drained by
+ * letting the shown one slide in and tapping it, so the taps record the
+ * order notifications reached the screen. The UI runs on the virtual
+ * clock, in steps far enough apart for the per-second rate limit and
+ * short enough that nothing times out before it is tapped.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "unity.h"
+#include "test_ui.h"
+
+#define DRAIN_STEP_MS       500
+#define SLIDE_IN_MS         250         /* Past ui.c's 200 ms slide-in */
+
+static int s_tapped[32];
+static int s_tap_count;
+
+#define TAP_FN(n)   static void tap_##n(void) { s_tapped[s_tap_count++] = n; }
+TAP_FN(0) TAP_FN(1) TAP_FN(2) TAP_FN(3) TAP_FN(4) TAP_FN(5)
+TAP_FN(6) TAP_FN(7) TAP_FN(8) TAP_FN(9) TAP_FN(10) TAP_FN(11)
+
+static void (*const s_taps[])(void) = {
+    tap_0, tap_1, tap_2, tap_3, tap_4, tap_5, tap_6, tap_7, tap_8, tap_9, tap_10, tap_11,
+};
+
+/* Holds the screen under the notifications; ignores the taps that reach it */
+static void blank_render(void)
+{
+    display_draw_text(2, 20, "Under", DISPLAY_FONT_PROP, COLOR_WHITE);
+}
+
+static void blank_input(int8_t x, int8_t y, uint8_t buttons)
+{
+}
+
+static const ui_app_t s_blank_app = {
+    .id = "blank",
+    .name = "Blank",
+    .on_render = blank_render,
+    .on_input = blank_input,
+};
+
+static void start_notify(void)
+{
+    test_ui_start();
+    test_time_freeze();
+    TEST_ASSERT_EQUAL(ESP_OK, ui_register_app(&s_blank_app));
+    TEST_ASSERT_EQUAL(ESP_OK, ui_launch_app("blank"));
+    s_tap_count = 0;
+}
+
+static esp_err_t post(int tap, ui_notify_priority_t priority, const char *group,
+                      const char *title, const char *body)
+{
+    ui_notification_t notif = {
+        .title = title,
+        .body = body,
+        .priority = priority,
+        .on_tap = s_taps[tap],
+        .group = group,
+    };
+    return ui_notify(&notif);
+}
+
+/**
+ * @brief Let the next notification slide in, without tapping it
+ */
+static void show_next(void)
+{
+    test_time_advance(DRAIN_STEP_MS);
+    ui_tick(DRAIN_STEP_MS);
+    test_time_advance(SLIDE_IN_MS);
+    ui_tick(SLIDE_IN_MS);
+}
+
+/**
+ * @brief Tap whatever notification is shown
+ */
+static void tap(void)
+{
+    ui_input(0, 0, UI_BTN_PRESS);
+    ui_input(0, 0, 0);
+}
+
+/**
+ * @brief Show and tap notifications until none is shown or waiting
+ * @return Number of notifications tapped
+ */
+static int drain(void)
+{
+    ui_notify_stats_t stats;
+    int before = s_tap_count;
+    
+    for (int i = 0; i < 4 * UI_NOTIFY_QUEUE_LEN; i++) {
+        int taps = s_tap_count;
+        show_next();
+        tap();
+        ui_get_notify_stats(&stats);
+        if (s_tap_count == taps && stats.pending == 0) break;
+    }
+    return s_tap_count - before;
+}
+
+/**
+ * @brief Render with the unread count cleared, so only the notification differs
+ */
+static void capture(uint8_t *out)
+{
+    ui_status_t status = *ui_get_status();
+    status.unread_notifications = 0;
+    ui_update_status(&status);
+    test_ui_frame(out);
+}
+
+static void assert_taps(const int *expected, int count)
+{
+    char msg[24];
+    
+    TEST_ASSERT_EQUAL(count, s_tap_count);
+    for (int i = 0; i < count; i++) {
+        snprintf(msg, sizeof(msg), "shown %d", i);
+        TEST_ASSERT_EQUAL_MESSAGE(expected[i], s_tapped[i], msg);
+    }
+}
+
+TEST_CASE("notifications are shown highest priority first, oldest first within one", "[ui]")
+{
+    ui_notify_stats_t stats;
+    
+    start_notify();
+    TEST_ASSERT_EQUAL(ESP_OK, post(0, UI_NOTIFY_LOW, NULL, "low a", NULL));
+    TEST_ASSERT_EQUAL(ESP_OK, post(1, UI_NOTIFY_NORMAL, NULL, "normal b", NULL));
+    TEST_ASSERT_EQUAL(ESP_OK, post(2, UI_NOTIFY_HIGH, NULL, "high c", NULL));
+    TEST_ASSERT_EQUAL(ESP_OK, post(3, UI_NOTIFY_NORMAL, NULL, "normal d", NULL));
+    TEST_ASSERT_EQUAL(ESP_OK, post(4, UI_NOTIFY_LOW, NULL, "low e", NULL));
+    TEST_ASSERT_EQUAL(ESP_OK, post(5, UI_NOTIFY_HIGH, NULL, "high f", NULL));
+    ui_get_notify_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(6, stats.pending);
+    
+    TEST_ASSERT_EQUAL(6, drain());
+    assert_taps((const int[]){ 2, 5, 1, 3, 0, 4 }, 6);
+    
+    ui_get_notify_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(6, stats.posted);
+    TEST_ASSERT_EQUAL_UINT32(6, stats.shown);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.coalesced);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.pending);
+    
+    /* One that arrives while a lower one is shown waits its turn */
+    TEST_ASSERT_EQUAL(ESP_OK, post(6, UI_NOTIFY_LOW, NULL, "low g", NULL));
+    show_next();
+    TEST_ASSERT_EQUAL(ESP_OK, post(7, UI_NOTIFY_HIGH, NULL, "high h", NULL));
+    tap();
+    TEST_ASSERT_EQUAL(1, drain());
+    assert_taps((const int[]){ 2, 5, 1, 3, 0, 4, 6, 7 }, 8);
+}
+
+TEST_CASE("notifications from one mesh sender coalesce", "[ui]")
+{
+    static uint8_t merged[TEST_FRAME_SIZE], single[TEST_FRAME_SIZE];
+    ui_notify_stats_t stats;
+    
+    start_notify();
+    
+    /* A burst from node 7 with one from node 9 in between */
+    TEST_ASSERT_EQUAL(ESP_OK, post(0, UI_NOTIFY_NORMAL, "!a1b2c3d7", "Alice", "msg 1"));
+    TEST_ASSERT_EQUAL(ESP_OK, post(1, UI_NOTIFY_NORMAL, "!a1b2c3d7", "Alice", "msg 2"));
+    TEST_ASSERT_EQUAL(ESP_OK, post(2, UI_NOTIFY_NORMAL, "!a1b2c3d9", "Bob", "hi"));
+    TEST_ASSERT_EQUAL(ESP_OK, post(3, UI_NOTIFY_NORMAL, "!a1b2c3d7", "Alice", "msg 3"));
+    TEST_ASSERT_EQUAL(ESP_OK, post(4, UI_NOTIFY_NORMAL, "!a1b2c3d7", "Alice W.", "msg 4"));
+    ui_get_notify_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(5, stats.posted);
+    TEST_ASSERT_EQUAL_UINT32(3, stats.coalesced);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.pending);
+    
+    /* Node 7 keeps its first place in line, with the newest text */
+    show_next();
+    capture(merged);
+    
+    /* More from node 7 while it is shown: merged into it, no new slide-in */
+    TEST_ASSERT_EQUAL(ESP_OK, post(5, UI_NOTIFY_NORMAL, "!a1b2c3d7", "Alice", "msg 5"));
+    show_next();
+    ui_get_notify_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.shown);
+    TEST_ASSERT_EQUAL_UINT32(4, stats.coalesced);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.pending);
+    
+    TEST_ASSERT_EQUAL(2, drain());
+    assert_taps((const int[]){ 5, 2 }, 2);
+    
+    /* The merged one looked like a single "4 msgs from" with the newest title */
+    TEST_ASSERT_EQUAL(ESP_OK, post(6, UI_NOTIFY_NORMAL, NULL, "4 msgs from Alice W.", "msg 4"));
+    show_next();
+    capture(single);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(single, merged, TEST_FRAME_SIZE);
+    tap();
+}
+
+TEST_CASE("a full notification queue evicts the oldest of the lowest priority", "[ui]")
+{
+    ui_notify_stats_t stats;
+    char group[8];
+    
+    start_notify();
+    for (int i = 0; i < UI_NOTIFY_QUEUE_LEN; i++) {
+        snprintf(group, sizeof(group), "node %d", i);
+        TEST_ASSERT_EQUAL(ESP_OK, post(i, UI_NOTIFY_NORMAL, group, group, NULL));
+    }
+    
+    /* Ranks below everything waiting: refused */
+    TEST_ASSERT_EQUAL(ESP_ERR_NO_MEM, post(8, UI_NOTIFY_LOW, NULL, "low", NULL));
+    ui_get_notify_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.dropped);
+    TEST_ASSERT_EQUAL_UINT32(UI_NOTIFY_QUEUE_LEN, stats.pending);
+    
+    /* Higher, then equal: each pushes out the oldest normal one */
+    TEST_ASSERT_EQUAL(ESP_OK, post(9, UI_NOTIFY_HIGH, NULL, "high", NULL));
+    TEST_ASSERT_EQUAL(ESP_OK, post(10, UI_NOTIFY_NORMAL, "node 10", "node 10", NULL));
+    ui_get_notify_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(3, stats.dropped);
+    TEST_ASSERT_EQUAL_UINT32(UI_NOTIFY_QUEUE_LEN, stats.pending);
+    
+    /* A sender already waiting still merges into the full queue */
+    TEST_ASSERT_EQUAL(ESP_OK, post(11, UI_NOTIFY_NORMAL, "node 5", "node 5", NULL));
+    ui_get_notify_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(3, stats.dropped);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.coalesced);
+    TEST_ASSERT_EQUAL_UINT32(UI_NOTIFY_QUEUE_LEN, stats.pending);
+    
+    TEST_ASSERT_EQUAL(UI_NOTIFY_QUEUE_LEN, drain());
+    assert_taps((const int[]){ 9, 2, 3, 4, 11, 6, 7, 10 }, UI_NOTIFY_QUEUE_LEN);
+}
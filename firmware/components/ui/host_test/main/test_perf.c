@@ -0,0 +1,194 @@
+/**
+ * @file test_perf.c
+ * @brief Frame-time histograms and the cost of the probes
+ *
+ * Bucket edges and percentiles are checked against the layout ui_perf.h
+ * documents. The benchmark drives frames and input through a busy app and
+ * prints their cost; it runs in either build, so building a second time
+ * with sdkconfig.perf_off (see CMakeLists.txt) gives the figures without
+ * the probes to set against these.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "unity.h"
+#include "test_ui.h"
+#include "ui_perf.h"
+#include "sdkconfig.h"
+
+#define BENCH_RUNS          5
+#define BENCH_FRAMES        500
+
+#if CONFIG_UI_PERF
+#define PROBES              "on"
+#else
+#define PROBES              "off"
+#endif
+
+/**
+ * @brief Histogram with `count` samples of each given value, as hist_add() would fill it
+ */
+static void fill_hist(ui_perf_hist_t *h, const uint32_t *us, const uint32_t *count, int n)
+{
+    memset(h, 0, sizeof(*h));
+    for (int i = 0; i < n; i++) {
+        uint32_t q = us[i] >> 2;
+        int bucket = q ? 32 - __builtin_clz(q) : 0;
+        if (bucket >= UI_PERF_BUCKETS) bucket = UI_PERF_BUCKETS - 1;
+        h->count += count[i];
+        h->total_us += (uint64_t)us[i] * count[i];
+        h->buckets[bucket] += count[i];
+        if (count[i] && us[i] > h->max_us) h->max_us = us[i];
+    }
+}
+
+TEST_CASE("perf percentile is the upper edge of the bucket holding it", "[ui]")
+{
+    ui_perf_hist_t h;
+    
+    memset(&h, 0, sizeof(h));
+    TEST_ASSERT_EQUAL_UINT32(0, ui_perf_percentile(&h, 95));
+    TEST_ASSERT_EQUAL_UINT32(0, ui_perf_percentile(NULL, 95));
+    
+    /* 94 samples in [8, 16) and 6 in [512, 1024): p94 is the first bucket's edge */
+    fill_hist(&h, (const uint32_t[]){ 10, 1000 }, (const uint32_t[]){ 94, 6 }, 2);
+    TEST_ASSERT_EQUAL_UINT32(16, ui_perf_percentile(&h, 50));
+    TEST_ASSERT_EQUAL_UINT32(16, ui_perf_percentile(&h, 94));
+    /* p95 is in the second, capped at the longest sample */
+    TEST_ASSERT_EQUAL_UINT32(1000, ui_perf_percentile(&h, 95));
+    TEST_ASSERT_EQUAL_UINT32(1000, ui_perf_percentile(&h, 100));
+    
+    /* Rounds up: with 19 samples p95 needs all 19, not 18 */
+    fill_hist(&h, (const uint32_t[]){ 2, 600 }, (const uint32_t[]){ 18, 1 }, 2);
+    TEST_ASSERT_EQUAL_UINT32(4, ui_perf_percentile(&h, 90));
+    TEST_ASSERT_EQUAL_UINT32(600, ui_perf_percentile(&h, 95));
+    
+    /* The open last bucket reports the longest sample */
+    fill_hist(&h, (const uint32_t[]){ 5, 70000, 250000 }, (const uint32_t[]){ 95, 4, 1 }, 3);
+    TEST_ASSERT_EQUAL_UINT32(8, ui_perf_percentile(&h, 95));
+    TEST_ASSERT_EQUAL_UINT32(250000, ui_perf_percentile(&h, 96));
+    TEST_ASSERT_EQUAL_UINT32(250000, ui_perf_percentile(&h, 99));
+}
+
+TEST_CASE("perf samples land in power-of-two buckets", "[ui]")
+{
+    ui_perf_hist_t h;
+    char msg[40];
+    
+    test_ui_start();
+    ui_perf_reset();
+#if CONFIG_UI_PERF
+    /* Bucket 0 is [0, 4), the last one [65536, ...), bucket i between is [2^(i+1), 2^(i+2)) */
+    for (int i = 0; i < UI_PERF_BUCKETS; i++) {
+        uint32_t low = i == 0 ? 0 : 2u << i;
+        uint32_t high = i == UI_PERF_BUCKETS - 1 ? UINT32_MAX : (4u << i) - 1;
+        ui_perf_reset();
+        ui_perf_sample(UI_PERF_CAPTURE_RX, low);
+        ui_perf_sample(UI_PERF_CAPTURE_RX, high);
+        TEST_ASSERT_TRUE(ui_perf_get(UI_PERF_CAPTURE_RX, &h));
+        
+        snprintf(msg, sizeof(msg), "bucket %d [%lu, %lu]", i, (unsigned long)low, (unsigned long)high);
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(2, h.count, msg);
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(2, h.buckets[i], msg);
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(high, h.max_us, msg);
+        TEST_ASSERT_EQUAL_MESSAGE((uint64_t)low + high, h.total_us, msg);
+    }
+    
+    /* Only the sampled probe moves, and out-of-range probes are refused */
+    TEST_ASSERT_TRUE(ui_perf_get(UI_PERF_CAPTURE_SHOWN, &h));
+    TEST_ASSERT_EQUAL_UINT32(0, h.count);
+    TEST_ASSERT_FALSE(ui_perf_get(UI_PERF_PROBE_COUNT, &h));
+    ui_perf_reset();
+    TEST_ASSERT_TRUE(ui_perf_get(UI_PERF_CAPTURE_RX, &h));
+    TEST_ASSERT_EQUAL_UINT32(0, h.count);
+#else
+    ui_perf_sample(UI_PERF_CAPTURE_RX, 100);
+    TEST_ASSERT_FALSE(ui_perf_get(UI_PERF_CAPTURE_RX, &h));
+    (void)msg;
+#endif
+}
+
+/* ============================================================================
+ * Benchmark
+ * ============================================================================ */
+
+static int s_bench_x;
+
+/* Enough drawing that a frame is not just the probes */
+static void bench_render(void)
+{
+    char line[24];
+    
+    for (int i = 0; i < 5; i++) {
+        snprintf(line, sizeof(line), "row %d x=%d", i, s_bench_x);
+        display_draw_text(2, 2 + i * 10, line, DISPLAY_FONT_PROP, COLOR_WHITE);
+    }
+    display_fill_circle(100 + s_bench_x % 16, 40, 12, COLOR_INVERSE);
+}
+
+static void bench_input(int8_t x, int8_t y, uint8_t buttons)
+{
+    s_bench_x += x;
+    ui_invalidate();
+}
+
+static const ui_app_t s_bench_app = {
+    .id = "bench",
+    .name = "Bench",
+    .on_render = bench_render,
+    .on_input = bench_input,
+};
+
+TEST_CASE("frame and input cost benchmark", "[ui][bench]")
+{
+    ui_input_stats_t input_before, input_after;
+    uint64_t best_input = UINT64_MAX, best_frame = UINT64_MAX;
+    
+    test_ui_start();
+    TEST_ASSERT_EQUAL(ESP_OK, ui_register_app(&s_bench_app));
+    TEST_ASSERT_EQUAL(ESP_OK, ui_launch_app("bench"));
+    ui_render();
+    ui_perf_reset();
+    s_bench_x = 0;
+    ui_get_input_stats(&input_before);
+    
+    /* Best of several runs, as the panel's flush task shares the host's CPU */
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        uint64_t input_ns = 0, frame_ns = 0;
+        for (int i = 0; i < BENCH_FRAMES; i++) {
+            /* Alternating PRESS and DOUBLE, so every report is a button event */
+            TEST_ASSERT_TRUE(ui_post_input(1, 0, i & 1 ? UI_BTN_DOUBLE : UI_BTN_PRESS));
+            uint64_t t0 = test_now_ns();
+            ui_process_input();
+            uint64_t t1 = test_now_ns();
+            ui_render();
+            uint64_t t2 = test_now_ns();
+            input_ns += t1 - t0;
+            frame_ns += t2 - t1;
+        }
+        if (input_ns < best_input) best_input = input_ns;
+        if (frame_ns < best_frame) best_frame = frame_ns;
+    }
+    ui_get_input_stats(&input_after);
+    TEST_ASSERT_EQUAL_UINT32(0, input_after.dropped - input_before.dropped);
+    TEST_ASSERT_EQUAL(BENCH_RUNS * BENCH_FRAMES, s_bench_x);
+    
+    printf("\nUI cost per frame, best of %d runs of %d frames\n", BENCH_RUNS, BENCH_FRAMES);
+    printf("%-8s %12s %12s\n", "probes", "input ns", "frame ns");
+    printf("%-8s %12.0f %12.0f\n", PROBES,
+           (double)best_input / BENCH_FRAMES, (double)best_frame / BENCH_FRAMES);
+
+#if CONFIG_UI_PERF
+    /* One sample per frame and per delivery, the app's own included */
+    ui_perf_hist_t input, frame, app;
+    TEST_ASSERT_TRUE(ui_perf_get(UI_PERF_INPUT, &input));
+    TEST_ASSERT_TRUE(ui_perf_get(UI_PERF_FRAME, &frame));
+    TEST_ASSERT_TRUE(ui_perf_get_app(0, &app));
+    TEST_ASSERT_EQUAL_UINT32(BENCH_RUNS * BENCH_FRAMES, input.count);
+    TEST_ASSERT_EQUAL_UINT32(BENCH_RUNS * BENCH_FRAMES, frame.count);
+    TEST_ASSERT_EQUAL_UINT32(BENCH_RUNS * BENCH_FRAMES, app.count);
+    printf("p95 from the histograms: input %lu us, app %lu us, frame %lu us\n",
+           (unsigned long)ui_perf_percentile(&input, 95), (unsigned long)ui_perf_percentile(&app, 95),
+           (unsigned long)ui_perf_percentile(&frame, 95));
+#endif
+}
@@ -0,0 +1,48 @@
+/**
+ * @file test_ui.h
+ * @brief Shared helpers for the UI host tests
+ */
+
+#pragma once
+
+#include "display.h"
+#include "ui.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TEST_FRAME_SIZE     (DISPLAY_WIDTH * DISPLAY_HEIGHT / 8)
+
+/**
+ * @brief Bring up the full-frame host display (once) and a fresh UI with no apps
+ *
+ * Also puts the UI back on the real clock.
+ */
+void test_ui_start(void);
+
+/**
+ * @brief Restart the host display, banded or full-frame, and a fresh UI
+ */
+void test_ui_restart(bool banded);
+
+/**
+ * @brief Render a frame and copy the panel once it has been sent
+ * @param out TEST_FRAME_SIZE bytes
+ */
+void test_ui_frame(uint8_t *out);
+
+/**
+ * @brief Run the UI on a virtual clock that moves only with test_time_advance()
+ *
+ * Until the next test_ui_start() or test_ui_restart().
+ */
+void test_time_freeze(void);
+
+/**
+ * @brief Move the virtual clock forward
+ */
+void test_time_advance(uint32_t ms);
+
+/**
+ * @brief Monotonic time in nanoseconds, for benchmarks
+ */
+uint64_t test_now_ns(void);
@@ -6,6 +6,7 @@
 #pragma once
 
 #include "esp_err.h"
+#include "display.h"
 #include <stdint.h>
 #include <stdbool.h>
 #include <stddef.h>
@@ -23,7 +24,16 @@ extern "C" {
 #define UI_ICON_WIDTH           16
 #define UI_ICON_HEIGHT          16
 #define UI_STATUS_BAR_HEIGHT    10
+#define UI_CONTENT_HEIGHT       (DISPLAY_HEIGHT - UI_STATUS_BAR_HEIGHT)  /* App viewport, below the status bar */
 #define UI_NOTIFY_HEIGHT        12
+#define UI_ANIM_FRAME_MS        33      /* Redraw period while something animates */
+#define UI_INPUT_QUEUE_LEN      32      /* Button events ui_post_input() can hold, power of two */
+#define UI_INPUT_TRACE_LEN      4       /* Traced inputs waiting for one frame to be shown */
+#define UI_NOTIFY_QUEUE_LEN     8       /* Notifications waiting to be shown */
+#define UI_NOTIFY_TITLE_LEN     24      /* Bytes kept of a title, terminator included */
+#define UI_NOTIFY_BODY_LEN      40      /* Bytes kept of a body, terminator included */
+#define UI_NOTIFY_PER_SEC       2       /* Notification animations started per second, at most */
+#define UI_NOTIFY_BUSY_MS       1500    /* Longest a notification stays up while others wait */
 
 /* Button bit masks (from joystick) */
 #define UI_BTN_PRESS            0x01
@@ -42,12 +52,16 @@ extern "C" {
 typedef struct {
     const char *id;                 /**< Unique app identifier */
     const char *name;               /**< Display name */
-    const uint8_t *icon;            /**< 16x16 bitmap icon (NULL for default) */
+    const uint8_t *icon;            /**< 16x16 packed bitmap icon (NULL for default) */
+    const display_sprite_t *sprite; /**< 16x16 page-format icon, preferred over icon */
     void (*on_enter)(void);         /**< Called when app becomes active */
     void (*on_exit)(void);          /**< Called when app is deactivated */
     void (*on_input)(int8_t x, int8_t y, uint8_t buttons);  /**< Input handler */
-    void (*on_render)(void);        /**< Render handler (called each frame) */
-    void (*on_tick)(uint32_t dt_ms); /**< Background tick (even when not focused) */
+    void (*on_render)(void);        /**< Render handler (called when the app's picture is redrawn, see ui_invalidate()); draws in a viewport whose (0, 0) is just below the status bar */
+    void (*on_tick)(uint32_t dt_ms); /**< Background tick (even when not focused), see ui_schedule_tick() */
+    bool tick_every_frame;          /**< Call on_tick from every ui_tick() instead of on schedule */
+    size_t state_size;              /**< Bytes of working state the UI allocates for the app, see ui_app_state() */
+    void (*on_evict)(void *state);  /**< Called before the app's state is freed (optional) */
 } ui_app_t;
 
 /**
@@ -87,8 +101,20 @@ typedef struct {
     ui_notify_priority_t priority;
     uint32_t duration_ms;           /**< 0 = default (3000ms) */
     void (*on_tap)(void);           /**< Optional tap callback */
+    const char *group;              /**< Coalescing key (e.g. the sender's ID), NULL or "" = none */
 } ui_notification_t;
 
+/**
+ * @brief Notification queue counters
+ */
+typedef struct {
+    uint32_t posted;                /**< Calls to ui_notify() that were accepted */
+    uint32_t coalesced;             /**< Merged into a notification of the same group */
+    uint32_t dropped;               /**< Lost to a full queue of equal or higher priority */
+    uint32_t shown;                 /**< Notifications that slid in */
+    uint32_t pending;               /**< Waiting now */
+} ui_notify_stats_t;
+
 /**
  * @brief Dialog button
  */
@@ -138,6 +164,52 @@ typedef struct {
     uint8_t minute;
 } ui_status_t;
 
+/**
+ * @brief Frame timing
+ */
+typedef struct {
+    uint32_t frames;                /**< Frames rendered since init */
+    uint32_t frames_per_minute;     /**< Frames rendered in the last full minute */
+    uint32_t render_us;             /**< Time spent drawing the last frame */
+    uint32_t flush_us;              /**< Time the display took to send the last completed frame */
+} ui_frame_stats_t;
+
+/**
+ * @brief Input queue counters
+ */
+typedef struct {
+    uint32_t posted;                /**< Calls to ui_post_input() */
+    uint32_t coalesced;             /**< Axis updates replaced by a newer one before delivery */
+    uint32_t dropped;               /**< Button events lost to a full queue */
+    uint32_t depth;                 /**< Button events waiting now */
+    uint32_t max_depth;             /**< Most button events ever waiting */
+} ui_input_stats_t;
+
+/**
+ * @brief Called when a traced input has reached the panel
+ *
+ * Runs on the UI task once the transfer of the first frame drawn after the
+ * input was delivered has finished. Times are esp_timer microseconds,
+ * truncated to 32 bits.
+ * @param tag Tag given to ui_post_input_traced()
+ * @param input_us When the input handlers ran
+ * @param shown_us When the frame's transfer finished
+ */
+typedef void (*ui_input_trace_fn_t)(uint32_t tag, uint32_t input_us, uint32_t shown_us);
+
+/**
+ * @brief App state memory counters
+ */
+typedef struct {
+    uint32_t budget;                /**< Most bytes of app state resident at once (CONFIG_UI_APP_MEM_BUDGET) */
+    uint32_t resident;              /**< Bytes of app state allocated now */
+    uint32_t peak;                  /**< Most bytes ever allocated */
+    uint32_t warm;                  /**< Closed apps whose state is kept */
+    uint32_t hits;                  /**< Launches that found their state still warm */
+    uint32_t evictions;             /**< States freed to make room or past the warm limit */
+    uint32_t failures;              /**< Launches refused for lack of memory */
+} ui_app_mem_stats_t;
+
 /* ============================================================================
  * Core API
  * ============================================================================ */
@@ -165,8 +237,15 @@ size_t ui_get_apps(const ui_app_t **apps, size_t max_apps);
 
 /**
  * @brief Launch an app by ID
+ *
+ * An app with a state_size gets its state before on_enter: the one it
+ * left warm, or a new zeroed one. Closed apps stay warm, up to
+ * CONFIG_UI_APP_WARM_APPS of them; the least recently used are evicted
+ * to stay within CONFIG_UI_APP_MEM_BUDGET.
+ *
  * @param app_id App identifier
- * @return ESP_OK on success
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND, or ESP_ERR_NO_MEM if the
+ *         scene stack is full or the state does not fit
  */
 esp_err_t ui_launch_app(const char *app_id);
 
@@ -175,13 +254,49 @@ esp_err_t ui_launch_app(const char *app_id);
  */
 void ui_go_back(void);
 
+/**
+ * @brief Get an app's state
+ *
+ * Zeroed when new, kept as the app left it while warm. Valid from on_enter
+ * until on_evict: apps usually keep the pointer from on_enter and drop it
+ * in on_evict. Their input and render callbacks only run while they are
+ * open, but on_tick may run after eviction, so background work keeps what
+ * it needs elsewhere.
+ *
+ * @return The state, or NULL if the app has none resident
+ */
+void *ui_app_state(const ui_app_t *app);
+
+/**
+ * @brief Bytes of state resident for one app
+ * @param app Index in registration order, as returned by ui_get_apps()
+ */
+size_t ui_get_app_resident(size_t app);
+
+/**
+ * @brief Get app state memory counters
+ */
+void ui_get_app_mem_stats(ui_app_mem_stats_t *stats);
+
 /**
  * @brief Go directly to main menu
  */
 void ui_go_home(void);
 
+/**
+ * @brief Check whether an app is the scene on screen
+ *
+ * Still true under a dialog or the keyboard. Background ticks use it to
+ * skip ui_invalidate() for apps nobody is looking at; launching an app
+ * redraws it anyway.
+ */
+bool ui_is_app_focused(const ui_app_t *app);
+
 /**
  * @brief Process joystick input
+ *
+ * Runs the input handlers right away, so call it from the UI task only.
+ * Other tasks use ui_post_input().
  * @param x X-axis (-100 to 100)
  * @param y Y-axis (-100 to 100)
  * @param buttons Button bitmask
@@ -189,17 +304,108 @@ void ui_go_home(void);
 void ui_input(int8_t x, int8_t y, uint8_t buttons);
 
 /**
- * @brief Render current frame
- * Call this from your display task at desired FPS
+ * @brief Queue joystick input for the UI task
+ *
+ * Lock-free and never blocks; meant for exactly one producer task (the
+ * BLE host). Reports whose buttons differ from the previous one are queued
+ * in order; axis-only reports replace any axis report not yet delivered.
+ * Wakes the UI task.
+ * @return false if the queue was full and a button event was dropped
+ */
+bool ui_post_input(int8_t x, int8_t y, uint8_t buttons);
+
+/**
+ * @brief Queue joystick input and report when it is on screen
+ *
+ * Like ui_post_input(). A non-zero tag is handed to the trace callback
+ * once a frame drawn after the input has been delivered reaches the panel.
+ * An axis report replaced before delivery is not reported, and neither is
+ * anything beyond UI_INPUT_TRACE_LEN inputs delivered within one frame.
+ * @param tag Caller's identifier for the report, 0 = do not trace
+ * @return false if the queue was full and a button event was dropped
+ */
+bool ui_post_input_traced(int8_t x, int8_t y, uint8_t buttons, uint32_t tag);
+
+/**
+ * @brief Set the callback for traced inputs
+ * @param fn Callback, NULL to stop tracing
+ */
+void ui_set_input_trace(ui_input_trace_fn_t fn);
+
+/**
+ * @brief Deliver queued input to the input handlers, in order
+ *
+ * Call from the UI task at the start of each frame.
+ */
+void ui_process_input(void);
+
+/**
+ * @brief Get input queue counters
+ */
+void ui_get_input_stats(ui_input_stats_t *stats);
+
+/**
+ * @brief Render current frame unconditionally
  */
 void ui_render(void);
 
 /**
- * @brief Background tick for all apps
- * @param dt_ms Milliseconds since last tick
+ * @brief Request a redraw, on_render of the focused app included
+ *
+ * The app's last picture is kept and the status bar, notifications,
+ * dialogs and the keyboard are drawn over it, so on_render runs only when
+ * the picture may have changed: after input to the app, a scene or status
+ * change, a dialog or keyboard closing, or this call. Apps call it when
+ * what they show changes otherwise (a timer, data from another task). Safe
+ * from any task, not from ISRs.
+ */
+void ui_invalidate(void);
+
+/**
+ * @brief Render a frame if anything changed since the last one
+ * @return true if a frame was rendered
+ */
+bool ui_render_if_needed(void);
+
+/**
+ * @brief Sleep the calling task until the UI needs it
+ *
+ * Returns at once if a redraw is pending, otherwise on ui_invalidate(),
+ * the next notification animation step or dismissal, the next scheduled
+ * app tick, or after max_ms, whichever comes first. Meant for the task that calls ui_tick() and
+ * ui_render_if_needed().
+ */
+void ui_wait(uint32_t max_ms);
+
+/**
+ * @brief Run the background ticks that are due
+ *
+ * Calls on_tick of every app whose scheduled tick has come, and of every
+ * app with tick_every_frame set.
+ *
+ * @param dt_ms Milliseconds since last tick, passed to tick_every_frame apps
  */
 void ui_tick(uint32_t dt_ms);
 
+/**
+ * @brief Schedule an app's next background tick
+ *
+ * on_tick is called once, delay_ms from now, with the milliseconds since
+ * the app's previous tick (or since it was scheduled, if it was idle). Apps
+ * that want to keep ticking schedule again from on_tick. A tick already
+ * pending is moved. UI task only.
+ *
+ * @param app Registered app
+ * @param delay_ms Milliseconds from now
+ * @return ESP_OK, or ESP_ERR_NOT_FOUND if the app is not registered
+ */
+esp_err_t ui_schedule_tick(const ui_app_t *app, uint32_t delay_ms);
+
+/**
+ * @brief Drop an app's pending background tick, if any
+ */
+void ui_cancel_tick(const ui_app_t *app);
+
 /**
  * @brief Update system status
  * @param status New status values
@@ -211,14 +417,31 @@ void ui_update_status(const ui_status_t *status);
  */
 const ui_status_t *ui_get_status(void);
 
+/**
+ * @brief Get frame timing
+ * @param stats Output
+ */
+void ui_get_frame_stats(ui_frame_stats_t *stats);
+
 /* ============================================================================
  * Notification API
  * ============================================================================ */
 
 /**
- * @brief Show a notification
+ * @brief Queue a notification
+ *
+ * Title and body are copied (truncated to UI_NOTIFY_TITLE_LEN and
+ * UI_NOTIFY_BODY_LEN bytes), so they may live on the caller's stack.
+ * Waiting notifications are shown highest priority first, oldest first
+ * within a priority, and at most UI_NOTIFY_PER_SEC start per second.
+ * One that arrives while another of the same group waits or is shown is
+ * merged into it: the newest text is kept and the title reads
+ * "N msgs from <title>". When the queue is full the oldest of the lowest
+ * priority is dropped, unless the new one ranks below it. Safe from any
+ * task, not from ISRs.
  * @param notif Notification to display
- * @return ESP_OK on success
+ * @return ESP_OK, ESP_ERR_INVALID_ARG without a title, or ESP_ERR_NO_MEM
+ *         if it was dropped
  */
 esp_err_t ui_notify(const ui_notification_t *notif);
 
@@ -230,9 +453,16 @@ void ui_notify_simple(const char *text);
 
 /**
  * @brief Dismiss current notification
+ *
+ * The next waiting one, if any, is shown once the rate limit allows.
  */
 void ui_notify_dismiss(void);
 
+/**
+ * @brief Get notification queue counters
+ */
+void ui_get_notify_stats(ui_notify_stats_t *stats);
+
 /* ============================================================================
  * Dialog API
  * ============================================================================ */
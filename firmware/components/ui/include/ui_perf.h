@@ -0,0 +1,126 @@
+/**
+ * @file ui_perf.h
+ * @brief Frame-time instrumentation
+ *
+ * The UI times the parts of each frame and keeps a histogram per probe:
+ * input handling, the focused app's on_render (also kept per app), the
+ * overlays drawn over it, the whole frame and the panel transfer. Input,
+ * app and overlay times are taken with the CPU cycle counter (a nanosecond
+ * clock on Linux builds); frame and transfer times come from the existing
+ * frame and display statistics.
+ *
+ * Joystick input latency is kept in stages, fed by the control link when
+ * a traced input reaches the panel (see ui_post_input_traced()): partner
+ * capture to arrival over BLE, arrival to the input handlers, handlers to
+ * the panel, and the whole way. Stages starting at the partner need its
+ * clock offset estimate and are skipped until it has one.
+ *
+ * Histogram buckets double in width: bucket 0 holds samples under 4 us,
+ * bucket i (0 < i < UI_PERF_BUCKETS - 1) holds [2^(i+1), 2^(i+2)) us and
+ * the last bucket everything from 2^16 us (65 ms) up.
+ *
+ * Enabled with CONFIG_UI_PERF. Without it the probes compile to nothing,
+ * ui_perf_get() returns false and ui_perf_dump_csv() prints nothing.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define UI_PERF_BUCKETS         16
+
+/**
+ * @brief Timed parts of a frame
+ */
+typedef enum {
+    UI_PERF_INPUT,                  /**< ui_process_input() when it delivered anything */
+    UI_PERF_APP_RENDER,             /**< Focused app's on_render, any app */
+    UI_PERF_OVERLAY,                /**< Status bar, dialog, keyboard and notification */
+    UI_PERF_FRAME,                  /**< Drawing a whole frame (ui_frame_stats_t.render_us) */
+    UI_PERF_REFRESH,                /**< Sending a frame to the panel */
+    UI_PERF_CAPTURE_RX,             /**< Partner sampling a joystick report to its arrival here */
+    UI_PERF_RX_INPUT,               /**< Its arrival to the input handlers */
+    UI_PERF_INPUT_SHOWN,            /**< Input handlers to the frame reaching the panel */
+    UI_PERF_CAPTURE_SHOWN,          /**< Partner sampling to the frame reaching the panel */
+    UI_PERF_PROBE_COUNT,
+} ui_perf_probe_t;
+
+/**
+ * @brief Event counters
+ */
+typedef enum {
+    UI_PERF_NOTIFICATIONS,          /**< Notifications shown */
+    UI_PERF_COUNTER_COUNT,
+} ui_perf_counter_t;
+
+/**
+ * @brief Histogram of one probe
+ */
+typedef struct {
+    uint32_t count;                 /**< Samples */
+    uint64_t total_us;              /**< Sum of all samples */
+    uint32_t max_us;                /**< Longest sample */
+    uint32_t buckets[UI_PERF_BUCKETS];
+} ui_perf_hist_t;
+
+/**
+ * @brief Add a sample timed outside the UI task's own probes
+ *
+ * Does nothing if instrumentation is compiled out.
+ */
+void ui_perf_sample(ui_perf_probe_t probe, uint32_t us);
+
+/**
+ * @brief Get a probe's histogram
+ * @return false if instrumentation is compiled out
+ */
+bool ui_perf_get(ui_perf_probe_t probe, ui_perf_hist_t *hist);
+
+/**
+ * @brief Get the on_render histogram of one app
+ * @param app Index in registration order, as returned by ui_get_apps()
+ * @return false if instrumentation is compiled out or there is no such app
+ */
+bool ui_perf_get_app(size_t app, ui_perf_hist_t *hist);
+
+/**
+ * @brief Get an event counter, 0 if instrumentation is compiled out
+ */
+uint32_t ui_perf_get_counter(ui_perf_counter_t counter);
+
+/**
+ * @brief Upper bound of the bucket holding the given percentile (us)
+ *
+ * 0 for an empty histogram. For the last bucket this is the longest sample.
+ */
+uint32_t ui_perf_percentile(const ui_perf_hist_t *hist, unsigned percent);
+
+/**
+ * @brief Clear all histograms and counters
+ */
+void ui_perf_reset(void);
+
+/**
+ * @brief Print all histograms and counters to the console UART as CSV
+ *
+ * One line per probe, app, app with a state and counter, all starting
+ * with "perf,":
+ *
+ *   perf,<probe>,<count>,<total_us>,<max_us>,<bucket 0>,...,<bucket 15>
+ *   perf,app:<id>,<count>,<total_us>,<max_us>,<bucket 0>,...,<bucket 15>
+ *   perf,mem:<id>,<resident bytes>
+ *   perf,counter,<name>,<value>
+ *
+ * Call from the UI task.
+ */
+void ui_perf_dump_csv(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,221 @@
+/**
+ * @file sprites.c
+ * @brief Sprite and icon atlas
+ *
+ * Single definition of every sprite declared in sprites.h, in the packed
+ * horizontal format (MSB = leftmost pixel). Each doc comment ends with the
+ * sprite size as (WxH); tools/sprite_pages.py reads this file at build time
+ * and emits the page-format SPRITE_* copies.
+ */
+
+#include "sprites.h"
+
+/* ============================================================================
+ * App Icons (16x16 pixels, 32 bytes each)
+ * ============================================================================ */
+
+/** Settings icon - gear shape (16x16) */
+const uint8_t ICON_SETTINGS[] = {
+    0x01, 0x80, 0x01, 0x80, 0x0F, 0xF0, 0x1F, 0xF8,
+    0x39, 0x9C, 0x71, 0x8E, 0xE1, 0x87, 0xE1, 0x87,
+    0xE1, 0x87, 0xE1, 0x87, 0x71, 0x8E, 0x39, 0x9C,
+    0x1F, 0xF8, 0x0F, 0xF0, 0x01, 0x80, 0x01, 0x80,
+};
+
+/** Notes icon - document with lines (16x16) */
+const uint8_t ICON_NOTES[] = {
+    0x3F, 0x80, 0x20, 0xC0, 0x20, 0xA0, 0x20, 0x90,
+    0x20, 0xF8, 0x20, 0x08, 0x2E, 0x08, 0x20, 0x08,
+    0x2E, 0x08, 0x20, 0x08, 0x2E, 0x08, 0x20, 0x08,
+    0x2E, 0x08, 0x20, 0x08, 0x3F, 0xF8, 0x00, 0x00,
+};
+
+/** Calendar icon - calendar grid (16x16) */
+const uint8_t ICON_CALENDAR[] = {
+    0x00, 0x00, 0x66, 0x66, 0xFF, 0xFF, 0x81, 0x81,
+    0xFF, 0xFF, 0x80, 0x01, 0xB6, 0xDB, 0x80, 0x01,
+    0xB6, 0xDB, 0x80, 0x01, 0xB6, 0xDB, 0x80, 0x01,
+    0xB6, 0xDB, 0x80, 0x01, 0xFF, 0xFF, 0x00, 0x00,
+};
+
+/** Mesh/Messages icon - speech bubble (16x16) */
+const uint8_t ICON_MESH[] = {
+    0x00, 0x00, 0x1F, 0xF8, 0x3F, 0xFC, 0x60, 0x06,
+    0x40, 0x02, 0x40, 0x02, 0x40, 0x02, 0x40, 0x02,
+    0x60, 0x06, 0x3F, 0xFC, 0x1F, 0xF8, 0x0C, 0x00,
+    0x06, 0x00, 0x03, 0x00, 0x01, 0x00, 0x00, 0x00,
+};
+
+/** Music icon - music note (16x16) */
+const uint8_t ICON_MUSIC[] = {
+    0x00, 0x00, 0x01, 0xFC, 0x01, 0xFC, 0x01, 0x04,
+    0x01, 0x04, 0x01, 0x04, 0x01, 0x04, 0x01, 0x04,
+    0x01, 0x00, 0x01, 0x00, 0x0F, 0x00, 0x1F, 0x00,
+    0x1F, 0x00, 0x1F, 0x00, 0x0E, 0x00, 0x00, 0x00,
+};
+
+/** Camera icon - camera shape (16x16) */
+const uint8_t ICON_CAMERA[] = {
+    0x00, 0x00, 0x07, 0xE0, 0x04, 0x20, 0x7F, 0xFE,
+    0xFF, 0xFF, 0xC0, 0x03, 0xC3, 0xC3, 0xC7, 0xE3,
+    0xCC, 0x33, 0xC8, 0x13, 0xC8, 0x13, 0xCC, 0x33,
+    0xC7, 0xE3, 0xC3, 0xC3, 0xFF, 0xFF, 0x00, 0x00,
+};
+
+/** Solitaire icon - playing card (16x16) */
+const uint8_t ICON_SOLITAIRE[] = {
+    0x3F, 0xFC, 0x20, 0x04, 0x20, 0x04, 0x21, 0x84,
+    0x23, 0xC4, 0x27, 0xE4, 0x23, 0xC4, 0x21, 0x84,
+    0x20, 0x04, 0x20, 0x04, 0x21, 0x84, 0x23, 0xC4,
+    0x27, 0xE4, 0x23, 0xC4, 0x21, 0x84, 0x3F, 0xFC,
+};
+
+/** Translate icon - speech bubbles with arrows (16x16) */
+const uint8_t ICON_TRANSLATE[] = {
+    0x1F, 0x80, 0x20, 0x40, 0x5F, 0x40, 0x40, 0x40,
+    0x5F, 0x40, 0x20, 0x40, 0x1B, 0x80, 0x00, 0xC0,
+    0x03, 0x00, 0x01, 0xD8, 0x02, 0x04, 0x02, 0xFA,
+    0x02, 0x02, 0x02, 0xFA, 0x02, 0x04, 0x01, 0xF8,
+};
+
+/** Email icon - envelope (16x16) */
+const uint8_t ICON_EMAIL[] = {
+    0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xC0, 0x03, 0xA0, 0x05, 0x90, 0x09, 0x88, 0x11,
+    0x84, 0x21, 0x82, 0x41, 0x81, 0x81, 0x80, 0x01,
+    0x80, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00,
+};
+
+/** Browser icon - globe (16x16) */
+const uint8_t ICON_BROWSER[] = {
+    0x07, 0xE0, 0x18, 0x18, 0x21, 0x84, 0x41, 0x82,
+    0x49, 0x92, 0x89, 0x91, 0xFF, 0xFF, 0x89, 0x91,
+    0x89, 0x91, 0xFF, 0xFF, 0x89, 0x91, 0x49, 0x92,
+    0x41, 0x82, 0x21, 0x84, 0x18, 0x18, 0x07, 0xE0,
+};
+
+/* ============================================================================
+ * Status Bar Icons (8x8 pixels, 8 bytes each)
+ * ============================================================================ */
+
+/** Bluetooth icon (8x8) */
+const uint8_t ICON_BLE_8[] = {
+    0x08, 0x0C, 0x2A, 0x1C, 0x08, 0x1C, 0x2A, 0x0C,
+};
+
+/** WiFi icon - signal bars (8x8) */
+const uint8_t ICON_WIFI_8[] = {
+    0x00, 0x3C, 0x42, 0x18, 0x24, 0x00, 0x18, 0x00,
+};
+
+/** Battery icon - full (8x8) */
+const uint8_t ICON_BATTERY_FULL_8[] = {
+    0x7E, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x7E,
+};
+
+/** Battery icon - empty (8x8) */
+const uint8_t ICON_BATTERY_EMPTY_8[] = {
+    0x7E, 0x81, 0x81, 0x81, 0x81, 0x81, 0xFF, 0x7E,
+};
+
+/** Music playing icon (8x8) */
+const uint8_t ICON_PLAYING_8[] = {
+    0x10, 0x18, 0x1C, 0x1E, 0x1E, 0x1C, 0x18, 0x10,
+};
+
+/** Notification bell icon (8x8) */
+const uint8_t ICON_BELL_8[] = {
+    0x18, 0x3C, 0x3C, 0x3C, 0x7E, 0xFF, 0x00, 0x18,
+};
+
+/* ============================================================================
+ * UI Element Icons (various sizes)
+ * ============================================================================ */
+
+/** Checkbox unchecked (8x8) */
+const uint8_t ICON_CHECKBOX_OFF[] = {
+    0xFF, 0x81, 0x81, 0x81, 0x81, 0x81, 0x81, 0xFF,
+};
+
+/** Checkbox checked (8x8) */
+const uint8_t ICON_CHECKBOX_ON[] = {
+    0xFF, 0x81, 0x85, 0x89, 0x91, 0xA1, 0xC1, 0xFF,
+};
+
+/** Radio button off (8x8) */
+const uint8_t ICON_RADIO_OFF[] = {
+    0x3C, 0x42, 0x81, 0x81, 0x81, 0x81, 0x42, 0x3C,
+};
+
+/** Radio button on (8x8) */
+const uint8_t ICON_RADIO_ON[] = {
+    0x3C, 0x42, 0x99, 0xBD, 0xBD, 0x99, 0x42, 0x3C,
+};
+
+/** Arrow right (8x8) */
+const uint8_t ICON_ARROW_RIGHT[] = {
+    0x10, 0x18, 0x1C, 0x1E, 0x1C, 0x18, 0x10, 0x00,
+};
+
+/** Arrow left (8x8) */
+const uint8_t ICON_ARROW_LEFT[] = {
+    0x08, 0x18, 0x38, 0x78, 0x38, 0x18, 0x08, 0x00,
+};
+
+/** Arrow up (8x8) */
+const uint8_t ICON_ARROW_UP[] = {
+    0x18, 0x3C, 0x7E, 0x18, 0x18, 0x18, 0x18, 0x00,
+};
+
+/** Arrow down (8x8) */
+const uint8_t ICON_ARROW_DOWN[] = {
+    0x18, 0x18, 0x18, 0x18, 0x7E, 0x3C, 0x18, 0x00,
+};
+
+/** Home icon (8x8) */
+const uint8_t ICON_HOME_8[] = {
+    0x18, 0x3C, 0x7E, 0xFF, 0xFF, 0xDB, 0xDB, 0xDB,
+};
+
+/** Back/return icon (8x8) */
+const uint8_t ICON_BACK_8[] = {
+    0x20, 0x60, 0xFE, 0xFF, 0xFE, 0x60, 0x20, 0x00,
+};
+
+/* ============================================================================
+ * Card Suits for Solitaire (8x8 pixels each)
+ * ============================================================================ */
+
+/** Heart suit (8x8) */
+const uint8_t SUIT_HEART[] = {
+    0x00, 0x66, 0xFF, 0xFF, 0xFF, 0x7E, 0x3C, 0x18,
+};
+
+/** Diamond suit (8x8) */
+const uint8_t SUIT_DIAMOND[] = {
+    0x18, 0x3C, 0x7E, 0xFF, 0xFF, 0x7E, 0x3C, 0x18,
+};
+
+/** Club suit (8x8) */
+const uint8_t SUIT_CLUB[] = {
+    0x18, 0x3C, 0x18, 0xDB, 0xFF, 0xFF, 0x18, 0x3C,
+};
+
+/** Spade suit (8x8) */
+const uint8_t SUIT_SPADE[] = {
+    0x18, 0x3C, 0x7E, 0xFF, 0xFF, 0x18, 0x3C, 0x3C,
+};
+
+/* ============================================================================
+ * Custom Sprites - Add your own sprites here!
+ * ============================================================================ */
+
+/* Add your custom sprites below this line, ending the doc comment with
+ * the size, e.g. (16x16), and declare them in sprites.h */
+/* ---------------------------------------- */
+
+
+
+
+/* ---------------------------------------- */
+/* End of custom sprites */
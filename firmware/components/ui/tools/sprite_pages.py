@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+"""
+Convert the packed sprite atlas (sprites.c) into page-native sprites.
+
+Source sprites are packed horizontally, MSB = leftmost pixel, and each one
+is preceded by a doc comment ending in its size, e.g. "(16x16)". The output
+defines a display_sprite_t SPRITE_<NAME> per sprite whose data is laid out
+like the SSD1306 framebuffer: ceil(h / 8) pages, each holding one byte per
+column with bit 0 as the top row of the page.
+
+Usage: sprite_pages.py <sprites.c> <output.c>
+"""
+
+import re
+import sys
+
+SPRITE_RE = re.compile(
+    r"/\*\*[^*]*?\((\d+)x(\d+)\)\s*\*/\s*"
+    r"const\s+uint8_t\s+(\w+)\[\]\s*=\s*\{([^}]*)\};",
+    re.S,
+)
+
+
+def parse(text):
+    sprites = []
+    for m in SPRITE_RE.finditer(text):
+        w, h, name, body = int(m.group(1)), int(m.group(2)), m.group(3), m.group(4)
+        body = re.sub(r"//[^\n]*", "", body)
+        data = [int(tok, 0) for tok in re.findall(r"0[xX][0-9a-fA-F]+|\d+", body)]
+        expected = (w + 7) // 8 * h
+        if len(data) != expected:
+            raise SystemExit(f"{name}: {len(data)} bytes, expected {expected} for {w}x{h}")
+        sprites.append((name, w, h, data))
+    return sprites
+
+
+def to_pages(w, h, data):
+    stride = (w + 7) // 8
+    pages = []
+    for page in range((h + 7) // 8):
+        for col in range(w):
+            byte = 0
+            for bit in range(8):
+                row = page * 8 + bit
+                if row < h and data[row * stride + col // 8] & (0x80 >> (col % 8)):
+                    byte |= 1 << bit
+            pages.append(byte)
+    return pages
+
+
+def emit(sprites, src_name):
+    out = [
+        "/* Generated by sprite_pages.py from %s - do not edit */" % src_name,
+        "",
+        '#include "sprites.h"',
+        "",
+    ]
+    for name, w, h, data in sprites:
+        pages = to_pages(w, h, data)
+        out.append("static const uint8_t %s_pages[] = {" % name)
+        for i in range(0, len(pages), w):
+            out.append("    " + ", ".join("0x%02X" % b for b in pages[i:i + w]) + ",")
+        out.append("};")
+        out.append("const display_sprite_t SPRITE_%s = { %d, %d, %s_pages };" % (name, w, h, name))
+        out.append("")
+    return "\n".join(out)
+
+
+def main():
+    if len(sys.argv) != 3:
+        raise SystemExit(__doc__)
+    with open(sys.argv[1]) as f:
+        sprites = parse(f.read())
+    if not sprites:
+        raise SystemExit("no sprites found in " + sys.argv[1])
+    text = emit(sprites, sys.argv[1].replace("\\", "/").split("/")[-1])
+    with open(sys.argv[2], "w") as f:
+        f.write(text)
+
+
+if __name__ == "__main__":
+    main()
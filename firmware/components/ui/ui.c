@@ -4,9 +4,15 @@
  */
 
 #include "ui.h"
+#include "ui_perf_priv.h"
 #include "display.h"
 #include "esp_log.h"
 #include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <stdatomic.h>
+#include <stdlib.h>
 #include <string.h>
 
 static const char *TAG = "ui";
@@ -26,15 +32,44 @@ static int s_scene_top = -1;
 /* System status */
 static ui_status_t s_status = {0};
 
-/* Notification state */
+/* A notification with its own copy of the text */
+typedef struct {
+    ui_notify_priority_t priority;
+    uint32_t duration_ms;
+    void (*on_tap)(void);
+    uint32_t group;             /* Hash of the coalescing key, 0 = none */
+    uint32_t seq;               /* Arrival order */
+    uint16_t count;             /* Notifications merged into this one */
+    char title[UI_NOTIFY_TITLE_LEN];
+    char body[UI_NOTIFY_BODY_LEN];
+} notify_entry_t;
+
+/* Notification being shown, owned by the UI task */
 typedef struct {
     bool active;
-    ui_notification_t notif;
+    notify_entry_t entry;
     uint32_t show_time;
     int16_t y_offset;           /* For slide animation */
 } notify_state_t;
 static notify_state_t s_notify = {0};
 
+/*
+ * Notifications waiting to be shown, unordered (the queue is small, so
+ * picking the next one is a scan). ui_notify() may run on any task; the
+ * queue and the arrival count are only touched under s_notify_lock.
+ */
+static notify_entry_t s_notify_queue[UI_NOTIFY_QUEUE_LEN];
+static int s_notify_pending = 0;
+static uint32_t s_notify_seq = 0;
+static uint32_t s_notify_arrived = 0;   /* Not yet added to the unread count */
+static ui_notify_stats_t s_notify_stats = {0};
+static SemaphoreHandle_t s_notify_lock = NULL;
+
+/* Start times of the last UI_NOTIFY_PER_SEC slide-ins (ms), oldest at s_notify_start_next */
+static uint32_t s_notify_starts[UI_NOTIFY_PER_SEC];
+static int s_notify_start_next = 0;
+static int s_notify_started = 0;
+
 /* Dialog state */
 typedef struct {
     bool active;
@@ -61,10 +96,122 @@ typedef struct {
 } menu_state_t;
 static menu_state_t s_menu = {0};
 
+/* Frame timing */
+static ui_frame_stats_t s_frame_stats = {0};
+static uint32_t s_minute_start = 0;     /* Start of the frames-per-minute window (ms) */
+static uint32_t s_minute_frames = 0;
+
+/* On-demand rendering: set by anything that changes the picture */
+static volatile bool s_dirty = true;            /* A frame must be composed */
+static volatile bool s_scene_dirty = true;      /* The menu or app must be drawn again */
+static volatile bool s_status_dirty = true;     /* The status bar must be drawn again */
+static TaskHandle_t s_ui_task = NULL;   /* Task sleeping in ui_wait() */
+
+/*
+ * Composition layers. The scene (menu or app) and the status bar are drawn
+ * into these only when they change; every frame copies them to the screen
+ * and draws the overlays on top, so an animating notification or a dialog
+ * does not run the app's on_render. The scene layer is screen-sized, so the
+ * content viewport sits in it where it sits on screen. Banded panels get no
+ * layers: they do without a frame buffer to save the memory, and the layers
+ * would take it back. There, and without memory for a layer, its content is
+ * drawn straight into each frame (each band), as before.
+ */
+static display_surface_t s_scene_layer;
+static display_surface_t s_status_layer;
+
 /* Input debouncing */
 static uint32_t s_last_input_time = 0;
 static uint8_t s_last_buttons = 0;
 
+/*
+ * Input queue from the BLE host task (single producer) to the UI task
+ * (single consumer). Button events go through the ring and are never
+ * merged. Axis-only reports go through a triple buffer, where a newer
+ * report simply replaces one not yet taken. A report records how many
+ * ring events came before it, so the consumer delivers it in the right
+ * place, or not at all if a button event posted after it already carries
+ * a newer position.
+ */
+typedef struct {
+    uint32_t time_ms;
+    uint32_t tag;
+    int8_t x;
+    int8_t y;
+    uint8_t buttons;
+} input_event_t;
+
+typedef struct {
+    uint32_t time_ms;
+    uint32_t tag;
+    unsigned seq;                       /* Ring events posted before it */
+    int8_t x;
+    int8_t y;
+} axis_report_t;
+
+/*
+ * Each side owns one slot and they trade through the middle one. The
+ * producer fills its slot, then swaps it into the middle marked fresh; the
+ * consumer swaps its slot for the middle to take a report. A report's
+ * fields are published and taken together.
+ */
+#define AXIS_SLOT_MASK          0x3u
+#define AXIS_FRESH              0x4u
+
+static input_event_t s_input_ring[UI_INPUT_QUEUE_LEN];
+static atomic_uint s_input_head = 0;    /* Written by the producer */
+static atomic_uint s_input_tail = 0;    /* Written by the consumer */
+static axis_report_t s_axis_slots[3];
+static atomic_uint s_axis_middle = 1;   /* Slot index | FRESH if not taken yet */
+static unsigned s_axis_back = 0;        /* Producer side: slot being filled */
+static unsigned s_axis_front = 2;       /* Consumer side: slot last taken */
+static uint8_t s_post_buttons = 0;      /* Producer side: buttons of the last report */
+static ui_input_stats_t s_input_stats = {0};
+
+/*
+ * Traced inputs, owned by the UI task. Delivered ones wait for the next
+ * frame; once it is handed to the display they wait for the display's
+ * finished count to reach that frame.
+ */
+typedef struct {
+    uint32_t tag;
+    uint32_t input_us;
+} input_trace_t;
+
+#define TRACE_POLL_MS           2       /* ui_wait() period while a traced frame is in flight */
+
+static ui_input_trace_fn_t s_trace_fn = NULL;
+static input_trace_t s_trace_pending[UI_INPUT_TRACE_LEN];  /* Delivered, not drawn yet */
+static int s_trace_pending_count = 0;
+static input_trace_t s_trace_sent[UI_INPUT_TRACE_LEN];     /* Drawn, frame not shown yet */
+static int s_trace_sent_count = 0;
+static uint32_t s_trace_frame = 0;      /* display_stats_t.queued of that frame */
+
+/*
+ * Scheduled app ticks: a min-heap of deadlines, at most one per app.
+ * s_tick_slot maps an app index to its heap slot so a pending tick can be
+ * moved or dropped in place.
+ */
+typedef struct {
+    uint32_t deadline;                  /* ms */
+    uint8_t app;                        /* Index into s_apps */
+} tick_entry_t;
+
+static tick_entry_t s_tick_heap[UI_MAX_APPS];
+static int s_tick_count = 0;
+static int8_t s_tick_slot[UI_MAX_APPS]; /* -1 = nothing pending */
+static uint32_t s_tick_since[UI_MAX_APPS];  /* Last tick, or when scheduled from idle (ms) */
+
+/*
+ * App state allocated on launch. An app is open while it is on the scene
+ * stack; a closed app with state resident is warm and can be evicted,
+ * least recently closed first.
+ */
+static void *s_app_state[UI_MAX_APPS];
+static uint32_t s_app_closed[UI_MAX_APPS];  /* Close order of warm apps, larger = more recent */
+static uint32_t s_app_close_seq = 0;
+static ui_app_mem_stats_t s_app_mem = {0};
+
 /* ============================================================================
  * Forward Declarations
  * ============================================================================ */
@@ -77,6 +224,15 @@ static void render_osk(void);
 static void handle_menu_input(int8_t x, int8_t y, uint8_t buttons);
 static void handle_dialog_input(int8_t x, int8_t y, uint8_t buttons);
 static void handle_osk_input(int8_t x, int8_t y, uint8_t buttons);
+static void run_due_ticks(uint32_t now);
+static uint32_t next_tick_in(uint32_t now);
+static int app_index(const ui_app_t *app);
+static esp_err_t app_mem_acquire(int app);
+static void app_mem_release(int app);
+static void request_frame(void);
+static void close_osk(const char *text, bool confirmed);
+static void notify_update(uint32_t now);
+static uint32_t notify_next_in(uint32_t now);
 
 /* ============================================================================
  * Core API Implementation
@@ -90,9 +246,43 @@ esp_err_t ui_init(void)
     s_scene_top = -1;
     memset(&s_status, 0, sizeof(s_status));
     memset(&s_notify, 0, sizeof(s_notify));
+    s_notify_pending = 0;
+    s_notify_arrived = 0;
+    s_notify_started = 0;
+    memset(&s_notify_stats, 0, sizeof(s_notify_stats));
+    if (!s_notify_lock) {
+        s_notify_lock = xSemaphoreCreateMutex();
+        if (!s_notify_lock) return ESP_ERR_NO_MEM;
+    }
     memset(&s_dialog, 0, sizeof(s_dialog));
     memset(&s_osk, 0, sizeof(s_osk));
     memset(&s_menu, 0, sizeof(s_menu));
+    memset(s_tick_slot, -1, sizeof(s_tick_slot));
+    s_tick_count = 0;
+    for (int i = 0; i < UI_MAX_APPS; i++) {
+        free(s_app_state[i]);
+        s_app_state[i] = NULL;
+    }
+    memset(&s_app_mem, 0, sizeof(s_app_mem));
+    s_app_mem.budget = CONFIG_UI_APP_MEM_BUDGET;
+    s_dirty = true;
+    s_scene_dirty = true;
+    s_status_dirty = true;
+    
+    if (display_is_banded()) {
+        /* Also drops layers made for a full-frame panel before a restart */
+        display_surface_destroy(&s_scene_layer);
+        display_surface_destroy(&s_status_layer);
+    } else {
+        if (!s_scene_layer.data &&
+            display_surface_create(&s_scene_layer, DISPLAY_WIDTH, DISPLAY_HEIGHT) != ESP_OK) {
+            ESP_LOGW(TAG, "No memory for the scene layer, apps redraw every frame");
+        }
+        if (!s_status_layer.data &&
+            display_surface_create(&s_status_layer, DISPLAY_WIDTH, UI_STATUS_BAR_HEIGHT) != ESP_OK) {
+            ESP_LOGW(TAG, "No memory for the status layer");
+        }
+    }
     
     /* Start at main menu */
     s_scene_stack[0].type = UI_SCENE_MENU;
@@ -115,6 +305,7 @@ esp_err_t ui_register_app(const ui_app_t *app)
         return ESP_ERR_NO_MEM;
     }
     
+    s_tick_slot[s_app_count] = -1;
     s_apps[s_app_count++] = app;
     ESP_LOGI(TAG, "Registered app: %s", app->name);
     
@@ -133,10 +324,12 @@ size_t ui_get_apps(const ui_app_t **apps, size_t max_apps)
 esp_err_t ui_launch_app(const char *app_id)
 {
     const ui_app_t *app = NULL;
+    int index = -1;
     
     for (size_t i = 0; i < s_app_count; i++) {
         if (strcmp(s_apps[i]->id, app_id) == 0) {
             app = s_apps[i];
+            index = (int)i;
             break;
         }
     }
@@ -152,6 +345,12 @@ esp_err_t ui_launch_app(const char *app_id)
         return ESP_ERR_NO_MEM;
     }
     
+    esp_err_t ret = app_mem_acquire(index);
+    if (ret != ESP_OK) {
+        ui_notify_simple("Not enough memory");
+        return ret;
+    }
+    
     s_scene_top++;
     s_scene_stack[s_scene_top].type = UI_SCENE_APP;
     s_scene_stack[s_scene_top].app = app;
@@ -160,6 +359,7 @@ esp_err_t ui_launch_app(const char *app_id)
     if (app->on_enter) {
         app->on_enter();
     }
+    ui_invalidate();
     
     ESP_LOGI(TAG, "Launched app: %s", app->name);
     return ESP_OK;
@@ -174,11 +374,16 @@ void ui_go_back(void)
     
     ui_scene_t *current = &s_scene_stack[s_scene_top];
     
-    if (current->type == UI_SCENE_APP && current->app && current->app->on_exit) {
-        current->app->on_exit();
+    const ui_app_t *app = current->type == UI_SCENE_APP ? current->app : NULL;
+    if (app && app->on_exit) {
+        app->on_exit();
     }
     
     s_scene_top--;
+    if (app) {
+        app_mem_release(app_index(app));
+    }
+    ui_invalidate();
     ESP_LOGD(TAG, "Popped scene, now at level %d", s_scene_top);
 }
 
@@ -189,23 +394,42 @@ void ui_go_home(void)
     }
 }
 
-void ui_input(int8_t x, int8_t y, uint8_t buttons)
+bool ui_is_app_focused(const ui_app_t *app)
 {
-    uint32_t now = esp_timer_get_time() / 1000;
+    if (s_scene_top < 0) return false;
+    
+    const ui_scene_t *current = &s_scene_stack[s_scene_top];
+    return current->type == UI_SCENE_APP && current->app == app;
+}
+
+/**
+ * @brief Run the input handlers for one report received at `now`
+ */
+static void dispatch_input(int8_t x, int8_t y, uint8_t buttons, uint32_t now, uint32_t tag)
+{
+    if (tag && s_trace_fn && s_trace_pending_count < UI_INPUT_TRACE_LEN) {
+        s_trace_pending[s_trace_pending_count++] = (input_trace_t){
+            .tag = tag, .input_us = (uint32_t)esp_timer_get_time(),
+        };
+    }
     
     /* Detect button edges */
     uint8_t pressed = buttons & ~s_last_buttons;
     s_last_buttons = buttons;
     s_last_input_time = now;
     
+    /* Input for a dialog or the keyboard only changes the overlay */
+    if (s_osk.active || s_dialog.active) {
+        request_frame();
+    } else {
+        ui_invalidate();
+    }
+    
     /* Home button always goes home */
     if (pressed & UI_BTN_HOME) {
         if (s_osk.active) {
             /* Cancel OSK */
-            s_osk.active = false;
-            if (s_osk.config.callback) {
-                s_osk.config.callback(NULL, false);
-            }
+            close_osk(NULL, false);
         } else if (s_dialog.active) {
             ui_close_dialog();
         } else {
@@ -217,10 +441,7 @@ void ui_input(int8_t x, int8_t y, uint8_t buttons)
     /* Back button */
     if (pressed & UI_BTN_BACK) {
         if (s_osk.active) {
-            s_osk.active = false;
-            if (s_osk.config.callback) {
-                s_osk.config.callback(NULL, false);
-            }
+            close_osk(NULL, false);
         } else if (s_dialog.active) {
             ui_close_dialog();
         } else {
@@ -231,8 +452,8 @@ void ui_input(int8_t x, int8_t y, uint8_t buttons)
     
     /* Dismiss notification on any press */
     if (s_notify.active && (pressed & UI_BTN_PRESS)) {
-        if (s_notify.notif.on_tap) {
-            s_notify.notif.on_tap();
+        if (s_notify.entry.on_tap) {
+            s_notify.entry.on_tap();
         }
         ui_notify_dismiss();
         return;
@@ -254,25 +475,223 @@ void ui_input(int8_t x, int8_t y, uint8_t buttons)
     }
 }
 
-void ui_render(void)
+void ui_input(int8_t x, int8_t y, uint8_t buttons)
+{
+    dispatch_input(x, y, buttons, esp_timer_get_time() / 1000, 0);
+}
+
+/* ============================================================================
+ * Input Queue
+ * ============================================================================ */
+
+bool ui_post_input(int8_t x, int8_t y, uint8_t buttons)
+{
+    return ui_post_input_traced(x, y, buttons, 0);
+}
+
+bool ui_post_input_traced(int8_t x, int8_t y, uint8_t buttons, uint32_t tag)
+{
+    uint32_t now = esp_timer_get_time() / 1000;
+    unsigned head = atomic_load_explicit(&s_input_head, memory_order_relaxed);
+    bool ok = true;
+    
+    s_input_stats.posted++;
+    
+    if (buttons == s_post_buttons) {
+        /* Axis only: replace whatever axis report is still waiting */
+        s_axis_slots[s_axis_back] = (axis_report_t){
+            .time_ms = now, .tag = tag, .seq = head, .x = x, .y = y,
+        };
+        unsigned prev = atomic_exchange_explicit(&s_axis_middle, s_axis_back | AXIS_FRESH,
+                                                 memory_order_acq_rel);
+        s_axis_back = prev & AXIS_SLOT_MASK;
+        if (prev & AXIS_FRESH) {
+            s_input_stats.coalesced++;
+        }
+    } else {
+        unsigned tail = atomic_load_explicit(&s_input_tail, memory_order_acquire);
+        unsigned depth = head - tail;
+        if (depth >= UI_INPUT_QUEUE_LEN) {
+            s_input_stats.dropped++;
+            ok = false;
+        } else {
+            s_input_ring[head & (UI_INPUT_QUEUE_LEN - 1)] = (input_event_t){
+                .time_ms = now, .tag = tag, .x = x, .y = y, .buttons = buttons,
+            };
+            atomic_store_explicit(&s_input_head, head + 1, memory_order_release);
+            s_post_buttons = buttons;
+            if (depth + 1 > s_input_stats.max_depth) s_input_stats.max_depth = depth + 1;
+        }
+    }
+    
+    request_frame();    /* The handlers decide what to redraw */
+    return ok;
+}
+
+/**
+ * @brief Deliver ring events up to (not including) position `end`
+ */
+static void drain_ring(unsigned end)
+{
+    unsigned tail = atomic_load_explicit(&s_input_tail, memory_order_relaxed);
+    
+    while (tail != end) {
+        input_event_t ev = s_input_ring[tail & (UI_INPUT_QUEUE_LEN - 1)];
+        atomic_store_explicit(&s_input_tail, ++tail, memory_order_release);
+        dispatch_input(ev.x, ev.y, ev.buttons, ev.time_ms, ev.tag);
+    }
+}
+
+void ui_process_input(void)
+{
+    UI_PERF_BEGIN(perf);
+    
+    /* Taken before reading head, so the axis report's place is within reach */
+    unsigned middle = atomic_exchange_explicit(&s_axis_middle, s_axis_front, memory_order_acq_rel);
+    s_axis_front = middle & AXIS_SLOT_MASK;
+    bool fresh = middle & AXIS_FRESH;
+    unsigned head = atomic_load_explicit(&s_input_head, memory_order_acquire);
+    if (!fresh && head == atomic_load_explicit(&s_input_tail, memory_order_relaxed)) {
+        return;     /* Nothing queued */
+    }
+    
+    if (fresh) {
+        const axis_report_t *axis = &s_axis_slots[s_axis_front];
+        unsigned tail = atomic_load_explicit(&s_input_tail, memory_order_relaxed);
+        
+        /* Skip it if a button event delivered already was posted after it */
+        if ((int)(axis->seq - tail) >= 0) {
+            drain_ring(axis->seq);
+            dispatch_input(axis->x, axis->y, s_last_buttons, axis->time_ms, axis->tag);
+        }
+    }
+    
+    /* Events posted after the axis report, or all of them without one */
+    drain_ring(head);
+    UI_PERF_END(UI_PERF_INPUT, perf);
+}
+
+void ui_get_input_stats(ui_input_stats_t *stats)
+{
+    if (!stats) return;
+    
+    *stats = s_input_stats;
+    stats->depth = atomic_load(&s_input_head) - atomic_load(&s_input_tail);
+}
+
+void ui_set_input_trace(ui_input_trace_fn_t fn)
+{
+    s_trace_fn = fn;
+}
+
+/**
+ * @brief Report the traced inputs drawn in the last frame once it is shown
+ */
+static void trace_report(const display_stats_t *disp)
+{
+    if (s_trace_sent_count == 0 || (int32_t)(disp->done - s_trace_frame) < 0) return;
+    
+    for (int i = 0; i < s_trace_sent_count && s_trace_fn; i++) {
+        s_trace_fn(s_trace_sent[i].tag, s_trace_sent[i].input_us, disp->last_done_us);
+    }
+    s_trace_sent_count = 0;
+}
+
+/**
+ * @brief Attach the inputs delivered since the last frame to the one just queued
+ */
+static void trace_frame_queued(const display_stats_t *disp)
+{
+    /* The previous frame has finished before this one was handed over */
+    trace_report(disp);
+    if (s_trace_pending_count == 0) return;
+    
+    memcpy(s_trace_sent, s_trace_pending, s_trace_pending_count * sizeof(input_trace_t));
+    s_trace_sent_count = s_trace_pending_count;
+    s_trace_pending_count = 0;
+    s_trace_frame = disp->queued;
+    
+    /* Banded panels are done by the time display_render() returns */
+    trace_report(disp);
+}
+
+/**
+ * @brief Draw the status bar
+ */
+static void draw_status(void)
+{
+    UI_PERF_BEGIN(status);
+    render_status_bar();
+    UI_PERF_ADD(UI_PERF_OVERLAY, status);
+}
+
+/**
+ * @brief Draw the menu or the focused app in the viewport below the status bar
+ */
+static void draw_scene(void)
+{
+    ui_scene_t *current = &s_scene_stack[s_scene_top];
+    
+    display_push_viewport(0, UI_STATUS_BAR_HEIGHT, DISPLAY_WIDTH, UI_CONTENT_HEIGHT);
+    if (current->type == UI_SCENE_MENU) {
+        render_main_menu();
+    } else if (current->type == UI_SCENE_APP && current->app && current->app->on_render) {
+        UI_PERF_BEGIN(app);
+        current->app->on_render();
+        UI_PERF_ADD(UI_PERF_APP_RENDER, app);
+    }
+    display_pop_clip();
+}
+
+/**
+ * @brief Redraw a layer if it changed
+ *
+ * Leaves the layer invalid if it cannot be drawn, so the frame draws its
+ * content directly.
+ */
+static void update_layer(display_surface_t *layer, volatile bool *dirty, void (*draw)(void))
+{
+    if (!layer->data || (!*dirty && layer->valid)) return;
+    
+    /* Cleared first, like s_dirty */
+    *dirty = false;
+    if (display_surface_begin(layer) == ESP_OK) {
+        draw();
+        display_surface_end();
+    } else {
+        display_surface_invalidate(layer);
+    }
+}
+
+/**
+ * @brief Compose one whole frame from the layers and overlays
+ *
+ * Banded panels call this once per band, so it must not change any state.
+ */
+static void draw_frame(void *ctx)
 {
     display_clear();
+    display_reset_clip();   /* Drop anything an app left pushed */
     
-    /* Render current scene */
+    /* Status bar (always visible, reserve top 10px), then the scene */
     if (s_scene_top >= 0) {
-        ui_scene_t *current = &s_scene_stack[s_scene_top];
-        
-        /* Status bar (always visible, reserve top 10px) */
-        render_status_bar();
+        if (s_status_layer.valid) {
+            display_blit_surface(0, 0, &s_status_layer);
+        } else {
+            draw_status();
+        }
         
-        if (current->type == UI_SCENE_MENU) {
-            render_main_menu();
-        } else if (current->type == UI_SCENE_APP && current->app && current->app->on_render) {
-            current->app->on_render();
+        if (s_scene_layer.valid) {
+            display_push_clip(0, UI_STATUS_BAR_HEIGHT, DISPLAY_WIDTH, UI_CONTENT_HEIGHT);
+            display_blit_surface(0, 0, &s_scene_layer);
+            display_pop_clip();
+        } else {
+            draw_scene();
         }
     }
     
     /* Overlay layers */
+    UI_PERF_BEGIN(overlay);
     if (s_dialog.active) {
         render_dialog();
     }
@@ -284,34 +703,119 @@ void ui_render(void)
     if (s_notify.active) {
         render_notification();
     }
+    UI_PERF_ADD(UI_PERF_OVERLAY, overlay);
+}
+
+/**
+ * @brief Close the frames-per-minute window once a minute has passed
+ */
+static void roll_frame_minute(uint32_t now)
+{
+    uint32_t elapsed = now - s_minute_start;
+    if (elapsed < 60000) return;
     
-    display_refresh();
+    /* A window with no frames at all may be several minutes long */
+    s_frame_stats.frames_per_minute = elapsed < 120000 ? s_minute_frames : 0;
+    s_minute_frames = 0;
+    s_minute_start = now;
+}
+
+void ui_render(void)
+{
+    int64_t start = esp_timer_get_time();
+    
+    /* Cleared first, so a change made while drawing asks for another frame */
+    s_dirty = false;
+    if (s_scene_top >= 0) {
+        update_layer(&s_status_layer, &s_status_dirty, draw_status);
+        update_layer(&s_scene_layer, &s_scene_dirty, draw_scene);
+    }
+    display_render(draw_frame, NULL);
+    
+    /* Time spent waiting on the panel is not drawing time */
+    display_stats_t disp;
+    display_get_stats(&disp);
+    int64_t end = esp_timer_get_time();
+    uint32_t elapsed = (uint32_t)(end - start);
+    s_frame_stats.render_us = elapsed > disp.last_wait_us ? elapsed - disp.last_wait_us : 0;
+    s_frame_stats.frames++;
+    trace_frame_queued(&disp);
+    
+    UI_PERF_FRAME_DONE(s_scene_stack[s_scene_top].type == UI_SCENE_APP ?
+                       app_index(s_scene_stack[s_scene_top].app) : -1,
+                       s_frame_stats.render_us, &disp);
+    
+    roll_frame_minute((uint32_t)(end / 1000));
+    s_minute_frames++;
+}
+
+/**
+ * @brief Ask for a frame without redrawing the layers (overlay changes)
+ */
+static void request_frame(void)
+{
+    s_dirty = true;
+    
+    TaskHandle_t task = s_ui_task;
+    if (task && task != xTaskGetCurrentTaskHandle()) {
+        xTaskNotifyGive(task);
+    }
+}
+
+void ui_invalidate(void)
+{
+    s_scene_dirty = true;
+    request_frame();
+}
+
+bool ui_render_if_needed(void)
+{
+    if (!s_dirty) return false;
+    ui_render();
+    return true;
+}
+
+void ui_wait(uint32_t max_ms)
+{
+    s_ui_task = xTaskGetCurrentTaskHandle();
+    if (s_dirty) return;
+    
+    uint32_t wait = max_ms;
+    if (s_notify.active || s_notify_pending > 0) {
+        uint32_t next = notify_next_in(esp_timer_get_time() / 1000);
+        if (next < wait) wait = next;
+    }
+    if (s_tick_count > 0) {
+        uint32_t next = next_tick_in(esp_timer_get_time() / 1000);
+        if (next < wait) wait = next;
+    }
+    
+    /* The display does not wake this task when a frame is shown */
+    if (s_trace_sent_count > 0 && wait > TRACE_POLL_MS) {
+        wait = TRACE_POLL_MS;
+    }
+    
+    if (wait > 0) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait));
+    }
 }
 
 void ui_tick(uint32_t dt_ms)
 {
-    /* Update notification animation */
-    if (s_notify.active) {
-        uint32_t now = esp_timer_get_time() / 1000;
-        uint32_t elapsed = now - s_notify.show_time;
-        
-        /* Slide in animation (first 200ms) */
-        if (elapsed < 200) {
-            s_notify.y_offset = -UI_NOTIFY_HEIGHT + (UI_NOTIFY_HEIGHT * elapsed / 200);
-        } else {
-            s_notify.y_offset = 0;
-        }
-        
-        /* Auto-dismiss */
-        uint32_t duration = s_notify.notif.duration_ms ? s_notify.notif.duration_ms : 3000;
-        if (elapsed > duration) {
-            ui_notify_dismiss();
-        }
+    /* Traced inputs whose frame has reached the panel since */
+    if (s_trace_sent_count > 0) {
+        display_stats_t disp;
+        display_get_stats(&disp);
+        trace_report(&disp);
     }
     
-    /* Tick all apps (for background tasks) */
+    /* Notification queue and animation */
+    notify_update(esp_timer_get_time() / 1000);
+    
+    /* Apps that are due, then the ones that tick every frame */
+    run_due_ticks(esp_timer_get_time() / 1000);
     for (size_t i = 0; i < s_app_count; i++) {
-        if (s_apps[i]->on_tick) {
+        if (s_apps[i]->tick_every_frame && s_apps[i]->on_tick) {
             s_apps[i]->on_tick(dt_ms);
         }
     }
@@ -319,8 +823,12 @@ void ui_tick(uint32_t dt_ms)
 
 void ui_update_status(const ui_status_t *status)
 {
-    if (status) {
+    if (status && memcmp(&s_status, status, sizeof(s_status)) != 0) {
         memcpy(&s_status, status, sizeof(s_status));
+        
+        /* Apps may show status fields too (the clock, the link) */
+        s_status_dirty = true;
+        ui_invalidate();
     }
 }
 
@@ -329,27 +837,499 @@ const ui_status_t *ui_get_status(void)
     return &s_status;
 }
 
+void ui_get_frame_stats(ui_frame_stats_t *stats)
+{
+    if (!stats) return;
+    
+    display_stats_t disp;
+    display_get_stats(&disp);
+    
+    roll_frame_minute(esp_timer_get_time() / 1000);
+    *stats = s_frame_stats;
+    stats->flush_us = disp.last_flush_us;
+}
+
+/* ============================================================================
+ * Tick Scheduler
+ * ============================================================================ */
+
+/* Deadlines wrap with the ms clock, so compare them by difference */
+static inline bool tick_before(uint32_t a, uint32_t b)
+{
+    return (int32_t)(a - b) < 0;
+}
+
+static void tick_place(int slot, tick_entry_t entry)
+{
+    s_tick_heap[slot] = entry;
+    s_tick_slot[entry.app] = slot;
+}
+
+static void tick_sift_up(int slot)
+{
+    tick_entry_t entry = s_tick_heap[slot];
+    while (slot > 0) {
+        int parent = (slot - 1) / 2;
+        if (!tick_before(entry.deadline, s_tick_heap[parent].deadline)) break;
+        tick_place(slot, s_tick_heap[parent]);
+        slot = parent;
+    }
+    tick_place(slot, entry);
+}
+
+static void tick_sift_down(int slot)
+{
+    tick_entry_t entry = s_tick_heap[slot];
+    while (true) {
+        int child = slot * 2 + 1;
+        if (child >= s_tick_count) break;
+        if (child + 1 < s_tick_count &&
+            tick_before(s_tick_heap[child + 1].deadline, s_tick_heap[child].deadline)) {
+            child++;
+        }
+        if (!tick_before(s_tick_heap[child].deadline, entry.deadline)) break;
+        tick_place(slot, s_tick_heap[child]);
+        slot = child;
+    }
+    tick_place(slot, entry);
+}
+
+static void tick_remove(int slot)
+{
+    s_tick_slot[s_tick_heap[slot].app] = -1;
+    if (--s_tick_count == slot) return;
+    
+    /* Move the last entry into the hole; it may belong above or below */
+    tick_place(slot, s_tick_heap[s_tick_count]);
+    if (slot > 0 && tick_before(s_tick_heap[slot].deadline, s_tick_heap[(slot - 1) / 2].deadline)) {
+        tick_sift_up(slot);
+    } else {
+        tick_sift_down(slot);
+    }
+}
+
+static int app_index(const ui_app_t *app)
+{
+    for (size_t i = 0; i < s_app_count; i++) {
+        if (s_apps[i] == app) return (int)i;
+    }
+    return -1;
+}
+
+esp_err_t ui_schedule_tick(const ui_app_t *app, uint32_t delay_ms)
+{
+    int i = app_index(app);
+    if (i < 0) return ESP_ERR_NOT_FOUND;
+    
+    /* At least 1 ms, so an app rescheduling itself from on_tick cannot spin ui_tick() */
+    uint32_t now = esp_timer_get_time() / 1000;
+    uint32_t deadline = now + (delay_ms ? delay_ms : 1);
+    
+    int slot = s_tick_slot[i];
+    if (slot < 0) {
+        s_tick_since[i] = now;
+        slot = s_tick_count++;
+        tick_place(slot, (tick_entry_t){ .deadline = deadline, .app = (uint8_t)i });
+        tick_sift_up(slot);
+    } else {
+        bool earlier = tick_before(deadline, s_tick_heap[slot].deadline);
+        s_tick_heap[slot].deadline = deadline;
+        if (earlier) tick_sift_up(slot);
+        else tick_sift_down(slot);
+    }
+    return ESP_OK;
+}
+
+void ui_cancel_tick(const ui_app_t *app)
+{
+    int i = app_index(app);
+    if (i >= 0 && s_tick_slot[i] >= 0) {
+        tick_remove(s_tick_slot[i]);
+    }
+}
+
+/**
+ * @brief Pop and run every tick due at `now`
+ */
+static void run_due_ticks(uint32_t now)
+{
+    while (s_tick_count > 0 && !tick_before(now, s_tick_heap[0].deadline)) {
+        int i = s_tick_heap[0].app;
+        tick_remove(0);
+        
+        uint32_t dt = now - s_tick_since[i];
+        s_tick_since[i] = now;
+        if (s_apps[i]->on_tick) {
+            s_apps[i]->on_tick(dt);
+        }
+    }
+}
+
+/**
+ * @brief Milliseconds from `now` to the earliest scheduled tick, 0 if due
+ */
+static uint32_t next_tick_in(uint32_t now)
+{
+    uint32_t deadline = s_tick_heap[0].deadline;
+    return tick_before(now, deadline) ? deadline - now : 0;
+}
+
+/* ============================================================================
+ * App Memory
+ * ============================================================================ */
+
+static bool app_is_open(int app)
+{
+    for (int i = 0; i <= s_scene_top; i++) {
+        if (s_scene_stack[i].type == UI_SCENE_APP && s_scene_stack[i].app == s_apps[app]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void app_mem_evict(int app)
+{
+    const ui_app_t *a = s_apps[app];
+    if (a->on_evict) {
+        a->on_evict(s_app_state[app]);
+    }
+    free(s_app_state[app]);
+    s_app_state[app] = NULL;
+    s_app_mem.resident -= a->state_size;
+    s_app_mem.warm--;
+    s_app_mem.evictions++;
+    ESP_LOGD(TAG, "Evicted %s (%u bytes)", a->id, (unsigned)a->state_size);
+}
+
+/**
+ * @brief Evict the least recently closed warm app
+ * @return false if no app is warm
+ */
+static bool app_mem_evict_lru(void)
+{
+    int lru = -1;
+    for (int i = 0; i < (int)s_app_count; i++) {
+        if (s_app_state[i] && !app_is_open(i) &&
+            (lru < 0 || (int32_t)(s_app_closed[i] - s_app_closed[lru]) < 0)) {
+            lru = i;
+        }
+    }
+    if (lru < 0) return false;
+    
+    app_mem_evict(lru);
+    return true;
+}
+
+/**
+ * @brief Make an app's state resident before it opens
+ */
+static esp_err_t app_mem_acquire(int app)
+{
+    size_t size = s_apps[app]->state_size;
+    if (size == 0) return ESP_OK;
+    
+    if (s_app_state[app]) {
+        /* Still warm, unless it is already open further down the stack */
+        if (!app_is_open(app)) {
+            s_app_mem.warm--;
+            s_app_mem.hits++;
+        }
+        return ESP_OK;
+    }
+    
+    /* Open apps cannot be evicted; do not drop warm ones if it would not help */
+    size_t open_bytes = s_app_mem.resident;
+    for (int i = 0; i < (int)s_app_count; i++) {
+        if (s_app_state[i] && !app_is_open(i)) open_bytes -= s_apps[i]->state_size;
+    }
+    
+    /* Make room within the budget, then in the heap */
+    void *state = NULL;
+    if (open_bytes + size <= s_app_mem.budget) {
+        while (s_app_mem.resident + size > s_app_mem.budget && app_mem_evict_lru()) {}
+        while (!(state = calloc(1, size)) && app_mem_evict_lru()) {}
+    }
+    if (!state) {
+        s_app_mem.failures++;
+        ESP_LOGE(TAG, "No memory for %s (%u bytes, %lu resident)", s_apps[app]->id,
+                 (unsigned)size, (unsigned long)s_app_mem.resident);
+        return ESP_ERR_NO_MEM;
+    }
+    
+    s_app_state[app] = state;
+    s_app_mem.resident += size;
+    if (s_app_mem.resident > s_app_mem.peak) {
+        s_app_mem.peak = s_app_mem.resident;
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Keep a closed app's state warm, within the warm limit
+ */
+static void app_mem_release(int app)
+{
+    if (app < 0 || !s_app_state[app] || app_is_open(app)) return;
+    
+    s_app_closed[app] = ++s_app_close_seq;
+    s_app_mem.warm++;
+    while (s_app_mem.warm > CONFIG_UI_APP_WARM_APPS && app_mem_evict_lru()) {}
+}
+
+void *ui_app_state(const ui_app_t *app)
+{
+    int i = app_index(app);
+    return i >= 0 ? s_app_state[i] : NULL;
+}
+
+size_t ui_get_app_resident(size_t app)
+{
+    return app < s_app_count && s_app_state[app] ? s_apps[app]->state_size : 0;
+}
+
+void ui_get_app_mem_stats(ui_app_mem_stats_t *stats)
+{
+    *stats = s_app_mem;
+}
+
 /* ============================================================================
  * Notification Implementation
  * ============================================================================ */
 
+#define NOTIFY_SLIDE_MS         200
+#define NOTIFY_DEFAULT_MS       3000
+
+/**
+ * @brief Copy text, truncated to whole UTF-8 characters
+ */
+static void copy_text(char *dst, size_t size, const char *src)
+{
+    size_t len = src ? strlen(src) : 0;
+    if (len >= size) {
+        len = size - 1;
+        while (len > 0 && ((uint8_t)src[len] & 0xC0) == 0x80) len--;
+    }
+    memcpy(dst, src ? src : "", len);
+    dst[len] = '\0';
+}
+
+/* FNV-1a; 0 is kept for "no group" */
+static uint32_t group_hash(const char *key)
+{
+    if (!key || !*key) return 0;
+    uint32_t h = 2166136261u;
+    while (*key) {
+        h = (h ^ (uint8_t)*key++) * 16777619u;
+    }
+    return h ? h : 1;
+}
+
+/**
+ * @brief Fold `from` into `into`: newest text, highest priority, summed count
+ */
+static void notify_merge(notify_entry_t *into, const notify_entry_t *from)
+{
+    uint32_t count = (uint32_t)into->count + from->count;
+    into->count = count > UINT16_MAX ? UINT16_MAX : count;
+    if (from->priority > into->priority) into->priority = from->priority;
+    if (from->duration_ms > into->duration_ms) into->duration_ms = from->duration_ms;
+    if (from->on_tap) into->on_tap = from->on_tap;
+    memcpy(into->title, from->title, sizeof(into->title));
+    memcpy(into->body, from->body, sizeof(into->body));
+}
+
 esp_err_t ui_notify(const ui_notification_t *notif)
 {
     if (!notif || !notif->title) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    memcpy(&s_notify.notif, notif, sizeof(ui_notification_t));
-    s_notify.active = true;
-    s_notify.show_time = esp_timer_get_time() / 1000;
-    s_notify.y_offset = -UI_NOTIFY_HEIGHT;
+    notify_entry_t entry = {
+        .priority = notif->priority,
+        .duration_ms = notif->duration_ms,
+        .on_tap = notif->on_tap,
+        .group = group_hash(notif->group),
+        .count = 1,
+    };
+    copy_text(entry.title, sizeof(entry.title), notif->title);
+    copy_text(entry.body, sizeof(entry.body), notif->body);
+    
+    esp_err_t ret = ESP_OK;
+    xSemaphoreTake(s_notify_lock, portMAX_DELAY);
+    entry.seq = s_notify_seq++;
+    s_notify_arrived++;
+    
+    /* Same group already waiting: merge, keeping its place in line */
+    notify_entry_t *slot = NULL;
+    for (int i = 0; entry.group && i < s_notify_pending; i++) {
+        if (s_notify_queue[i].group == entry.group) {
+            notify_merge(&s_notify_queue[i], &entry);
+            s_notify_stats.coalesced++;
+            s_notify_stats.posted++;
+            xSemaphoreGive(s_notify_lock);
+            request_frame();
+            return ESP_OK;
+        }
+    }
     
-    if (s_status.unread_notifications < 255) {
-        s_status.unread_notifications++;
+    if (s_notify_pending < UI_NOTIFY_QUEUE_LEN) {
+        slot = &s_notify_queue[s_notify_pending++];
+    } else {
+        /* Full: the oldest of the lowest priority makes room, if it ranks no higher */
+        slot = &s_notify_queue[0];
+        for (int i = 1; i < s_notify_pending; i++) {
+            notify_entry_t *e = &s_notify_queue[i];
+            if (e->priority < slot->priority ||
+                (e->priority == slot->priority && (int32_t)(e->seq - slot->seq) < 0)) {
+                slot = e;
+            }
+        }
+        if (slot->priority > entry.priority) slot = NULL;
+        s_notify_stats.dropped++;
     }
     
-    ESP_LOGI(TAG, "Notification: %s", notif->title);
-    return ESP_OK;
+    if (slot) {
+        *slot = entry;
+        s_notify_stats.posted++;
+    } else {
+        ret = ESP_ERR_NO_MEM;
+    }
+    xSemaphoreGive(s_notify_lock);
+    
+    /* The UI task picks it up in ui_tick() */
+    request_frame();
+    return ret;
+}
+
+/**
+ * @brief How long the shown notification stays up
+ */
+static uint32_t notify_duration(void)
+{
+    uint32_t duration = s_notify.entry.duration_ms ? s_notify.entry.duration_ms : NOTIFY_DEFAULT_MS;
+    
+    /* Make way for the ones waiting */
+    if (s_notify_pending > 0 && duration > UI_NOTIFY_BUSY_MS) {
+        duration = UI_NOTIFY_BUSY_MS;
+    }
+    return duration;
+}
+
+/**
+ * @brief Milliseconds until the rate limit lets another notification start
+ */
+static uint32_t notify_rate_wait(uint32_t now)
+{
+    if (s_notify_started < UI_NOTIFY_PER_SEC) return 0;
+    uint32_t since = now - s_notify_starts[s_notify_start_next];
+    return since >= 1000 ? 0 : 1000 - since;
+}
+
+/**
+ * @brief Show the next waiting notification, or merge it into the shown one
+ *
+ * Called with s_notify_lock held.
+ */
+static void notify_take_next(uint32_t now)
+{
+    /* Highest priority, oldest first */
+    int best = -1;
+    for (int i = 0; i < s_notify_pending; i++) {
+        notify_entry_t *e = &s_notify_queue[i];
+        if (s_notify.active && e->group && e->group == s_notify.entry.group) {
+            best = i;
+            break;
+        }
+        if (best < 0 || e->priority > s_notify_queue[best].priority ||
+            (e->priority == s_notify_queue[best].priority &&
+             (int32_t)(e->seq - s_notify_queue[best].seq) < 0)) {
+            best = i;
+        }
+    }
+    if (best < 0) return;
+    
+    notify_entry_t *e = &s_notify_queue[best];
+    if (s_notify.active) {
+        if (!e->group || e->group != s_notify.entry.group) return;
+        
+        /* More from the sender on screen: update it and restart its time, not its slide */
+        notify_merge(&s_notify.entry, e);
+        s_notify.show_time = now - NOTIFY_SLIDE_MS;
+        s_notify_stats.coalesced++;
+    } else {
+        if (notify_rate_wait(now) > 0) return;
+        
+        s_notify.entry = *e;
+        s_notify.active = true;
+        s_notify.show_time = now;
+        s_notify.y_offset = -UI_NOTIFY_HEIGHT;
+        s_notify_starts[s_notify_start_next] = now;
+        s_notify_start_next = (s_notify_start_next + 1) % UI_NOTIFY_PER_SEC;
+        if (s_notify_started < UI_NOTIFY_PER_SEC) s_notify_started++;
+        s_notify_stats.shown++;
+        UI_PERF_COUNT(UI_PERF_NOTIFICATIONS);
+        ESP_LOGI(TAG, "Notification: %s", s_notify.entry.title);
+    }
+    *e = s_notify_queue[--s_notify_pending];
+    request_frame();
+}
+
+/**
+ * @brief Advance the notification queue and the slide animation (UI task)
+ */
+static void notify_update(uint32_t now)
+{
+    if (s_notify_pending > 0 || s_notify_arrived > 0) {
+        xSemaphoreTake(s_notify_lock, portMAX_DELAY);
+        uint32_t arrived = s_notify_arrived;
+        s_notify_arrived = 0;
+        if (s_notify_pending > 0) {
+            notify_take_next(now);
+        }
+        xSemaphoreGive(s_notify_lock);
+        
+        if (arrived > 0) {
+            uint32_t unread = s_status.unread_notifications + arrived;
+            s_status.unread_notifications = unread > 255 ? 255 : unread;
+            s_status_dirty = true;
+            request_frame();
+        }
+    }
+    if (!s_notify.active) return;
+    
+    uint32_t elapsed = now - s_notify.show_time;
+    
+    /* Slide in animation */
+    int16_t y_offset = 0;
+    if (elapsed < NOTIFY_SLIDE_MS) {
+        y_offset = -UI_NOTIFY_HEIGHT + (UI_NOTIFY_HEIGHT * elapsed / NOTIFY_SLIDE_MS);
+    }
+    if (y_offset != s_notify.y_offset) {
+        s_notify.y_offset = y_offset;
+        request_frame();
+    }
+    
+    /* Auto-dismiss */
+    if (elapsed > notify_duration()) {
+        ui_notify_dismiss();
+    }
+}
+
+/**
+ * @brief Milliseconds until notify_update() has something to do
+ */
+static uint32_t notify_next_in(uint32_t now)
+{
+    if (!s_notify.active) {
+        return notify_rate_wait(now);
+    }
+    
+    /* Next slide-in step, or the moment it is dismissed */
+    uint32_t elapsed = now - s_notify.show_time;
+    uint32_t duration = notify_duration();
+    return elapsed < NOTIFY_SLIDE_MS ? UI_ANIM_FRAME_MS :
+           elapsed <= duration ? duration - elapsed + 1 : 0;
 }
 
 void ui_notify_simple(const char *text)
@@ -367,6 +1347,17 @@ void ui_notify_simple(const char *text)
 void ui_notify_dismiss(void)
 {
     s_notify.active = false;
+    request_frame();
+}
+
+void ui_get_notify_stats(ui_notify_stats_t *stats)
+{
+    if (!stats) return;
+    
+    xSemaphoreTake(s_notify_lock, portMAX_DELAY);
+    *stats = s_notify_stats;
+    stats->pending = s_notify_pending;
+    xSemaphoreGive(s_notify_lock);
 }
 
 /* ============================================================================
@@ -382,13 +1373,16 @@ esp_err_t ui_show_dialog(const ui_dialog_t *dialog)
     memcpy(&s_dialog.dialog, dialog, sizeof(ui_dialog_t));
     s_dialog.active = true;
     s_dialog.selected = dialog->default_button;
+    request_frame();
     
     return ESP_OK;
 }
 
 void ui_close_dialog(void)
 {
+    /* Its button may have changed what the app shows */
     s_dialog.active = false;
+    ui_invalidate();
 }
 
 /* ============================================================================
@@ -413,10 +1407,23 @@ esp_err_t ui_show_osk(const ui_osk_config_t *config)
     } else {
         s_osk.buffer[0] = '\0';
     }
+    request_frame();
     
     return ESP_OK;
 }
 
+/**
+ * @brief Hide the keyboard and report to its owner
+ */
+static void close_osk(const char *text, bool confirmed)
+{
+    s_osk.active = false;
+    if (s_osk.config.callback) {
+        s_osk.config.callback(text, confirmed);
+    }
+    ui_invalidate();    /* The callback may have changed what the app shows */
+}
+
 bool ui_osk_active(void)
 {
     return s_osk.active;
@@ -469,30 +1476,36 @@ static void render_notification(void)
 {
     if (!s_notify.active) return;
     
-    int y = s_notify.y_offset;
+    display_push_viewport(0, s_notify.y_offset, DISPLAY_WIDTH, UI_NOTIFY_HEIGHT);
     
     /* Background bar */
-    display_fill_rect(0, y, DISPLAY_WIDTH, UI_NOTIFY_HEIGHT, COLOR_WHITE);
+    display_fill_rect(0, 0, DISPLAY_WIDTH, UI_NOTIFY_HEIGHT, COLOR_WHITE);
     
     /* Title text (inverted) */
-    if (s_notify.notif.title) {
-        display_draw_string(2, y + 2, s_notify.notif.title, COLOR_BLACK, 1);
+    const char *title = s_notify.entry.title;
+    char merged[UI_NOTIFY_TITLE_LEN + 16];
+    if (s_notify.entry.count > 1) {
+        snprintf(merged, sizeof(merged), "%u msgs from %s", s_notify.entry.count, title);
+        title = merged;
     }
+    display_draw_text_fit(2, 2, DISPLAY_WIDTH - 4, title, DISPLAY_FONT_PROP, COLOR_BLACK);
+    
+    display_pop_clip();
 }
 
 static void render_main_menu(void)
 {
-    int start_y = UI_STATUS_BAR_HEIGHT + 2;
+    int start_y = 2;
     
     if (s_app_count == 0) {
-        display_draw_string(10, 30, "No apps", COLOR_WHITE, 1);
+        display_draw_string(10, 20, "No apps", COLOR_WHITE, 1);
         return;
     }
     
     /* Grid layout: 4 columns, 2 rows */
     int cols = 4;
     int cell_w = DISPLAY_WIDTH / cols;
-    int cell_h = (DISPLAY_HEIGHT - start_y) / 2;
+    int cell_h = (UI_CONTENT_HEIGHT - start_y) / 2;
     
     for (size_t i = 0; i < s_app_count && i < 8; i++) {
         int col = i % cols;
@@ -509,23 +1522,21 @@ static void render_main_menu(void)
         int icon_x = x + (cell_w - 16) / 2;
         int icon_y = y + 2;
         
-        if (s_apps[i]->icon) {
+        if (s_apps[i]->sprite) {
+            display_draw_sprite(icon_x, icon_y, s_apps[i]->sprite, COLOR_WHITE);
+        } else if (s_apps[i]->icon) {
             display_draw_bitmap(icon_x, icon_y, s_apps[i]->icon, 16, 16, COLOR_WHITE);
         } else {
             /* Default icon (simple box) */
             display_draw_rect(icon_x, icon_y, 16, 16, COLOR_WHITE);
         }
         
-        /* App name (centered below icon, truncated) */
+        /* App name (centered below icon, cut to the cell) */
         const char *name = s_apps[i]->name;
-        int name_len = strlen(name);
-        if (name_len > 5) name_len = 5;
-        int name_x = x + (cell_w - name_len * 6) / 2;
-        
-        char short_name[6];
-        strncpy(short_name, name, 5);
-        short_name[5] = '\0';
-        display_draw_string(name_x, icon_y + 18, short_name, COLOR_WHITE, 1);
+        int name_w = display_measure_string(name, DISPLAY_FONT_SMALL);
+        if (name_w > cell_w - 2) name_w = cell_w - 2;
+        display_draw_text_fit(x + (cell_w - name_w) / 2, icon_y + 18, cell_w - 2,
+                              name, DISPLAY_FONT_SMALL, COLOR_WHITE);
     }
 }
 
@@ -543,17 +1554,20 @@ static void render_dialog(void)
     display_fill_rect(x, y, w, h, COLOR_BLACK);
     display_draw_rect(x, y, w, h, COLOR_WHITE);
     
+    /* Contents are clipped inside the border */
+    display_push_viewport(x + 1, y + 1, w - 2, h - 2);
+    
     /* Title */
     if (s_dialog.dialog.title) {
-        display_draw_string(x + 4, y + 2, s_dialog.dialog.title, COLOR_WHITE, 1);
+        display_draw_string(3, 1, s_dialog.dialog.title, COLOR_WHITE, 1);
     }
     
     /* Buttons */
-    int btn_y = y + h - 12;
+    int btn_y = h - 13;
     int btn_w = w / s_dialog.dialog.button_count;
     
     for (int i = 0; i < s_dialog.dialog.button_count; i++) {
-        int btn_x = x + i * btn_w;
+        int btn_x = i * btn_w - 1;
         
         if (i == s_dialog.selected) {
             display_fill_rect(btn_x + 2, btn_y, btn_w - 4, 10, COLOR_WHITE);
@@ -562,6 +1576,8 @@ static void render_dialog(void)
             display_draw_string(btn_x + 4, btn_y + 1, s_dialog.dialog.buttons[i].label, COLOR_WHITE, 1);
         }
     }
+    
+    display_pop_clip();
 }
 
 static void render_osk(void)
@@ -747,10 +1763,7 @@ static void handle_osk_input(int8_t x, int8_t y, uint8_t buttons)
                 }
             } else if (key == '>') {
                 /* Enter - confirm */
-                s_osk.active = false;
-                if (s_osk.config.callback) {
-                    s_osk.config.callback(s_osk.buffer, true);
-                }
+                close_osk(s_osk.buffer, true);
             } else {
                 /* Add character */
                 size_t max_len = s_osk.config.max_length ? s_osk.config.max_length : sizeof(s_osk.buffer) - 1;
@@ -774,6 +1787,10 @@ void ui_draw_menu_list(int x, int y, int w, int h,
 {
     int item_h = 10;
     int visible = h / item_h;
+    int text_w = w - 4 - (count > (size_t)visible ? 2 : 0);
+    
+    /* Nothing spills out of the list box */
+    display_push_clip(x, y, w, h);
     
     for (int i = 0; i < visible && (scroll_offset + i) < (int)count; i++) {
         int idx = scroll_offset + i;
@@ -781,9 +1798,11 @@ void ui_draw_menu_list(int x, int y, int w, int h,
         
         if (idx == selected) {
             display_fill_rect(x, item_y, w, item_h, COLOR_WHITE);
-            display_draw_string(x + 2, item_y + 1, items[idx].label, COLOR_BLACK, 1);
+            display_draw_text_fit(x + 2, item_y + 1, text_w, items[idx].label,
+                                  DISPLAY_FONT_PROP, COLOR_BLACK);
         } else {
-            display_draw_string(x + 2, item_y + 1, items[idx].label, COLOR_WHITE, 1);
+            display_draw_text_fit(x + 2, item_y + 1, text_w, items[idx].label,
+                                  DISPLAY_FONT_PROP, COLOR_WHITE);
         }
     }
     
@@ -793,6 +1812,8 @@ void ui_draw_menu_list(int x, int y, int w, int h,
         int bar_y = y + (h - bar_h) * scroll_offset / (count - visible);
         display_fill_rect(x + w - 2, bar_y, 2, bar_h, COLOR_WHITE);
     }
+    
+    display_pop_clip();
 }
 
 bool ui_handle_menu_input(int8_t y, uint8_t buttons,
@@ -0,0 +1,235 @@
+/**
+ * @file ui_perf.c
+ * @brief Frame-time instrumentation - histograms and CSV export
+ */
+
+#include "ui_perf_priv.h"
+#include "ui.h"
+#include "display.h"
+#include <stdio.h>
+#include <string.h>
+
+#if CONFIG_UI_PERF
+
+#if !CONFIG_IDF_TARGET_LINUX
+#include "esp_rom_sys.h"
+#endif
+
+static const char *s_probe_names[UI_PERF_PROBE_COUNT] = {
+    [UI_PERF_INPUT] = "input",
+    [UI_PERF_APP_RENDER] = "app_render",
+    [UI_PERF_OVERLAY] = "overlay",
+    [UI_PERF_FRAME] = "frame",
+    [UI_PERF_REFRESH] = "refresh",
+    [UI_PERF_CAPTURE_RX] = "capture_rx",
+    [UI_PERF_RX_INPUT] = "rx_input",
+    [UI_PERF_INPUT_SHOWN] = "input_shown",
+    [UI_PERF_CAPTURE_SHOWN] = "capture_shown",
+};
+
+static const char *s_counter_names[UI_PERF_COUNTER_COUNT] = {
+    [UI_PERF_NOTIFICATIONS] = "notifications",
+};
+
+static ui_perf_hist_t s_hist[UI_PERF_PROBE_COUNT];
+static ui_perf_hist_t s_app_hist[UI_MAX_APPS];
+static uint32_t s_counters[UI_PERF_COUNTER_COUNT];
+
+/* Cycles added by UI_PERF_ADD() during the frame being drawn */
+static uint32_t s_frame_cycles[UI_PERF_PROBE_COUNT];
+static uint32_t s_panel_frames = 0;     /* Panel frame count at the last frame */
+
+/* ============================================================================
+ * Recording
+ * ============================================================================ */
+
+static void hist_add(ui_perf_hist_t *h, uint32_t us)
+{
+    /* Bucket by bit length of us / 4: <4, 4-7, 8-15, ... */
+    uint32_t q = us >> 2;
+    int bucket = q ? 32 - __builtin_clz(q) : 0;
+    if (bucket >= UI_PERF_BUCKETS) bucket = UI_PERF_BUCKETS - 1;
+    
+    h->count++;
+    h->total_us += us;
+    if (us > h->max_us) h->max_us = us;
+    h->buckets[bucket]++;
+}
+
+/* Cycle counts assume the CPU clock does not change under dynamic frequency scaling */
+static inline uint32_t cycles_to_us(uint32_t cycles)
+{
+#if CONFIG_IDF_TARGET_LINUX
+    return cycles / 1000;
+#else
+    return cycles / esp_rom_get_cpu_ticks_per_us();
+#endif
+}
+
+void ui_perf_record(ui_perf_probe_t probe, uint32_t cycles)
+{
+    hist_add(&s_hist[probe], cycles_to_us(cycles));
+}
+
+void ui_perf_add(ui_perf_probe_t probe, uint32_t cycles)
+{
+    s_frame_cycles[probe] += cycles;
+}
+
+void ui_perf_sample(ui_perf_probe_t probe, uint32_t us)
+{
+    if (probe < UI_PERF_PROBE_COUNT) hist_add(&s_hist[probe], us);
+}
+
+void ui_perf_frame_done(int app, uint32_t render_us, const display_stats_t *disp)
+{
+    /* Frames composed from cached layers did not run on_render at all */
+    uint32_t app_cycles = s_frame_cycles[UI_PERF_APP_RENDER];
+    if (app_cycles && app >= 0 && app < UI_MAX_APPS) {
+        uint32_t app_us = cycles_to_us(app_cycles);
+        hist_add(&s_hist[UI_PERF_APP_RENDER], app_us);
+        hist_add(&s_app_hist[app], app_us);
+    }
+    hist_add(&s_hist[UI_PERF_OVERLAY], cycles_to_us(s_frame_cycles[UI_PERF_OVERLAY]));
+    memset(s_frame_cycles, 0, sizeof(s_frame_cycles));
+    hist_add(&s_hist[UI_PERF_FRAME], render_us);
+    
+    /* Transfers run in the display's flush task; sample each one that finished */
+    if (disp->frames != s_panel_frames) {
+        s_panel_frames = disp->frames;
+        hist_add(&s_hist[UI_PERF_REFRESH], disp->last_flush_us);
+    }
+}
+
+void ui_perf_count(ui_perf_counter_t counter)
+{
+    s_counters[counter]++;
+}
+
+/* ============================================================================
+ * Readout
+ * ============================================================================ */
+
+bool ui_perf_get(ui_perf_probe_t probe, ui_perf_hist_t *hist)
+{
+    if (probe >= UI_PERF_PROBE_COUNT) return false;
+    *hist = s_hist[probe];
+    return true;
+}
+
+bool ui_perf_get_app(size_t app, ui_perf_hist_t *hist)
+{
+    const ui_app_t *apps[UI_MAX_APPS];
+    if (app >= ui_get_apps(apps, UI_MAX_APPS)) return false;
+    *hist = s_app_hist[app];
+    return true;
+}
+
+uint32_t ui_perf_get_counter(ui_perf_counter_t counter)
+{
+    return counter < UI_PERF_COUNTER_COUNT ? s_counters[counter] : 0;
+}
+
+void ui_perf_reset(void)
+{
+    memset(s_hist, 0, sizeof(s_hist));
+    memset(s_app_hist, 0, sizeof(s_app_hist));
+    memset(s_counters, 0, sizeof(s_counters));
+    memset(s_frame_cycles, 0, sizeof(s_frame_cycles));
+}
+
+static void dump_hist(const char *prefix, const char *name, const ui_perf_hist_t *h)
+{
+    char line[256];
+    int len = snprintf(line, sizeof(line), "perf,%s%s,%lu,%llu,%lu", prefix, name,
+                       (unsigned long)h->count, (unsigned long long)h->total_us,
+                       (unsigned long)h->max_us);
+    for (int i = 0; i < UI_PERF_BUCKETS && len < (int)sizeof(line); i++) {
+        len += snprintf(line + len, sizeof(line) - len, ",%lu", (unsigned long)h->buckets[i]);
+    }
+    puts(line);
+}
+
+void ui_perf_dump_csv(void)
+{
+    const ui_app_t *apps[UI_MAX_APPS];
+    size_t app_count = ui_get_apps(apps, UI_MAX_APPS);
+    
+    for (int i = 0; i < UI_PERF_PROBE_COUNT; i++) {
+        dump_hist("", s_probe_names[i], &s_hist[i]);
+    }
+    for (size_t i = 0; i < app_count; i++) {
+        if (s_app_hist[i].count) {
+            dump_hist("app:", apps[i]->id, &s_app_hist[i]);
+        }
+    }
+    for (size_t i = 0; i < app_count; i++) {
+        if (apps[i]->state_size) {
+            printf("perf,mem:%s,%u\n", apps[i]->id, (unsigned)ui_get_app_resident(i));
+        }
+    }
+    for (int i = 0; i < UI_PERF_COUNTER_COUNT; i++) {
+        printf("perf,counter,%s,%lu\n", s_counter_names[i], (unsigned long)s_counters[i]);
+    }
+    
+    /* Panel traffic is counted by the display driver */
+    display_stats_t disp;
+    display_get_stats(&disp);
+    printf("perf,counter,panel_frames,%lu\n", (unsigned long)disp.frames);
+    printf("perf,counter,panel_bytes,%llu\n", (unsigned long long)disp.total_bytes);
+    fflush(stdout);
+}
+
+#else
+
+void ui_perf_sample(ui_perf_probe_t probe, uint32_t us)
+{
+    (void)probe;
+    (void)us;
+}
+
+bool ui_perf_get(ui_perf_probe_t probe, ui_perf_hist_t *hist)
+{
+    (void)probe;
+    (void)hist;
+    return false;
+}
+
+bool ui_perf_get_app(size_t app, ui_perf_hist_t *hist)
+{
+    (void)app;
+    (void)hist;
+    return false;
+}
+
+uint32_t ui_perf_get_counter(ui_perf_counter_t counter)
+{
+    (void)counter;
+    return 0;
+}
+
+void ui_perf_reset(void)
+{
+}
+
+void ui_perf_dump_csv(void)
+{
+}
+
+#endif /* CONFIG_UI_PERF */
+
+uint32_t ui_perf_percentile(const ui_perf_hist_t *hist, unsigned percent)
+{
+    if (!hist || hist->count == 0) return 0;
+    
+    uint64_t target = ((uint64_t)hist->count * percent + 99) / 100;
+    uint64_t seen = 0;
+    for (int i = 0; i < UI_PERF_BUCKETS - 1; i++) {
+        seen += hist->buckets[i];
+        if (seen >= target) {
+            uint32_t upper = 4u << i;
+            return upper < hist->max_us ? upper : hist->max_us;
+        }
+    }
+    return hist->max_us;
+}
@@ -0,0 +1,65 @@
+/**
+ * @file ui_perf_priv.h
+ * @brief Instrumentation probes (private to the ui component)
+ *
+ * Every macro expands to nothing without CONFIG_UI_PERF, arguments
+ * included, so probes cost nothing when compiled out.
+ */
+
+#pragma once
+
+#include "ui_perf.h"
+#include "display.h"
+#include "sdkconfig.h"
+
+#if CONFIG_UI_PERF
+
+#if CONFIG_IDF_TARGET_LINUX
+/* No cycle counter on the host; "cycles" are nanoseconds there */
+#include <time.h>
+
+static inline uint32_t ui_perf_host_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)ts.tv_sec * 1000000000u + (uint32_t)ts.tv_nsec;
+}
+
+#define UI_PERF_CYCLES()                ui_perf_host_ns()
+#else
+#include "esp_cpu.h"
+#define UI_PERF_CYCLES()                esp_cpu_get_cycle_count()
+#endif
+
+/** Start timing: declares `mark` holding the cycle counter */
+#define UI_PERF_BEGIN(mark)             uint32_t mark = UI_PERF_CYCLES()
+
+/** Record the cycles since `mark` as one sample of `probe` */
+#define UI_PERF_END(probe, mark)        ui_perf_record((probe), UI_PERF_CYCLES() - (mark))
+
+/** Add the cycles since `mark` to this frame's sample of `probe` (banded panels draw a frame in parts) */
+#define UI_PERF_ADD(probe, mark)        ui_perf_add((probe), UI_PERF_CYCLES() - (mark))
+
+/**
+ * Close a frame: record the samples added during it, the frame's drawing
+ * time and the panel transfer if one finished since the last frame. `app`
+ * is the focused app's index, or -1.
+ */
+#define UI_PERF_FRAME_DONE(app, render_us, disp) ui_perf_frame_done((app), (render_us), (disp))
+
+#define UI_PERF_COUNT(counter)          ui_perf_count(counter)
+
+void ui_perf_record(ui_perf_probe_t probe, uint32_t cycles);
+void ui_perf_add(ui_perf_probe_t probe, uint32_t cycles);
+void ui_perf_frame_done(int app, uint32_t render_us, const display_stats_t *disp);
+void ui_perf_count(ui_perf_counter_t counter);
+
+#else
+
+#define UI_PERF_BEGIN(mark)
+#define UI_PERF_END(probe, mark)
+#define UI_PERF_ADD(probe, mark)
+#define UI_PERF_FRAME_DONE(app, render_us, disp)
+#define UI_PERF_COUNT(counter)
+
+#endif
@@ -15,6 +15,7 @@
 #include "control_link.h"
 #include "display.h"
 #include "ui.h"
+#include "ui_perf.h"
 #include "mesh_client.h"
 
 /* App headers */
@@ -39,6 +40,9 @@ static const char *TAG = "main";
 #define TEST_OLED_SCL_PIN   22
 #define TEST_OLED_I2C_ADDR  0x3C
 
+/* Longest the UI task sleeps: app ticks and the status bar clock */
+#define UI_IDLE_TICK_MS     1000
+
 /* ============================================================================
  * Input Handling
  * ============================================================================ */
@@ -49,10 +53,27 @@ static void handle_joystick_state(const control_link_joystick_t *state)
         return;
     }
     
-    /* Route all input through UI framework */
-    ui_input(state->x, state->y, state->buttons);
+    /* Hand off to the UI task; the BLE host must not run app input handlers */
+    ui_post_input_traced(state->x, state->y, state->buttons, state->seq);
+}
+
+/* A joystick report's frame has reached the panel: ACK it and record where the time went */
+static void handle_input_shown(uint32_t seq, uint32_t input_us, uint32_t shown_us)
+{
+    control_link_joystick_t rx = {0};
+    control_link_ack_input(seq, input_us, shown_us, &rx);
+    if (rx.rx_us == 0) {
+        return;     /* Too old to match */
+    }
+    
+    ui_perf_sample(UI_PERF_RX_INPUT, input_us - rx.rx_us);
+    ui_perf_sample(UI_PERF_INPUT_SHOWN, shown_us - input_us);
     
-    control_link_send_ack(state->seq);
+    /* A poor clock offset estimate can put the capture after the arrival */
+    if (rx.capture_valid && (int32_t)(rx.rx_us - rx.capture_us) >= 0) {
+        ui_perf_sample(UI_PERF_CAPTURE_RX, rx.rx_us - rx.capture_us);
+        ui_perf_sample(UI_PERF_CAPTURE_SHOWN, shown_us - rx.capture_us);
+    }
 }
 
 static void handle_macro_packet(const control_link_packet_t *packet)
@@ -78,6 +99,7 @@ static void handle_mesh_message(const mesh_message_t *msg)
     ui_notification_t notif = {
         .title = msg->from_name,
         .body = msg->message,
+        .group = msg->from_id,      /* A burst from one node shows as one notification */
         .priority = UI_NOTIFY_NORMAL,
         .duration_ms = 5000,
     };
@@ -103,6 +125,24 @@ static void handle_mesh_send_complete(uint32_t seq, bool success)
     }
 }
 
+/* Mesh Relay handles are resolved by the control link's GATT discovery */
+static void handle_link_ready(const control_link_handles_t *handles)
+{
+    if (!handles) {
+        mesh_client_set_handles(NULL);
+        return;
+    }
+    
+    mesh_client_handles_t mesh = {
+        .conn_handle = handles->conn_handle,
+        .inbox_char_handle = handles->mesh_inbox,
+        .send_char_handle = handles->mesh_send,
+        .status_char_handle = handles->mesh_status,
+        .node_list_char_handle = handles->mesh_node_list,
+    };
+    mesh_client_set_handles(&mesh);
+}
+
 /* ============================================================================
  * Tasks
  * ============================================================================ */
@@ -135,6 +175,7 @@ static void ui_task(void *arg)
         vTaskDelete(NULL);
         return;
     }
+    ui_set_input_trace(handle_input_shown);
     
     /* Register all apps */
     ui_register_app(&app_settings);
@@ -153,6 +194,7 @@ static void ui_task(void *arg)
     ESP_LOGI(TAG, "UI ready, entering render loop");
     
     uint32_t last_tick = esp_timer_get_time() / 1000;
+    uint32_t last_logged = 0;
     
     while (true) {
         uint32_t now = esp_timer_get_time() / 1000;
@@ -170,11 +212,22 @@ static void ui_task(void *arg)
         
         ui_update_status(&status);
         
-        /* Tick and render */
+        /* Queued input, then tick, and draw only if something changed */
+        ui_process_input();
         ui_tick(dt);
-        ui_render();
+        if (ui_render_if_needed()) {
+            ui_frame_stats_t frame;
+            ui_get_frame_stats(&frame);
+            if (frame.frames - last_logged >= 100) {
+                last_logged = frame.frames;
+                ESP_LOGD(TAG, "Frame %lu: render %lu us, flush %lu us, %lu frames/min",
+                         (unsigned long)frame.frames, (unsigned long)frame.render_us,
+                         (unsigned long)frame.flush_us, (unsigned long)frame.frames_per_minute);
+            }
+        }
         
-        vTaskDelay(pdMS_TO_TICKS(50));  /* 20 FPS */
+        /* Sleep until input, a notification step or the next tick */
+        ui_wait(UI_IDLE_TICK_MS);
     }
 }
 
@@ -208,6 +261,8 @@ static void init_services(void)
     ESP_ERROR_CHECK(mesh_client_subscribe_inbox(handle_mesh_message));
     ESP_ERROR_CHECK(mesh_client_subscribe_status(handle_mesh_status));
     ESP_ERROR_CHECK(mesh_client_subscribe_send_complete(handle_mesh_send_complete));
+    ESP_ERROR_CHECK(control_link_subscribe_ready(handle_link_ready));
+    ESP_ERROR_CHECK(control_link_subscribe_notify(mesh_client_on_notification));
     
     ESP_LOGI(TAG, "Services initialized");
 }
@@ -226,7 +281,8 @@ void app_main(void)
     init_services();
     
     /* Create tasks */
-    xTaskCreate(ui_task, "ui_task", 8192, NULL, 5, NULL);
+    /* Kept on one core: frame timings compare that core's cycle counter */
+    xTaskCreatePinnedToCore(ui_task, "ui_task", 8192, NULL, 5, NULL, portNUM_PROCESSORS - 1);
     xTaskCreate(connectivity_task, "conn_task", 4096, NULL, 6, NULL);
     
     ESP_LOGI(TAG, "System init complete");
@@ -0,0 +1,185 @@
+/**
+ * @file host_main.c
+ * @brief Linux build - runs the UI and apps on the in-memory display
+ *
+ * Opens every app in turn, plays a fixed joystick script into it and
+ * renders after each step, leaves it with the Home button and repeats.
+ * Then prints frame times per app and the ui_perf CSV. The control link
+ * and mesh client are their host builds, so the partner never connects.
+ *
+ *   idf.py --preview set-target linux && idf.py build monitor
+ *
+ * Environment:
+ *   UI_HOST_ROUNDS     Times each app is opened and scripted (default 20)
+ *   UI_HOST_DUMP_DIR   Write every rendered frame there as a PBM image
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_event.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs_flash.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "control_link.h"
+#include "display.h"
+#include "ui.h"
+#include "ui_perf.h"
+#include "mesh_client.h"
+
+/* App headers */
+#include "app_settings.h"
+#include "app_notes.h"
+#include "app_calendar.h"
+#include "app_mesh.h"
+#include "app_music.h"
+#include "app_camera.h"
+#include "app_solitaire.h"
+#include "app_translate.h"
+#include "app_email.h"
+#include "app_browser.h"
+
+static const char *TAG = "host";
+
+#define HOST_DEFAULT_ROUNDS     20
+
+/* ============================================================================
+ * Input Script
+ * ============================================================================ */
+
+typedef struct {
+    int8_t x;
+    int8_t y;
+    uint8_t buttons;
+} script_step_t;
+
+/* Moves and a press, each followed by the stick at rest. The press may
+ * open a dialog or the keyboard, which the round closes again. */
+static const script_step_t s_script[] = {
+    { 0, -100, 0 }, { 0, 0, 0 },
+    { 0, -100, 0 }, { 0, 0, 0 },
+    { 100, 0, 0 }, { 0, 0, 0 },
+    { 0, 100, 0 }, { 0, 0, 0 },
+    { 0, 0, UI_BTN_PRESS }, { 0, 0, 0 },
+    { -100, 0, 0 }, { 0, 0, 0 },
+};
+
+#define SCRIPT_LEN  (sizeof(s_script) / sizeof(s_script[0]))
+
+/* ============================================================================
+ * Run
+ * ============================================================================ */
+
+static void step(int8_t x, int8_t y, uint8_t buttons)
+{
+    ui_input(x, y, buttons);
+    ui_tick(UI_ANIM_FRAME_MS);
+    ui_render();
+}
+
+/**
+ * @brief Open an app, play the script into it and leave it again
+ *
+ * Leaves with the Home button rather than ui_go_home(): the first press
+ * closes a dialog or keyboard the script opened, the second goes home
+ * (or does nothing more if the first already did).
+ */
+static void run_round(const ui_app_t *app)
+{
+    if (ui_launch_app(app->id) != ESP_OK) {
+        ESP_LOGW(TAG, "Cannot launch %s", app->id);
+        return;
+    }
+    ui_render();
+    
+    for (size_t i = 0; i < SCRIPT_LEN; i++) {
+        step(s_script[i].x, s_script[i].y, s_script[i].buttons);
+    }
+    
+    for (int i = 0; i < 2; i++) {
+        step(0, 0, UI_BTN_HOME);
+        step(0, 0, 0);
+    }
+}
+
+static void print_report(void)
+{
+    const ui_app_t *apps[UI_MAX_APPS];
+    size_t count = ui_get_apps(apps, UI_MAX_APPS);
+    
+    printf("\n%-12s %8s %10s %10s %10s\n", "app", "frames", "mean us", "p95 us", "max us");
+    for (size_t i = 0; i < count; i++) {
+        ui_perf_hist_t hist;
+        if (!ui_perf_get_app(i, &hist) || hist.count == 0) {
+            printf("%-12s %8s\n", apps[i]->id, "-");
+            continue;
+        }
+        printf("%-12s %8lu %10lu %10lu %10lu\n", apps[i]->id,
+               (unsigned long)hist.count,
+               (unsigned long)(hist.total_us / hist.count),
+               (unsigned long)ui_perf_percentile(&hist, 95),
+               (unsigned long)hist.max_us);
+    }
+    
+    ui_frame_stats_t frame;
+    ui_get_frame_stats(&frame);
+    display_stats_t disp;
+    display_get_stats(&disp);
+    printf("\n%lu frames drawn, %lu reached the panel, %llu bytes sent\n\n",
+           (unsigned long)frame.frames, (unsigned long)disp.frames,
+           (unsigned long long)disp.total_bytes);
+    
+    ui_perf_dump_csv();
+}
+
+void app_main(void)
+{
+    ESP_LOGI(TAG, "Host build starting...");
+    
+    ESP_ERROR_CHECK(nvs_flash_init());
+    ESP_ERROR_CHECK(esp_event_loop_create_default());
+    ESP_ERROR_CHECK(control_link_init());
+    ESP_ERROR_CHECK(mesh_client_init());
+    
+    const char *rounds_env = getenv("UI_HOST_ROUNDS");
+    int rounds = rounds_env ? atoi(rounds_env) : HOST_DEFAULT_ROUNDS;
+    
+    display_config_t disp_cfg = {
+        .type = DISPLAY_TYPE_HOST,
+        .host = {
+            .dump_dir = getenv("UI_HOST_DUMP_DIR"),
+        },
+    };
+    ESP_ERROR_CHECK(display_init(&disp_cfg));
+    ESP_ERROR_CHECK(ui_init());
+    
+    /* Everything the device registers, plus the apps that wait for WiFi there */
+    ui_register_app(&app_settings);
+    ui_register_app(&app_notes);
+    ui_register_app(&app_calendar);
+    ui_register_app(&app_mesh);
+    ui_register_app(&app_music);
+    ui_register_app(&app_solitaire);
+    ui_register_app(&app_camera);
+    ui_register_app(&app_translate);
+    ui_register_app(&app_email);
+    ui_register_app(&app_browser);
+    
+    const ui_app_t *apps[UI_MAX_APPS];
+    size_t count = ui_get_apps(apps, UI_MAX_APPS);
+    
+    ui_render();
+    ui_perf_reset();
+    for (size_t i = 0; i < count; i++) {
+        ESP_LOGI(TAG, "Running %s", apps[i]->id);
+        for (int round = 0; round < rounds; round++) {
+            run_round(apps[i]);
+        }
+    }
+    
+    print_report();
+    display_deinit();
+    exit(0);
+}
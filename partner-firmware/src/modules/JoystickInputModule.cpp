@@ -25,6 +25,7 @@ JoystickInputModule::JoystickInputModule()
     : SinglePortModule("joystick", meshtastic_PortNum_PRIVATE_APP),
       seqCounter(0),
       currentLayer(LAYER_GLOBAL),
+      captureMicros(0),
       lastButtonPressTime(0),
       buttonDownTime(0),
       pressCount(0),
@@ -284,6 +285,9 @@ void JoystickInputModule::processTiltSensor()
 
 int32_t JoystickInputModule::runOnce()
 {
+    // Latency is measured from here
+    captureMicros = micros();
+    
     // Read joystick axes
     currentState.x = readAxis(JOYSTICK_X_PIN, JOYSTICK_INVERT_X);
     currentState.y = readAxis(JOYSTICK_Y_PIN, JOYSTICK_INVERT_Y);
@@ -93,6 +93,12 @@ public:
      */
     uint8_t getLayer() const { return currentLayer; }
 
+    /**
+     * @brief Get when the current state was sampled
+     * @return micros() at the start of the last poll
+     */
+    uint32_t getCaptureMicros() const { return captureMicros; }
+
 protected:
     /**
      * @brief Module tick function called by Meshtastic scheduler
@@ -140,6 +146,7 @@ private:
     JoystickEvent lastSentState;
     uint32_t seqCounter;
     uint8_t currentLayer;
+    uint32_t captureMicros;
 
     // Button gesture detection
     uint32_t lastButtonPressTime;
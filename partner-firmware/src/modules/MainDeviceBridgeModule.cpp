@@ -12,6 +12,7 @@
 #include "MeshService.h"
 #include "NodeDB.h"
 #include "Router.h"
+#include "concurrency/LockGuard.h"
 #include "mesh/generated/meshtastic/mesh.pb.h"
 
 #include <cstring>
@@ -20,6 +21,44 @@
 MainDeviceBridgeModule *MainDeviceBridgeModule::instance = nullptr;
 MainDeviceBridgeModule *mainDeviceBridgeModule = nullptr;
 
+// Joystick notification: JoystickEvent, capture micros(), clock offset (all little-endian)
+#define JOYSTICK_NOTIFY_LEN     16
+
+// Offset estimates that are the same to within this are not worth logging
+#define CLOCK_OFFSET_LOG_US     500
+
+// How often the latency histograms are logged
+#define LATENCY_LOG_MS          30000
+
+static const char *latencyStageNames[LATENCY_STAGE_COUNT] = {
+    "capture_notify",
+    "notify_rx",
+    "rx_input",
+    "input_shown",
+    "capture_shown",
+};
+
+// ============================================================================
+// Latency Histogram
+// ============================================================================
+
+void LatencyHistogram::add(uint32_t us)
+{
+    // Bucket by bit length of us / 4: <4, 4-7, 8-15, ...
+    uint32_t q = us >> 2;
+    int bucket = q ? 32 - __builtin_clz(q) : 0;
+    if (bucket >= BUCKETS) {
+        bucket = BUCKETS - 1;
+    }
+    
+    count++;
+    totalUs += us;
+    if (us > maxUs) {
+        maxUs = us;
+    }
+    buckets[bucket]++;
+}
+
 // ============================================================================
 // BLE Callbacks
 // ============================================================================
@@ -39,6 +78,16 @@ void MeshSendCallback::onWrite(NimBLECharacteristic *pCharacteristic)
     }
 }
 
+void AckCallback::onWrite(NimBLECharacteristic *pCharacteristic)
+{
+    std::string value = pCharacteristic->getValue();
+    if (value.empty() || !bridge) {
+        return;
+    }
+    
+    bridge->handleAck((const uint8_t *)value.data(), value.length());
+}
+
 void BridgeServerCallbacks::onConnect(NimBLEServer *pServer)
 {
     if (bridge) {
@@ -73,12 +122,23 @@ MainDeviceBridgeModule::MainDeviceBridgeModule()
       mainDeviceConnected(false),
       lastHeartbeat(0),
       lastStatusUpdate(0),
+      sentInputNext(0),
+      clockSampleNext(0),
+      clockSampleCount(0),
+      clockOffsetUs(0),
+      clockOffsetValid(false),
+      lastLatencyLog(0),
       meshSendCallback(nullptr),
+      ackCallback(nullptr),
       serverCallbacks(nullptr)
 {
     instance = this;
     mainDeviceBridgeModule = this;
     
+    memset(sentInputs, 0, sizeof(sentInputs));
+    memset(clockSamples, 0, sizeof(clockSamples));
+    memset(latency, 0, sizeof(latency));
+    
     LOG_INFO("MainDeviceBridgeModule constructed\n");
 }
 
@@ -165,11 +225,13 @@ void MainDeviceBridgeModule::setupBLEServices(NimBLEServer *server)
     // ========================================================================
     NimBLEService *cmdService = server->createService(COMMAND_SYNC_SERVICE_UUID);
     
-    // Ack (indicate)
+    // Ack (indicate to the main device, written back by it for joystick events)
     ackChar = cmdService->createCharacteristic(
         ACK_CHAR_UUID,
-        NIMBLE_PROPERTY::INDICATE
+        NIMBLE_PROPERTY::INDICATE | NIMBLE_PROPERTY::WRITE_NR
     );
+    ackCallback = new AckCallback(this);
+    ackChar->setCallbacks(ackCallback);
     ackChar->setValue("");
     
     // Heartbeat (notify)
@@ -206,6 +268,11 @@ void MainDeviceBridgeModule::onMainDeviceDisconnect()
 {
     mainDeviceConnected = false;
     LOG_INFO("Main device disconnected\n");
+    
+    // The main device's clock may have restarted by the time it is back
+    concurrency::LockGuard guard(&timingLock);
+    clockSampleCount = 0;
+    clockOffsetValid = false;
 }
 
 ProcessMessage MainDeviceBridgeModule::handleReceived(const meshtastic_MeshPacket &mp)
@@ -360,17 +427,132 @@ void MainDeviceBridgeModule::queueOutgoingMessage(uint32_t to, const char *messa
     }
 }
 
-void MainDeviceBridgeModule::sendJoystickEvent(const JoystickEvent &evt)
+void MainDeviceBridgeModule::sendJoystickEvent(const JoystickEvent &evt, uint32_t captureUs)
 {
     if (!joystickEventChar || !mainDeviceConnected) {
         return;
     }
     
-    // Send raw struct (8 bytes, packed)
-    joystickEventChar->setValue((uint8_t *)&evt, sizeof(JoystickEvent));
+    // Raw struct (8 bytes, packed), then the timing fields; without an
+    // offset estimate the main device cannot use the capture time, so
+    // the event goes out alone
+    uint8_t buf[JOYSTICK_NOTIFY_LEN];
+    size_t len = sizeof(JoystickEvent);
+    memcpy(buf, &evt, sizeof(JoystickEvent));
+    
+    // Logged before it goes out, so an ACK that comes straight back finds it;
+    // the lock is not held across notify()
+    uint32_t notifyUs = micros();
+    {
+        concurrency::LockGuard guard(&timingLock);
+        if (clockOffsetValid) {
+            memcpy(&buf[8], &captureUs, sizeof(captureUs));
+            memcpy(&buf[12], &clockOffsetUs, sizeof(clockOffsetUs));
+            len = JOYSTICK_NOTIFY_LEN;
+        }
+        sentInputs[sentInputNext] = {evt.seq, captureUs, notifyUs};
+        sentInputNext = (sentInputNext + 1) % SENT_INPUTS;
+        latency[LATENCY_CAPTURE_NOTIFY].add(notifyUs - captureUs);
+    }
+    
+    joystickEventChar->setValue(buf, len);
     joystickEventChar->notify();
 }
 
+void MainDeviceBridgeModule::handleAck(const uint8_t *data, size_t len)
+{
+    uint32_t received = micros();
+    
+    // Plain ACKs (just the seq) carry no timing
+    if (len < sizeof(InputLatencyAck)) {
+        return;
+    }
+    
+    InputLatencyAck ack;
+    memcpy(&ack, data, sizeof(ack));
+    
+    // Runs in the NimBLE host task, alongside sendJoystickEvent()
+    concurrency::LockGuard guard(&timingLock);
+    const SentInput *sent = nullptr;
+    for (int i = 0; i < SENT_INPUTS; i++) {
+        if (sentInputs[i].seq == ack.seq && sentInputs[i].notifyUs != 0) {
+            sent = &sentInputs[i];
+            break;
+        }
+    }
+    if (!sent) {
+        return;     // Too old
+    }
+    
+    updateClockOffset(sent->notifyUs, ack, received);
+    
+    // Main device times on our clock; skip stages a stale offset would make negative
+    int32_t notifyRx = (int32_t)(ack.rxTime - clockOffsetUs - sent->notifyUs);
+    int32_t captureShown = (int32_t)(ack.shownTime - clockOffsetUs - sent->captureUs);
+    if (notifyRx >= 0) {
+        latency[LATENCY_NOTIFY_RX].add(notifyRx);
+    }
+    if (captureShown >= 0) {
+        latency[LATENCY_CAPTURE_SHOWN].add(captureShown);
+    }
+    latency[LATENCY_RX_INPUT].add(ack.inputTime - ack.rxTime);
+    latency[LATENCY_INPUT_SHOWN].add(ack.shownTime - ack.inputTime);
+}
+
+void MainDeviceBridgeModule::updateClockOffset(uint32_t sent, const InputLatencyAck &ack, uint32_t received)
+{
+    // NTP-style: the round trip less the main device's time holding the
+    // event is the radio delay, assumed the same both ways. All modulo
+    // 2^32, so the clocks may wrap.
+    int32_t delay = (int32_t)((received - sent) - (ack.sentTime - ack.rxTime));
+    if (delay < 0) {
+        return;
+    }
+    int32_t offset = (int32_t)(ack.rxTime - sent - (uint32_t)delay / 2);
+    
+    clockSamples[clockSampleNext] = {(uint32_t)delay, offset};
+    clockSampleNext = (clockSampleNext + 1) % CLOCK_SAMPLES;
+    if (clockSampleCount < CLOCK_SAMPLES) {
+        clockSampleCount++;
+    }
+    
+    // Queuing only ever adds delay, so the quickest round trip is the most symmetric
+    const ClockSample *best = &clockSamples[0];
+    for (int i = 1; i < clockSampleCount; i++) {
+        if (clockSamples[i].delayUs < best->delayUs) {
+            best = &clockSamples[i];
+        }
+    }
+    
+    int32_t change = best->offsetUs - clockOffsetUs;
+    if (!clockOffsetValid || change > CLOCK_OFFSET_LOG_US || change < -CLOCK_OFFSET_LOG_US) {
+        LOG_DEBUG("Clock offset %d us (round trip %u us)\n", best->offsetUs, best->delayUs);
+    }
+    clockOffsetUs = best->offsetUs;
+    clockOffsetValid = true;
+}
+
+void MainDeviceBridgeModule::logLatency()
+{
+    // A consistent copy, so ACKs are not held up while it is logged
+    LatencyHistogram snapshot[LATENCY_STAGE_COUNT];
+    {
+        concurrency::LockGuard guard(&timingLock);
+        memcpy(snapshot, latency, sizeof(snapshot));
+    }
+    
+    for (int i = 0; i < LATENCY_STAGE_COUNT; i++) {
+        const LatencyHistogram &h = snapshot[i];
+        char line[256];
+        int len = snprintf(line, sizeof(line), "latency,%s,%u,%llu,%u", latencyStageNames[i],
+                           h.count, (unsigned long long)h.totalUs, h.maxUs);
+        for (int b = 0; b < LatencyHistogram::BUCKETS && len < (int)sizeof(line); b++) {
+            len += snprintf(line + len, sizeof(line) - len, ",%u", h.buckets[b]);
+        }
+        LOG_INFO("%s\n", line);
+    }
+}
+
 void MainDeviceBridgeModule::sendKeypadEvent(uint8_t buttons, uint32_t seq)
 {
     if (!keypadEventChar || !mainDeviceConnected) {
@@ -403,6 +585,12 @@ int32_t MainDeviceBridgeModule::runOnce()
         heartbeatChar->notify();
     }
     
+    // Latency histograms, while joystick events are being timed
+    if (latency[LATENCY_CAPTURE_NOTIFY].count && (now - lastLatencyLog > LATENCY_LOG_MS)) {
+        lastLatencyLog = now;
+        logLatency();
+    }
+    
     // Update status every 30 seconds
     if (mainDeviceConnected && (now - lastStatusUpdate > 30000)) {
         lastStatusUpdate = now;
@@ -584,7 +772,8 @@ size_t MainDeviceBridgeModule::buildNodeList(uint8_t *buf, size_t bufLen)
 void sendJoystickToMainDevice(const JoystickEvent &evt)
 {
     if (mainDeviceBridgeModule) {
-        mainDeviceBridgeModule->sendJoystickEvent(evt);
+        uint32_t captureUs = joystickInputModule ? joystickInputModule->getCaptureMicros() : micros();
+        mainDeviceBridgeModule->sendJoystickEvent(evt, captureUs);
     }
 }
 #endif
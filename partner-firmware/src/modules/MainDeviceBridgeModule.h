@@ -14,6 +14,7 @@
 #include "SinglePortModule.h"
 #include "configuration.h"
 #include "JoystickInputModule.h"
+#include "concurrency/Lock.h"
 #include "mesh/generated/meshtastic/mesh.pb.h"
 
 #include <NimBLEDevice.h>
@@ -62,6 +63,49 @@ struct MeshSendRequest {
     bool wantAck;                   ///< Request delivery ACK
 };
 
+/**
+ * @brief Input ACK written by the main device once a joystick event is on screen
+ *
+ * Times are the main device's esp_timer microseconds, truncated to 32 bits.
+ * A plain ACK is just the seq.
+ */
+struct __attribute__((packed)) InputLatencyAck {
+    uint32_t seq;                   ///< JoystickEvent seq
+    uint32_t rxTime;                ///< Notification received
+    uint32_t inputTime;             ///< Delivered to the UI's input handlers
+    uint32_t shownTime;             ///< Transfer of the frame showing it finished
+    uint32_t sentTime;              ///< This ACK written
+};
+
+/**
+ * @brief Stages of joystick input latency
+ */
+enum LatencyStage {
+    LATENCY_CAPTURE_NOTIFY,         ///< Sampled to handed to BLE
+    LATENCY_NOTIFY_RX,              ///< Handed to BLE to received by the main device
+    LATENCY_RX_INPUT,               ///< Received to the UI's input handlers
+    LATENCY_INPUT_SHOWN,            ///< Input handlers to the frame on the panel
+    LATENCY_CAPTURE_SHOWN,          ///< Sampled to the frame on the panel
+    LATENCY_STAGE_COUNT
+};
+
+/**
+ * @brief Latency histogram, bucketed like the main device's ui_perf
+ *
+ * Bucket 0 holds samples under 4 us, bucket i [2^(i+1), 2^(i+2)) us and
+ * the last one everything longer.
+ */
+struct LatencyHistogram {
+    static const int BUCKETS = 16;
+    
+    uint32_t count;                 ///< Samples
+    uint64_t totalUs;               ///< Sum of all samples
+    uint32_t maxUs;                 ///< Longest sample
+    uint32_t buckets[BUCKETS];
+    
+    void add(uint32_t us);
+};
+
 /**
  * @brief BLE callback handler for MeshSend writes
  */
@@ -74,6 +118,18 @@ private:
     class MainDeviceBridgeModule *bridge;
 };
 
+/**
+ * @brief BLE callback handler for ACK writes from the main device
+ */
+class AckCallback : public NimBLECharacteristicCallbacks {
+public:
+    AckCallback(class MainDeviceBridgeModule *bridge) : bridge(bridge) {}
+    void onWrite(NimBLECharacteristic *pCharacteristic) override;
+    
+private:
+    class MainDeviceBridgeModule *bridge;
+};
+
 /**
  * @brief BLE server callbacks for connection management
  */
@@ -120,9 +176,13 @@ public:
     
     /**
      * @brief Send joystick event to main device
+     *
+     * The notification carries the event, its capture time and, once
+     * known, the main device's clock offset, so both ends can time it.
      * @param evt Joystick event struct
+     * @param captureUs micros() when the event was sampled
      */
-    void sendJoystickEvent(const JoystickEvent &evt);
+    void sendJoystickEvent(const JoystickEvent &evt, uint32_t captureUs);
     
     /**
      * @brief Send keypad event to main device
@@ -194,6 +254,26 @@ private:
      * @brief Build node list response
      */
     size_t buildNodeList(uint8_t *buf, size_t bufLen);
+    
+    /**
+     * @brief Handle an ACK written by the main device
+     */
+    void handleAck(const uint8_t *data, size_t len);
+    
+    /**
+     * @brief Update the clock offset estimate from one round trip
+     *
+     * Called with timingLock held.
+     * @param sent micros() when the event was notified
+     * @param ack The main device's receive and ACK times
+     * @param received micros() when the ACK arrived
+     */
+    void updateClockOffset(uint32_t sent, const InputLatencyAck &ack, uint32_t received);
+    
+    /**
+     * @brief Log the latency histograms
+     */
+    void logLatency();
 
     // BLE characteristics
     NimBLECharacteristic *meshInboxChar;
@@ -210,14 +290,46 @@ private:
     uint32_t lastHeartbeat;
     uint32_t lastStatusUpdate;
     
+    // Joystick events awaiting an input ACK
+    struct SentInput {
+        uint32_t seq;
+        uint32_t captureUs;
+        uint32_t notifyUs;
+    };
+    static const int SENT_INPUTS = 16;
+    SentInput sentInputs[SENT_INPUTS];
+    uint8_t sentInputNext;
+    
+    // Round trips for the clock offset; the one with the least delay wins
+    struct ClockSample {
+        uint32_t delayUs;
+        int32_t offsetUs;           ///< Main device clock minus ours
+    };
+    static const int CLOCK_SAMPLES = 8;
+    ClockSample clockSamples[CLOCK_SAMPLES];
+    uint8_t clockSampleNext;
+    uint8_t clockSampleCount;
+    int32_t clockOffsetUs;
+    bool clockOffsetValid;
+    
+    LatencyHistogram latency[LATENCY_STAGE_COUNT];
+    uint32_t lastLatencyLog;
+    
+    // Guards sentInputs, the clock samples and offset, and latency: ACKs
+    // and disconnects arrive in the NimBLE host task, events go out from
+    // the module thread
+    concurrency::Lock timingLock;
+    
     // Callbacks (prevent dangling pointers)
     MeshSendCallback *meshSendCallback;
+    AckCallback *ackCallback;
     BridgeServerCallbacks *serverCallbacks;
     
     // Singleton
     static MainDeviceBridgeModule *instance;
     
     friend class MeshSendCallback;
+    friend class AckCallback;
     friend class BridgeServerCallbacks;
 };
 